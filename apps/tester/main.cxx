@@ -7,6 +7,7 @@ using namespace cgv::base;
 struct test_listener : public base, public registration_listener
 {
 	static std::vector<base_ptr> tests;
+	static bool run_benchmarks;
 	void register_object(base_ptr object, const std::string& options)
 	{
 		if (object->get_interface<test>())
@@ -21,9 +22,13 @@ struct test_listener : public base, public registration_listener
 			std::cout << "no tests registered" << std::endl;
 			return true;
 		}
-		unsigned int succeeded = 0;
+		unsigned int succeeded = 0, skipped = 0;
 		for (unsigned int i=0; i<tests.size(); ++i) {
 			test* t = tests[i]->get_interface<test>();
+			if (t->is_benchmark() && !run_benchmarks) {
+				++skipped;
+				continue;
+			}
 			std::cout << "test " << t->get_test_name().c_str() << ":";
 			std::cout.flush();
 			cgv::base::test::nr_failed = 0;
@@ -35,23 +40,35 @@ struct test_listener : public base, public registration_listener
 				std::cout << "failed";
 			std::cout << std::endl;
 		}
-		if (succeeded == tests.size()) {
+		if (skipped > 0)
+			std::cout << "skipped " << skipped << " benchmarks, use --benchmarks to run them" << std::endl;
+		unsigned int executed = unsigned(tests.size()) - skipped;
+		if (succeeded == executed) {
 			std::cout << "all tests successful" << std::endl;
 			return true;
 		}
 		else
-			std::cout << (tests.size()-succeeded) << " tests of " << tests.size() << " failed" << std::endl;
+			std::cout << (executed-succeeded) << " tests of " << executed << " failed" << std::endl;
 		return false;
 	}
 };
 
 std::vector<base_ptr> test_listener::tests;
+bool test_listener::run_benchmarks = false;
 
 int main(int argc, char** argv)
 {
+	// benchmarks are only run if requested with --benchmarks, which is not passed on to the command line processing
+	std::vector<char*> args;
+	for (int i = 0; i < argc; ++i) {
+		if (std::string(argv[i]) == "--benchmarks")
+			test_listener::run_benchmarks = true;
+		else
+			args.push_back(argv[i]);
+	}
 	register_object(new test_listener());
 	enable_registration();
-	process_command_line_args(argc, argv);
+	process_command_line_args(int(args.size()), &args[0]);
 	bool res = test_listener::perform_tests();
 #if _MSC_VER >= 1600
 	std::cin.get();
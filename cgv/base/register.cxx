@@ -8,6 +8,8 @@
 #include <algorithm>
 #include <vector>
 #include <set>
+#include <unordered_map>
+#include <chrono>
 
 #if defined(_WIN32)
 #include <Windows.h>
@@ -57,12 +59,38 @@ struct registration_order_info
 	}
 };
 
+/// remove all entries of object from the list of an index and the list itself if it becomes empty
+static void remove_from_index(std::unordered_map<std::string, std::vector<base_ptr>>& index, const std::string& key,
+							  base_ptr object)
+{
+	auto iter = index.find(key);
+	if (iter == index.end())
+		return;
+	std::vector<base_ptr>& L = iter->second;
+	L.erase(std::remove(L.begin(), L.end(), object), L.end());
+	if (L.empty())
+		index.erase(iter);
+}
+
 struct object_collection
 {
 	std::vector<base_ptr> objects;
+	/// objects in registration order indexed by name at registration time and by type name
+	std::unordered_map<std::string, std::vector<base_ptr>> name_index, type_index;
+	/// names under which a named object is found in the name index
+	std::unordered_map<const base*, std::vector<std::string>> indexed_names;
+	void add_to_name_index(base_ptr object, const std::string& name)
+	{
+		name_index[name].push_back(object);
+		indexed_names[&(*object)].push_back(name);
+	}
 	void add_object(base_ptr object)
 	{
 		objects.push_back(object);
+		type_index[object->get_type_name()].push_back(object);
+		named_ptr np = object->cast<named>();
+		if (np)
+			add_to_name_index(object, np->get_name());
 	}
 	void remove_object(base_ptr object)
 	{
@@ -72,6 +100,13 @@ struct object_collection
 				++i;
 			}
 		}
+		remove_from_index(type_index, object->get_type_name(), object);
+		auto iter = indexed_names.find(&(*object));
+		if (iter == indexed_names.end())
+			return;
+		for (const auto& name : iter->second)
+			remove_from_index(name_index, name, object);
+		indexed_names.erase(iter);
 	}
 	void unregister_all_objects()
 	{
@@ -81,21 +116,31 @@ struct object_collection
 	}
 	named_ptr find_object_by_name(const std::string& name)
 	{
+		// objects can be renamed after registration, such that index entries are validated
+		auto iter = name_index.find(name);
+		if (iter != name_index.end()) {
+			for (const auto& bp : iter->second) {
+				named_ptr np = bp->cast<named>();
+				if (np->get_name() == name)
+					return np;
+			}
+		}
+		// fall back to linear search for objects renamed after registration and index them under the new name
 		for (unsigned int oi = 0; oi < objects.size(); ++oi) {
 			named_ptr np = objects[oi]->cast<named>();
-			if (np && np->get_name() == name)
+			if (np && np->get_name() == name) {
+				add_to_name_index(objects[oi], name);
 				return np;
+			}
 		}
 		return named_ptr();
 	}
 	base_ptr find_object_by_type(const std::string& type_name)
 	{
-		for (unsigned int oi = 0; oi < objects.size(); ++oi) {
-			base_ptr bp = objects[oi];
-			if (type_name == bp->get_type_name())
-				return bp;
-		}
-		return base_ptr();
+		auto iter = type_index.find(type_name);
+		if (iter == type_index.end())
+			return base_ptr();
+		return iter->second.front();
 	}
 	bool request_exit_from_all_objects()
 	{
@@ -164,6 +209,45 @@ std::vector<base_ptr>& ref_listeners()
 	return listeners;
 }
 
+struct lazy_object_info
+{
+	base_ptr constructor;
+	std::string name;
+	std::string options;
+};
+
+static std::vector<lazy_object_info>& ref_lazy_objects()
+{
+	static std::vector<lazy_object_info> lazy_objects;
+	return lazy_objects;
+}
+
+static std::vector<registration_timing>& ref_registration_timings()
+{
+	static std::vector<registration_timing> timings;
+	return timings;
+}
+
+/// return timing entry of plugin or program with given name and append one if the last entry has a different name
+static registration_timing& ref_registration_timing(const std::string& name)
+{
+	std::vector<registration_timing>& T = ref_registration_timings();
+	if (T.empty() || T.back().name != name) {
+		registration_timing rt;
+		rt.name = name;
+		rt.load_seconds = rt.registration_seconds = 0;
+		rt.nr_events = 0;
+		T.push_back(rt);
+	}
+	return T.back();
+}
+
+/// return seconds since given time point
+static double seconds_since(const std::chrono::steady_clock::time_point& t)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
 /****************** helper functions **************/
 
 void show_split_lines(const std::string& s)
@@ -275,8 +359,9 @@ void sort_registration_events(bool before_contructor_execution)
 	// initialized combined partial order
 	size_t N = ref_registration_events().size();
 	std::vector<std::set<unsigned>> combined_partial_order;
-	combined_partial_order.resize(N);
 	unsigned nr_partial_orders = 0;
+	// index of first registration event per type name, which is built only if a partial order applies
+	std::unordered_map<std::string, unsigned> event_index;
 
 	// iterate all registration order infos
 	for (auto roi : ref_registration_order_infos()) {
@@ -302,21 +387,22 @@ void sort_registration_events(bool before_contructor_execution)
 		std::vector<cgv::utils::token> toks;
 		cgv::utils::tokenizer(roi.partial_order).set_ws(";").bite_all(toks);
 
+		if (combined_partial_order.empty()) {
+			combined_partial_order.resize(N);
+			for (unsigned i = 0; i < N; ++i)
+				event_index.emplace(ref_registration_events()[i].first->get_type_name(), i);
+		}
+
 		// first construct a vector with indices of registration events
 		std::vector<unsigned> event_indices;
 		unsigned nr_matched = 0;
 		for (auto t : toks) {
-			bool found = false;
-			for (unsigned i = 0; i < N; ++i) {
-				std::string tn = ref_registration_events()[i].first->get_type_name();
-				if (t == tn) {
-					event_indices.push_back(i);
-					++nr_matched;
-					found = true;
-					break;
-				}
+			auto iter = event_index.find(to_string(t));
+			if (iter != event_index.end()) {
+				event_indices.push_back(iter->second);
+				++nr_matched;
 			}
-			if (!found) {
+			else {
 				std::cout << "REG ORDER: could not find event <" << t << ">" << std::endl;
 			}
 		}
@@ -383,10 +469,11 @@ void enable_registration()
 	if (is_registration_enabled())
 		return;
 
+	std::string name = ref_plugin_name().empty() ? ref_prog_name() : ref_plugin_name();
 	if (is_registration_debugging_enabled())
-		std::cout << "REG ENABLE <" << (ref_plugin_name().empty() ? ref_prog_name() : ref_plugin_name()) << "> Begin"
-				  << std::endl;
+		std::cout << "REG ENABLE <" << name << "> Begin" << std::endl;
 
+	auto start_time = std::chrono::steady_clock::now();
 	unsigned i, i0 = ref_info().nr_events_before_disable;
 
 	sort_registration_events(true);
@@ -412,49 +499,60 @@ void enable_registration()
 
 	sort_registration_events(false);
 
+	// classify the objects of new events once instead of querying their interfaces in each of the following passes;
+	// events emitted during the passes are classified when they are reached
+	enum EventKind { EK_SERVER = 1, EK_DRIVER = 2, EK_LISTENER = 4 };
+	std::vector<unsigned char> kinds;
+	auto kind = [&kinds, i0](unsigned i) -> unsigned char {
+		while (i0 + kinds.size() <= i) {
+			base_ptr object = ref_registration_events()[i0 + kinds.size()].first;
+			kinds.push_back((object->get_interface<server>() != 0 ? EK_SERVER : 0) |
+							(object->get_interface<driver>() != 0 ? EK_DRIVER : 0) |
+							(object->get_interface<registration_listener>() != 0 ? EK_LISTENER : 0));
+		}
+		return kinds[i - i0];
+	};
+
 	// next register all servers
-	const std::vector<base_ptr>& L = ref_listeners();
 	for (i = i0; i < ref_registration_events().size(); ++i) {
-		base_ptr object = ref_registration_events()[i].first;
-		if (object->get_interface<server>() == 0)
+		if ((kind(i) & EK_SERVER) == 0)
 			continue;
+		base_ptr object = ref_registration_events()[i].first;
 		register_object_internal(object, ref_registration_events()[i].second);
-		if (object->get_interface<registration_listener>() != 0)
+		if ((kind(i) & EK_LISTENER) != 0)
 			ref_listeners().push_back(object);
 	}
 
 	// next register all drivers
 	for (i = i0; i < ref_registration_events().size(); ++i) {
-		base_ptr object = ref_registration_events()[i].first;
-		if (object->get_interface<driver>() == 0)
+		if ((kind(i) & EK_DRIVER) == 0)
 			continue;
+		base_ptr object = ref_registration_events()[i].first;
 		register_object_internal(object, ref_registration_events()[i].second);
-		if (object->get_interface<registration_listener>() != 0)
+		if ((kind(i) & EK_LISTENER) != 0)
 			ref_listeners().push_back(object);
 	}
 
 	// next register all listeners
 	for (i = i0; i < ref_registration_events().size(); ++i) {
-		base_ptr object = ref_registration_events()[i].first;
-		if (object->get_interface<registration_listener>() == 0)
+		if ((kind(i) & EK_LISTENER) == 0)
 			continue;
-		if (object->get_interface<server>() == 0 && object->get_interface<driver>() == 0) {
+		base_ptr object = ref_registration_events()[i].first;
+		if ((kind(i) & (EK_SERVER | EK_DRIVER)) == 0) {
 			register_object_internal(object, ref_registration_events()[i].second);
 			ref_listeners().push_back(object);
 		}
 		// send all buffered events
+		registration_listener* rl = object->get_interface<registration_listener>();
 		for (unsigned j = 0; j < i0; ++j)
-			object->get_interface<registration_listener>()->register_object(ref_registration_events()[j].first,
-																			ref_registration_events()[j].second);
+			rl->register_object(ref_registration_events()[j].first, ref_registration_events()[j].second);
 	}
 
 	// next register all remaining objects
 	for (i = i0; i < ref_registration_events().size(); ++i) {
-		base_ptr object = ref_registration_events()[i].first;
-		if (object->get_interface<registration_listener>() != 0 || object->get_interface<driver>() != 0 ||
-			object->get_interface<server>() != 0)
+		if (kind(i) != 0)
 			continue;
-		register_object_internal(object, ref_registration_events()[i].second);
+		register_object_internal(ref_registration_events()[i].first, ref_registration_events()[i].second);
 	}
 
 	// remove registration events
@@ -464,9 +562,32 @@ void enable_registration()
 	ref_info().nr_events_before_disable = (unsigned)ref_registration_events().size();
 	ref_info().registration_enabled = true;
 
-	if (is_registration_debugging_enabled())
-		std::cout << "REG ENABLE <" << (ref_plugin_name().empty() ? ref_prog_name() : ref_plugin_name()) << "> End"
-				  << std::endl;
+	registration_timing& rt = ref_registration_timing(name);
+	rt.registration_seconds += seconds_since(start_time);
+	rt.nr_events += (unsigned)kinds.size();
+
+	if (is_registration_debugging_enabled()) {
+		std::cout << "REG ENABLE <" << name << "> End" << std::endl;
+		show_registration_timings();
+	}
+}
+
+const std::vector<registration_timing>& get_registration_timings()
+{
+	return ref_registration_timings();
+}
+
+void show_registration_timings()
+{
+	double load_seconds = 0, registration_seconds = 0;
+	for (const auto& rt : ref_registration_timings()) {
+		std::cout << "REG TIMING <" << rt.name << "> load " << 1000 * rt.load_seconds << " ms, registration "
+				  << 1000 * rt.registration_seconds << " ms for " << rt.nr_events << " events" << std::endl;
+		load_seconds += rt.load_seconds;
+		registration_seconds += rt.registration_seconds;
+	}
+	std::cout << "REG TIMING total load " << 1000 * load_seconds << " ms, registration "
+			  << 1000 * registration_seconds << " ms" << std::endl;
 }
 
 void disable_registration()
@@ -499,6 +620,7 @@ void enable_permanent_registration()
 
 void unregister_all_objects()
 {
+	ref_lazy_objects().clear();
 	ref_object_collection().unregister_all_objects();
 }
 
@@ -642,16 +764,74 @@ void unregister_object(base_ptr object, const std::string& options)
 	object->unregister();
 }
 
+void register_lazy_object(base_ptr constructor, const std::string& name, const std::string& options)
+{
+	if (!constructor->get_interface<object_constructor>()) {
+		std::cerr << "ERROR: lazy registration of " << constructor->get_type_name()
+				  << " which is not an object constructor" << std::endl;
+		return;
+	}
+	if (is_registration_debugging_enabled())
+		std::cout << "REG LAZY " << constructor->get_interface<object_constructor>()->get_constructed_type_name()
+				  << "<" << name << "> ('" << options << "')" << std::endl;
+	lazy_object_info loi;
+	loi.constructor = constructor;
+	loi.name = name;
+	loi.options = options;
+	ref_lazy_objects().push_back(loi);
+}
+
+/// construct and register i-th lazy object
+static void construct_lazy_object(unsigned i)
+{
+	// remove entry first such that lookups from constructor do not construct object twice
+	lazy_object_info loi = ref_lazy_objects()[i];
+	ref_lazy_objects().erase(ref_lazy_objects().begin() + i);
+	object_constructor* oc = loi.constructor->get_interface<object_constructor>();
+	if (is_registration_debugging_enabled())
+		std::cout << "REG CONSTRUCT LAZY " << oc->get_constructed_type_name() << "<" << loi.name << ">" << std::endl;
+	base_ptr object = oc->construct_object();
+	named_ptr np = object->cast<named>();
+	if (np && !loi.name.empty())
+		np->set_name(loi.name);
+	register_object(object, loi.options);
+}
+
+void construct_lazy_objects()
+{
+	while (!ref_lazy_objects().empty())
+		construct_lazy_object(0);
+}
+
 /// in case permanent registration is active, look for a registered object by name
 named_ptr find_object_by_name(const std::string& name)
 {
-	return ref_object_collection().find_object_by_name(name);
+	named_ptr np = ref_object_collection().find_object_by_name(name);
+	if (np || !is_registration_enabled())
+		return np;
+	for (unsigned i = 0; i < ref_lazy_objects().size(); ++i) {
+		if (ref_lazy_objects()[i].name == name) {
+			construct_lazy_object(i);
+			return ref_object_collection().find_object_by_name(name);
+		}
+	}
+	return np;
 }
 
 /// in case permanent registration is active, look for a registered object by type name
 base_ptr find_object_by_type(const std::string& type_name)
 {
-	return ref_object_collection().find_object_by_type(type_name);
+	base_ptr bp = ref_object_collection().find_object_by_type(type_name);
+	if (bp || !is_registration_enabled())
+		return bp;
+	for (unsigned i = 0; i < ref_lazy_objects().size(); ++i) {
+		if (ref_lazy_objects()[i].constructor->get_interface<object_constructor>()->get_constructed_type_name() ==
+			type_name) {
+			construct_lazy_object(i);
+			return ref_object_collection().find_object_by_type(type_name);
+		}
+	}
+	return bp;
 }
 
 std::string get_config_file_name(const std::string& _file_name)
@@ -787,13 +967,18 @@ bool process_gui_file(const std::string& file_name)
 	return false;
 }
 
-test::test(const std::string& _test_name, bool (*_test_func)()) : test_name(_test_name), test_func(_test_func) {}
+test::test(const std::string& _test_name, bool (*_test_func)(), bool _benchmark) : test_name(_test_name), test_func(_test_func), benchmark(_benchmark) {}
 
 std::string test::get_test_name() const
 {
 	return test_name;
 }
 
+bool test::is_benchmark() const
+{
+	return benchmark;
+}
+
 bool test::exec_test() const
 {
 	return test_func();
@@ -811,6 +996,11 @@ test_registration::test_registration(const std::string& _test_name, bool (*_test
 	register_object(base_ptr(new test(_test_name, _test_func)), "");
 }
 
+benchmark_registration::benchmark_registration(const std::string& _test_name, bool (*_test_func)())
+{
+	register_object(base_ptr(new test(_test_name, _test_func, true)), "");
+}
+
 /// construct
 factory::factory(const std::string& _created_type_name, bool _singleton, const std::string& _object_options)
 	: created_type_name(_created_type_name), is_singleton(_singleton), object_options(_object_options)
@@ -966,6 +1156,9 @@ void show_all()
 		show_split_lines(objects[oi]->get_property_declarations());
 		std::cout << "\n\n";
 	}
+	for (const auto& loi : ref_lazy_objects())
+		std::cout << "lazy(" << loi.name << "):"
+				  << loi.constructor->get_interface<object_constructor>()->get_constructed_type_name() << "\n\n";
 	std::cout << "__________________________________________________________________\n" << std::endl;
 	return;
 }
@@ -1421,8 +1614,10 @@ void* load_plugin(const std::string& file_name)
 		result = nullptr;
 		for (auto& dll_name : fn) {
 			ref_plugin_name() = dll_name;
+			auto start_time = std::chrono::steady_clock::now();
 			result = load_plugin_platform(dll_name);
 			if (result) {
+				ref_registration_timing(dll_name).load_seconds += seconds_since(start_time);
 				break;
 			}
 
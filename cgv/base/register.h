@@ -5,6 +5,7 @@
 #include <cgv/utils/token.h>
 #include <cgv/type/info/type_name.h>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <map>
 
@@ -56,6 +57,23 @@ extern void CGV_API disable_registration_debugging();
 /// check whether registration debugging is enabled
 extern bool CGV_API is_registration_debugging_enabled();
 
+/// timing of the startup of the program or of a loaded plugin
+struct registration_timing
+{
+	/// name of plugin or program
+	std::string name;
+	/// seconds spent in loading the plugin including the execution of its static constructors
+	double load_seconds;
+	/// seconds spent in enable_registration including the construction of objects with delayed registration
+	double registration_seconds;
+	/// number of registration events processed in enable_registration
+	unsigned nr_events;
+};
+/// return the startup timings of program and plugins in the order of their registration
+extern CGV_API const std::vector<registration_timing>& get_registration_timings();
+/// print the startup timings of program and plugins to std::cout, which is done after each registration if registration debugging is enabled
+extern void CGV_API show_registration_timings();
+
 /// register a registration listener that stores pointers to all registered objects
 extern void CGV_API enable_permanent_registration();
 /// deregister registration listener and dereference pointers to registered objects
@@ -192,6 +210,35 @@ struct object_registration_2
 			register_object(base_ptr(new object_constructor_impl_2<T,CA1,CA2>(a1,a2)),options);
 	}
 };
+
+//! register an object constructor whose object is only constructed when it is looked up.
+/*! Once registration is enabled, the object is constructed and registered with the given options on the first call
+    to find_object_by_name with the given name or to find_object_by_type with the type name of the constructed
+	object, as done by the name and type commands of config files. If the constructed object is named, the given
+	name is assigned to it. Use this for objects that are only needed on demand in order to shorten startup. */
+extern void CGV_API register_lazy_object(base_ptr constructor, const std::string& name, const std::string& options = "");
+/// construct and register all objects that have been registered lazily and not looked up yet
+extern void CGV_API construct_lazy_objects();
+
+/// convenience class to lazily register an object of the given class type under the given name
+template <class T>
+struct lazy_object_registration
+{
+	/// pass the name used for lookup and information about the target registration listener in the options argument
+	lazy_object_registration(const std::string& name, const std::string& options = "") {
+		register_lazy_object(base_ptr(new object_constructor_impl<T>()), name, options);
+	}
+};
+
+/// convenience class to lazily register an object of the given class type with one constructor argument under the given name
+template <class T, typename CA>
+struct lazy_object_registration_1
+{
+	/// pass the constructor argument, the name used for lookup and information about the target registration listener in the options argument
+	lazy_object_registration_1(const CA& arg, const std::string& name, const std::string& options = "") {
+		register_lazy_object(base_ptr(new object_constructor_impl_1<T,CA>(arg)), name, options);
+	}
+};
 //@}
 
 /**@name support for driver, listener and factory registration*/
@@ -375,13 +422,17 @@ protected:
 	std::string test_name;
 	/// pointer to test function
 	bool (*test_func)();
+	/// whether the test is a benchmark that is only run on request
+	bool benchmark;
 public:
 	/// constructor for a test structure
-	test(const std::string& _test_name, bool (*_test_func)());
+	test(const std::string& _test_name, bool (*_test_func)(), bool _benchmark = false);
 	/// implementation of the type name function of the base class
 	std::string get_type_name() const;
 	/// access to name of test function
 	std::string get_test_name() const;
+	/// return whether the test is a benchmark
+	bool is_benchmark() const;
 	/// execute test and return whether this was successful
 	bool exec_test() const;
 };
@@ -406,6 +457,13 @@ struct CGV_API test_registration
 	/// the constructor creates a test structure and registeres the test
 	test_registration(const std::string& _test_name, bool (*_test_func)());
 };
+
+/// declare an instance of benchmark_registration as static variable in order to register a benchmark function in a test plugin, which the tester only runs on request
+struct CGV_API benchmark_registration
+{
+	/// the constructor creates a test structure marked as benchmark and registeres the test
+	benchmark_registration(const std::string& _test_name, bool (*_test_func)());
+};
 //@}
 
 
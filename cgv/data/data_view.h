@@ -90,19 +90,19 @@ public:
 	}
 	/// constant access to the ci-th component of i-th data entry
 	template <typename S> S get(int ci, int i) const { 
-		return format->get<S>(ci, get_ptr<cgv::type::func::drop_pointer<P>::type>(i));
+		return format->get<S>(ci, get_ptr<typename cgv::type::func::drop_pointer<P>::type>(i));
 	}
 	/// constant access to the ci-th component of (i,j)-th data entry
 	template <typename S> S get(int ci, int i, int j) const { 
-		return format->get<S>(ci, get_ptr<cgv::type::func::drop_pointer<P>::type>(i, j));
+		return format->get<S>(ci, get_ptr<typename cgv::type::func::drop_pointer<P>::type>(i, j));
 	}
 	/// constant access to the ci-th component of (i,j,k)-th data entry
 	template <typename S> S get(int ci, int i, int j, int k) const { 
-		return format->get<S>(ci, get_ptr<cgv::type::func::drop_pointer<P>::type>(i,j,k));
+		return format->get<S>(ci, get_ptr<typename cgv::type::func::drop_pointer<P>::type>(i,j,k));
 	}
 	/// constant access to the ci-th component of (i,j,k,l)-th data entry
 	template <typename S> S get(int ci, int i, int j, int k, int l) const { 
-		return format->get<S>(ci, get_ptr<cgv::type::func::drop_pointer<P>::type>(i, j, k, l));
+		return format->get<S>(ci, get_ptr<typename cgv::type::func::drop_pointer<P>::type>(i, j, k, l));
 	}
 	/// access to i-th data entry
 	D operator () (unsigned int i) const;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 namespace cgv {
 	namespace data {
 
@@ -23,5 +25,32 @@ public:
 	inline int get_ref_count() const { return ref_count; }
 };
 
+/** alternative to ref_counted for classes whose ref_ptrs are copied and released concurrently in several threads.
+    The count is incremented with relaxed and decremented with acquire-release memory order, such that the
+	deleting thread sees all writes made to the instance before other threads released their references. This
+	makes copies of ref_ptrs to shared instances thread safe but more expensive than with ref_counted, while
+	assignment to the same ref_ptr from several threads still needs to be synchronized. */
+class atomic_ref_counted
+{
+private:
+	/// keep a mutable reference count to allow ref counted points to const instances
+	mutable std::atomic<int> ref_count;
+protected:
+	friend class ref_ptr_tag;
+	/// constructor initializes the count to 0
+	inline atomic_ref_counted() : ref_count(0) {}
+	/// copies are not referenced by the ref_ptrs of the copied instance
+	inline atomic_ref_counted(const atomic_ref_counted&) : ref_count(0) {}
+	/// assignment keeps the count
+	inline atomic_ref_counted& operator = (const atomic_ref_counted&) { return *this; }
+	/// increment count
+	inline void inc_ref_count() const { ref_count.fetch_add(1, std::memory_order_relaxed); }
+	/// decrement count and return the count before the decrement
+	inline int dec_ref_count() const { return ref_count.fetch_sub(1, std::memory_order_acq_rel); }
+public:
+	/// read access to current count
+	inline int get_ref_count() const { return ref_count.load(std::memory_order_acquire); }
+};
+
 	}
 }
@@ -39,6 +39,19 @@ protected:
 		assert(0);
 		return false;
 	}
+	/// increment the count of an atomically ref counted object
+	void inc_ref_count(const atomic_ref_counted* ptr) const
+	{
+		ptr->inc_ref_count();
+	}
+	/// decrement the count of an atomically ref counted object and return whether to delete the object
+	bool dec_ref_count(const atomic_ref_counted* ptr) const
+	{
+		int count = ptr->dec_ref_count();
+		// ERROR: zero ref count decremented
+		assert(count > 0);
+		return count == 1;
+	}
 };
 
 template <typename T, bool is_ref_counted = false>
@@ -152,10 +165,10 @@ public:
 };
 
 /** reference counted pointer, which can work together with types that are derived
-    from ref_counted, in which case the reference count of ref_counted is
-	used. Otherwise a reference count is allocated and access to the stored instance
-	needs to follow two pointers. */
-template <class T, bool is_ref_counted = type::cond::is_base_of<ref_counted,T>::value>
+    from ref_counted or atomic_ref_counted, in which case the reference count of the
+	base class is used. Otherwise a reference count is allocated and access to the stored
+	instance needs to follow two pointers. */
+template <class T, bool is_ref_counted = type::cond::is_base_of<ref_counted,T>::value || type::cond::is_base_of<atomic_ref_counted,T>::value>
 class ref_ptr : public ref_ptr_impl<T,is_ref_counted>
 {
 public:
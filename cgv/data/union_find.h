@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <utility>
 
 namespace cgv {
 	namespace data {
@@ -37,5 +40,70 @@ struct union_find : public std::vector<unsigned int>
 	}
 };
 
+/** lock-free union find structure that can be used concurrently from several threads. Representatives are linked
+    by compare and swap such that the representative with the larger index is always attached to the one with the
+	smaller index, which avoids cycles. Paths are halved during find. */
+struct concurrent_union_find
+{
+protected:
+	std::unique_ptr<std::atomic<unsigned int>[]> parent;
+	unsigned int n;
+public:
+	/// construct with given number of elements
+	concurrent_union_find(unsigned int _n = 0) : n(0) { init(_n); }
+	/// init such that each element is a representative, which must not be called concurrently
+	void init(unsigned int _n) {
+		if (_n != n) {
+			parent.reset(_n > 0 ? new std::atomic<unsigned int>[_n] : 0);
+			n = _n;
+		}
+		for (unsigned int i = 0; i < n; ++i)
+			parent[i].store(i, std::memory_order_relaxed);
+	}
+	/// return number of elements
+	unsigned int size() const { return n; }
+	/// find representative with path halving
+	unsigned int find(unsigned int i)
+	{
+		while (true) {
+			unsigned int p = parent[i].load(std::memory_order_relaxed);
+			if (p == i)
+				return i;
+			unsigned int gp = parent[p].load(std::memory_order_relaxed);
+			if (gp != p)
+				parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+			i = gp;
+		}
+	}
+	/// check whether two elements are in the same group
+	bool same(unsigned int i, unsigned int j)
+	{
+		while (true) {
+			i = find(i);
+			j = find(j);
+			if (i == j)
+				return true;
+			// i is still a representative such that the groups are different at this moment
+			if (parent[i].load(std::memory_order_relaxed) == i)
+				return false;
+		}
+	}
+	/// union of the groups of two elements, returns false if both elements already were in the same group
+	bool unify(unsigned int i, unsigned int j)
+	{
+		while (true) {
+			i = find(i);
+			j = find(j);
+			if (i == j)
+				return false;
+			if (i < j)
+				std::swap(i, j);
+			unsigned int expected = i;
+			if (parent[i].compare_exchange_strong(expected, j, std::memory_order_acq_rel))
+				return true;
+		}
+	}
+};
+
 	}
 }
\ No newline at end of file
@@ -1,95 +1,228 @@
 #include "normal_estimation.h"
 
-#include <cgv/math/mat.h>
-#include <cgv/math/eig.h>
-#include <cgv/math/point_operations.h>
+#include <cmath>
+#include <algorithm>
 
 namespace cgv {
 	namespace math {
 
-void estimate_normal_ls(unsigned nr_points, const float* _points, float* _normal, float* _evals, float* _mean, float* _evecs)
+namespace {
+	void cross_3(const double* a, const double* b, double* c)
+	{
+		c[0] = a[1] * b[2] - a[2] * b[1];
+		c[1] = a[2] * b[0] - a[0] * b[2];
+		c[2] = a[0] * b[1] - a[1] * b[0];
+	}
+	double dot_3(const double* a, const double* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+	void normalize_3(double* a)
+	{
+		double l = std::sqrt(dot_3(a, a));
+		if (l > 0) {
+			a[0] /= l;
+			a[1] /= l;
+			a[2] /= l;
+		}
+	}
+	void mul_3(const double* A, const double* v, double* r)
+	{
+		r[0] = A[0] * v[0] + A[1] * v[1] + A[2] * v[2];
+		r[1] = A[1] * v[0] + A[3] * v[1] + A[4] * v[2];
+		r[2] = A[2] * v[0] + A[4] * v[1] + A[5] * v[2];
+	}
+	/// compute eigenvector of simple eigenvalue lambda as the longest cross product of two rows of A - lambda*I
+	void simple_eigenvector_3x3(const double* A, double lambda, double* v)
+	{
+		double r0[3] = { A[0] - lambda, A[1], A[2] };
+		double r1[3] = { A[1], A[3] - lambda, A[4] };
+		double r2[3] = { A[2], A[4], A[5] - lambda };
+		double c[3][3];
+		cross_3(r0, r1, c[0]);
+		cross_3(r0, r2, c[1]);
+		cross_3(r1, r2, c[2]);
+		double l[3] = { dot_3(c[0], c[0]), dot_3(c[1], c[1]), dot_3(c[2], c[2]) };
+		int i = l[0] >= l[1] ? (l[0] >= l[2] ? 0 : 2) : (l[1] >= l[2] ? 1 : 2);
+		if (l[i] == 0) {
+			v[0] = 1; v[1] = 0; v[2] = 0;
+			return;
+		}
+		double f = 1.0 / std::sqrt(l[i]);
+		v[0] = f * c[i][0];
+		v[1] = f * c[i][1];
+		v[2] = f * c[i][2];
+	}
+	/// compute orthonormal vectors u and w that are orthogonal to unit vector v
+	void orthogonal_basis_3(const double* v, double* u, double* w)
+	{
+		if (std::abs(v[0]) > std::abs(v[1])) {
+			double f = 1.0 / std::sqrt(v[0] * v[0] + v[2] * v[2]);
+			u[0] = -f * v[2]; u[1] = 0; u[2] = f * v[0];
+		}
+		else {
+			double f = 1.0 / std::sqrt(v[1] * v[1] + v[2] * v[2]);
+			u[0] = 0; u[1] = f * v[2]; u[2] = -f * v[1];
+		}
+		cross_3(v, u, w);
+	}
+}
+
+void eig_sym_3x3(const double* _A, double* _evals, double* _evecs)
 {
-	cgv::math::mat<float> points;
-	points.set_extern_data(3, nr_points, const_cast<float*>(_points));
+	// scale matrix to avoid over- and underflow
+	double s = 0;
+	for (int i = 0; i < 6; ++i)
+		s = std::max(s, std::abs(_A[i]));
+	if (s == 0) {
+		_evals[0] = _evals[1] = _evals[2] = 0;
+		if (_evecs) {
+			std::fill(_evecs, _evecs + 9, 0.0);
+			_evecs[0] = _evecs[4] = _evecs[8] = 1;
+		}
+		return;
+	}
+	double A[6];
+	for (int i = 0; i < 6; ++i)
+		A[i] = _A[i] / s;
 
-	cgv::math::vec<float> normal;
-	normal.set_extern_data(3, _normal);
+	double p1 = A[1] * A[1] + A[2] * A[2] + A[4] * A[4];
+	if (p1 == 0) {
+		// diagonal matrix
+		int idx[3] = { 0, 1, 2 };
+		double d[3] = { A[0], A[3], A[5] };
+		std::stable_sort(idx, idx + 3, [&d](int i, int j) { return d[i] > d[j]; });
+		for (int i = 0; i < 3; ++i) {
+			_evals[i] = s * d[idx[i]];
+			if (_evecs) {
+				_evecs[3 * i] = _evecs[3 * i + 1] = _evecs[3 * i + 2] = 0;
+				_evecs[3 * i + idx[i]] = 1;
+			}
+		}
+		return;
+	}
+	// trigonometric solution of characteristic polynomial
+	double q = (A[0] + A[3] + A[5]) / 3;
+	double b00 = A[0] - q, b11 = A[3] - q, b22 = A[5] - q;
+	double p = std::sqrt((b00 * b00 + b11 * b11 + b22 * b22 + 2 * p1) / 6);
+	double det_b = b00 * (b11 * b22 - A[4] * A[4]) - A[1] * (A[1] * b22 - A[4] * A[2]) + A[2] * (A[1] * A[4] - b11 * A[2]);
+	double r = std::max(-1.0, std::min(1.0, det_b / (2 * p * p * p)));
+	double phi = std::acos(r) / 3;
+	double e0 = q + 2 * p * std::cos(phi);
+	double e2 = q + 2 * p * std::cos(phi + 2.0943951023931954923);
+	double e1 = 3 * q - e0 - e2;
+	if (!_evecs) {
+		_evals[0] = s * e0;
+		_evals[1] = s * e1;
+		_evals[2] = s * e2;
+		return;
+	}
+	// compute eigenvector of the eigenvalue that is better separated and solve the remaining 2x2 problem in its orthogonal complement
+	bool largest_first = e0 - e1 >= e1 - e2;
+	double v[3], u[3], w[3], Au[3], Aw[3];
+	simple_eigenvector_3x3(A, largest_first ? e0 : e2, v);
+	orthogonal_basis_3(v, u, w);
+	mul_3(A, u, Au);
+	mul_3(A, w, Aw);
+	double a = dot_3(u, Au), b = dot_3(u, Aw), c = dot_3(w, Aw);
+	double theta = 0.5 * std::atan2(2 * b, a - c);
+	double ct = std::cos(theta), st = std::sin(theta);
+	double mean = 0.5 * (a + c), radius = std::sqrt(0.25 * (a - c) * (a - c) + b * b);
+	double x[3] = { ct * u[0] + st * w[0], ct * u[1] + st * w[1], ct * u[2] + st * w[2] };
+	double y[3] = { -st * u[0] + ct * w[0], -st * u[1] + ct * w[1], -st * u[2] + ct * w[2] };
+	const double *v0, *v1, *v2;
+	if (largest_first) {
+		e1 = mean + radius;
+		e2 = mean - radius;
+		v0 = v; v1 = x; v2 = y;
+	}
+	else {
+		e0 = mean + radius;
+		e1 = mean - radius;
+		v0 = x; v1 = y; v2 = v;
+	}
+	_evals[0] = s * e0;
+	_evals[1] = s * e1;
+	_evals[2] = s * e2;
+	std::copy(v0, v0 + 3, _evecs);
+	std::copy(v1, v1 + 3, _evecs + 3);
+	std::copy(v2, v2 + 3, _evecs + 6);
+}
 
-	cgv::math::mat<float> covmat;
-	cgv::math::vec<float> mean;
+namespace {
+	/// compute normal and optional outputs from mean and upper triangle of covariance matrix
+	void fit_normal_3(const double* mean, const double* C, float* _normal, float* _evals, float* _mean, float* _evecs)
+	{
+		double evals[3], evecs[9];
+		eig_sym_3x3(C, evals, evecs);
+		double n[3] = { evecs[6], evecs[7], evecs[8] };
+		normalize_3(n);
+		for (int i = 0; i < 3; ++i) {
+			_normal[i] = (float)n[i];
+			if (_evals)
+				_evals[i] = (float)evals[i];
+			if (_mean)
+				_mean[i] = (float)mean[i];
+		}
+		if (_evecs)
+			for (int i = 0; i < 9; ++i)
+				_evecs[i] = (float)evecs[i];
+	}
+}
 
-	cgv::math::covmat_and_mean(points,covmat,mean);
-	cgv::math::mat<double> dcovmat(covmat), v;
-	cgv::math::diag_mat<double> d;
-	cgv::math::eig_sym(dcovmat,v,d);
+void estimate_normal_ls(unsigned nr_points, const float* _points, float* _normal, float* _evals, float* _mean, float* _evecs)
+{
+	double mean[3] = { 0, 0, 0 };
+	const float* p = _points;
+	for (unsigned i = 0; i < nr_points; ++i, p += 3)
+		for (int c = 0; c < 3; ++c)
+			mean[c] += p[c];
+	if (nr_points > 0)
+		for (int c = 0; c < 3; ++c)
+			mean[c] /= nr_points;
 
-	normal = cgv::math::vec<float>(normalize(v.col(2)));
-	if (_evals) {
-		_evals[0] = (float)d(0);		
-		_evals[1] = (float)d(1);		
-		_evals[2] = (float)d(2);
-	}
-	if (_mean) {
-		_mean[0] = (float)mean(0);
-		_mean[1] = (float)mean(1);
-		_mean[2] = (float)mean(2);
-	}
-	if (_evecs) {
-		_evecs[0] = (float)v(0, 0);
-		_evecs[1] = (float)v(1, 0);
-		_evecs[2] = (float)v(2, 0);
-		_evecs[3] = (float)v(0, 1);
-		_evecs[4] = (float)v(1, 1);
-		_evecs[5] = (float)v(2, 1);
-		_evecs[6] = (float)v(0, 2);
-		_evecs[7] = (float)v(1, 2);
-		_evecs[8] = (float)v(2, 2);
+	double C[6] = { 0, 0, 0, 0, 0, 0 };
+	p = _points;
+	for (unsigned i = 0; i < nr_points; ++i, p += 3) {
+		double d0 = p[0] - mean[0], d1 = p[1] - mean[1], d2 = p[2] - mean[2];
+		C[0] += d0 * d0; C[1] += d0 * d1; C[2] += d0 * d2;
+		C[3] += d1 * d1; C[4] += d1 * d2; C[5] += d2 * d2;
 	}
+	if (nr_points > 0)
+		for (int i = 0; i < 6; ++i)
+			C[i] /= nr_points;
+	fit_normal_3(mean, C, _normal, _evals, _mean, _evecs);
 }
 
 void estimate_normal_wls(unsigned nr_points, const float* _points, const float* _weights, float* _normal, float* _evals, float* _mean, float* _evecs)
 {
-	cgv::math::mat<float> points;
-	points.set_extern_data(3, nr_points, const_cast<float*>(_points));
-	cgv::math::vec<float> weights;
-	weights.set_extern_data(nr_points, const_cast<float*>(_weights));
-	cgv::math::vec<float> normal;
-	normal.set_extern_data(3, _normal);
+	double weight_sum = 0;
+	for (unsigned i = 0; i < nr_points; ++i)
+		weight_sum += _weights[i];
 
-	cgv::math::mat<float> covmat;
-	cgv::math::vec<float> mean;
-
-	
-
-	cgv::math::weighted_covmat_and_mean(weights,points,covmat,mean);
-	cgv::math::mat<double> dcovmat(covmat), v;
-	cgv::math::diag_mat<double> d;
-	cgv::math::eig_sym(dcovmat,v,d);
-
-	normal = cgv::math::vec<float>(normalize(v.col(2)));
-
-	if (_evals) {
-		_evals[0] = (float)d(0);		
-		_evals[1] = (float)d(1);		
-		_evals[2] = (float)d(2);
-	}
-	if (_mean) {
-		_mean[0] = (float)mean(0);
-		_mean[1] = (float)mean(1);
-		_mean[2] = (float)mean(2);
-	}
-	if (_evecs) {
-		_evecs[0] = (float)v(0, 0);
-		_evecs[1] = (float)v(1, 0);
-		_evecs[2] = (float)v(2, 0);
-		_evecs[3] = (float)v(0, 1);
-		_evecs[4] = (float)v(1, 1);
-		_evecs[5] = (float)v(2, 1);
-		_evecs[6] = (float)v(0, 2);
-		_evecs[7] = (float)v(1, 2);
-		_evecs[8] = (float)v(2, 2);
+	double mean[3] = { 0, 0, 0 };
+	double sqr_weight_sum = 0;
+	const float* p = _points;
+	for (unsigned i = 0; i < nr_points; ++i, p += 3) {
+		double w = _weights[i] / weight_sum;
+		for (int c = 0; c < 3; ++c)
+			mean[c] += w * p[c];
+		sqr_weight_sum += w * w;
+	}
+	double C[6] = { 0, 0, 0, 0, 0, 0 };
+	p = _points;
+	for (unsigned i = 0; i < nr_points; ++i, p += 3) {
+		double w = _weights[i] / weight_sum;
+		double d0 = p[0] - mean[0], d1 = p[1] - mean[1], d2 = p[2] - mean[2];
+		C[0] += w * d0 * d0; C[1] += w * d0 * d1; C[2] += w * d0 * d2;
+		C[3] += w * d1 * d1; C[4] += w * d1 * d2; C[5] += w * d2 * d2;
 	}
+	// unbiased weighted covariance
+	if (sqr_weight_sum < 1)
+		for (int i = 0; i < 6; ++i)
+			C[i] /= 1 - sqr_weight_sum;
+	fit_normal_3(mean, C, _normal, _evals, _mean, _evecs);
 }
 
 	}
-}
\ No newline at end of file
+}
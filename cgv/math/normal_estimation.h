@@ -18,6 +18,14 @@ namespace cgv {
 
 		/// Weighted version of \c estimate_normal_ls with additional input \c _weights pointing to \c nr_points scalar weights.
 		extern CGV_API void estimate_normal_wls(unsigned nr_points, const float* _points, const float* _weights, float* _normal, float* _evals = 0, float* _mean = 0, float* _evecs = 0);
+
+		//! Closed form eigen decomposition of a symmetric 3x3 matrix.
+		/*! The matrix is given by the 6 entries of its upper triangle in the order a00, a01, a02, a11, a12, a22.
+		    The eigenvalues are written in decreasing order to the 3 doubles pointed to by \c _evals. If \c _evecs
+			is specified, the corresponding normalized eigenvectors are written in 3 double trippels to \c _evecs.
+			In contrast to the iterative eig_sym, no memory is allocated such that the function can be called
+			concurrently for many small problems. */
+		extern CGV_API void eig_sym_3x3(const double* _A, double* _evals, double* _evecs = 0);
 	}
 }
 #include <cgv/config/lib_end.h>
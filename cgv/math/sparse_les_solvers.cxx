@@ -0,0 +1,585 @@
+#include "sparse_les_solvers.h"
+#include <cgv/os/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+
+namespace cgv {
+	namespace math {
+
+namespace {
+	/// return number of blocks used by parallel_blocks, where small ranges are processed in one block
+	unsigned get_nr_parallel_blocks(size_t n, unsigned nr_threads)
+	{
+		if (nr_threads == 0)
+			nr_threads = cgv::os::get_thread_pool().get_concurrency();
+		const size_t min_block_size = 16384;
+		return unsigned(std::min(size_t(nr_threads), std::max(size_t(1), n / min_block_size)));
+	}
+
+	/// call f(t,b,e) for the blocks t = 0 ... get_nr_parallel_blocks(n, nr_threads)-1 covering [b,e) of [0,n) with one task per block in the shared thread pool
+	template <typename F>
+	void parallel_blocks(size_t n, unsigned nr_threads, const F& f)
+	{
+		unsigned nr_blocks = get_nr_parallel_blocks(n, nr_threads);
+		if (nr_blocks == 1) {
+			f(0u, size_t(0), n);
+			return;
+		}
+		cgv::os::get_thread_pool().parallel_for(0, nr_blocks, [&](size_t t) { f(unsigned(t), t*n / nr_blocks, (t + 1)*n / nr_blocks); }, 1);
+	}
+
+	/// compute dot product from per block partial sums
+	double parallel_dot(size_t n, const double* u, const double* v, unsigned nr_threads)
+	{
+		if (n == 0)
+			return 0;
+		unsigned nr_blocks = get_nr_parallel_blocks(n, nr_threads);
+		std::vector<double> partial_sums(nr_blocks, 0.0);
+		parallel_blocks(n, nr_threads, [&](unsigned t, size_t b, size_t e) {
+			double s = 0;
+			for (size_t i = b; i < e; ++i)
+				s += u[i] * v[i];
+			partial_sums[t] = s;
+		});
+		double s = 0;
+		for (double p : partial_sums)
+			s += p;
+		return s;
+	}
+}
+
+csr_matrix::csr_matrix() : n(0)
+{
+	row_offsets.push_back(0);
+}
+
+void csr_matrix::build(int _n, std::vector<sparse_les_triplet>& triplets)
+{
+	n = _n;
+	std::stable_sort(triplets.begin(), triplets.end(), [](const sparse_les_triplet& t1, const sparse_les_triplet& t2) {
+		return t1.r < t2.r || (t1.r == t2.r && t1.c < t2.c);
+	});
+	row_offsets.assign(size_t(n) + 1, 0);
+	column_indices.clear();
+	values.clear();
+	for (size_t ti = 0; ti < triplets.size(); ++ti) {
+		// of several triplets at the same position only the last one counts
+		if (ti + 1 < triplets.size() && triplets[ti + 1].r == triplets[ti].r && triplets[ti + 1].c == triplets[ti].c)
+			continue;
+		++row_offsets[triplets[ti].r + 1];
+		column_indices.push_back(triplets[ti].c);
+		values.push_back(triplets[ti].val);
+	}
+	for (int r = 0; r < n; ++r)
+		row_offsets[r + 1] += row_offsets[r];
+}
+
+void csr_matrix::extract_triplets(std::vector<sparse_les_triplet>& triplets) const
+{
+	for (int r = 0; r < n; ++r)
+		for (size_t p = row_offsets[r]; p < row_offsets[r + 1]; ++p) {
+			sparse_les_triplet t = { r, column_indices[p], values[p] };
+			triplets.push_back(t);
+		}
+}
+
+double csr_matrix::get_entry(int r, int c) const
+{
+	auto b = column_indices.begin() + row_offsets[r], e = column_indices.begin() + row_offsets[r + 1];
+	auto iter = std::lower_bound(b, e, c);
+	if (iter == e || *iter != c)
+		return 0;
+	return values[iter - column_indices.begin()];
+}
+
+void csr_matrix::multiply(const double* x, double* y, unsigned nr_threads) const
+{
+	parallel_blocks(n, nr_threads, [&](unsigned, size_t b, size_t e) {
+		for (size_t r = b; r < e; ++r) {
+			double s = 0;
+			for (size_t p = row_offsets[r]; p < row_offsets[r + 1]; ++p)
+				s += values[p] * x[column_indices[p]];
+			y[r] = s;
+		}
+	});
+}
+
+assembled_sparse_les::assembled_sparse_les(int _n, int _nr_rhs, int nr_nze) : n(_n), nr_rhs(_nr_rhs), nr_threads(0)
+{
+	if (nr_nze > 0)
+		triplets.reserve(nr_nze);
+	B.resize(size_t(n)*nr_rhs, 0.0);
+	X.resize(size_t(n)*nr_rhs, 0.0);
+	A.build(n, triplets);
+}
+
+void assembled_sparse_les::set_mat_entry(int r, int c, double val)
+{
+	sparse_les_triplet t = { r, c, val };
+	triplets.push_back(t);
+}
+
+void assembled_sparse_les::set_b_entry(int i, int j, double val)
+{
+	B[size_t(j)*n + i] = val;
+}
+
+double& assembled_sparse_les::ref_b_entry(int i, int j)
+{
+	return B[size_t(j)*n + i];
+}
+
+double assembled_sparse_les::get_x_entry(int i, int j) const
+{
+	return X[size_t(j)*n + i];
+}
+
+bool assembled_sparse_les::assemble()
+{
+	if (triplets.empty())
+		return false;
+	if (A.get_nr_non_zeros() > 0) {
+		std::vector<sparse_les_triplet> all_triplets;
+		all_triplets.reserve(A.get_nr_non_zeros() + triplets.size());
+		A.extract_triplets(all_triplets);
+		all_triplets.insert(all_triplets.end(), triplets.begin(), triplets.end());
+		A.build(n, all_triplets);
+	}
+	else
+		A.build(n, triplets);
+	std::vector<sparse_les_triplet>().swap(triplets);
+	return true;
+}
+
+const csr_matrix& assembled_sparse_les::get_matrix()
+{
+	assemble();
+	return A;
+}
+
+bool assembled_sparse_les::analyze_residuals()
+{
+	residuals.resize(nr_rhs);
+	std::vector<double> r(n);
+	bool finite = true;
+	for (int j = 0; j < nr_rhs; ++j) {
+		const double* x = &X[size_t(j)*n];
+		const double* b = &B[size_t(j)*n];
+		A.multiply(x, &r[0], nr_threads);
+		for (int i = 0; i < n; ++i)
+			r[i] -= b[i];
+		double b_norm = sqrt(parallel_dot(n, b, b, nr_threads));
+		residuals[j] = sqrt(parallel_dot(n, &r[0], &r[0], nr_threads)) / (b_norm > 0 ? b_norm : 1.0);
+		finite = finite && std::isfinite(residuals[j]);
+	}
+	return finite;
+}
+
+double assembled_sparse_les::get_residual(int j) const
+{
+	return j < int(residuals.size()) ? residuals[j] : -1.0;
+}
+
+pcg_sparse_les::pcg_sparse_les(int _n, int _nr_rhs, int nr_nze, PcgPreconditioner _preconditioner) :
+	assembled_sparse_les(_n, _nr_rhs, nr_nze), preconditioner(_preconditioner), preconditioner_valid(false), tolerance(1e-10), max_nr_iterations(10000)
+{
+}
+
+bool pcg_sparse_les::factorize_ic0(double shift)
+{
+	// copy lower triangle of A
+	L.n = n;
+	L.row_offsets.assign(size_t(n) + 1, 0);
+	L.column_indices.clear();
+	L.values.clear();
+	for (int r = 0; r < n; ++r) {
+		for (size_t p = A.row_offsets[r]; p < A.row_offsets[r + 1] && A.column_indices[p] <= r; ++p) {
+			L.column_indices.push_back(A.column_indices[p]);
+			L.values.push_back(A.column_indices[p] == r ? (1 + shift)*A.values[p] : A.values[p]);
+		}
+		L.row_offsets[r + 1] = L.values.size();
+		if (L.column_indices.empty() || L.column_indices.back() != r)
+			return false;
+	}
+	// compute L(i,k) = (A(i,k) - sum_j<k L(i,j)*L(k,j)) / L(k,k) restricted to the pattern of A
+	for (int i = 0; i < n; ++i) {
+		size_t pi_end = L.row_offsets[i + 1] - 1;
+		for (size_t pi = L.row_offsets[i]; pi < pi_end; ++pi) {
+			int k = L.column_indices[pi];
+			size_t qi = L.row_offsets[i], qk = L.row_offsets[k], qk_end = L.row_offsets[k + 1] - 1;
+			double s = L.values[pi];
+			while (qi < pi && qk < qk_end) {
+				if (L.column_indices[qi] < L.column_indices[qk])
+					++qi;
+				else if (L.column_indices[qi] > L.column_indices[qk])
+					++qk;
+				else
+					s -= L.values[qi++] * L.values[qk++];
+			}
+			L.values[pi] = s / L.values[qk_end];
+		}
+		double d = L.values[pi_end];
+		for (size_t pi = L.row_offsets[i]; pi < pi_end; ++pi)
+			d -= L.values[pi] * L.values[pi];
+		if (!(d > 0))
+			return false;
+		L.values[pi_end] = sqrt(d);
+	}
+	return true;
+}
+
+bool pcg_sparse_les::compute_preconditioner()
+{
+	if (preconditioner == PCG_IC0) {
+		// shift the diagonal until the incomplete factorization does not break down
+		double shift = 0;
+		for (int attempt = 0; attempt < 20; ++attempt) {
+			if (factorize_ic0(shift))
+				return true;
+			shift = shift == 0 ? 1e-3 : 2 * shift;
+		}
+		return false;
+	}
+	inv_diag.resize(n);
+	for (int i = 0; i < n; ++i) {
+		double d = A.get_entry(i, i);
+		if (d == 0)
+			return false;
+		inv_diag[i] = 1.0 / d;
+	}
+	return true;
+}
+
+void pcg_sparse_les::apply_preconditioner(const double* r, double* z) const
+{
+	if (preconditioner == PCG_IC0) {
+		// solve L*y = r and L^T*z = y in place
+		for (int i = 0; i < n; ++i) {
+			double s = r[i];
+			size_t p_end = L.row_offsets[i + 1] - 1;
+			for (size_t p = L.row_offsets[i]; p < p_end; ++p)
+				s -= L.values[p] * z[L.column_indices[p]];
+			z[i] = s / L.values[p_end];
+		}
+		for (int i = n - 1; i >= 0; --i) {
+			size_t p_end = L.row_offsets[i + 1] - 1;
+			z[i] /= L.values[p_end];
+			for (size_t p = L.row_offsets[i]; p < p_end; ++p)
+				z[L.column_indices[p]] -= L.values[p] * z[i];
+		}
+		return;
+	}
+	parallel_blocks(n, nr_threads, [&](unsigned, size_t b, size_t e) {
+		for (size_t i = b; i < e; ++i)
+			z[i] = inv_diag[i] * r[i];
+	});
+}
+
+bool pcg_sparse_les::solve(bool analyze_residual)
+{
+	if (assemble() || !preconditioner_valid)
+		preconditioner_valid = compute_preconditioner();
+	if (!preconditioner_valid)
+		return false;
+	nr_iterations.assign(nr_rhs, 0);
+	std::vector<double> r(n), z(n), p(n), q(n);
+	bool converged = true;
+	for (int j = 0; j < nr_rhs; ++j) {
+		double* x = &X[size_t(j)*n];
+		const double* b = &B[size_t(j)*n];
+		A.multiply(x, &q[0], nr_threads);
+		parallel_blocks(n, nr_threads, [&](unsigned, size_t bi, size_t ei) {
+			for (size_t i = bi; i < ei; ++i)
+				r[i] = b[i] - q[i];
+		});
+		double threshold = tolerance*tolerance*parallel_dot(n, b, b, nr_threads);
+		double r_sqr = parallel_dot(n, &r[0], &r[0], nr_threads);
+		if (r_sqr <= threshold)
+			continue;
+		apply_preconditioner(&r[0], &z[0]);
+		p = z;
+		double rz = parallel_dot(n, &r[0], &z[0], nr_threads);
+		int it;
+		for (it = 0; it < max_nr_iterations && r_sqr > threshold; ++it) {
+			A.multiply(&p[0], &q[0], nr_threads);
+			double pq = parallel_dot(n, &p[0], &q[0], nr_threads);
+			if (!(pq > 0))
+				break;
+			double alpha = rz / pq;
+			parallel_blocks(n, nr_threads, [&](unsigned, size_t bi, size_t ei) {
+				for (size_t i = bi; i < ei; ++i) {
+					x[i] += alpha*p[i];
+					r[i] -= alpha*q[i];
+				}
+			});
+			r_sqr = parallel_dot(n, &r[0], &r[0], nr_threads);
+			apply_preconditioner(&r[0], &z[0]);
+			double rz_new = parallel_dot(n, &r[0], &z[0], nr_threads);
+			double beta = rz_new / rz;
+			rz = rz_new;
+			parallel_blocks(n, nr_threads, [&](unsigned, size_t bi, size_t ei) {
+				for (size_t i = bi; i < ei; ++i)
+					p[i] = z[i] + beta*p[i];
+			});
+		}
+		nr_iterations[j] = it;
+		converged = converged && r_sqr <= threshold;
+	}
+	if (analyze_residual && !analyze_residuals())
+		return false;
+	return converged;
+}
+
+int pcg_sparse_les::get_nr_iterations(int j) const
+{
+	return j < int(nr_iterations.size()) ? nr_iterations[j] : 0;
+}
+
+ldlt_sparse_les::ldlt_sparse_les(int _n, int _nr_rhs, int nr_nze) :
+	assembled_sparse_les(_n, _nr_rhs, nr_nze), factorized(false), ordering(SO_NESTED_DISSECTION)
+{
+}
+
+void ldlt_sparse_les::compute_nested_dissection()
+{
+	const size_t min_part_size = 64;
+	perm.clear();
+	perm.reserve(n);
+	// part membership and breadth first search stamps
+	std::vector<int> part_stamp(n, -1), visit_stamp(n, -1), level_of(n, 0);
+	int stamp = 0;
+	std::vector<int> queue;
+	// breadth first search in current part from vertex v, returns level offsets into queue
+	auto bfs = [&](int v, int part, std::vector<size_t>& level_offsets) {
+		++stamp;
+		queue.clear();
+		level_offsets.assign(1, 0);
+		queue.push_back(v);
+		visit_stamp[v] = stamp;
+		level_of[v] = 0;
+		for (size_t qi = 0; qi < queue.size(); ++qi) {
+			int u = queue[qi];
+			for (size_t p = A.row_offsets[u]; p < A.row_offsets[u + 1]; ++p) {
+				int w = A.column_indices[p];
+				if (part_stamp[w] != part || visit_stamp[w] == stamp)
+					continue;
+				visit_stamp[w] = stamp;
+				level_of[w] = level_of[u] + 1;
+				queue.push_back(w);
+			}
+		}
+		for (size_t qi = 1; qi < queue.size(); ++qi)
+			if (level_of[queue[qi]] != level_of[queue[qi - 1]])
+				level_offsets.push_back(qi);
+		level_offsets.push_back(queue.size());
+	};
+	// stack of parts to be ordered and separators that are emitted after their parts
+	struct task
+	{
+		std::vector<int> vertices;
+		bool is_separator;
+	};
+	std::vector<task> tasks(1);
+	tasks[0].is_separator = false;
+	for (int i = 0; i < n; ++i)
+		tasks[0].vertices.push_back(i);
+	int part = 0;
+	std::vector<size_t> level_offsets;
+	while (!tasks.empty()) {
+		task t;
+		std::swap(t, tasks.back());
+		tasks.pop_back();
+		if (t.is_separator || t.vertices.size() <= min_part_size) {
+			perm.insert(perm.end(), t.vertices.begin(), t.vertices.end());
+			continue;
+		}
+		++part;
+		for (int v : t.vertices)
+			part_stamp[v] = part;
+		// find pseudo peripheral vertex by repeated breadth first search
+		int v = t.vertices[0];
+		bfs(v, part, level_offsets);
+		for (int iter = 0; iter < 4; ++iter) {
+			size_t nr_levels = level_offsets.size() - 1;
+			int w = queue.back();
+			std::vector<size_t> w_level_offsets;
+			bfs(w, part, w_level_offsets);
+			if (w_level_offsets.size() - 1 <= nr_levels) {
+				bfs(v, part, level_offsets);
+				break;
+			}
+			v = w;
+			level_offsets.swap(w_level_offsets);
+		}
+		size_t nr_reached = queue.size(), nr_levels = level_offsets.size() - 1;
+		// vertices in other connected components form a part of their own
+		if (nr_reached < t.vertices.size()) {
+			task rest;
+			rest.is_separator = false;
+			for (int u : t.vertices)
+				if (visit_stamp[u] != stamp)
+					rest.vertices.push_back(u);
+			tasks.push_back(rest);
+		}
+		std::vector<int> component(queue.begin(), queue.end());
+		if (nr_levels < 3) {
+			tasks.push_back(task());
+			tasks.back().vertices.swap(component);
+			tasks.back().is_separator = true;
+			continue;
+		}
+		// select smallest level around the median as separator
+		size_t best_level = 0, median_level = 1;
+		for (size_t l = 1; l + 1 < nr_levels; ++l) {
+			if (level_offsets[l] <= nr_reached / 2)
+				median_level = l;
+			if (level_offsets[l + 1] < 4 * nr_reached / 10 || level_offsets[l] > 6 * nr_reached / 10)
+				continue;
+			if (best_level == 0 || level_offsets[l + 1] - level_offsets[l] < level_offsets[best_level + 1] - level_offsets[best_level])
+				best_level = l;
+		}
+		if (best_level == 0)
+			best_level = median_level;
+		task separator, lower, upper;
+		separator.is_separator = true;
+		lower.is_separator = upper.is_separator = false;
+		separator.vertices.assign(component.begin() + level_offsets[best_level], component.begin() + level_offsets[best_level + 1]);
+		lower.vertices.assign(component.begin(), component.begin() + level_offsets[best_level]);
+		upper.vertices.assign(component.begin() + level_offsets[best_level + 1], component.end());
+		// separator is emitted after both halves, which are popped first
+		tasks.push_back(separator);
+		tasks.push_back(upper);
+		tasks.push_back(lower);
+	}
+}
+
+void ldlt_sparse_les::analyze()
+{
+	if (ordering == SO_NESTED_DISSECTION)
+		compute_nested_dissection();
+	else {
+		perm.resize(n);
+		for (int i = 0; i < n; ++i)
+			perm[i] = i;
+	}
+	inv_perm.resize(n);
+	for (int k = 0; k < n; ++k)
+		inv_perm[perm[k]] = k;
+	// elimination tree and column counts of permuted matrix C = P*A*P^T from its upper triangle
+	parent.assign(n, -1);
+	std::vector<int> flag(n), counts(n, 0);
+	for (int k = 0; k < n; ++k) {
+		flag[k] = k;
+		int r = perm[k];
+		for (size_t p = A.row_offsets[r]; p < A.row_offsets[r + 1]; ++p) {
+			int i = inv_perm[A.column_indices[p]];
+			if (i >= k)
+				continue;
+			for (; flag[i] != k; i = parent[i]) {
+				if (parent[i] == -1)
+					parent[i] = k;
+				++counts[i];
+				flag[i] = k;
+			}
+		}
+	}
+	L_col_offsets.assign(size_t(n) + 1, 0);
+	for (int k = 0; k < n; ++k)
+		L_col_offsets[k + 1] = L_col_offsets[k] + counts[k];
+	L_rows.resize(L_col_offsets[n]);
+	L_values.resize(L_col_offsets[n]);
+}
+
+bool ldlt_sparse_les::factorize()
+{
+	D.resize(n);
+	std::vector<double> y(n, 0.0);
+	std::vector<int> flag(n), pattern(n), fill(n, 0);
+	for (int k = 0; k < n; ++k) {
+		// scatter column k of the upper triangle of C and compute the nonzero pattern of row k of L
+		int top = n;
+		flag[k] = k;
+		int r = perm[k];
+		for (size_t p = A.row_offsets[r]; p < A.row_offsets[r + 1]; ++p) {
+			int i = inv_perm[A.column_indices[p]];
+			if (i > k)
+				continue;
+			y[i] += A.values[p];
+			int len = 0;
+			for (; flag[i] != k; i = parent[i]) {
+				pattern[len++] = i;
+				flag[i] = k;
+			}
+			while (len > 0)
+				pattern[--top] = pattern[--len];
+		}
+		// sparse triangular solve for row k of L
+		D[k] = y[k];
+		y[k] = 0;
+		for (; top < n; ++top) {
+			int i = pattern[top];
+			double yi = y[i];
+			y[i] = 0;
+			size_t p_end = L_col_offsets[i] + fill[i];
+			for (size_t p = L_col_offsets[i]; p < p_end; ++p)
+				y[L_rows[p]] -= L_values[p] * yi;
+			double l_ki = yi / D[i];
+			D[k] -= l_ki*yi;
+			L_rows[p_end] = k;
+			L_values[p_end] = l_ki;
+			++fill[i];
+		}
+		if (D[k] == 0 || !std::isfinite(D[k]))
+			return false;
+	}
+	return true;
+}
+
+bool ldlt_sparse_les::solve(bool analyze_residual)
+{
+	if (assemble() || !factorized) {
+		analyze();
+		factorized = factorize();
+	}
+	if (!factorized)
+		return false;
+	std::vector<double> y(n);
+	for (int j = 0; j < nr_rhs; ++j) {
+		const double* b = &B[size_t(j)*n];
+		double* x = &X[size_t(j)*n];
+		for (int k = 0; k < n; ++k)
+			y[k] = b[perm[k]];
+		for (int k = 0; k < n; ++k)
+			for (size_t p = L_col_offsets[k]; p < L_col_offsets[k + 1]; ++p)
+				y[L_rows[p]] -= L_values[p] * y[k];
+		for (int k = 0; k < n; ++k)
+			y[k] /= D[k];
+		for (int k = n - 1; k >= 0; --k)
+			for (size_t p = L_col_offsets[k]; p < L_col_offsets[k + 1]; ++p)
+				y[k] -= L_values[p] * y[L_rows[p]];
+		for (int k = 0; k < n; ++k)
+			x[perm[k]] = y[k];
+	}
+	if (analyze_residual && !analyze_residuals())
+		return false;
+	return true;
+}
+
+/// jacobi preconditioned conjugate gradient solver with the constructor signature of the factory
+struct pcg_jacobi_sparse_les : public pcg_sparse_les
+{
+	pcg_jacobi_sparse_les(int n, int nr_rhs, int nr_nze) : pcg_sparse_les(n, nr_rhs, nr_nze, PCG_JACOBI) {}
+};
+
+/// incomplete Cholesky preconditioned conjugate gradient solver with the constructor signature of the factory
+struct pcg_ic0_sparse_les : public pcg_sparse_les
+{
+	pcg_ic0_sparse_les(int n, int nr_rhs, int nr_nze) : pcg_sparse_les(n, nr_rhs, nr_nze, PCG_IC0) {}
+};
+
+register_sparse_les_factory<ldlt_sparse_les> register_ldlt_sparse_les("ldlt", SparseLesCaps(SLC_SYMMETRIC | SLC_NZE_OPTIONAL));
+register_sparse_les_factory<pcg_ic0_sparse_les> register_pcg_ic0_sparse_les("pcg_ic0", SparseLesCaps(SLC_SYMMETRIC | SLC_NZE_OPTIONAL));
+register_sparse_les_factory<pcg_jacobi_sparse_les> register_pcg_jacobi_sparse_les("pcg_jacobi", SparseLesCaps(SLC_SYMMETRIC | SLC_NZE_OPTIONAL));
+
+	}
+}
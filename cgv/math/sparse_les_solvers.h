@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+#include "sparse_les.h"
+
+#include "lib_begin.h"
+
+namespace cgv {
+	namespace math {
+
+/// matrix entry used to assemble sparse matrices
+struct sparse_les_triplet
+{
+	int r, c;
+	double val;
+};
+
+/// square sparse matrix in compressed row storage with increasing column indices per row
+class CGV_API csr_matrix
+{
+public:
+	/// number of rows and columns
+	int n;
+	/// offsets of rows into column_indices and values with n+1 entries
+	std::vector<size_t> row_offsets;
+	/// column indices of non zero entries
+	std::vector<int> column_indices;
+	/// values of non zero entries
+	std::vector<double> values;
+	/// construct empty matrix
+	csr_matrix();
+	/// build matrix from triplets, which are sorted in place and where later triplets overwrite earlier ones at the same position
+	void build(int _n, std::vector<sparse_les_triplet>& triplets);
+	/// append all entries as triplets
+	void extract_triplets(std::vector<sparse_les_triplet>& triplets) const;
+	/// return number of non zero entries
+	size_t get_nr_non_zeros() const { return values.size(); }
+	/// return entry at row r and column c, which is zero if not stored
+	double get_entry(int r, int c) const;
+	/// compute y = A*x in nr_threads blocks executed in the shared thread pool (0 ... use concurrency of the pool)
+	void multiply(const double* x, double* y, unsigned nr_threads = 0) const;
+};
+
+/** base class of the native sparse solvers that collects matrix entries as triplets and compresses them into a
+    csr_matrix before solving. The right hand sides and solutions are stored in column major order. Matrix entries
+	set after a solve overwrite the corresponding entries of the previous matrix. Solvers for symmetric systems expect
+	both triangles of the matrix to be set. */
+class CGV_API assembled_sparse_les : public sparse_les
+{
+protected:
+	int n, nr_rhs;
+	std::vector<sparse_les_triplet> triplets;
+	csr_matrix A;
+	std::vector<double> B, X;
+	/// relative residuals of last analyzed solve
+	std::vector<double> residuals;
+	/// compress pending triplets into A and return whether A changed
+	bool assemble();
+	/// compute relative residuals of all right hand sides and return whether they are finite
+	bool analyze_residuals();
+public:
+	using sparse_les::set_b_entry;
+	using sparse_les::ref_b_entry;
+	using sparse_les::get_x_entry;
+	/// number of blocks executed in parallel in the shared thread pool, where 0 uses the concurrency of the pool
+	unsigned nr_threads;
+	/// construct solver for n unknowns, nr_rhs right hand sides and an optional estimate of the number of non zero entries
+	assembled_sparse_les(int _n, int _nr_rhs, int nr_nze = -1);
+	/// set entry in row r and column c in the sparse matrix A
+	void set_mat_entry(int r, int c, double val);
+	/// set i-th entry in the j-th right hand side
+	void set_b_entry(int i, int j, double val);
+	/// set i-th entry in j-th right hand side
+	double& ref_b_entry(int i, int j);
+	/// return the i-th component of the j-th solution vector
+	double get_x_entry(int i, int j) const;
+	/// return the compressed matrix, which includes pending entries
+	const csr_matrix& get_matrix();
+	/// return relative residual |A*x-b|/|b| of j-th right hand side computed in the last solve with residual analysis
+	double get_residual(int j = 0) const;
+};
+
+/// preconditioner choice of pcg_sparse_les
+enum PcgPreconditioner
+{
+	PCG_JACOBI,
+	PCG_IC0
+};
+
+/** preconditioned conjugate gradient solver for symmetric positive definite systems. Matrix vector products and
+    vector operations are distributed over nr_threads threads. The Jacobi preconditioner scales by the inverse diagonal,
+	the incomplete Cholesky preconditioner without fill in (IC0) needs sequential triangular solves but typically
+	converges in much less iterations. The current solution is used as initial guess, such that repeated solves of
+	slowly changing systems start from the last solution. */
+class CGV_API pcg_sparse_les : public assembled_sparse_les
+{
+protected:
+	PcgPreconditioner preconditioner;
+	/// inverse diagonal for Jacobi preconditioner
+	std::vector<double> inv_diag;
+	/// lower triangular incomplete Cholesky factor including the diagonal
+	csr_matrix L;
+	/// whether preconditioner is valid for current matrix
+	bool preconditioner_valid;
+	/// compute incomplete Cholesky factor of A + shift*diag(A) and return false on breakdown
+	bool factorize_ic0(double shift);
+	/// compute preconditioner for current matrix
+	bool compute_preconditioner();
+	/// compute z = M^-1 * r
+	void apply_preconditioner(const double* r, double* z) const;
+	/// number of iterations per right hand side of last solve
+	std::vector<int> nr_iterations;
+public:
+	/// iteration stops if |r| <= tolerance*|b|
+	double tolerance;
+	/// maximum number of iterations per right hand side
+	int max_nr_iterations;
+	/// construct solver
+	pcg_sparse_les(int _n, int _nr_rhs, int nr_nze = -1, PcgPreconditioner _preconditioner = PCG_JACOBI);
+	/// solve all right hand sides and return whether all converged
+	bool solve(bool analyze_residual = false);
+	/// return number of iterations for the j-th right hand side of last solve
+	int get_nr_iterations(int j = 0) const;
+};
+
+/// fill reducing orderings of ldlt_sparse_les
+enum SparseOrdering
+{
+	SO_NATURAL,
+	SO_NESTED_DISSECTION
+};
+
+/** simplicial LDL^T factorization for symmetric systems, which extends the Cholesky factorization to quasi definite
+    matrices. The matrix is first permuted with a fill reducing ordering, where nested dissection recursively splits
+	the matrix graph at the middle level set of a breadth first search from a pseudo peripheral vertex. The symbolic
+	analysis computes the elimination tree and column counts, after which the numeric factorization computes L row by
+	row. The factorization is kept as long as no matrix entries change, such that only the triangular solves are
+	repeated for new right hand sides. */
+class CGV_API ldlt_sparse_les : public assembled_sparse_les
+{
+protected:
+	/// permutation with perm[k] being the original index of the k-th unknown and its inverse
+	std::vector<int> perm, inv_perm;
+	/// elimination tree
+	std::vector<int> parent;
+	/// strictly lower triangular unit factor in compressed column storage
+	std::vector<size_t> L_col_offsets;
+	std::vector<int> L_rows;
+	std::vector<double> L_values;
+	/// diagonal factor
+	std::vector<double> D;
+	/// whether the factorization is valid for the current matrix
+	bool factorized;
+	/// compute nested dissection ordering
+	void compute_nested_dissection();
+	/// compute ordering, elimination tree and structure of L
+	void analyze();
+	/// compute numeric factorization and return false if a zero pivot occurs
+	bool factorize();
+public:
+	/// ordering used in the next factorization
+	SparseOrdering ordering;
+	/// construct solver
+	ldlt_sparse_les(int _n, int _nr_rhs, int nr_nze = -1);
+	/// factorize if necessary and solve all right hand sides
+	bool solve(bool analyze_residual = false);
+	/// return number of entries in L of last factorization
+	size_t get_nr_factor_entries() const { return L_values.size(); }
+};
+
+	}
+}
+
+#include <cgv/config/lib_end.h>
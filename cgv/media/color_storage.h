@@ -56,6 +56,8 @@ namespace cgv {
 			virtual void resize(size_t nr_colors) = 0;
 			/// return a void pointer to the color data
 			virtual const void* get_data_ptr() const = 0;
+			/// return a void pointer to the writable color data
+			virtual void* ref_data_ptr() = 0;
 			/// return a void pointer to the color data vector
 			virtual const void* get_data_vector_ptr() const = 0;
 			/// set i-th color to color of type stored in storage
@@ -114,6 +116,7 @@ namespace cgv {
 			size_t get_nr_colors() const { return colors.size(); }
 			void resize(size_t nr_colors) { colors.resize(nr_colors); }
 			const void* get_data_ptr() const { return &colors.front(); }
+			void* ref_data_ptr() { return &colors.front(); }
 			const void* get_data_vector_ptr() const { return &colors; }
 			// implementation of color access uses type conversion operators implemented for color class
 			void set_color(size_t i, const void* col_ptr) { colors[i] = *reinterpret_cast<const C*>(col_ptr); }
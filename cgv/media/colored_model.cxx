@@ -107,6 +107,10 @@ namespace cgv {
 		{
 			return color_storage_ptr->get_data_ptr();
 		}
+		void* colored_model::ref_color_data_ptr()
+		{
+			return color_storage_ptr->ref_data_ptr();
+		}
 		const void* colored_model::get_color_data_vector_ptr() const
 		{
 			return color_storage_ptr->get_data_vector_ptr();
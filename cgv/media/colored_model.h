@@ -56,6 +56,8 @@ namespace cgv {
 			ColorType get_color_storage_type() const;
 
 			const void* get_color_data_ptr() const;
+			/// return writable pointer to color data, which must have been allocated before
+			void* ref_color_data_ptr();
 			const void* get_color_data_vector_ptr() const;
 
 			//! ensure that colors are allocated and of given storage type
@@ -7,6 +7,7 @@
 #include <cgv/math/mfunc.h>
 #include <cgv/media/axis_aligned_box.h>
 #include "streaming_mesh.h"
+#include "min_max_block_tree.h"
 
 namespace cgv {
 	namespace media {
@@ -28,6 +29,34 @@ namespace cgv {
 				bool operator () (const T& _value) const { return _value == reference_value; }
 			};
 
+			/// check whether the predicate has the same result for all values in [min_value, max_value] and return it in flag, which is unknown for general predicates
+			template <typename P, typename T>
+			bool get_constant_predicate_value(const P&, const T&, const T&, bool&) { return false; }
+
+			template <typename T>
+			bool get_constant_predicate_value(const greater_equal<T>& pred, const T& min_value, const T& max_value, bool& flag)
+			{
+				if (min_value >= pred.reference_value)
+					flag = true;
+				else if (max_value < pred.reference_value)
+					flag = false;
+				else
+					return false;
+				return true;
+			}
+
+			template <typename T>
+			bool get_constant_predicate_value(const equal<T>& pred, const T& min_value, const T& max_value, bool& flag)
+			{
+				if (min_value == max_value)
+					flag = min_value == pred.reference_value;
+				else if (min_value > pred.reference_value || max_value < pred.reference_value)
+					flag = false;
+				else
+					return false;
+				return true;
+			}
+
 
 /** data structure for the information that is cached per volume slice bz the cuberille algorithm */
 template <typename T, class P>
@@ -78,17 +107,35 @@ private:
 	unsigned int resx, resy, resz;
 	vec_type d;
 	const P& pred;
+	unsigned int slice_index;
 protected:
 	const cgv::math::v3_func<X,T>& func;
+	const min_max_block_tree<T>* block_tree;
+	/// evaluate predicate on voxel (i,j) of current slice, where voxels in blocks of constant predicate value are not evaluated
+	bool evaluate_predicate(unsigned i, unsigned j) const
+	{
+		if (block_tree && slice_index < resz) {
+			T min_value, max_value;
+			bool flag;
+			block_tree->get_range(i, j, slice_index, min_value, max_value);
+			if (get_constant_predicate_value(pred, min_value, max_value, flag))
+				return flag;
+		}
+		return pred(func.evaluate(p.to_vec()));
+	}
 public:
 	/// construct dual contouring object
 	cuberille(const cgv::math::v3_func<X,T>& _func,
 			  streaming_mesh_callback_handler* _smcbh, 
 		      const P& _pred) :
-	func(_func), pred(_pred)
+	func(_func), pred(_pred), block_tree(0)
 	{
 		base_type::set_callback_handler(_smcbh);
 	}
+	/** set tree over the function samples of the extraction grid, which allows to skip the function evaluations in blocks
+	    where the predicate is constant. The tree must be built for the resolution passed to extract. Pass 0 to evaluate
+		all voxels. */
+	void set_block_tree(const min_max_block_tree<T>* _block_tree) { block_tree = _block_tree; }
 	/// construct a quadrilateral
 	void generate_edge_quad(int vi, int vj, int vk, int vl, bool reorient)
 	{
@@ -107,7 +154,7 @@ public:
 		for (j = 0, p(1) = minp(1); j <= resy; ++j, p(1) += d(1)) {
 			for (i = 0, p(0) = minp(0); i <= resx; ++i, p(0) += d(0)) {
 				// set voxel flag
-				I[0]->set_flag(i, j, i < resx && j < resy && pred(func.evaluate(p.to_vec())));
+				I[0]->set_flag(i, j, i < resx && j < resy && evaluate_predicate(i, j));
 				// and check whether assigned vertex is needed
 				bool need_vertex = false;
 				need_vertex = need_vertex || (I[0]->flag(i, j) != I[1]->flag(i, j));     // z(x0,y0)
@@ -130,7 +177,7 @@ public:
 				}
 				// create vertex if necessary
 				if (need_vertex)
-					I[0]->set_index(i, j, new_vertex(p - T(0.5)*d));
+					I[0]->set_index(i, j, this->new_vertex(p - T(0.5)*d));
 			}
 		}
 		// iterate voxels again to create edge quads
@@ -165,6 +212,7 @@ public:
 		c_slice_info<T, P> slice_info_1(resx+1,resy+1), slice_info_2(resx+1,resy+1);
 		c_slice_info<T, P> *I[2] = { &slice_info_1, &slice_info_2 };
 		for (unsigned k=0; k<=resz; ++k, p(2) += d(2)) {
+			slice_index = k;
 			process_slice(I);
 			base_type::drop_vertices(I[1]->nr_vertices);
 			// show progression
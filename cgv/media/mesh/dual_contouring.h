@@ -7,6 +7,7 @@
 #include <cgv/math/mfunc.h>
 #include <cgv/media/axis_aligned_box.h>
 #include "streaming_mesh.h"
+#include "min_max_block_tree.h"
 
 namespace cgv {
 	namespace media {
@@ -97,21 +98,27 @@ private:
 	unsigned int resx, resy, resz;
 	vec_type d;
 	T iso_value;
+	unsigned int slice_index;
 protected:
 	const cgv::math::v3_func<X,T>& func;
 	X epsilon;
 	unsigned int max_nr_iters;
 	X consistency_threshold;
+	const min_max_block_tree<T>* block_tree;
 public:
 	/// construct dual contouring object
 	dual_contouring(const cgv::math::v3_func<X,T>& _func,
 				    streaming_mesh_callback_handler* _smcbh, 
 					const X& _consistency_threshold = 0.01f, unsigned int _max_nr_iters = 10,
 					const X& _epsilon = 1e-6f) :
-	func(_func), max_nr_iters(_max_nr_iters), consistency_threshold(_consistency_threshold), epsilon(_epsilon)
+	func(_func), max_nr_iters(_max_nr_iters), consistency_threshold(_consistency_threshold), epsilon(_epsilon), block_tree(0)
 	{
 		base_type::set_callback_handler(_smcbh);
 	}
+	/** set tree over the function samples of the extraction grid, which is used to skip function evaluations at samples
+	    that only lie in blocks without iso surface. The tree must be built for the resolution passed to extract and 
+		can be reused for different iso values. Pass 0 to evaluate all samples. */
+	void set_block_tree(const min_max_block_tree<T>* _block_tree) { block_tree = _block_tree; }
 	/// construct a new vertex on an edge
 	void compute_cell_vertex(dc_slice_info<T> *info_ptr, int i, int j)
 	{
@@ -220,8 +227,11 @@ public:
 		info_ptr->init();
 		for (j = 0, p(1) = minp(1); j < resy; ++j, p(1) += d(1))
 			for (i = 0, p(0) = minp(0); i < resx; ++i, p(0)+=d(0)) {
-				// eval function on slice
-				info_ptr->set_value(i,j,func.evaluate(p.to_vec()),iso_value);
+				// eval function on slice unless the sample lies only in blocks without iso surface
+				T v;
+				if (!block_tree || !block_tree->get_uniform_value(i, j, slice_index, iso_value, v))
+					v = func.evaluate(p.to_vec());
+				info_ptr->set_value(i,j,v,iso_value);
 				// process slice internal edges
 				if (i > 0 && info_ptr->flag(i-1,j) != info_ptr->flag(i,j))
 					process_edge_plane(info_ptr->value(i-1,j),
@@ -312,8 +322,10 @@ public:
 		unsigned int nr_vertices[4] = { 0, 0, 0, 0 };
 		unsigned int k, n;
 
+		slice_index = 0;
 		process_slice(0, slice_info_ptrs[0]);
 		p(2) += d(2);
+		slice_index = 1;
 		process_slice(slice_info_ptrs[0], slice_info_ptrs[1]);
 		process_slab(slice_info_ptrs[0], slice_info_ptrs[1]);
 		p(2) += d(2);
@@ -328,6 +340,7 @@ public:
 			dc_slice_info<T> *info_ptr_0 = slice_info_ptrs[(k-2)%3];
 			dc_slice_info<T> *info_ptr_1 = slice_info_ptrs[(k-1)%3];
 			dc_slice_info<T> *info_ptr_2 = slice_info_ptrs[k%3];
+			slice_index = k;
 			process_slice(info_ptr_1, info_ptr_2);
 			process_slab(info_ptr_1, info_ptr_2);
 			generate_slice_quads(info_ptr_0, info_ptr_1);
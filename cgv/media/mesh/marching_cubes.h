@@ -2,11 +2,17 @@
 
 #include <vector>
 #include <deque>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
 #include <cgv/utils/progression.h>
+#include <cgv/os/thread_pool.h>
 #include <cgv/math/fvec.h>
+#include <cgv/type/standard_types.h>
 #include <cgv/math/mfunc.h>
 #include <cgv/media/axis_aligned_box.h>
 #include <cgv/media/mesh/streaming_mesh.h>
+#include <cgv/media/mesh/min_max_block_tree.h>
 
 #include <cgv/media/lib_begin.h>
 
@@ -225,12 +231,459 @@ public:
 				base_type::drop_vertices(n);
 		}
 	}
+	/** extract iso surface in parallel and write vertex locations and triangle vertex indices to the given vectors.
+	    The volume is split into z-slabs that are processed by nr_threads tasks in the shared thread pool (0 ... use concurrency of the pool),
+		where each slab evaluates its slices, creates the vertices on the edges owned by its slices and collects the
+		triangles of its cell layers. Vertices on the first slice of the next slab are referenced by keys that are
+		welded when the slab results are copied to the output buffers, which are allocated once. The result does not
+		depend on the number of threads and eval and valid need to be callable concurrently. */
+	template <typename Eval, typename Valid>
+	void extract_parallel_impl(const T& _iso_value,
+		const axis_aligned_box<X, 3>& box,
+		unsigned int resx, unsigned int resy, unsigned int resz,
+		const Eval& eval, const Valid& valid,
+		std::vector<pnt_type>& positions, std::vector<unsigned int>& triangles,
+		unsigned int nr_threads = 0)
+	{
+		positions.clear();
+		triangles.clear();
+		if (resx < 2 || resy < 2 || resz < 2)
+			return;
+		const unsigned int none = (unsigned int)-1, foreign = 0x80000000u;
+		const pnt_type p0 = box.get_min_pnt();
+		vec_type delta = box.get_extent();
+		delta(0) /= (resx - 1); delta(1) /= (resy - 1); delta(2) /= (resz - 1);
+		const T iso = _iso_value;
+		const size_t n = size_t(resx)*resy;
+
+		if (nr_threads == 0)
+			nr_threads = cgv::os::get_thread_pool().get_concurrency();
+		unsigned int nr_slabs = std::min(resz, std::max(1u, std::min(2 * nr_threads, resz / 8)));
+		nr_threads = std::min(nr_threads, nr_slabs);
+
+		/// per slice vertex indices of the x-, y- and z-edges starting at a grid point and of the snap vertex at the point
+		struct slice_table
+		{
+			std::vector<unsigned int> x, y, z, snap;
+		};
+		/// vertices and triangles of a slab together with the vertex indices of its first slice
+		struct slab_result
+		{
+			std::vector<pnt_type> P;
+			std::vector<unsigned int> triangles;
+			slice_table first;
+		};
+		std::vector<slab_result> results(nr_slabs);
+
+		auto process_slab = [&](unsigned int s) {
+			slab_result& R = results[s];
+			unsigned int k0 = unsigned(size_t(s)*resz / nr_slabs), k1 = unsigned(size_t(s + 1)*resz / nr_slabs);
+			unsigned int k_end = k1 < resz ? k1 : resz - 1;
+			// ring of slice values and flags, where bit 0 tells whether the value is inside and bit 1 whether it is valid
+			std::vector<T> V[3];
+			std::vector<unsigned char> F[3];
+			slice_table tables[2];
+			std::vector<unsigned char> codes(resx);
+			auto evaluate_slice = [&](unsigned int k) {
+				std::vector<T>& Vk = V[k % 3];
+				std::vector<unsigned char>& Fk = F[k % 3];
+				Vk.resize(n);
+				Fk.resize(n);
+				pnt_type p;
+				p(2) = p0(2) + k*delta(2);
+				size_t pi = 0;
+				for (unsigned int j = 0; j < resy; ++j) {
+					p(1) = p0(1) + j*delta(1);
+					for (unsigned int i = 0; i < resx; ++i, ++pi) {
+						p(0) = p0(0) + i*delta(0);
+						T v = eval(i, j, k, p);
+						Vk[pi] = v;
+						Fk[pi] = (v > iso ? 1 : 0) | (valid(v) ? 2 : 0);
+					}
+				}
+			};
+			auto crossing = [](unsigned char fa, unsigned char fb) {
+				return (fa & fb & 2) != 0 && ((fa ^ fb) & 1) != 0;
+			};
+			auto fraction = [&](const T& va, const T& vb) {
+				return (fabs(vb - va) > epsilon) ? (X)(iso - va) / (vb - va) : (X)0.5;
+			};
+			auto grid_point = [&](unsigned int i, unsigned int j, unsigned int k) {
+				return pnt_type(p0(0) + i*delta(0), p0(1) + j*delta(1), p0(2) + k*delta(2));
+			};
+			// create vertex of own slice or return key of vertex owned by next slab
+			auto new_vertex = [&](bool own, size_t key, const pnt_type& q) {
+				if (!own)
+					return foreign | unsigned(key);
+				R.P.push_back(q);
+				return unsigned(R.P.size() - 1);
+			};
+			// compute snap vertices and vertices on x- and y-edges of slice k
+			auto build_table = [&](unsigned int k, slice_table& S, bool own) {
+				const std::vector<T>& Vk = V[k % 3];
+				const std::vector<unsigned char>& Fk = F[k % 3];
+				S.x.assign(n, none);
+				S.y.assign(n, none);
+				S.z.assign(n, none);
+				S.snap.assign(n, none);
+				auto near_start = [&](const T& va, unsigned char fa, const T& vb, unsigned char fb) {
+					return crossing(fa, fb) && fraction(va, vb) < grid_epsilon;
+				};
+				auto near_end = [&](const T& va, unsigned char fa, const T& vb, unsigned char fb) {
+					if (!crossing(fa, fb))
+						return false;
+					X f = fraction(va, vb);
+					return !(f < grid_epsilon) && 1 - f < grid_epsilon;
+				};
+				size_t pi = 0;
+				for (unsigned int j = 0; j < resy; ++j) {
+					for (unsigned int i = 0; i < resx; ++i, ++pi) {
+						const T& v = Vk[pi];
+						unsigned char f = Fk[pi];
+						if ((i > 0 && near_end(Vk[pi - 1], Fk[pi - 1], v, f)) ||
+							(i + 1 < resx && near_start(v, f, Vk[pi + 1], Fk[pi + 1])) ||
+							(j > 0 && near_end(Vk[pi - resx], Fk[pi - resx], v, f)) ||
+							(j + 1 < resy && near_start(v, f, Vk[pi + resx], Fk[pi + resx])) ||
+							(k > 0 && near_end(V[(k - 1) % 3][pi], F[(k - 1) % 3][pi], v, f)) ||
+							(k + 1 < resz && near_start(v, f, V[(k + 1) % 3][pi], F[(k + 1) % 3][pi])))
+							S.snap[pi] = new_vertex(own, 3 * pi + 2, grid_point(i, j, k));
+					}
+				}
+				pi = 0;
+				for (unsigned int j = 0; j < resy; ++j) {
+					for (unsigned int i = 0; i < resx; ++i, ++pi) {
+						for (int e = 0; e < 2; ++e) {
+							size_t pj = pi + (e == 0 ? 1 : resx);
+							if ((e == 0 ? i + 1 : j + 1) >= (e == 0 ? resx : resy) || !crossing(Fk[pi], Fk[pj]))
+								continue;
+							X f = fraction(Vk[pi], Vk[pj]);
+							unsigned int vi;
+							if (f < grid_epsilon)
+								vi = S.snap[pi];
+							else if (1 - f < grid_epsilon)
+								vi = S.snap[pj];
+							else {
+								pnt_type q = grid_point(e == 0 ? i + 1 : i, e == 0 ? j : j + 1, k);
+								q(e) -= (1 - f)*delta(e);
+								vi = new_vertex(own, 3 * pi + e, q);
+							}
+							(e == 0 ? S.x : S.y)[pi] = vi;
+						}
+					}
+				}
+			};
+			// compute vertices on z-edges between slices k-1 and k
+			auto build_z_edges = [&](unsigned int k, slice_table& A, const slice_table& B) {
+				const std::vector<T>& Va = V[(k - 1) % 3];
+				const std::vector<T>& Vb = V[k % 3];
+				const std::vector<unsigned char>& Fa = F[(k - 1) % 3];
+				const std::vector<unsigned char>& Fb = F[k % 3];
+				size_t pi = 0;
+				for (unsigned int j = 0; j < resy; ++j) {
+					for (unsigned int i = 0; i < resx; ++i, ++pi) {
+						if (!crossing(Fa[pi], Fb[pi]))
+							continue;
+						X f = fraction(Va[pi], Vb[pi]);
+						if (f < grid_epsilon)
+							A.z[pi] = A.snap[pi];
+						else if (1 - f < grid_epsilon)
+							A.z[pi] = B.snap[pi];
+						else {
+							pnt_type q = grid_point(i, j, k);
+							q(2) -= (1 - f)*delta(2);
+							A.z[pi] = new_vertex(true, 0, q);
+						}
+					}
+				}
+			};
+			// construct triangles of cell layer between slices k-1 and k
+			auto build_triangles = [&](unsigned int k, const slice_table& A, const slice_table& B) {
+				const unsigned char* Fa = &F[(k - 1) % 3][0];
+				const unsigned char* Fb = &F[k % 3][0];
+				for (unsigned int j = 0; j + 1 < resy; ++j) {
+					const unsigned char* a = Fa + size_t(j)*resx;
+					const unsigned char* b = Fb + size_t(j)*resx;
+					// classify all cells of a row in a loop that the compiler vectorizes
+					for (unsigned int i = 0; i + 1 < resx; ++i)
+						codes[i] = (unsigned char)(
+							(a[i] & 1) | ((a[i + 1] & 1) << 1) | ((a[i + resx + 1] & 1) << 2) | ((a[i + resx] & 1) << 3) |
+							((b[i] & 1) << 4) | ((b[i + 1] & 1) << 5) | ((b[i + resx + 1] & 1) << 6) | ((b[i + resx] & 1) << 7));
+					for (unsigned int i = 0; i + 1 < resx; ++i) {
+						int idx = codes[i];
+						if (idx == 0 || idx == 255)
+							continue;
+						size_t pi = size_t(j)*resx + i;
+						unsigned int vis[12] = {
+							A.x[pi], A.y[pi + 1], A.x[pi + resx], A.y[pi],
+							B.x[pi], B.y[pi + 1], B.x[pi + resx], B.y[pi],
+							A.z[pi], A.z[pi + 1], A.z[pi + resx], A.z[pi + resx + 1]
+						};
+						int nt = get_nr_cube_triangles(idx);
+						for (int t = 0; t < nt; ++t) {
+							int vi, vj, vk;
+							put_cube_triangle(idx, t, vi, vj, vk);
+							unsigned int ui = vis[vi], uj = vis[vj], uk = vis[vk];
+							if (ui == none || uj == none || uk == none)
+								continue;
+							if (ui != uj && ui != uk && uj != uk) {
+								R.triangles.push_back(uk);
+								R.triangles.push_back(uj);
+								R.triangles.push_back(ui);
+							}
+						}
+					}
+				}
+			};
+			// slices k0-1 and k0 are needed to build the table of slice k0
+			if (k0 > 0)
+				evaluate_slice(k0 - 1);
+			evaluate_slice(k0);
+			for (unsigned int k = k0; k <= k_end; ++k) {
+				if (k + 1 < resz)
+					evaluate_slice(k + 1);
+				slice_table& B = tables[k & 1];
+				build_table(k, B, k < k1);
+				if (k == k0) {
+					R.first.x = B.x;
+					R.first.y = B.y;
+					R.first.snap = B.snap;
+				}
+				else {
+					slice_table& A = tables[(k - 1) & 1];
+					build_z_edges(k, A, B);
+					build_triangles(k, A, B);
+				}
+			}
+		};
+
+		// process slabs in parallel
+		std::atomic<unsigned int> next_slab(0);
+		auto worker = [&]() {
+			unsigned int s;
+			while ((s = next_slab.fetch_add(1)) < nr_slabs)
+				process_slab(s);
+		};
+		cgv::os::get_thread_pool().parallel_for(0, nr_threads, [&](size_t) { worker(); }, 1);
+
+		// allocate output buffers and weld vertices referenced across slab borders
+		std::vector<size_t> vertex_offsets(nr_slabs + 1, 0), triangle_offsets(nr_slabs + 1, 0);
+		for (unsigned int s = 0; s < nr_slabs; ++s) {
+			vertex_offsets[s + 1] = vertex_offsets[s] + results[s].P.size();
+			triangle_offsets[s + 1] = triangle_offsets[s] + results[s].triangles.size();
+		}
+		positions.resize(vertex_offsets[nr_slabs]);
+		triangles.resize(triangle_offsets[nr_slabs]);
+		next_slab = 0;
+		auto copy_worker = [&]() {
+			unsigned int s;
+			while ((s = next_slab.fetch_add(1)) < nr_slabs) {
+				slab_result& R = results[s];
+				std::copy(R.P.begin(), R.P.end(), positions.begin() + vertex_offsets[s]);
+				unsigned int* T_ptr = &triangles[0] + triangle_offsets[s];
+				for (unsigned int vi : R.triangles) {
+					if (vi & foreign) {
+						size_t key = vi & ~foreign;
+						const slice_table& S = results[s + 1].first;
+						const std::vector<unsigned int>& indices = key % 3 == 0 ? S.x : (key % 3 == 1 ? S.y : S.snap);
+						*T_ptr++ = unsigned(vertex_offsets[s + 1] + indices[key / 3]);
+					}
+					else
+						*T_ptr++ = unsigned(vertex_offsets[s] + vi);
+				}
+				std::vector<pnt_type>().swap(R.P);
+				std::vector<unsigned int>().swap(R.triangles);
+			}
+		};
+		cgv::os::get_thread_pool().parallel_for(0, nr_threads, [&](size_t) { copy_worker(); }, 1);
+	}
+	/** extract iso surface only in the blocks of a min_max_block_tree that are active for the iso value and write the
+	    vertex locations and triangle vertex indices to the given vectors. The tree needs to be built over the same
+		sample grid. Active blocks are processed by nr_threads tasks in the shared thread pool (0 ... use concurrency of the pool) and vertices on
+		block borders are welded by the grid edge or grid point they belong to, such that the result matches the one of
+		extract_parallel_impl up to the vertex order. Only samples of active blocks are evaluated. */
+	template <typename Eval, typename Valid>
+	void extract_sparse_impl(const T& _iso_value,
+		const axis_aligned_box<X, 3>& box,
+		unsigned int resx, unsigned int resy, unsigned int resz,
+		const min_max_block_tree<T>& tree,
+		const Eval& eval, const Valid& valid,
+		std::vector<pnt_type>& positions, std::vector<unsigned int>& triangles,
+		unsigned int nr_threads = 0)
+	{
+		positions.clear();
+		triangles.clear();
+		if (resx < 2 || resy < 2 || resz < 2 || tree.empty() ||
+			tree.get_resx() != resx || tree.get_resy() != resy || tree.get_resz() != resz)
+			return;
+		std::vector<size_t> blocks;
+		tree.collect_active_blocks(_iso_value, blocks);
+		if (blocks.empty())
+			return;
+		const unsigned int none = (unsigned int)-1;
+		const cgv::type::uint64_type no_key = (cgv::type::uint64_type)-1;
+		const pnt_type p0 = box.get_min_pnt();
+		vec_type delta = box.get_extent();
+		delta(0) /= (resx - 1); delta(1) /= (resy - 1); delta(2) /= (resz - 1);
+		const T iso = _iso_value;
+		const unsigned int B = tree.get_block_size(), m = B + 1;
+		const size_t strides[3] = { 1, m, size_t(m)*m };
+
+		if (nr_threads == 0)
+			nr_threads = cgv::os::get_thread_pool().get_concurrency();
+		nr_threads = unsigned(std::min(size_t(nr_threads), blocks.size()));
+
+		/// vertices and triangles of a block, where vertices on the block border store the key of their grid edge or point
+		struct block_result
+		{
+			std::vector<pnt_type> P;
+			std::vector<cgv::type::uint64_type> keys;
+			std::vector<unsigned int> triangles;
+		};
+		std::vector<block_result> results(blocks.size());
+
+		std::atomic<size_t> next_block(0);
+		auto worker = [&]() {
+			// per thread sample values, flags with bit 0 for inside and bit 1 for valid, and vertex indices of the x-, y-
+			// and z-edges starting at a sample and of the snap vertex at the sample
+			std::vector<T> V(size_t(m)*m*m);
+			std::vector<unsigned char> F(V.size());
+			std::vector<unsigned int> indices(4 * V.size());
+			size_t b;
+			while ((b = next_block.fetch_add(1)) < blocks.size()) {
+				block_result& R = results[b];
+				unsigned int bx, by, bz;
+				tree.get_block_coordinates(blocks[b], bx, by, bz);
+				const unsigned int i0 = bx*B, j0 = by*B, k0 = bz*B;
+				const unsigned int n[3] = { std::min(B, resx - 1 - i0) + 1, std::min(B, resy - 1 - j0) + 1, std::min(B, resz - 1 - k0) + 1 };
+				auto grid_point = [&](unsigned int li, unsigned int lj, unsigned int lk) {
+					return pnt_type(p0(0) + (i0 + li)*delta(0), p0(1) + (j0 + lj)*delta(1), p0(2) + (k0 + lk)*delta(2));
+				};
+				auto grid_index = [&](unsigned int li, unsigned int lj, unsigned int lk) {
+					return (cgv::type::uint64_type(k0 + lk)*resy + j0 + lj)*resx + i0 + li;
+				};
+				for (unsigned int lk = 0; lk < n[2]; ++lk)
+					for (unsigned int lj = 0; lj < n[1]; ++lj)
+						for (unsigned int li = 0; li < n[0]; ++li) {
+							size_t l = lk*strides[2] + lj*strides[1] + li;
+							T v = eval(i0 + li, j0 + lj, k0 + lk, grid_point(li, lj, lk));
+							V[l] = v;
+							F[l] = (v > iso ? 1 : 0) | (valid(v) ? 2 : 0);
+						}
+				std::fill(indices.begin(), indices.end(), none);
+				// create vertex with key if it is shared with neighboring blocks
+				auto new_vertex = [&](const pnt_type& q, bool shared, cgv::type::uint64_type key) {
+					R.P.push_back(q);
+					R.keys.push_back(shared ? key : no_key);
+					return unsigned(R.P.size() - 1);
+				};
+				auto snap_vertex = [&](const unsigned int* lc) {
+					unsigned int& vi = indices[4 * (lc[2] * strides[2] + lc[1] * strides[1] + lc[0]) + 3];
+					if (vi == none) {
+						bool shared = false;
+						for (int c = 0; c < 3; ++c)
+							shared = shared || lc[c] == 0 || lc[c] + 1 == n[c];
+						vi = new_vertex(grid_point(lc[0], lc[1], lc[2]), shared, 4 * grid_index(lc[0], lc[1], lc[2]) + 3);
+					}
+					return vi;
+				};
+				auto edge_vertex = [&](unsigned int li, unsigned int lj, unsigned int lk, int e) {
+					size_t la = lk*strides[2] + lj*strides[1] + li, lb = la + strides[e];
+					unsigned int& vi = indices[4 * la + e];
+					if (vi != none || (F[la] & F[lb] & 2) == 0 || ((F[la] ^ F[lb]) & 1) == 0)
+						return vi;
+					X f = (fabs(V[lb] - V[la]) > epsilon) ? (X)(iso - V[la]) / (V[lb] - V[la]) : (X)0.5;
+					unsigned int lc[3] = { li, lj, lk };
+					if (f < grid_epsilon)
+						vi = snap_vertex(lc);
+					else {
+						++lc[e];
+						if (1 - f < grid_epsilon)
+							vi = snap_vertex(lc);
+						else {
+							pnt_type q = grid_point(lc[0], lc[1], lc[2]);
+							q(e) -= (1 - f)*delta(e);
+							bool shared = false;
+							for (int c = 0; c < 3; ++c)
+								shared = shared || (c != e && (lc[c] == 0 || lc[c] + 1 == n[c]));
+							vi = new_vertex(q, shared, 4 * grid_index(li, lj, lk) + e);
+						}
+					}
+					return vi;
+				};
+				// construct triangles with the same cube and edge numbering as extract_impl
+				for (unsigned int lk = 0; lk + 1 < n[2]; ++lk)
+					for (unsigned int lj = 0; lj + 1 < n[1]; ++lj)
+						for (unsigned int li = 0; li + 1 < n[0]; ++li) {
+							const unsigned char* a = &F[lk*strides[2] + lj*strides[1] + li];
+							const unsigned char* c = a + strides[2];
+							int idx =
+								(a[0] & 1) | ((a[1] & 1) << 1) | ((a[m + 1] & 1) << 2) | ((a[m] & 1) << 3) |
+								((c[0] & 1) << 4) | ((c[1] & 1) << 5) | ((c[m + 1] & 1) << 6) | ((c[m] & 1) << 7);
+							if (idx == 0 || idx == 255)
+								continue;
+							unsigned int vis[12] = {
+								edge_vertex(li, lj, lk, 0), edge_vertex(li + 1, lj, lk, 1),
+								edge_vertex(li, lj + 1, lk, 0), edge_vertex(li, lj, lk, 1),
+								edge_vertex(li, lj, lk + 1, 0), edge_vertex(li + 1, lj, lk + 1, 1),
+								edge_vertex(li, lj + 1, lk + 1, 0), edge_vertex(li, lj, lk + 1, 1),
+								edge_vertex(li, lj, lk, 2), edge_vertex(li + 1, lj, lk, 2),
+								edge_vertex(li, lj + 1, lk, 2), edge_vertex(li + 1, lj + 1, lk, 2)
+							};
+							int nt = get_nr_cube_triangles(idx);
+							for (int t = 0; t < nt; ++t) {
+								int vi, vj, vk;
+								put_cube_triangle(idx, t, vi, vj, vk);
+								unsigned int ui = vis[vi], uj = vis[vj], uk = vis[vk];
+								if (ui == none || uj == none || uk == none)
+									continue;
+								if (ui != uj && ui != uk && uj != uk) {
+									R.triangles.push_back(uk);
+									R.triangles.push_back(uj);
+									R.triangles.push_back(ui);
+								}
+							}
+						}
+			}
+		};
+		cgv::os::get_thread_pool().parallel_for(0, nr_threads, [&](size_t) { worker(); }, 1);
+
+		// concatenate block results in block order and weld shared vertices
+		size_t nr_vertices = 0, nr_indices = 0;
+		for (const auto& R : results) {
+			nr_vertices += R.P.size();
+			nr_indices += R.triangles.size();
+		}
+		positions.reserve(nr_vertices);
+		triangles.reserve(nr_indices);
+		std::unordered_map<cgv::type::uint64_type, unsigned int> shared_vertices;
+		std::vector<unsigned int> vertex_map;
+		for (auto& R : results) {
+			vertex_map.resize(R.P.size());
+			for (size_t vi = 0; vi < R.P.size(); ++vi) {
+				if (R.keys[vi] != no_key) {
+					auto iter = shared_vertices.find(R.keys[vi]);
+					if (iter != shared_vertices.end()) {
+						vertex_map[vi] = iter->second;
+						continue;
+					}
+					shared_vertices[R.keys[vi]] = unsigned(positions.size());
+				}
+				vertex_map[vi] = unsigned(positions.size());
+				positions.push_back(R.P[vi]);
+			}
+			for (unsigned int vi : R.triangles)
+				triangles.push_back(vertex_map[vi]);
+			std::vector<pnt_type>().swap(R.P);
+			std::vector<cgv::type::uint64_type>().swap(R.keys);
+			std::vector<unsigned int>().swap(R.triangles);
+		}
+	}
 };
 
 template <typename T>
 struct always_valid
 {
-	bool operator () (const T& v) const { return true; }
+	bool operator () (const T&) const { return true; }
 };
 
 #include <limits>
@@ -268,7 +721,7 @@ public:
 		const X& _epsilon = 1e-6f) : marching_cubes_base<X, T>(_smcbh, _grid_epsilon, _epsilon), func(_func)
 	{
 	}
-	T operator () (unsigned i, unsigned j, unsigned k, const pnt_type& p) const {
+	T operator () (unsigned, unsigned, unsigned, const pnt_type& p) const {
 		return func.evaluate(p.to_vec());
 	}
 	void extract(const T& _iso_value,
@@ -279,6 +732,39 @@ public:
 		always_valid<T> valid;
 		this->extract_impl(_iso_value, box, resx, resy, resz, *this, valid, show_progress);
 	}
+	/// extract iso surface in parallel into vertex location and triangle index vectors, where func needs to be thread safe
+	void extract_parallel(const T& _iso_value,
+		const axis_aligned_box<X, 3>& box,
+		unsigned int resx, unsigned int resy, unsigned int resz,
+		std::vector<pnt_type>& positions, std::vector<unsigned int>& triangles,
+		unsigned int nr_threads = 0)
+	{
+		always_valid<T> valid;
+		this->extract_parallel_impl(_iso_value, box, resx, resy, resz, *this, valid, positions, triangles, nr_threads);
+	}
+	/// build a min_max_block_tree over the samples of func on the given grid, where func needs to be thread safe
+	void build_block_tree(const axis_aligned_box<X, 3>& box,
+		unsigned int resx, unsigned int resy, unsigned int resz,
+		min_max_block_tree<T>& tree, unsigned int block_size = 8, unsigned int nr_threads = 0) const
+	{
+		pnt_type p0 = box.get_min_pnt();
+		vec_type delta = box.get_extent();
+		delta(0) /= (resx - 1); delta(1) /= (resy - 1); delta(2) /= (resz - 1);
+		tree.build(resx, resy, resz, [&](unsigned i, unsigned j, unsigned k) {
+			return func.evaluate(pnt_type(p0(0) + i*delta(0), p0(1) + j*delta(1), p0(2) + k*delta(2)).to_vec());
+		}, block_size, nr_threads);
+	}
+	/// extract iso surface only in the active blocks of a tree built with build_block_tree for the same grid
+	void extract_sparse(const T& _iso_value,
+		const axis_aligned_box<X, 3>& box,
+		unsigned int resx, unsigned int resy, unsigned int resz,
+		const min_max_block_tree<T>& tree,
+		std::vector<pnt_type>& positions, std::vector<unsigned int>& triangles,
+		unsigned int nr_threads = 0)
+	{
+		always_valid<T> valid;
+		this->extract_sparse_impl(_iso_value, box, resx, resy, resz, tree, *this, valid, positions, triangles, nr_threads);
+	}
 };
 
 		}
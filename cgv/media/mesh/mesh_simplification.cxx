@@ -0,0 +1,653 @@
+#include "simple_mesh.h"
+#include <cgv/data/dynamic_priority_queue.h>
+#include <cgv/os/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace cgv {
+	namespace media {
+		namespace mesh {
+
+namespace {
+
+typedef cgv::type::uint32_type idx_type;
+typedef cgv::math::fvec<float, 3> vec3f;
+const idx_type no_index = idx_type(-1);
+const float infinite_cost = std::numeric_limits<float>::infinity();
+
+/// symmetric quadric in the packed layout of cgv::math::qem, i.e. scalar part, vector part and upper triangle of the
+/// matrix part, with fixed size such that quadrics of all vertices are stored in one flat array. Each quadric is
+/// relative to the position of its vertex, which keeps the vector and scalar parts small and the evaluation precise.
+struct quadric
+{
+	float c[10];
+	void zeros() { std::fill(c, c + 10, 0.0f); }
+	/// add plane with unit normal n and distance d to the origin with weight w
+	void add_plane(const vec3f& n, float d, float w)
+	{
+		c[0] += w * d * d;
+		c[1] += w * d * n(0); c[2] += w * d * n(1); c[3] += w * d * n(2);
+		c[4] += w * n(0) * n(0); c[5] += w * n(0) * n(1); c[6] += w * n(0) * n(2);
+		c[7] += w * n(1) * n(1); c[8] += w * n(1) * n(2);
+		c[9] += w * n(2) * n(2);
+	}
+	quadric& operator += (const quadric& q) { for (int i = 0; i < 10; ++i) c[i] += q.c[i]; return *this; }
+	/// evaluate the quadric error at the given location
+	double evaluate(const vec3f& p) const
+	{
+		double x = p(0), y = p(1), z = p(2);
+		return c[4] * x * x + c[7] * y * y + c[9] * z * z + 2 * (c[5] * x * y + c[6] * x * z + c[8] * y * z + c[1] * x + c[2] * y + c[3] * z) + c[0];
+	}
+	/// return quadric relative to an origin that is translated by t
+	quadric translated(const vec3f& t) const
+	{
+		quadric q = *this;
+		q.c[0] = float(evaluate(t));
+		q.c[1] += c[4] * t(0) + c[5] * t(1) + c[6] * t(2);
+		q.c[2] += c[5] * t(0) + c[7] * t(1) + c[8] * t(2);
+		q.c[3] += c[6] * t(0) + c[8] * t(1) + c[9] * t(2);
+		return q;
+	}
+	/// compute location of minimal error on the edge from p0 to p1, where the global minimum is used if it is well defined and close to the edge
+	vec3f minarg(const vec3f& p0, const vec3f& p1) const
+	{
+		double a00 = c[4], a01 = c[5], a02 = c[6], a11 = c[7], a12 = c[8], a22 = c[9];
+		double i00 = a11 * a22 - a12 * a12, i01 = a02 * a12 - a01 * a22, i02 = a01 * a12 - a02 * a11;
+		double det = a00 * i00 + a01 * i01 + a02 * i02;
+		double trace = a00 + a11 + a22;
+		if (std::abs(det) > 1e-6 * trace * trace * trace) {
+			double i11 = a00 * a22 - a02 * a02, i12 = a01 * a02 - a00 * a12, i22 = a00 * a11 - a01 * a01;
+			vec3f p(float(-(i00 * c[1] + i01 * c[2] + i02 * c[3]) / det),
+				   float(-(i01 * c[1] + i11 * c[2] + i12 * c[3]) / det),
+				   float(-(i02 * c[1] + i12 * c[2] + i22 * c[3]) / det));
+			if ((p - 0.5f * (p0 + p1)).sqr_length() <= (p1 - p0).sqr_length())
+				return p;
+		}
+		// minimize the quadratic polynomial along the edge
+		vec3f d = p1 - p0;
+		double Ad[3] = { a00 * d(0) + a01 * d(1) + a02 * d(2), a01 * d(0) + a11 * d(1) + a12 * d(2), a02 * d(0) + a12 * d(1) + a22 * d(2) };
+		double a = Ad[0] * d(0) + Ad[1] * d(1) + Ad[2] * d(2);
+		double b = Ad[0] * p0(0) + Ad[1] * p0(1) + Ad[2] * p0(2) + c[1] * d(0) + c[2] * d(1) + c[3] * d(2);
+		float t = a > 0 ? float(std::min(std::max(-b / a, 0.0), 1.0)) : 0.5f;
+		return p0 + t * d;
+	}
+};
+
+/// vertex state flags
+enum VertexState
+{
+	VS_LOCKED = 1,
+	VS_REMOVED = 2,
+	VS_MOVED = 4
+};
+
+/// flat arrays of the triangle mesh shared by all regions, where each region only writes to the vertices that it owns
+/// and to their triangles
+struct simplification_state
+{
+	/// positions normalized to a bounding box diagonal of one
+	std::vector<vec3f> P;
+	/// per vertex quadric
+	std::vector<quadric> Q;
+	/// per vertex combination of VertexState flags
+	std::vector<cgv::type::uint8_type> vertex_states;
+	/// vertices that have been collapsed into each other form circular lists
+	std::vector<idx_type> merged_vertices;
+	/// per vertex best collapse target and position
+	std::vector<idx_type> targets;
+	std::vector<vec3f> target_positions;
+	/// per vertex index in the priority queue of its region
+	std::vector<idx_type> local_indices;
+	/// three vertices, three attribute corners of the input mesh and one alive flag per triangle
+	std::vector<idx_type> T, A;
+	std::vector<cgv::type::uint8_type> triangle_alive;
+	/// per vertex triangles of the input
+	std::vector<idx_type> adjacency_begins, adjacency;
+	/// attribute index vectors of input corners, where two corners have the same attributes if all of them agree
+	std::vector<const std::vector<idx_type>*> attribute_indices;
+
+	bool same_attributes(idx_type c0, idx_type c1) const
+	{
+		if (c0 == c1)
+			return true;
+		for (auto ai : attribute_indices)
+			if ((*ai)[c0] != (*ai)[c1])
+				return false;
+		return true;
+	}
+	/// append the triangles of the current vertex v, which include the triangles of all vertices merged into it
+	void gather_triangles(idx_type v, std::vector<idx_type>& triangles) const
+	{
+		triangles.clear();
+		idx_type w = v;
+		do {
+			for (idx_type ai = adjacency_begins[w]; ai < adjacency_begins[w + 1]; ++ai)
+				if (triangle_alive[adjacency[ai]])
+					triangles.push_back(adjacency[ai]);
+			w = merged_vertices[w];
+		} while (w != v);
+	}
+	/// append the vertices of the given triangles except for v and u in ascending order without duplicates
+	void gather_neighbors(const std::vector<idx_type>& triangles, idx_type v, idx_type u, std::vector<idx_type>& neighbors) const
+	{
+		neighbors.clear();
+		for (idx_type t : triangles)
+			for (int k = 0; k < 3; ++k)
+				if (T[3 * t + k] != v && T[3 * t + k] != u)
+					neighbors.push_back(T[3 * t + k]);
+		std::sort(neighbors.begin(), neighbors.end());
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+	}
+	int corner_of(idx_type t, idx_type v) const { return T[3 * t] == v ? 0 : (T[3 * t + 1] == v ? 1 : (T[3 * t + 2] == v ? 2 : -1)); }
+	vec3f triangle_normal(idx_type t, idx_type moved, const vec3f& p) const
+	{
+		const vec3f& p0 = T[3 * t] == moved ? p : P[T[3 * t]];
+		const vec3f& p1 = T[3 * t + 1] == moved ? p : P[T[3 * t + 1]];
+		const vec3f& p2 = T[3 * t + 2] == moved ? p : P[T[3 * t + 2]];
+		return cross(p1 - p0, p2 - p0);
+	}
+};
+
+/// priority of a vertex in the queue is the cost of its best collapse
+struct collapse_cost
+{
+	float cost;
+	bool operator < (const collapse_cost& cc) const { return cost < cc.cost; }
+};
+
+/// simplifies the triangles of a set of vertices by collapsing each vertex into one of its neighbors in the order of increasing quadric error
+class region_simplifier
+{
+	simplification_state& S;
+	/// vertices of the region
+	const std::vector<idx_type>& vertices;
+	cgv::data::dynamic_priority_queue<collapse_cost> queue;
+	/// scratch vectors for triangles of the removed and the kept vertex and their neighbors
+	std::vector<idx_type> triangles_v, triangles_u, neighbors_v, neighbors_u, candidate_triangles, candidate_neighbors;
+	/// attribute corners of v and u in the triangles that are removed by the collapse
+	std::vector<std::pair<idx_type, idx_type> > attribute_map;
+	/// check whether collapse of v into u at location p keeps the mesh manifold, does not flip triangles and keeps
+	/// attribute seams, and fill triangles_v and attribute_map for the collapse
+	bool is_valid(idx_type v, idx_type u, const vec3f& p)
+	{
+		S.gather_triangles(v, triangles_v);
+		S.gather_triangles(u, triangles_u);
+		attribute_map.clear();
+		size_t nr_opposite = 0;
+		for (idx_type t : triangles_v) {
+			int ku = S.corner_of(t, u);
+			if (ku == -1)
+				continue;
+			attribute_map.push_back(std::make_pair(S.A[3 * t + S.corner_of(t, v)], S.A[3 * t + ku]));
+			++nr_opposite;
+		}
+		if (nr_opposite == 0)
+			return false;
+		// link condition: the common neighbors of v and u are the vertices opposite to the collapsed edge
+		S.gather_neighbors(triangles_v, v, u, neighbors_v);
+		S.gather_neighbors(triangles_u, v, u, neighbors_u);
+		size_t nr_common = 0;
+		for (size_t i = 0, j = 0; i < neighbors_v.size() && j < neighbors_u.size(); ) {
+			if (neighbors_v[i] < neighbors_u[j])
+				++i;
+			else if (neighbors_u[j] < neighbors_v[i])
+				++j;
+			else {
+				++nr_common;
+				++i;
+				++j;
+			}
+		}
+		if (nr_common != nr_opposite)
+			return false;
+		// attributes of v must map consistently to attributes of u
+		for (size_t i = 0; i < attribute_map.size(); ++i)
+			for (size_t j = i + 1; j < attribute_map.size(); ++j)
+				if (S.same_attributes(attribute_map[i].first, attribute_map[j].first) &&
+					!S.same_attributes(attribute_map[i].second, attribute_map[j].second))
+					return false;
+		for (idx_type t : triangles_v) {
+			if (S.corner_of(t, u) != -1)
+				continue;
+			idx_type av = S.A[3 * t + S.corner_of(t, v)];
+			bool found = false;
+			for (const auto& am : attribute_map)
+				if (S.same_attributes(av, am.first)) {
+					found = true;
+					break;
+				}
+			if (!found)
+				return false;
+			if (dot(S.triangle_normal(t, v, p), S.triangle_normal(t, v, S.P[v])) <= 0)
+				return false;
+		}
+		for (idx_type t : triangles_u)
+			if (S.corner_of(t, v) == -1 && dot(S.triangle_normal(t, u, p), S.triangle_normal(t, u, S.P[u])) <= 0)
+				return false;
+		return true;
+	}
+	/// collapse v into u at location p after a successful validity check
+	void collapse(idx_type v, idx_type u, const vec3f& p)
+	{
+		for (idx_type t : triangles_v) {
+			if (S.corner_of(t, u) != -1) {
+				S.triangle_alive[t] = 0;
+				--nr_triangles;
+				continue;
+			}
+			int kv = S.corner_of(t, v);
+			S.T[3 * t + kv] = u;
+			for (const auto& am : attribute_map)
+				if (S.same_attributes(S.A[3 * t + kv], am.first)) {
+					S.A[3 * t + kv] = am.second;
+					break;
+				}
+		}
+		S.Q[u] = S.Q[u].translated(p - S.P[u]);
+		S.Q[u] += S.Q[v].translated(p - S.P[v]);
+		S.P[u] = p;
+		S.vertex_states[v] |= VS_REMOVED;
+		S.vertex_states[u] |= VS_MOVED;
+		std::swap(S.merged_vertices[u], S.merged_vertices[v]);
+		++nr_collapses;
+	}
+	/// find the collapse of v with the smallest cost, optionally only among valid collapses, and return its cost
+	/// compute cost and location of the collapse of v into u
+	float compute_cost(idx_type v, idx_type u, vec3f& p) const
+	{
+		quadric q = S.Q[v];
+		q += S.Q[u].translated(S.P[v] - S.P[u]);
+		p = q.minarg(vec3f(0.0f), S.P[u] - S.P[v]);
+		float cost = float(std::max(q.evaluate(p), 0.0));
+		p += S.P[v];
+		return cost;
+	}
+	/// find the collapse of v with the smallest cost, optionally only among valid collapses, and return its cost
+	float compute_candidate(idx_type v, bool only_valid)
+	{
+		S.gather_triangles(v, candidate_triangles);
+		S.gather_neighbors(candidate_triangles, v, v, candidate_neighbors);
+		float best_cost = infinite_cost;
+		for (idx_type u : candidate_neighbors) {
+			if ((S.vertex_states[u] & VS_LOCKED) != 0)
+				continue;
+			vec3f p;
+			float cost = compute_cost(v, u, p);
+			if (cost < best_cost && (!only_valid || is_valid(v, u, p))) {
+				best_cost = cost;
+				S.targets[v] = u;
+				S.target_positions[v] = p;
+			}
+		}
+		return best_cost;
+	}
+	/// update the candidate of w after the collapse of v into u, where only the collapse of w into u changes and all
+	/// collapses need to be compared only if the previous candidate of w involved v or u and became more expensive
+	void update_candidate(idx_type w, idx_type v, idx_type u)
+	{
+		idx_type li = S.local_indices[w];
+		if (li == no_index || queue.is_empty(li))
+			return;
+		if (w == u)
+			queue[li].cost = compute_candidate(w, false);
+		else {
+			vec3f p;
+			float cost = compute_cost(w, u, p);
+			bool involved = S.targets[w] == v || S.targets[w] == u;
+			if (cost <= queue[li].cost || (involved && queue[li].cost == infinite_cost)) {
+				queue[li].cost = cost;
+				S.targets[w] = u;
+				S.target_positions[w] = p;
+			}
+			else if (involved)
+				queue[li].cost = compute_candidate(w, false);
+			else
+				return;
+		}
+		queue.update(li);
+	}
+public:
+	size_t nr_triangles;
+	size_t nr_collapses;
+	float max_cost;
+	/// construct for the given vertices, which must not be locked, and the number of triangles incident to them
+	region_simplifier(simplification_state& _S, const std::vector<idx_type>& _vertices, size_t _nr_triangles) :
+		S(_S), vertices(_vertices), nr_triangles(_nr_triangles), nr_collapses(0), max_cost(0) {}
+	/// collapse vertices until the number of triangles reaches the target or the next collapse would exceed the cost bound
+	void simplify(size_t target_nr_triangles, float cost_bound)
+	{
+		for (idx_type li = 0; li < idx_type(vertices.size()); ++li) {
+			S.local_indices[vertices[li]] = li;
+			collapse_cost cc = { compute_candidate(vertices[li], false) };
+			queue.insert(cc);
+		}
+		while (!queue.empty() && nr_triangles > target_nr_triangles) {
+			idx_type li = queue.top();
+			float cost = queue[li].cost;
+			if (cost == infinite_cost || cost > cost_bound)
+				break;
+			idx_type v = vertices[li], u = S.targets[v];
+			vec3f p = S.target_positions[v];
+			if (!is_valid(v, u, p)) {
+				queue[li].cost = compute_candidate(v, true);
+				queue.update(li);
+				continue;
+			}
+			collapse(v, u, p);
+			max_cost = std::max(max_cost, cost);
+			queue.remove(li);
+			S.local_indices[v] = no_index;
+			update_candidate(u, v, u);
+			S.gather_triangles(u, triangles_u);
+			S.gather_neighbors(triangles_u, u, u, neighbors_u);
+			for (idx_type w : neighbors_u)
+				update_candidate(w, v, u);
+		}
+		for (idx_type v : vertices)
+			S.local_indices[v] = no_index;
+	}
+};
+
+}
+
+template <typename T>
+simplification_statistics simple_mesh<T>::simplify(const simplification_parameters& params)
+{
+	simplification_statistics stats;
+	idx_type nr_positions = get_nr_positions();
+	simplification_state S;
+
+	// fan triangulation of faces without degenerate triangles
+	std::vector<idx_type> triangle_faces;
+	for (idx_type fi = 0; fi < get_nr_faces(); ++fi)
+		for (idx_type ci = begin_corner(fi) + 1; ci + 1 < end_corner(fi); ++ci) {
+			idx_type c[3] = { begin_corner(fi), ci, ci + 1 };
+			if (c2p(c[0]) == c2p(c[1]) || c2p(c[1]) == c2p(c[2]) || c2p(c[2]) == c2p(c[0]))
+				continue;
+			for (int k = 0; k < 3; ++k) {
+				S.T.push_back(c2p(c[k]));
+				S.A.push_back(c[k]);
+			}
+			triangle_faces.push_back(fi);
+		}
+	idx_type nr_triangles = idx_type(triangle_faces.size());
+	stats.nr_input_triangles = stats.nr_triangles = nr_triangles;
+	S.triangle_alive.assign(nr_triangles, 1);
+	if (has_normal_indices())
+		S.attribute_indices.push_back(&normal_indices);
+	if (has_tex_coord_indices())
+		S.attribute_indices.push_back(&tex_coord_indices);
+	if (tangent_indices.size() == position_indices.size() && !tangent_indices.empty())
+		S.attribute_indices.push_back(&tangent_indices);
+
+	// normalize positions to a bounding box diagonal of one
+	box_type box = compute_box();
+	vec3 center = box.get_center();
+	T scale = box.get_extent().length() > 0 ? T(1) / box.get_extent().length() : T(1);
+	S.P.resize(nr_positions);
+	cgv::os::parallel_for(0, nr_positions, [&](size_t pi) {
+		S.P[pi] = vec3f(scale * (positions[pi] - center));
+	});
+
+	// vertex to triangle adjacency
+	S.adjacency_begins.assign(size_t(nr_positions) + 1, 0);
+	for (idx_type v : S.T)
+		++S.adjacency_begins[v + 1];
+	for (idx_type pi = 0; pi < nr_positions; ++pi)
+		S.adjacency_begins[pi + 1] += S.adjacency_begins[pi];
+	S.adjacency.resize(S.T.size());
+	{
+		std::vector<idx_type> fill(S.adjacency_begins.begin(), S.adjacency_begins.end() - 1);
+		for (idx_type ti = 0; ti < 3 * nr_triangles; ++ti)
+			S.adjacency[fill[S.T[ti]]++] = ti / 3;
+	}
+
+	// per vertex quadrics of the incident triangle planes weighted by their area relative to the average triangle area
+	double total_area = 0;
+	for (idx_type t = 0; t < nr_triangles; ++t)
+		total_area += 0.5 * S.triangle_normal(t, no_index, vec3f()).length();
+	float area_scale = total_area > 0 ? float(nr_triangles / total_area) : 1.0f;
+	S.Q.resize(nr_positions);
+	cgv::os::parallel_for(0, nr_positions, [&](size_t pi) {
+		S.Q[pi].zeros();
+		for (idx_type ai = S.adjacency_begins[pi]; ai < S.adjacency_begins[pi + 1]; ++ai) {
+			vec3f n = S.triangle_normal(S.adjacency[ai], no_index, vec3f());
+			float l = n.length();
+			if (l > 0)
+				S.Q[pi].add_plane(n / l, 0.0f, 0.5f * l * area_scale);
+		}
+	});
+	// planes orthogonal to borders and to edges between groups or materials
+	if (params.border_weight > 0) {
+		const corner_table& ct = get_corner_table();
+		for (idx_type ci = 0; ci < get_nr_corners(); ++ci) {
+			idx_type fi = ct.c2f[ci];
+			idx_type inv = ct.inv[ci];
+			if (inv != no_index &&
+				(group_indices.size() != faces.size() || group_indices[fi] == group_indices[ct.c2f[inv]]) &&
+				(material_indices.size() != faces.size() || material_indices[fi] == material_indices[ct.c2f[inv]]))
+				continue;
+			vec3f face_normal(0.0f);
+			for (idx_type cj = begin_corner(fi); cj < end_corner(fi); ++cj)
+				face_normal += cross(S.P[c2p(cj)], S.P[c2p(next_corner(cj))]);
+			idx_type p0 = c2p(ci), p1 = c2p(next_corner(ci));
+			vec3f e = S.P[p1] - S.P[p0];
+			vec3f n = cross(e, face_normal);
+			float l = n.length();
+			if (l == 0)
+				continue;
+			n /= l;
+			float w = params.border_weight * e.sqr_length() * area_scale;
+			S.Q[p0].add_plane(n, 0.0f, w);
+			S.Q[p1].add_plane(n, dot(n, e), w);
+		}
+	}
+
+	S.vertex_states.assign(nr_positions, 0);
+	S.merged_vertices.resize(nr_positions);
+	for (idx_type pi = 0; pi < nr_positions; ++pi)
+		S.merged_vertices[pi] = pi;
+	S.targets.assign(nr_positions, no_index);
+	S.target_positions.resize(nr_positions);
+	S.local_indices.assign(nr_positions, no_index);
+	float cost_bound = params.max_error < 0 ? infinite_cost : float(params.max_error * params.max_error);
+	size_t target_nr_triangles = params.target_nr_triangles;
+	bool done = params.target_nr_triangles == 0 && params.max_error < 0;
+	float max_cost = 0;
+
+	// simplify the interiors of the cells of a regular grid in parallel, where vertices shared by several cells are
+	// locked, and repeat this on the grid shifted by half a cell such that the first cell borders are simplified, too
+	cgv::os::thread_pool& pool = cgv::os::get_thread_pool();
+	unsigned nr_regions = params.nr_regions;
+	// regions need to be large as collapses next to the locked region borders are restricted
+	if (nr_regions == 0)
+		nr_regions = std::max(std::min(4 * pool.get_concurrency(), unsigned(nr_triangles / 262144)), 1u);
+	unsigned resolution = 1;
+	while (resolution * resolution * resolution < nr_regions)
+		++resolution;
+	stats.nr_regions = 1;
+	if (!done && resolution > 1) {
+		stats.nr_regions = resolution * resolution * resolution;
+		vec3f extent(scale * box.get_extent());
+		std::vector<idx_type> triangle_regions(nr_triangles, no_index), vertex_regions(nr_positions);
+		for (unsigned shift = 0; shift < 2 && stats.nr_triangles > target_nr_triangles; ++shift) {
+			unsigned nr_cells = resolution + shift;
+			cgv::os::parallel_for(0, nr_triangles, [&](size_t t) {
+				if (!S.triangle_alive[t])
+					return;
+				vec3f c = (S.P[S.T[3 * t]] + S.P[S.T[3 * t + 1]] + S.P[S.T[3 * t + 2]]) / 3.0f;
+				idx_type cell[3];
+				for (int i = 0; i < 3; ++i)
+					cell[i] = extent(i) > 0 ? idx_type(std::min(std::max((c(i) / extent(i) + 0.5f) * float(resolution) + 0.5f * shift, 0.0f), nr_cells - 1.0f)) : 0;
+				triangle_regions[t] = (cell[2] * nr_cells + cell[1]) * nr_cells + cell[0];
+			});
+			pool.parallel_for(0, nr_positions, [&](size_t pi) {
+				vertex_regions[pi] = no_index;
+				if ((S.vertex_states[pi] & VS_REMOVED) != 0)
+					return;
+				idx_type w = idx_type(pi);
+				do {
+					for (idx_type ai = S.adjacency_begins[w]; ai < S.adjacency_begins[w + 1]; ++ai) {
+						if (!S.triangle_alive[S.adjacency[ai]])
+							continue;
+						idx_type r = triangle_regions[S.adjacency[ai]];
+						if (vertex_regions[pi] == no_index)
+							vertex_regions[pi] = r;
+						else if (vertex_regions[pi] != r)
+							S.vertex_states[pi] |= VS_LOCKED;
+					}
+					w = S.merged_vertices[w];
+				} while (w != pi);
+			});
+			size_t nr_shifted_regions = size_t(nr_cells) * nr_cells * nr_cells;
+			std::vector<std::vector<idx_type> > region_vertices(nr_shifted_regions);
+			std::vector<size_t> region_nr_triangles(nr_shifted_regions, 0), region_nr_border_triangles(nr_shifted_regions, 0);
+			for (idx_type pi = 0; pi < nr_positions; ++pi)
+				if (vertex_regions[pi] != no_index && (S.vertex_states[pi] & VS_LOCKED) == 0)
+					region_vertices[vertex_regions[pi]].push_back(pi);
+			for (idx_type t = 0; t < nr_triangles; ++t)
+				if (S.triangle_alive[t]) {
+					++region_nr_triangles[triangle_regions[t]];
+					if (((S.vertex_states[S.T[3 * t]] | S.vertex_states[S.T[3 * t + 1]] | S.vertex_states[S.T[3 * t + 2]]) & VS_LOCKED) != 0)
+						++region_nr_border_triangles[triangle_regions[t]];
+				}
+			std::vector<size_t> region_nr_collapses(nr_shifted_regions, 0);
+			std::vector<float> region_max_costs(nr_shifted_regions, 0);
+			pool.parallel_for(0, nr_shifted_regions, [&](size_t r) {
+				region_simplifier rs(S, region_vertices[r], region_nr_triangles[r]);
+				// only the interior triangles are reduced by the global ratio as the border triangles are kept
+				size_t nr_border_triangles = region_nr_border_triangles[r];
+				rs.simplify(size_t(double(target_nr_triangles) * (region_nr_triangles[r] - nr_border_triangles) / stats.nr_triangles + 0.5) + nr_border_triangles, cost_bound);
+				region_nr_collapses[r] = rs.nr_collapses;
+				region_max_costs[r] = rs.max_cost;
+			}, 1);
+			for (size_t r = 0; r < nr_shifted_regions; ++r) {
+				stats.nr_collapses += region_nr_collapses[r];
+				max_cost = std::max(max_cost, region_max_costs[r]);
+			}
+			stats.nr_triangles = 0;
+			for (idx_type t = 0; t < nr_triangles; ++t)
+				stats.nr_triangles += S.triangle_alive[t];
+			for (auto& vs : S.vertex_states)
+				vs &= ~VS_LOCKED;
+		}
+	}
+	// simplify the whole mesh sequentially, which stitches the regions
+	if (!done) {
+		std::vector<idx_type> vertices;
+		for (idx_type pi = 0; pi < nr_positions; ++pi)
+			if ((S.vertex_states[pi] & VS_REMOVED) == 0 && S.adjacency_begins[pi] < S.adjacency_begins[pi + 1])
+				vertices.push_back(pi);
+		region_simplifier rs(S, vertices, stats.nr_triangles);
+		rs.simplify(target_nr_triangles, cost_bound);
+		stats.nr_collapses += rs.nr_collapses;
+		stats.nr_triangles = rs.nr_triangles;
+		max_cost = std::max(max_cost, rs.max_cost);
+	}
+	stats.max_error = std::sqrt(double(max_cost));
+
+	// compact positions and per position attributes
+	std::vector<idx_type> position_remap(nr_positions, no_index);
+	idx_type nr_new_positions = 0;
+	for (idx_type t = 0; t < nr_triangles; ++t)
+		if (S.triangle_alive[t])
+			for (int k = 0; k < 3; ++k)
+				position_remap[S.T[3 * t + k]] = 0;
+	for (idx_type pi = 0; pi < nr_positions; ++pi)
+		if (position_remap[pi] != no_index) {
+			if ((S.vertex_states[pi] & VS_MOVED) != 0)
+				positions[nr_new_positions] = cgv::math::fvec<T, 3>(S.P[pi]) / scale + center;
+			else
+				positions[nr_new_positions] = positions[pi];
+			position_remap[pi] = nr_new_positions++;
+		}
+	positions.resize(nr_new_positions);
+	auto compact_per_position = [&](void* data, size_t size) {
+		for (idx_type pi = 0; pi < nr_positions; ++pi)
+			if (position_remap[pi] != no_index && position_remap[pi] != pi)
+				std::memcpy(static_cast<char*>(data) + position_remap[pi] * size, static_cast<char*>(data) + pi * size, size);
+	};
+	if (has_colors() && get_nr_colors() == nr_positions) {
+		compact_per_position(ref_color_data_ptr(), get_color_size());
+		resize_colors(nr_new_positions);
+	}
+	if (!has_normal_indices() && normals.size() == nr_positions) {
+		compact_per_position(&normals.front(), sizeof(vec3));
+		normals.resize(nr_new_positions);
+	}
+	if (!has_tex_coord_indices() && tex_coords.size() == nr_positions) {
+		compact_per_position(&tex_coords.front(), sizeof(vec2));
+		tex_coords.resize(nr_new_positions);
+	}
+	if (tangent_indices.size() != position_indices.size() && tangents.size() == nr_positions) {
+		compact_per_position(&tangents.front(), sizeof(vec3));
+		tangents.resize(nr_new_positions);
+	}
+
+	// faces and corners of the remaining triangles with compacted attributes
+	std::vector<idx_type> old_normal_indices, old_tex_coord_indices, old_tangent_indices;
+	std::vector<idx_type> old_group_indices, old_material_indices;
+	bool has_groups = group_indices.size() == faces.size(), has_materials = material_indices.size() == faces.size();
+	if (has_normal_indices())
+		old_normal_indices.swap(normal_indices);
+	if (has_tex_coord_indices())
+		old_tex_coord_indices.swap(tex_coord_indices);
+	if (tangent_indices.size() == position_indices.size())
+		old_tangent_indices.swap(tangent_indices);
+	old_group_indices.swap(group_indices);
+	old_material_indices.swap(material_indices);
+	position_indices.clear();
+	normal_indices.clear();
+	tex_coord_indices.clear();
+	tangent_indices.clear();
+	faces.clear();
+	for (idx_type t = 0; t < nr_triangles; ++t) {
+		if (!S.triangle_alive[t])
+			continue;
+		faces.push_back(idx_type(position_indices.size()));
+		if (has_groups)
+			group_indices.push_back(old_group_indices[triangle_faces[t]]);
+		if (has_materials)
+			material_indices.push_back(old_material_indices[triangle_faces[t]]);
+		for (int k = 0; k < 3; ++k) {
+			idx_type ac = S.A[3 * t + k];
+			position_indices.push_back(position_remap[S.T[3 * t + k]]);
+			if (!old_normal_indices.empty())
+				normal_indices.push_back(old_normal_indices[ac]);
+			if (!old_tex_coord_indices.empty())
+				tex_coord_indices.push_back(old_tex_coord_indices[ac]);
+			if (!old_tangent_indices.empty())
+				tangent_indices.push_back(old_tangent_indices[ac]);
+		}
+	}
+	auto compact_indexed = [](auto& values, std::vector<idx_type>& indices) {
+		std::vector<idx_type> remap(values.size(), no_index);
+		typename std::remove_reference<decltype(values)>::type new_values;
+		for (auto& i : indices) {
+			if (remap[i] == no_index) {
+				remap[i] = idx_type(new_values.size());
+				new_values.push_back(values[i]);
+			}
+			i = remap[i];
+		}
+		values.swap(new_values);
+	};
+	if (!normal_indices.empty())
+		compact_indexed(normals, normal_indices);
+	if (!tex_coord_indices.empty())
+		compact_indexed(tex_coords, tex_coord_indices);
+	if (!tangent_indices.empty())
+		compact_indexed(tangents, tangent_indices);
+	invalidate_corner_table();
+	return stats;
+}
+
+template simplification_statistics simple_mesh<float>::simplify(const simplification_parameters& params);
+template simplification_statistics simple_mesh<double>::simplify(const simplification_parameters& params);
+
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace cgv {
+	namespace media {
+		namespace mesh {
+
+/// parameters of the quadric error metric based simplification of simple_mesh
+struct simplification_parameters
+{
+	/// simplification stops when the number of triangles is not larger than this, where 0 only stops at the maximum error
+	size_t target_nr_triangles;
+	/** simplification stops at the first collapse with a larger error, where the error is the square root of the
+	    quadric error relative to the bounding box diagonal with planes weighted by their area relative to the average
+		triangle area; negative values do not bound the error */
+	double max_error;
+	/// weight of the planes orthogonal to borders and to edges between different groups or materials that keep these in place
+	float border_weight;
+	/** number of cells of a regular grid whose interiors are simplified in parallel, once on the grid and once on the
+	    grid shifted by half a cell, before the cell borders are stitched by a sequential simplification of the whole
+		mesh. 0 chooses the number from the available concurrency and the mesh size and 1 simplifies the whole mesh
+		sequentially. */
+	unsigned nr_regions;
+	/// construct with target number of triangles and maximum error
+	simplification_parameters(size_t _target_nr_triangles = 0, double _max_error = -1, float _border_weight = 10, unsigned _nr_regions = 0) :
+		target_nr_triangles(_target_nr_triangles), max_error(_max_error), border_weight(_border_weight), nr_regions(_nr_regions) {}
+};
+
+/// result of a simplification
+struct simplification_statistics
+{
+	/// number of triangles after triangulating the faces of the input mesh
+	size_t nr_input_triangles;
+	/// number of triangles of the simplified mesh
+	size_t nr_triangles;
+	/// number of performed edge collapses
+	size_t nr_collapses;
+	/// number of spatial regions that have been simplified in parallel
+	unsigned nr_regions;
+	/// maximum error of the performed collapses in the units of simplification_parameters::max_error
+	double max_error;
+	/// construct empty statistics
+	simplification_statistics() : nr_input_triangles(0), nr_triangles(0), nr_collapses(0), nr_regions(0), max_error(0) {}
+};
+
+		}
+	}
+}
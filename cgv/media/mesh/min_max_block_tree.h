@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cgv/os/thread_pool.h>
+
+namespace cgv {
+	namespace media {
+		namespace volume {
+			class volume;
+		}
+		namespace mesh {
+
+/** hierarchy of minimum and maximum values over blocks of a regular sample grid, which allows iso surface extraction
+    to skip all blocks whose value range cannot contain the iso value. Leaf block (bx,by,bz) covers the cells
+	[b*block_size, (b+1)*block_size) in each direction and therefore the samples [b*block_size, (b+1)*block_size]
+	including the samples shared with the next block. Each coarser level combines 2x2x2 blocks of the finer level.
+	The tree only depends on the sample values, such that it is built once and reused for all iso values.
+	A block is active for an iso value if it contains samples on both sides, i.e. min <= iso < max, which
+	corresponds to the inside test value > iso of the extraction algorithms. */
+template <typename T>
+class min_max_block_tree
+{
+public:
+	/// per level information
+	struct level_info
+	{
+		unsigned nx, ny, nz;
+		std::vector<T> min_values, max_values;
+		size_t index(unsigned bx, unsigned by, unsigned bz) const { return (size_t(bz)*ny + by)*nx + bx; }
+	};
+protected:
+	unsigned resx, resy, resz;
+	unsigned block_size;
+	/// levels with the leaf level first
+	std::vector<level_info> levels;
+	/// recursively collect active leaf blocks
+	void collect(unsigned li, unsigned bx, unsigned by, unsigned bz, const T& iso_value, std::vector<size_t>& blocks) const {
+		const level_info& L = levels[li];
+		if (bx >= L.nx || by >= L.ny || bz >= L.nz)
+			return;
+		size_t bi = L.index(bx, by, bz);
+		if (!(L.min_values[bi] <= iso_value && iso_value < L.max_values[bi]))
+			return;
+		if (li == 0) {
+			blocks.push_back(bi);
+			return;
+		}
+		for (unsigned c = 0; c < 8; ++c)
+			collect(li - 1, 2 * bx + (c & 1), 2 * by + ((c >> 1) & 1), 2 * bz + (c >> 2), iso_value, blocks);
+	}
+public:
+	/// construct empty tree
+	min_max_block_tree() : resx(0), resy(0), resz(0), block_size(8) {}
+	/// return whether tree has been built
+	bool empty() const { return levels.empty(); }
+	/// return number of samples in x-direction
+	unsigned get_resx() const { return resx; }
+	/// return number of samples in y-direction
+	unsigned get_resy() const { return resy; }
+	/// return number of samples in z-direction
+	unsigned get_resz() const { return resz; }
+	/// return number of cells per block and direction
+	unsigned get_block_size() const { return block_size; }
+	/// return number of levels
+	unsigned get_nr_levels() const { return unsigned(levels.size()); }
+	/// return level with leaf level 0
+	const level_info& get_level(unsigned li) const { return levels[li]; }
+	/// build tree from function eval(i,j,k) that returns the value of sample (i,j,k) and can be called concurrently from nr_threads tasks in the shared thread pool (0 ... use concurrency of the pool)
+	template <typename Eval>
+	void build(unsigned _resx, unsigned _resy, unsigned _resz, const Eval& eval, unsigned _block_size = 8, unsigned nr_threads = 0) {
+		resx = _resx; resy = _resy; resz = _resz;
+		block_size = std::max(1u, _block_size);
+		levels.clear();
+		if (resx < 2 || resy < 2 || resz < 2)
+			return;
+		level_info L;
+		L.nx = (resx - 2) / block_size + 1;
+		L.ny = (resy - 2) / block_size + 1;
+		L.nz = (resz - 2) / block_size + 1;
+		L.min_values.resize(size_t(L.nx)*L.ny*L.nz);
+		L.max_values.resize(L.min_values.size());
+		// compute leaf blocks from samples with one slab of blocks per task
+		if (nr_threads == 0)
+			nr_threads = cgv::os::get_thread_pool().get_concurrency();
+		nr_threads = std::min(nr_threads, L.nz);
+		std::atomic<unsigned> next_bz(0);
+		auto worker = [&]() {
+			unsigned bz;
+			while ((bz = next_bz.fetch_add(1)) < L.nz) {
+				unsigned k0 = bz*block_size, k1 = std::min(k0 + block_size, resz - 1);
+				for (unsigned by = 0; by < L.ny; ++by) {
+					unsigned j0 = by*block_size, j1 = std::min(j0 + block_size, resy - 1);
+					for (unsigned bx = 0; bx < L.nx; ++bx) {
+						unsigned i0 = bx*block_size, i1 = std::min(i0 + block_size, resx - 1);
+						T v_min = eval(i0, j0, k0), v_max = v_min;
+						for (unsigned k = k0; k <= k1; ++k)
+							for (unsigned j = j0; j <= j1; ++j)
+								for (unsigned i = i0; i <= i1; ++i) {
+									T v = eval(i, j, k);
+									if (v < v_min)
+										v_min = v;
+									if (v > v_max)
+										v_max = v;
+								}
+						size_t bi = L.index(bx, by, bz);
+						L.min_values[bi] = v_min;
+						L.max_values[bi] = v_max;
+					}
+				}
+			}
+		};
+		cgv::os::get_thread_pool().parallel_for(0, nr_threads, [&](size_t) { worker(); }, 1);
+		levels.push_back(L);
+		// combine 2x2x2 blocks until one block remains
+		while (levels.back().nx > 1 || levels.back().ny > 1 || levels.back().nz > 1) {
+			const level_info& F = levels.back();
+			level_info C;
+			C.nx = (F.nx + 1) / 2;
+			C.ny = (F.ny + 1) / 2;
+			C.nz = (F.nz + 1) / 2;
+			C.min_values.resize(size_t(C.nx)*C.ny*C.nz);
+			C.max_values.resize(C.min_values.size());
+			for (unsigned bz = 0; bz < C.nz; ++bz)
+				for (unsigned by = 0; by < C.ny; ++by)
+					for (unsigned bx = 0; bx < C.nx; ++bx) {
+						size_t ci = C.index(bx, by, bz);
+						bool first = true;
+						for (unsigned c = 0; c < 8; ++c) {
+							unsigned fx = 2 * bx + (c & 1), fy = 2 * by + ((c >> 1) & 1), fz = 2 * bz + (c >> 2);
+							if (fx >= F.nx || fy >= F.ny || fz >= F.nz)
+								continue;
+							size_t fi = F.index(fx, fy, fz);
+							if (first || F.min_values[fi] < C.min_values[ci])
+								C.min_values[ci] = F.min_values[fi];
+							if (first || F.max_values[fi] > C.max_values[ci])
+								C.max_values[ci] = F.max_values[fi];
+							first = false;
+						}
+					}
+			levels.push_back(C);
+		}
+	}
+	/// collect indices of leaf blocks that are active for the given iso value in time proportional to their number
+	void collect_active_blocks(const T& iso_value, std::vector<size_t>& blocks) const {
+		blocks.clear();
+		if (!empty())
+			collect(unsigned(levels.size() - 1), 0, 0, 0, iso_value, blocks);
+	}
+	/// compute the leaf block coordinates from a leaf block index
+	void get_block_coordinates(size_t bi, unsigned& bx, unsigned& by, unsigned& bz) const {
+		const level_info& L = levels[0];
+		bx = unsigned(bi % L.nx);
+		by = unsigned((bi / L.nx) % L.ny);
+		bz = unsigned(bi / (size_t(L.nx)*L.ny));
+	}
+	/// return the index of the leaf block that contains the cell starting at sample (i,j,k)
+	size_t get_block_index(unsigned i, unsigned j, unsigned k) const {
+		const level_info& L = levels[0];
+		return L.index(std::min(i / block_size, L.nx - 1), std::min(j / block_size, L.ny - 1), std::min(k / block_size, L.nz - 1));
+	}
+	/// return the value range of the leaf block that contains sample (i,j,k)
+	void get_range(unsigned i, unsigned j, unsigned k, T& min_value, T& max_value) const {
+		size_t bi = get_block_index(i, j, k);
+		min_value = levels[0].min_values[bi];
+		max_value = levels[0].max_values[bi];
+	}
+	/** if all blocks that contain sample (i,j,k) are inactive for the iso value, no edge incident to the sample crosses
+	    the iso surface. Then set value to the block minimum or maximum, which is on the same side of the iso value as
+		the sample, and return true. Return false if the sample needs to be evaluated. */
+	bool get_uniform_value(unsigned i, unsigned j, unsigned k, const T& iso_value, T& value) const {
+		const level_info& L = levels[0];
+		const unsigned c[3] = { i, j, k }, n[3] = { L.nx, L.ny, L.nz };
+		unsigned lo[3], hi[3];
+		for (int d = 0; d < 3; ++d) {
+			hi[d] = std::min(c[d] / block_size, n[d] - 1);
+			lo[d] = (c[d] > 0 && c[d] % block_size == 0) ? c[d] / block_size - 1 : hi[d];
+		}
+		for (unsigned bz = lo[2]; bz <= hi[2]; ++bz)
+			for (unsigned by = lo[1]; by <= hi[1]; ++by)
+				for (unsigned bx = lo[0]; bx <= hi[0]; ++bx) {
+					size_t bi = L.index(bx, by, bz);
+					if (L.min_values[bi] <= iso_value && iso_value < L.max_values[bi])
+						return false;
+				}
+		size_t bi = L.index(hi[0], hi[1], hi[2]);
+		value = L.min_values[bi] > iso_value ? L.min_values[bi] : L.max_values[bi];
+		return true;
+	}
+};
+
+/// evaluator that reads a voxel component converted to type T from a volume, where samples correspond to voxels
+template <typename T, typename V = cgv::media::volume::volume>
+struct volume_evaluator
+{
+	const V& vol;
+	unsigned component_index;
+	volume_evaluator(const V& _vol, unsigned _component_index = 0) : vol(_vol), component_index(_component_index) {}
+	/// return dimensions of volume
+	typename V::dimension_type get_dimensions() const { return vol.get_dimensions(); }
+	/// return voxel value as used to build a min_max_block_tree
+	T operator () (unsigned i, unsigned j, unsigned k) const { return vol.get_data_view().template get<T>(component_index, k, j, i); }
+	/// return voxel value as used by the marching cubes extraction
+	template <typename P>
+	T operator () (unsigned i, unsigned j, unsigned k, const P&) const { return (*this)(i, j, k); }
+};
+
+		}
+	}
+}
@@ -4,7 +4,12 @@
 #include <cgv/type/standard_types.h>
 #include <cgv/utils/advanced_scan.h>
 #include <cgv/utils/tokenizer.h>
+#include <cgv/utils/mapped_file.h>
 #include <cgv/base/import.h>
+#include <cgv/os/thread_pool.h>
+#include <algorithm>
+#include <cstring>
+#include <climits>
 
 using namespace cgv::math;
 using namespace cgv::type;
@@ -191,66 +196,303 @@ void obj_reader_generic<T>::parse_and_process_texcoord(const std::vector<cgv::ut
 {
 	process_texcoord(parse_v2d(tokens));
 }
+///
+template <typename T>
+void obj_reader_generic<T>::process_vertex_coordinates(const double* p)
+{
+	process_vertex(v3d_type((crd_type)p[0], (crd_type)p[1], (crd_type)p[2]));
+}
+///
+template <typename T>
+void obj_reader_generic<T>::process_normal_coordinates(const double* n)
+{
+	process_normal(v3d_type((crd_type)n[0], (crd_type)n[1], (crd_type)n[2]));
+}
+///
+template <typename T>
+void obj_reader_generic<T>::process_texcoord_coordinates(const double* t)
+{
+	process_texcoord(v2d_type((crd_type)t[0], (crd_type)t[1]));
+}
 
-bool obj_reader_base::read_obj(const std::string& file_name)
+/// marks texture coordinate and normal indices that are not given or that equal the vertex index
+static const int no_index = INT_MIN;
+static const int vertex_index = INT_MIN + 1;
+
+struct obj_reader_base::parsed_chunk
 {
-	std::string content;
-	if (!cgv::base::read_data_file(file_name, content, true))
-		return false;
+	/// types of parsed lines
+	enum line_type : unsigned char { vertex_line, colored_vertex_line, normal_line, texcoord_line, color_line, face_line, polyline_line, group_line, material_line, mtllib_line };
+	/// types of the parsed lines in file order
+	std::vector<unsigned char> line_types;
+	/// coordinates of vertices, normals and texture coordinates and rgba components of colors in file order
+	std::vector<double> values;
+	/// degrees of faces and lines
+	std::vector<unsigned> degrees;
+	/// vertex, texture coordinate and normal index of each corner of faces and lines as written in the file
+	std::vector<int> corners;
+	/// names of groups, their parameters, names of materials and names of material files
+	std::vector<std::string> names;
+	void clear()
+	{
+		line_types.clear();
+		values.clear();
+		degrees.clear();
+		corners.clear();
+		names.clear();
+	}
+};
 
-	path_name = file::get_path(file_name);
-	if (!path_name.empty())
-		path_name += "/";
+/// return pointer to the first non white space character in [p,end)
+inline const char* skip_obj_spaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		++p;
+	return p;
+}
 
-	std::vector<line> lines;
-	split_to_lines(content,lines);
-	
-	minus = 1;
-	material_index = -1;
-	group_index = -1;
-	nr_groups = 0;
-	nr_normals = nr_texcoords = 0;
-	std::map<std::string,unsigned> group_index_lut;
-	std::vector<token> tokens;
-	for (unsigned li=0; li<lines.size(); ++li) {
-		if(li % 1000 == 0)
-			printf("%d Percent done.\r", (int)(100.0*li/(lines.size()-1)) );
+/// return pointer behind the token starting at p
+inline const char* skip_obj_token(const char* p, const char* end)
+{
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+		++p;
+	return p;
+}
 
-		tokenizer(lines[li]).bite_all(tokens);
-		if (tokens.size() == 0)
-			continue;
+/// parse integer like atoi
+inline int parse_obj_int(const char* p, const char* end)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+	int value = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		value = 10 * value + (*p - '0');
+	return negative ? -value : value;
+}
 
-		switch (tokens[0][0]) {
-		case 'v' :
-			if (tokens[0].size() == 1) {
-				parse_and_process_vertex(tokens);
-				if (tokens.size() >= 7)
-					process_color(parse_color(tokens, 3));
+/** parse number in [begin,end) with the same result as cgv::utils::is_double. Numbers with at most 19 significant
+    digits and a decimal exponent of at most 22 are computed exactly without library calls. */
+static bool parse_obj_double(const char* begin, const char* end, double& value)
+{
+	static const double powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const char* p = begin;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+	unsigned long long mantissa = 0;
+	int nr_digits = 0, nr_significant_digits = 0, exponent = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p, ++nr_digits) {
+		mantissa = 10 * mantissa + (*p - '0');
+		if (mantissa > 0)
+			++nr_significant_digits;
+	}
+	if (p < end && *p == '.')
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p, ++nr_digits, --exponent) {
+			mantissa = 10 * mantissa + (*p - '0');
+			if (mantissa > 0)
+				++nr_significant_digits;
+		}
+	bool exact = nr_digits > 0 && nr_significant_digits <= 19;
+	if (exact && p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negative_exponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative_exponent = *p++ == '-';
+		int e = 0;
+		const char* digits_begin = p;
+		for (; p < end && *p >= '0' && *p <= '9' && e < 10000; ++p)
+			e = 10 * e + (*p - '0');
+		exact = p > digits_begin;
+		exponent += negative_exponent ? -e : e;
+	}
+	if (exact && p == end && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+		double v = double(mantissa);
+		v = exponent < 0 ? v / powers_of_ten[-exponent] : v * powers_of_ten[exponent];
+		value = negative ? -v : v;
+		return true;
+	}
+	// remaining numbers and other syntax accepted by is_double
+	return cgv::utils::is_double(begin, end, value);
+}
+
+/// parse up to n numbers from the tokens in [begin,end) into values and stop at the first number that cannot be parsed
+static void parse_obj_numbers(const char* const* begin, const char* const* end, unsigned n, double* values)
+{
+	for (unsigned i = 0; i < n; ++i)
+		if (!parse_obj_double(begin[i], end[i], values[i]))
+			return;
+}
+
+void obj_reader_base::parse_chunk(const char* begin, const char* end, parsed_chunk& chunk)
+{
+	chunk.clear();
+	// begin and end of the first tokens of a line
+	const unsigned max_nr_tokens = 9;
+	const char* token_begin[max_nr_tokens];
+	const char* token_end[max_nr_tokens];
+	for (const char* line_begin = begin; line_begin < end; ) {
+		const char* line_end = static_cast<const char*>(std::memchr(line_begin, '\n', end - line_begin));
+		if (!line_end)
+			line_end = end;
+		const char* p = skip_obj_spaces(line_begin, line_end);
+		line_begin = line_end + 1;
+		unsigned nr_tokens = 0;
+		while (p < line_end && nr_tokens < max_nr_tokens) {
+			token_begin[nr_tokens] = p;
+			token_end[nr_tokens] = p = skip_obj_token(p, line_end);
+			++nr_tokens;
+			p = skip_obj_spaces(p, line_end);
+		}
+		if (nr_tokens == 0)
+			continue;
+		// count all tokens of lines with more tokens than stored
+		const char* rest = p;
+		unsigned total_nr_tokens = nr_tokens;
+		for (const char* q = rest; q < line_end; q = skip_obj_spaces(skip_obj_token(q, line_end), line_end))
+			++total_nr_tokens;
+		size_t first_size = token_end[0] - token_begin[0];
+		switch (token_begin[0][0]) {
+		case 'v':
+			if (first_size == 1) {
+				// vertices with less than three coordinates are processed as origin
+				double v[7] = { 0, 0, 0, 0, 0, 0, 1 };
+				if (total_nr_tokens > 3)
+					parse_obj_numbers(token_begin + 1, token_end + 1, 3, v);
+				if (total_nr_tokens >= 7) {
+					parse_obj_numbers(token_begin + 4, token_end + 4, 3, v + 3);
+					if (total_nr_tokens > 7)
+						parse_obj_double(token_begin[7], token_end[7], v[6]);
+					chunk.line_types.push_back(parsed_chunk::colored_vertex_line);
+					chunk.values.insert(chunk.values.end(), v, v + 7);
+				}
+				else {
+					chunk.line_types.push_back(parsed_chunk::vertex_line);
+					chunk.values.insert(chunk.values.end(), v, v + 3);
+				}
 			}
-			else {
-				switch (tokens[0][1]) {
-				case 'n' :
-					parse_and_process_normal(tokens);
-					++nr_normals;
-					break;
-				case 't' : 
-					parse_and_process_texcoord(tokens);
-					++nr_texcoords;
-					break;
-				case 'c' : 
-					process_color(parse_color(tokens));
-					break;
+			else if (token_begin[0][1] == 'n' || token_begin[0][1] == 't') {
+				bool is_normal = token_begin[0][1] == 'n';
+				unsigned n = is_normal ? 3 : 2;
+				double v[3] = { 0, 0, 0 };
+				if (total_nr_tokens > n)
+					parse_obj_numbers(token_begin + 1, token_end + 1, n, v);
+				chunk.line_types.push_back(is_normal ? parsed_chunk::normal_line : parsed_chunk::texcoord_line);
+				chunk.values.insert(chunk.values.end(), v, v + n);
+			}
+			else if (token_begin[0][1] == 'c') {
+				double c[4] = { 0, 0, 0, 1 };
+				if (total_nr_tokens > 3)
+					parse_obj_numbers(token_begin + 1, token_end + 1, 3, c);
+				if (total_nr_tokens > 4)
+					parse_obj_double(token_begin[4], token_end[4], c[3]);
+				chunk.line_types.push_back(parsed_chunk::color_line);
+				chunk.values.insert(chunk.values.end(), c, c + 4);
+			}
+			break;
+		case 'f':
+		case 'l': {
+			chunk.line_types.push_back(token_begin[0][0] == 'f' ? parsed_chunk::face_line : parsed_chunk::polyline_line);
+			unsigned degree = 0;
+			for (const char* q = token_end[0]; (q = skip_obj_spaces(q, line_end)) < line_end; ++degree) {
+				const char* corner_end = skip_obj_token(q, line_end);
+				// split corner at slashes into the tokens of the index syntax v, v/t, v/t/n or v//n
+				const char* parts[5];
+				unsigned nr_parts = 0;
+				for (const char* r = q; r < corner_end; ++nr_parts) {
+					if (nr_parts < 5)
+						parts[nr_parts] = r;
+					r = *r == '/' ? r + 1 : std::find(r, corner_end, '/');
+				}
+				q = corner_end;
+				int vi = *parts[0] == '/' ? 0 : parse_obj_int(parts[0], corner_end);
+				int ti = no_index, ni = no_index;
+				if (nr_parts == 1)
+					ti = ni = vertex_index;
+				else if (nr_parts >= 3) {
+					unsigned j = 2;
+					if (*parts[2] != '/') {
+						ti = parse_obj_int(parts[2], corner_end);
+						++j;
+					}
+					if (nr_parts >= j + 2)
+						ni = *parts[j + 1] == '/' ? 0 : parse_obj_int(parts[j + 1], corner_end);
 				}
+				chunk.corners.push_back(vi);
+				chunk.corners.push_back(ti);
+				chunk.corners.push_back(ni);
+			}
+			chunk.degrees.push_back(degree);
+			break;
+		}
+		case 'g':
+			if (nr_tokens > 1) {
+				chunk.line_types.push_back(parsed_chunk::group_line);
+				chunk.names.push_back(std::string(token_begin[1], token_end[1]));
+				// parameters range from the third token to the end of the line without trailing white space
+				const char* parameters_end = line_end;
+				while (parameters_end > token_begin[1] && (parameters_end[-1] == ' ' || parameters_end[-1] == '\t' || parameters_end[-1] == '\r'))
+					--parameters_end;
+				chunk.names.push_back(nr_tokens > 2 ? std::string(token_begin[2], parameters_end) : std::string());
 			}
 			break;
-		case 'f' :
+		default:
+			if (nr_tokens > 1) {
+				std::string keyword(token_begin[0], token_end[0]);
+				if (keyword == "usemtl" || keyword == "mtllib") {
+					chunk.line_types.push_back(keyword == "usemtl" ? parsed_chunk::material_line : parsed_chunk::mtllib_line);
+					chunk.names.push_back(std::string(token_begin[1], token_end[1]));
+				}
+			}
+		}
+	}
+}
+
+void obj_reader_base::process_chunk(const parsed_chunk& chunk, std::map<std::string, unsigned>& group_index_lut)
+{
+	const double* values = chunk.values.data();
+	const unsigned* degrees = chunk.degrees.data();
+	const int* corners = chunk.corners.data();
+	const std::string* names = chunk.names.data();
+	std::vector<int> vertex_indices, normal_indices, texcoord_indices;
+	for (unsigned char type : chunk.line_types) {
+		switch (type) {
+		case parsed_chunk::vertex_line:
+			process_vertex_coordinates(values);
+			values += 3;
+			break;
+		case parsed_chunk::colored_vertex_line:
+			process_vertex_coordinates(values);
+			process_color(color_type((float)values[3], (float)values[4], (float)values[5], (float)values[6]));
+			values += 7;
+			break;
+		case parsed_chunk::normal_line:
+			process_normal_coordinates(values);
+			values += 3;
+			++nr_normals;
+			break;
+		case parsed_chunk::texcoord_line:
+			process_texcoord_coordinates(values);
+			values += 2;
+			++nr_texcoords;
+			break;
+		case parsed_chunk::color_line:
+			process_color(color_type((float)values[0], (float)values[1], (float)values[2], (float)values[3]));
+			values += 4;
+			break;
+		case parsed_chunk::face_line:
+		case parsed_chunk::polyline_line: {
+			bool is_line = type == parsed_chunk::polyline_line;
 			if (group_index == -1) {
 				group_index = 0;
 				nr_groups = 1;
-				process_group("main","");
+				process_group("main", "");
 				group_index_lut["main"] = group_index;
 			}
-			if (material_index == -1) {
+			if (!is_line && material_index == -1) {
 				obj_material m;
 				m.set_name("default");
 				material_index = 0;
@@ -259,48 +501,135 @@ bool obj_reader_base::read_obj(const std::string& file_name)
 				material_index_lut[m.get_name()] = material_index;
 				have_default_material = true;
 			}
-			parse_face(tokens); 
-			break;
-		case 'l':
-			if (group_index == -1) {
-				group_index = 0;
-				nr_groups = 1;
-				process_group("main", "");
-				group_index_lut["main"] = group_index;
+			// convert one based indices and keep texture coordinate and normal indices only if they refer to read elements
+			unsigned degree = *degrees++;
+			vertex_indices.clear();
+			normal_indices.clear();
+			texcoord_indices.clear();
+			for (unsigned i = 0; i < degree; ++i, corners += 3) {
+				int vi = corners[0], ti = corners[1], ni = corners[2];
+				if (vi > 0)
+					vi -= minus;
+				vertex_indices.push_back(vi);
+				if (ti == vertex_index)
+					ti = vi;
+				else if (ti > 0)
+					ti -= minus;
+				if (ti != no_index && (int)nr_texcoords > ti)
+					texcoord_indices.push_back(ti);
+				if (ni == vertex_index)
+					ni = vi;
+				else if (ni > 0)
+					ni -= minus;
+				if (ni != no_index && (int)nr_normals > ni)
+					normal_indices.push_back(ni);
 			}
-			parse_face(tokens, true);
+			int* nml_ptr = normal_indices.size() == vertex_indices.size() ? normal_indices.data() : 0;
+			int* tex_ptr = texcoord_indices.size() == vertex_indices.size() ? texcoord_indices.data() : 0;
+			if (is_line)
+				process_line(degree, vertex_indices.data(), tex_ptr, nml_ptr);
+			else
+				process_face(degree, vertex_indices.data(), tex_ptr, nml_ptr);
 			break;
-		case 'g' :
-			if (tokens.size() > 1) {
-				std::string name = to_string(tokens[1]);
-				std::string parameters;
-				if (tokens.size() > 2)
-					parameters.assign(tokens[2].begin, tokens.back().end - tokens[2].begin);
-
-				std::map<std::string,unsigned>::iterator it = 
-					group_index_lut.find(name);
-
-				if (it != group_index_lut.end())
-					group_index = it->second;
-				else {
-					group_index = nr_groups;
-					++nr_groups;
-					process_group(name, parameters);
-					group_index_lut[name] = group_index;
-				}
+		}
+		case parsed_chunk::group_line: {
+			const std::string& name = *names++;
+			const std::string& parameters = *names++;
+			std::map<std::string, unsigned>::iterator it = group_index_lut.find(name);
+			if (it != group_index_lut.end())
+				group_index = it->second;
+			else {
+				group_index = nr_groups;
+				++nr_groups;
+				process_group(name, parameters);
+				group_index_lut[name] = group_index;
 			}
 			break;
-		default:
-			if (to_string(tokens[0]) == "usemtl")
-				parse_material(tokens);
-			else if (to_string(tokens[0]) == "mtllib") {
-				if (tokens.size() > 1)
-					read_mtl(to_string(tokens[1]));
-			}
 		}
-		tokens.clear();
+		case parsed_chunk::material_line: {
+			std::map<std::string, unsigned>::iterator it = material_index_lut.find(*names++);
+			if (it != material_index_lut.end())
+				material_index = it->second;
+			break;
+		}
+		case parsed_chunk::mtllib_line:
+			read_mtl(*names++);
+			break;
+		}
 	}
-	printf("\n");
+}
+
+void obj_reader_base::parse_obj(const char* begin, const char* end)
+{
+	minus = 1;
+	material_index = -1;
+	group_index = -1;
+	nr_groups = 0;
+	nr_normals = nr_texcoords = 0;
+	std::map<std::string, unsigned> group_index_lut;
+
+	// chunks are parsed in batches, where the next batch is parsed while the current one is processed
+	cgv::os::thread_pool& pool = cgv::os::get_thread_pool();
+	const size_t chunk_size = size_t(4) << 20;
+	const size_t batch_size = 2 * size_t(pool.get_concurrency());
+	std::vector<parsed_chunk> batches[2];
+	batches[0].resize(batch_size);
+	batches[1].resize(batch_size);
+	size_t batch_lengths[2] = { 0, 0 };
+	const char* next = begin;
+	cgv::os::task_group group(pool);
+	auto parse_batch = [&](unsigned bi) {
+		batch_lengths[bi] = 0;
+		while (next < end && batch_lengths[bi] < batch_size) {
+			// extend chunk to the end of its last line
+			const char* chunk_end = end - next > ptrdiff_t(chunk_size) ? next + chunk_size : end;
+			const char* newline = static_cast<const char*>(std::memchr(chunk_end - 1, '\n', end - chunk_end + 1));
+			chunk_end = newline ? newline + 1 : end;
+			parsed_chunk* chunk = &batches[bi][batch_lengths[bi]++];
+			const char* chunk_begin = next;
+			group.run([chunk_begin, chunk_end, chunk]() { parse_chunk(chunk_begin, chunk_end, *chunk); });
+			next = chunk_end;
+		}
+	};
+	parse_batch(0);
+	group.wait();
+	for (unsigned bi = 0; batch_lengths[bi] > 0; bi = 1 - bi) {
+		parse_batch(1 - bi);
+		try {
+			for (size_t ci = 0; ci < batch_lengths[bi]; ++ci)
+				process_chunk(batches[bi][ci], group_index_lut);
+		}
+		catch (...) {
+			// parsing tasks reference the batches
+			group.wait();
+			throw;
+		}
+		group.wait();
+		batch_lengths[bi] = 0;
+	}
+}
+
+bool obj_reader_base::read_obj(const std::string& file_name)
+{
+	// map plain files and read resource files and empty files into memory
+	cgv::utils::mapped_file mapping;
+	std::string content;
+	const char* begin;
+	const char* end;
+	if (file_name.substr(0, 6) != "str://" && file_name.substr(0, 6) != "res://" && mapping.open(file_name)) {
+		begin = mapping.data();
+		end = begin + mapping.size();
+	}
+	else {
+		if (!cgv::base::read_data_file(file_name, content, true))
+			return false;
+		begin = content.data();
+		end = begin + content.size();
+	}
+	path_name = file::get_path(file_name);
+	if (!path_name.empty())
+		path_name += "/";
+	parse_obj(begin, end);
 	return true;
 }
 
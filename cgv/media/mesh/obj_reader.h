@@ -44,6 +44,20 @@ protected:
 	virtual void parse_and_process_vertex(const std::vector<cgv::utils::token>& tokens) = 0;
 	virtual void parse_and_process_normal(const std::vector<cgv::utils::token>& tokens) = 0;
 	virtual void parse_and_process_texcoord(const std::vector<cgv::utils::token>& tokens) = 0;
+	/// lines of a part of an obj file parsed independently of the other parts
+	struct parsed_chunk;
+	/// parse the lines in [begin,end) into chunk, which is called for several chunks in parallel
+	static void parse_chunk(const char* begin, const char* end, parsed_chunk& chunk);
+	/// call the processing functions with the content of a parsed chunk in file order
+	void process_chunk(const parsed_chunk& chunk, std::map<std::string, unsigned>& group_index_lut);
+	/// parse the obj file content in [begin,end) in line aligned chunks in parallel and process them in file order
+	void parse_obj(const char* begin, const char* end);
+	/// process vertex given by three parsed coordinates
+	virtual void process_vertex_coordinates(const double* p) = 0;
+	/// process normal given by three parsed coordinates
+	virtual void process_normal_coordinates(const double* n) = 0;
+	/// process texture coordinate given by two parsed coordinates
+	virtual void process_texcoord_coordinates(const double* t) = 0;
 	//@}
 
 	/**@name status info during reading*/
@@ -79,7 +93,8 @@ protected:
 public:
 	///
 	obj_reader_base();
-	/// read an obj file
+	/** read an obj file, which is memory mapped and parsed in line aligned chunks by the threads of the shared
+	    thread pool. The processing functions are called in file order from the calling thread. */
 	virtual bool read_obj(const std::string& file_name);
 	/// read a material file
 	virtual bool read_mtl(const std::string& file_name);
@@ -116,6 +131,12 @@ protected:
 	void parse_and_process_normal(const std::vector<cgv::utils::token>& tokens);
 	///
 	void parse_and_process_texcoord(const std::vector<cgv::utils::token>& tokens);
+	///
+	void process_vertex_coordinates(const double* p);
+	///
+	void process_normal_coordinates(const double* n);
+	///
+	void process_texcoord_coordinates(const double* t);
 	//@}
 
 	/**@name virtual interface*/
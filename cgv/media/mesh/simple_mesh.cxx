@@ -5,12 +5,17 @@
 #include <cgv/utils/scan.h>
 #include <cgv/media/mesh/obj_reader.h>
 #include <cgv/math/bucket_sort.h>
+#include <cgv/utils/mapped_file.h>
+#include <cgv/os/thread_pool.h>
+#include <cstring>
 #include <fstream>
 
 namespace cgv {
 	namespace media {
 		namespace mesh {
 
+bool simple_mesh_base::binary_cache_enabled = true;
+
 /// default constructor
 simple_mesh_base::simple_mesh_base() 
 {
@@ -26,7 +31,8 @@ simple_mesh_base::simple_mesh_base(const simple_mesh_base& smb) :
 	group_indices(smb.group_indices),
 	group_names(smb.group_names),
 	material_indices(smb.material_indices),
-	materials(smb.materials)
+	materials(smb.materials),
+	corner_table_ptr(smb.corner_table_ptr)
 {
 }
 /// assignment operator
@@ -41,6 +47,7 @@ simple_mesh_base& simple_mesh_base::operator=(const simple_mesh_base& smb)
 	group_names=smb.group_names;
 	material_indices=smb.material_indices;
 	materials = smb.materials;
+	corner_table_ptr = smb.corner_table_ptr;
 	return *this;
 }
 
@@ -48,6 +55,7 @@ simple_mesh_base& simple_mesh_base::operator=(const simple_mesh_base& smb)
 /// create a new empty face to which new corners are added and return face index
 simple_mesh_base::idx_type simple_mesh_base::start_face()
 {
+	invalidate_corner_table();
 	faces.push_back((cgv::type::uint32_type)position_indices.size());
 	if (!materials.empty())
 		material_indices.push_back(idx_type(materials.size()) - 1);
@@ -58,6 +66,7 @@ simple_mesh_base::idx_type simple_mesh_base::start_face()
 /// create a new corner from position, optional normal and optional tex coordinate indices and return corner index
 simple_mesh_base::idx_type simple_mesh_base::new_corner(idx_type position_index, idx_type normal_index, idx_type tex_coord_index)
 {
+	invalidate_corner_table();
 	position_indices.push_back(position_index);
 	if (normal_index != -1)
 		normal_indices.push_back(normal_index);
@@ -69,6 +78,7 @@ simple_mesh_base::idx_type simple_mesh_base::new_corner(idx_type position_index,
 /// revert face orientation
 void simple_mesh_base::revert_face_orientation()
 {
+	invalidate_corner_table();
 	bool nmls = position_indices.size() == normal_indices.size();
 	bool tcs  = position_indices.size() == tex_coord_indices.size();
 	for (idx_type fi = 0; fi < get_nr_faces(); ++fi) {
@@ -174,68 +184,194 @@ void simple_mesh_base::extract_triangle_element_buffer(
 /// extract element array buffers for edges in wireframe
 void simple_mesh_base::extract_wireframe_element_buffer(const std::vector<idx_type>& vertex_indices, std::vector<idx_type>& edge_element_buffer) const
 {
-	// map stores for each halfedge the number of times it has been seen before
-	std::map<std::tuple<idx_type, idx_type>, idx_type> halfedge_to_count;
-	for (idx_type fi = 0; fi < faces.size(); ++fi) {
-		idx_type last_vi = vertex_indices.at(end_corner(fi) - 1);
-		for (idx_type ci = begin_corner(fi); ci < end_corner(fi); ++ci) {
-			// construct halfedge with sorted vertex indices
-			idx_type vi = vertex_indices.at(ci);
-			std::tuple<idx_type, idx_type> halfedge(last_vi, vi);
-			if (vi < last_vi)
-				std::swap(std::get<0>(halfedge), std::get<1>(halfedge));
-
-			// lookup corner in map
-			auto iter = halfedge_to_count.find(halfedge);
-
-			// determine vertex index
-			if (iter == halfedge_to_count.end()) {
-				halfedge_to_count[halfedge] = 1;
-				edge_element_buffer.push_back(last_vi);
-				edge_element_buffer.push_back(vi);
+	// one line per edge of the corner table from the position of its first corner to the next position
+	const corner_table& ct = get_corner_table();
+	size_t offset = edge_element_buffer.size();
+	edge_element_buffer.resize(offset + 2 * size_t(ct.get_nr_edges()));
+	cgv::os::parallel_for(0, ct.get_nr_edges(), [&](size_t ei) {
+		idx_type ci = ct.e2c[ei];
+		edge_element_buffer[offset + 2 * ei] = vertex_indices[ci];
+		edge_element_buffer[offset + 2 * ei + 1] = vertex_indices[next_corner(ci)];
+	});
+}
+
+/// sort values by their keys with a parallel and stable least significant digit radix sort over the lowest nr_key_bits bits
+static void radix_sort(std::vector<uint32_t>& keys, std::vector<uint32_t>& values, unsigned nr_key_bits)
+{
+	// use digits of at most 11 bits with the same number of bits per pass
+	unsigned nr_passes = (nr_key_bits + 10) / 11;
+	unsigned digit_bits = (nr_key_bits + nr_passes - 1) / nr_passes;
+	const size_t nr_buckets = size_t(1) << digit_bits;
+	size_t n = keys.size();
+	cgv::os::thread_pool& pool = cgv::os::get_thread_pool();
+	size_t nr_blocks = std::min(n / 65536 + 1, size_t(4 * pool.get_concurrency()));
+	size_t block_size = (n + nr_blocks - 1) / nr_blocks;
+	std::vector<uint32_t> sorted_keys(n), sorted_values(n);
+	std::vector<size_t> offsets(nr_blocks * nr_buckets);
+	for (unsigned shift = 0; shift < nr_key_bits; shift += digit_bits) {
+		// count digits per block
+		std::fill(offsets.begin(), offsets.end(), 0);
+		pool.parallel_for(0, nr_blocks, [&](size_t bi) {
+			size_t* counts = &offsets[bi * nr_buckets];
+			for (size_t i = bi * block_size; i < std::min(n, (bi + 1) * block_size); ++i)
+				++counts[(keys[i] >> shift) & (nr_buckets - 1)];
+		}, 1);
+		// offsets in the order of digits and then blocks keep the sort stable
+		size_t sum = 0;
+		for (size_t d = 0; d < nr_buckets; ++d)
+			for (size_t bi = 0; bi < nr_blocks; ++bi) {
+				size_t count = offsets[bi * nr_buckets + d];
+				offsets[bi * nr_buckets + d] = sum;
+				sum += count;
+			}
+		pool.parallel_for(0, nr_blocks, [&](size_t bi) {
+			size_t* block_offsets = &offsets[bi * nr_buckets];
+			for (size_t i = bi * block_size; i < std::min(n, (bi + 1) * block_size); ++i) {
+				size_t j = block_offsets[(keys[i] >> shift) & (nr_buckets - 1)]++;
+				sorted_keys[j] = keys[i];
+				sorted_values[j] = values[i];
+			}
+		}, 1);
+		keys.swap(sorted_keys);
+		values.swap(sorted_values);
+	}
+}
+
+/// build corner table in parallel and store it in corner_table_ptr
+const corner_table& simple_mesh_base::build_corner_table() const
+{
+	std::shared_ptr<corner_table> ct_ptr = std::make_shared<corner_table>();
+	corner_table& ct = *ct_ptr;
+	idx_type nr_corners = get_nr_corners();
+	idx_type nr_positions = get_nr_positions();
+	unsigned nr_position_bits = 1;
+	while (nr_position_bits < 32 && (idx_type(1) << nr_position_bits) < nr_positions)
+		++nr_position_bits;
+
+	// corner to face map
+	ct.c2f.resize(nr_corners);
+	cgv::os::parallel_for(0, get_nr_faces(), [&](size_t fi) {
+		for (idx_type ci = begin_corner(idx_type(fi)); ci < end_corner(idx_type(fi)); ++ci)
+			ct.c2f[ci] = idx_type(fi);
+	});
+	auto edge_end = [this, &ct](idx_type ci) {
+		idx_type fi = ct.c2f[ci];
+		return c2p(ci + 1 == end_corner(fi) ? begin_corner(fi) : ci + 1);
+	};
+
+	// sort corners by the smaller position index of their undirected edges, which are the upper digits of the edge keys
+	std::vector<uint32_t> keys(nr_corners), corners(nr_corners);
+	cgv::os::parallel_for(0, nr_corners, [&](size_t ci) {
+		keys[ci] = std::min(c2p(idx_type(ci)), edge_end(idx_type(ci)));
+		corners[ci] = uint32_t(ci);
+	});
+	radix_sort(keys, corners, nr_position_bits);
+	// sort each run of corners with the same smaller position by the larger position, which is short for all but
+	// degenerate meshes, and pair successive corners with the same edge
+	ct.inv.resize(nr_corners);
+	cgv::os::parallel_for(0, nr_corners, [&](size_t i) {
+		if (i > 0 && keys[i - 1] == keys[i])
+			return;
+		size_t end = i + 1;
+		while (end < nr_corners && keys[end] == keys[i])
+			++end;
+		auto larger_position = [&](uint32_t ci) { return std::max(c2p(ci), edge_end(ci)); };
+		if (end - i > 16)
+			std::stable_sort(corners.begin() + i, corners.begin() + end, [&](uint32_t c0, uint32_t c1) { return larger_position(c0) < larger_position(c1); });
+		else {
+			for (size_t j = i + 1; j < end; ++j) {
+				uint32_t cj = corners[j];
+				idx_type pj = larger_position(cj);
+				size_t k = j;
+				for (; k > i && larger_position(corners[k - 1]) > pj; --k)
+					corners[k] = corners[k - 1];
+				corners[k] = cj;
+			}
+		}
+		for (size_t j = i; j < end; ) {
+			if (j + 1 < end && larger_position(corners[j + 1]) == larger_position(corners[j])) {
+				ct.inv[corners[j]] = corners[j + 1];
+				ct.inv[corners[j + 1]] = corners[j];
+				j += 2;
 			}
 			else
-				++halfedge_to_count[halfedge];
-			last_vi = vi;
+				ct.inv[corners[j++]] = idx_type(-1);
 		}
+	});
+
+	// enumerate edges in the order of their first corners with a parallel prefix sum over blocks of corners
+	cgv::os::thread_pool& pool = cgv::os::get_thread_pool();
+	size_t block_size = std::max(size_t(65536), pool.get_default_grain_size(nr_corners));
+	size_t nr_blocks = (size_t(nr_corners) + block_size - 1) / block_size;
+	std::vector<idx_type> block_edge_begins(nr_blocks + 1, 0);
+	auto is_first_corner = [&ct](idx_type ci) { return ct.inv[ci] == idx_type(-1) || ci < ct.inv[ci]; };
+	pool.parallel_for(0, nr_blocks, [&](size_t bi) {
+		idx_type count = 0;
+		for (idx_type ci = idx_type(bi * block_size); ci < std::min(size_t(nr_corners), (bi + 1) * block_size); ++ci)
+			if (is_first_corner(ci))
+				++count;
+		block_edge_begins[bi + 1] = count;
+	}, 1);
+	for (size_t bi = 0; bi < nr_blocks; ++bi)
+		block_edge_begins[bi + 1] += block_edge_begins[bi];
+	ct.c2e.resize(nr_corners);
+	ct.e2c.resize(block_edge_begins[nr_blocks]);
+	pool.parallel_for(0, nr_blocks, [&](size_t bi) {
+		idx_type ei = block_edge_begins[bi];
+		for (idx_type ci = idx_type(bi * block_size); ci < std::min(size_t(nr_corners), (bi + 1) * block_size); ++ci)
+			if (is_first_corner(ci)) {
+				ct.e2c[ei] = ci;
+				ct.c2e[ci] = ei++;
+			}
+	}, 1);
+	pool.parallel_for(0, nr_corners, [&](size_t ci) {
+		if (!is_first_corner(idx_type(ci)))
+			ct.c2e[ci] = ct.c2e[ct.inv[ci]];
+	});
+
+	// sort corners by position
+	cgv::os::parallel_for(0, nr_corners, [&](size_t ci) {
+		keys[ci] = c2p(idx_type(ci));
+		corners[ci] = uint32_t(ci);
+	});
+	radix_sort(keys, corners, nr_position_bits);
+	ct.position_corners.swap(corners);
+	ct.position_corner_begins.resize(size_t(nr_positions) + 1);
+	idx_type i = 0;
+	for (idx_type pi = 0; pi <= nr_positions; ++pi) {
+		while (i < nr_corners && keys[i] < pi)
+			++i;
+		ct.position_corner_begins[pi] = i;
 	}
+	corner_table_ptr = ct_ptr;
+	return ct;
 }
 
-/// compute a index vector storing the inv corners per corner and optionally index vectors with per position corner index, per corner next and or prev corner index (implementation assumes closed manifold connectivity)
+/// compute a index vector storing the inv corners per corner and optionally index vectors with per position corner index, per corner next and or prev corner index from the corner table
 void simple_mesh_base::compute_inv(std::vector<uint32_t>& inv, std::vector<uint32_t>* p2c_ptr, std::vector<uint32_t>* next_ptr, std::vector<uint32_t>* prev_ptr) const
 {
-	uint32_t fi, e = 0;
-	if (p2c_ptr)
+	const corner_table& ct = get_corner_table();
+	inv = ct.inv;
+	if (p2c_ptr) {
 		p2c_ptr->resize(get_nr_positions());
-	if (next_ptr)
-		next_ptr->resize(get_nr_corners());
-	if (prev_ptr)
-		prev_ptr->resize(get_nr_corners());
-	inv.resize(get_nr_corners(), uint32_t(-1));
-	std::map<std::pair<uint32_t, uint32_t>, uint32_t> pipj2ci;
-	for (fi = 0; fi < get_nr_faces(); ++fi) {
-		uint32_t prev_ci = end_corner(fi) - 1;
-		for (uint32_t ci = begin_corner(fi); ci < end_corner(fi); ++ci) {
-			uint32_t pi = c2p(ci);
-			if (p2c_ptr)
-				p2c_ptr->at(pi) = ci;
-			uint32_t next_ci = ci + 1 == end_corner(fi) ? begin_corner(fi) : ci + 1;
-			if (next_ptr)
-				next_ptr->at(ci) = next_ci;
-			if (prev_ptr)
-				prev_ptr->at(ci) = prev_ci;
-			prev_ci = ci;
-			uint32_t pj = c2p(next_ci);
-			std::pair<uint32_t, uint32_t> pipj(std::min(pi, pj), std::max(pi, pj));
-			if (pipj2ci.find(pipj) == pipj2ci.end())
-				pipj2ci[pipj] = ci;
-			else {
-				uint32_t inv_ci = pipj2ci[pipj];
-				inv[ci] = inv_ci;
-				inv[inv_ci] = ci;
-				pipj2ci.erase(pipj2ci.find(pipj));
+		for (uint32_t pi = 0; pi < get_nr_positions(); ++pi)
+			p2c_ptr->at(pi) = ct.p2c(pi);
+	}
+	if (next_ptr || prev_ptr) {
+		if (next_ptr)
+			next_ptr->resize(get_nr_corners());
+		if (prev_ptr)
+			prev_ptr->resize(get_nr_corners());
+		cgv::os::parallel_for(0, get_nr_faces(), [&](size_t fi) {
+			uint32_t prev_ci = end_corner(uint32_t(fi)) - 1;
+			for (uint32_t ci = begin_corner(uint32_t(fi)); ci < end_corner(uint32_t(fi)); ++ci) {
+				if (next_ptr)
+					(*next_ptr)[prev_ci] = ci;
+				if (prev_ptr)
+					(*prev_ptr)[ci] = prev_ci;
+				prev_ci = ci;
 			}
-		}
+		});
 	}
 }
 /// given the inv corners compute index vector per corner its edge index and optionally per edge its corner index (implementation assumes closed manifold connectivity)
@@ -401,18 +537,202 @@ void simple_mesh<T>::clear()
 	material_indices.clear();
 	materials.clear();
 	destruct_colors();
+	invalidate_corner_table();
 }
 
+/// identification of binary mesh files
+static const char bsm_magic[8] = { 'c', 'g', 'v', '_', 'b', 's', 'm', 0 };
+/// version of the binary mesh format
+static const cgv::type::uint32_type bsm_version = 2;
+/// value stored to detect files written on machines with different byte order
+static const cgv::type::uint32_type bsm_byte_order = 0x01020304;
+/// alignment of blocks within binary mesh files
+static const size_t bsm_alignment = 64;
+/// size of the blocks at the begin and end of source files that are hashed into the fingerprint
+static const size_t bsm_fingerprint_block_size = 4096;
+
+/// blocks of binary mesh files in the order in which they are stored
+enum BsmBlock
+{
+	BB_POSITIONS, BB_NORMALS, BB_TANGENTS, BB_TEX_COORDS,
+	BB_POSITION_INDICES, BB_NORMAL_INDICES, BB_TANGENT_INDICES, BB_TEX_COORD_INDICES,
+	BB_FACES, BB_GROUP_INDICES, BB_MATERIAL_INDICES, BB_COLORS,
+	BB_GROUP_NAMES, BB_MATERIALS, BB_SOURCE_FILE_NAME, BB_END
+};
+
+/// header of binary mesh files, which is followed by the blocks at the stored offsets
+struct bsm_header
+{
+	char magic[8];
+	cgv::type::uint32_type version;
+	cgv::type::uint32_type byte_order;
+	/// size of coordinates in bytes, which must match the coordinate type of the reading mesh
+	cgv::type::uint32_type coordinate_size;
+	/// storage type of colors
+	cgv::type::uint32_type color_type;
+	/// size and last write time of the file from which the mesh was read or -1 if unknown
+	cgv::type::uint64_type source_size;
+	cgv::type::int64_type source_write_time;
+	/// hash of the first and last block of the source file, which detects changes within the resolution of the write time
+	cgv::type::uint64_type source_fingerprint;
+	/// offset and size in bytes of each block
+	cgv::type::uint64_type block_offsets[BB_END];
+	cgv::type::uint64_type block_sizes[BB_END];
+};
+
+/// compute FNV-1a hash over the first and last bsm_fingerprint_block_size bytes of a file
+static cgv::type::uint64_type compute_source_fingerprint(const std::string& file_name)
+{
+	std::ifstream is(file_name, std::ios::binary);
+	if (!is)
+		return 0;
+	is.seekg(0, std::ios::end);
+	std::streamoff size = is.tellg();
+	std::streamoff block_size = std::streamoff(bsm_fingerprint_block_size);
+	std::vector<char> buffer(size_t(std::min(size, 2 * block_size)));
+	is.seekg(0);
+	if (size > 2 * block_size) {
+		is.read(buffer.data(), block_size);
+		is.seekg(size - block_size);
+		is.read(buffer.data() + block_size, block_size);
+	}
+	else
+		is.read(buffer.data(), buffer.size());
+	if (!is)
+		return 0;
+	cgv::type::uint64_type hash = 14695981039346656037ull;
+	for (char c : buffer) {
+		hash ^= cgv::type::uint8_type(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+/// append value in its binary representation to buffer
+template <typename V>
+static void append_value(std::vector<char>& buffer, const V& v)
+{
+	const char* ptr = reinterpret_cast<const char*>(&v);
+	buffer.insert(buffer.end(), ptr, ptr + sizeof(V));
+}
+/// append string with its length to buffer
+static void append_string(std::vector<char>& buffer, const std::string& s)
+{
+	append_value(buffer, cgv::type::uint32_type(s.size()));
+	buffer.insert(buffer.end(), s.begin(), s.end());
+}
+/// append all attributes of material to buffer
+static void append_material(std::vector<char>& buffer, const illum::textured_surface_material& m)
+{
+	append_string(buffer, m.get_name());
+	append_value(buffer, cgv::type::int32_type(m.get_brdf_type()));
+	append_value(buffer, m.get_diffuse_reflectance());
+	append_value(buffer, m.get_roughness());
+	append_value(buffer, m.get_metalness());
+	append_value(buffer, m.get_ambient_occlusion());
+	append_value(buffer, m.get_emission());
+	append_value(buffer, m.get_transparency());
+	append_value(buffer, m.get_propagation_slow_down());
+	append_value(buffer, m.get_roughness_anisotropy());
+	append_value(buffer, m.get_roughness_orientation());
+	append_value(buffer, m.get_specular_reflectance());
+	append_value(buffer, cgv::type::uint8_type(m.get_sRGBA_textures() ? 1 : 0));
+	append_value(buffer, cgv::type::uint32_type(m.get_nr_image_files()));
+	for (unsigned i = 0; i < m.get_nr_image_files(); ++i)
+		append_string(buffer, m.get_image_file_name(i));
+	int indices[9] = {
+		m.get_diffuse_index(), m.get_roughness_index(), m.get_metalness_index(),
+		m.get_ambient_index(), m.get_emission_index(), m.get_transparency_index(),
+		m.get_specular_index(), m.get_normal_index(), m.get_bump_index()
+	};
+	append_value(buffer, indices);
+	append_value(buffer, m.get_bump_scale());
+}
+
+/// sequential reader of values from a block that fails on reading beyond the end of the block
+struct bsm_block_reader
+{
+	const char* ptr;
+	const char* end;
+	bsm_block_reader(const char* _ptr, size_t size) : ptr(_ptr), end(_ptr + size) {}
+	template <typename V>
+	bool read(V& v)
+	{
+		if (size_t(end - ptr) < sizeof(V))
+			return false;
+		std::memcpy(&v, ptr, sizeof(V));
+		ptr += sizeof(V);
+		return true;
+	}
+	bool read(std::string& s)
+	{
+		cgv::type::uint32_type n;
+		if (!read(n) || size_t(end - ptr) < n)
+			return false;
+		s.assign(ptr, n);
+		ptr += n;
+		return true;
+	}
+	bool read(illum::textured_surface_material& m)
+	{
+		std::string name;
+		cgv::type::int32_type brdf_type;
+		illum::surface_material::color_type diffuse_reflectance, emission, specular_reflectance;
+		float roughness, metalness, ambient_occlusion, transparency, roughness_anisotropy, roughness_orientation, bump_scale;
+		std::complex<float> propagation_slow_down;
+		cgv::type::uint8_type sRGBA_textures;
+		cgv::type::uint32_type nr_image_files;
+		if (!(read(name) && read(brdf_type) && read(diffuse_reflectance) && read(roughness) && read(metalness) &&
+			read(ambient_occlusion) && read(emission) && read(transparency) && read(propagation_slow_down) &&
+			read(roughness_anisotropy) && read(roughness_orientation) && read(specular_reflectance) &&
+			read(sRGBA_textures) && read(nr_image_files)))
+			return false;
+		m = illum::textured_surface_material(name, illum::BrdfType(brdf_type), diffuse_reflectance, roughness, metalness,
+			ambient_occlusion, emission, transparency, propagation_slow_down, roughness_anisotropy, roughness_orientation,
+			specular_reflectance);
+		m.set_sRGBA_textures(sRGBA_textures != 0);
+		for (cgv::type::uint32_type i = 0; i < nr_image_files; ++i) {
+			std::string image_file_name;
+			if (!read(image_file_name))
+				return false;
+			m.add_image_file(image_file_name);
+		}
+		int indices[9];
+		if (!read(indices) || !read(bump_scale))
+			return false;
+		m.set_diffuse_index(indices[0]);
+		m.set_roughness_index(indices[1]);
+		m.set_metalness_index(indices[2]);
+		m.set_ambient_index(indices[3]);
+		m.set_emission_index(indices[4]);
+		m.set_transparency_index(indices[5]);
+		m.set_specular_index(indices[6]);
+		m.set_normal_index(indices[7]);
+		m.set_bump_index(indices[8]);
+		m.set_bump_scale(bump_scale);
+		return true;
+	}
+};
+
 /// read simple mesh from file
 template <typename T>
 bool simple_mesh<T>::read(const std::string& file_name)
 { 
 	std::string ext = cgv::utils::to_lower(cgv::utils::file::get_extension(file_name));
+	if (ext == "bsm")
+		return read_binary(file_name);
+	// the cache can only replace reading into an empty mesh, as reading otherwise appends to the mesh
+	bool use_cache = binary_cache_enabled && (ext == "obj" || ext == "stl") && positions.empty() && faces.empty();
+	std::string cache_file_name = file_name + ".bsm";
+	if (use_cache && read_binary(cache_file_name, file_name))
+		return true;
+	// the obj reader appends faces without start_face
+	invalidate_corner_table();
+	bool success = false;
 	if (ext == "obj") {
 		simple_mesh_obj_reader<T> reader(*this);
-		return reader.read_obj(file_name);
+		success = reader.read_obj(file_name);
 	}
-	if (ext == "stl") {
+	else if (ext == "stl") {
 		try {
 			stl_reader::StlMesh <T, unsigned> mesh(file_name);
 
@@ -429,30 +749,38 @@ bool simple_mesh<T>::read(const std::string& file_name)
 				for (size_t ci = 0; ci < 3; ++ci)
 					new_corner(mesh.tri_corner_ind(ti, ci), has_normals ? (unsigned)ti : -1);
 			}
-			return true;
+			success = true;
 		}
 		catch (std::exception& e) {
 			std::cout << e.what() << std::endl;
 			return false;
 		}
 	}
-	std::cerr << "unknown mesh file extension '*." << ext << "'" << std::endl;
-	return false;
+	else {
+		std::cerr << "unknown mesh file extension '*." << ext << "'" << std::endl;
+		return false;
+	}
+	// failing to write the cache, for example in read only directories, only affects the next read
+	if (success && use_cache)
+		write_binary(cache_file_name, file_name);
+	return success;
 }
 
-/// write simple mesh to file (currently only obj is supported)
+/// write simple mesh to file (currently obj and the binary format bsm are supported)
 template <typename T>
 bool simple_mesh<T>::write(const std::string& file_name) const
 {
+	if (cgv::utils::to_lower(cgv::utils::file::get_extension(file_name)) == "bsm")
+		return write_binary(file_name);
 	std::ofstream os(file_name);
 	if (os.fail())
 		return false;
 	for (const auto& p : positions)
-		os << "v " << p << std::endl;
+		os << "v " << p << "\n";
 	for (const auto& t : tex_coords)
-		os << "vt " << t << std::endl;
+		os << "vt " << t << "\n";
 	for (const auto& n : normals)
-		os << "vn " << n << std::endl;
+		os << "vn " << n << "\n";
 
 	bool nmls = position_indices.size() == normal_indices.size();
 	bool tcs = position_indices.size() == tex_coord_indices.size();
@@ -471,6 +799,163 @@ bool simple_mesh<T>::write(const std::string& file_name) const
 		}
 		os << "\n";
 	}
+	return !os.fail();
+}
+
+/// write simple mesh to binary file that stores all arrays as aligned blocks
+template <typename T>
+bool simple_mesh<T>::write_binary(const std::string& file_name, const std::string& source_file_name) const
+{
+	std::vector<char> group_names_block, materials_block, source_file_name_block;
+	append_value(group_names_block, cgv::type::uint32_type(group_names.size()));
+	for (const auto& gn : group_names)
+		append_string(group_names_block, gn);
+	append_value(materials_block, cgv::type::uint32_type(materials.size()));
+	for (const auto& m : materials)
+		append_material(materials_block, m);
+	append_string(source_file_name_block, source_file_name);
+
+	bsm_header header;
+	std::memset(&header, 0, sizeof(bsm_header));
+	std::memcpy(header.magic, bsm_magic, sizeof(bsm_magic));
+	header.version = bsm_version;
+	header.byte_order = bsm_byte_order;
+	header.coordinate_size = sizeof(T);
+	header.color_type = has_colors() ? get_color_storage_type() : CT_RGBA8;
+	header.source_size = cgv::type::uint64_type(-1);
+	header.source_write_time = -1;
+	if (!source_file_name.empty()) {
+		header.source_size = cgv::utils::file::size(source_file_name);
+		header.source_write_time = cgv::utils::file::get_last_write_time(source_file_name);
+		header.source_fingerprint = compute_source_fingerprint(source_file_name);
+	}
+	const void* block_ptrs[BB_END] = {
+		positions.data(), normals.data(), tangents.data(), tex_coords.data(),
+		position_indices.data(), normal_indices.data(), tangent_indices.data(), tex_coord_indices.data(),
+		faces.data(), group_indices.data(), material_indices.data(), has_colors() ? get_color_data_ptr() : 0,
+		group_names_block.data(), materials_block.data(), source_file_name_block.data()
+	};
+	size_t block_sizes[BB_END] = {
+		positions.size() * sizeof(vec3), normals.size() * sizeof(vec3), tangents.size() * sizeof(vec3), tex_coords.size() * sizeof(vec2),
+		position_indices.size() * sizeof(idx_type), normal_indices.size() * sizeof(idx_type), tangent_indices.size() * sizeof(idx_type), tex_coord_indices.size() * sizeof(idx_type),
+		faces.size() * sizeof(idx_type), group_indices.size() * sizeof(idx_type), material_indices.size() * sizeof(idx_type), get_nr_colors() * get_color_size(),
+		group_names_block.size(), materials_block.size(), source_file_name_block.size()
+	};
+	size_t offset = sizeof(bsm_header);
+	for (int bi = 0; bi < BB_END; ++bi) {
+		offset = (offset + bsm_alignment - 1) / bsm_alignment * bsm_alignment;
+		header.block_offsets[bi] = offset;
+		header.block_sizes[bi] = block_sizes[bi];
+		offset += block_sizes[bi];
+	}
+	// each block is written with a single call preceded by the zero padding up to its offset
+	FILE* fp = fopen(file_name.c_str(), "wb");
+	if (!fp)
+		return false;
+	static const char padding[bsm_alignment] = { 0 };
+	bool success = fwrite(&header, sizeof(bsm_header), 1, fp) == 1;
+	offset = sizeof(bsm_header);
+	for (int bi = 0; success && bi < BB_END; ++bi) {
+		size_t padding_size = size_t(header.block_offsets[bi]) - offset;
+		if (padding_size > 0)
+			success = fwrite(padding, 1, padding_size, fp) == padding_size;
+		if (success && block_sizes[bi] > 0)
+			success = fwrite(block_ptrs[bi], 1, block_sizes[bi], fp) == block_sizes[bi];
+		offset = size_t(header.block_offsets[bi]) + block_sizes[bi];
+	}
+	if (fclose(fp) != 0)
+		success = false;
+	if (!success)
+		std::remove(file_name.c_str());
+	return success;
+}
+
+/// copy array block of binary mesh file, whose size has been validated, to vector
+template <typename V>
+static void read_block(const cgv::utils::mapped_file& file, const bsm_header& header, BsmBlock bi, std::vector<V>& v)
+{
+	v.resize(size_t(header.block_sizes[bi] / sizeof(V)));
+	if (!v.empty())
+		std::memcpy(reinterpret_cast<char*>(v.data()), file.data() + header.block_offsets[bi], size_t(header.block_sizes[bi]));
+}
+
+/// read simple mesh from binary file written with write_binary through a memory mapping
+template <typename T>
+bool simple_mesh<T>::read_binary(const std::string& file_name, const std::string& source_file_name)
+{
+	cgv::utils::mapped_file file;
+	if (!file.open(file_name) || file.size() < sizeof(bsm_header))
+		return false;
+	bsm_header header;
+	std::memcpy(&header, file.data(), sizeof(bsm_header));
+	if (std::memcmp(header.magic, bsm_magic, sizeof(bsm_magic)) != 0 || header.version != bsm_version ||
+		header.byte_order != bsm_byte_order || header.coordinate_size != sizeof(T) || header.color_type > CT_RGBA)
+		return false;
+	for (int bi = 0; bi < BB_END; ++bi)
+		if (header.block_offsets[bi] > file.size() || header.block_sizes[bi] > file.size() - header.block_offsets[bi])
+			return false;
+	// validate source file and decode variable sized blocks before the mesh is changed
+	bsm_block_reader source_reader(file.data() + header.block_offsets[BB_SOURCE_FILE_NAME], size_t(header.block_sizes[BB_SOURCE_FILE_NAME]));
+	std::string stored_source_file_name;
+	if (!source_reader.read(stored_source_file_name))
+		return false;
+	if (!source_file_name.empty()) {
+		if (stored_source_file_name != source_file_name ||
+			header.source_size != cgv::type::uint64_type(cgv::utils::file::size(source_file_name)) ||
+			header.source_write_time != cgv::utils::file::get_last_write_time(source_file_name) ||
+			header.source_write_time == -1 ||
+			header.source_fingerprint != compute_source_fingerprint(source_file_name))
+			return false;
+	}
+	std::vector<std::string> new_group_names;
+	bsm_block_reader group_reader(file.data() + header.block_offsets[BB_GROUP_NAMES], size_t(header.block_sizes[BB_GROUP_NAMES]));
+	cgv::type::uint32_type n;
+	if (!group_reader.read(n))
+		return false;
+	for (new_group_names.resize(n); n > 0; --n)
+		if (!group_reader.read(new_group_names[new_group_names.size() - n]))
+			return false;
+	std::vector<mat_type> new_materials;
+	bsm_block_reader material_reader(file.data() + header.block_offsets[BB_MATERIALS], size_t(header.block_sizes[BB_MATERIALS]));
+	if (!material_reader.read(n))
+		return false;
+	for (new_materials.resize(n); n > 0; --n)
+		if (!material_reader.read(new_materials[new_materials.size() - n]))
+			return false;
+	static const size_t color_sizes[] = { sizeof(rgb8), sizeof(rgba8), sizeof(rgb), sizeof(rgba) };
+	size_t color_size = color_sizes[header.color_type];
+	if (header.block_sizes[BB_COLORS] % color_size != 0)
+		return false;
+	const BsmBlock vec3_blocks[] = { BB_POSITIONS, BB_NORMALS, BB_TANGENTS };
+	for (BsmBlock bi : vec3_blocks)
+		if (header.block_sizes[bi] % sizeof(vec3) != 0)
+			return false;
+	for (int bi = BB_POSITION_INDICES; bi <= BB_MATERIAL_INDICES; ++bi)
+		if (header.block_sizes[bi] % sizeof(idx_type) != 0)
+			return false;
+	if (header.block_sizes[BB_TEX_COORDS] % sizeof(vec2) != 0)
+		return false;
+
+	// copy arrays with one memcpy each
+	clear();
+	read_block(file, header, BB_POSITIONS, positions);
+	read_block(file, header, BB_NORMALS, normals);
+	read_block(file, header, BB_TANGENTS, tangents);
+	read_block(file, header, BB_TEX_COORDS, tex_coords);
+	read_block(file, header, BB_POSITION_INDICES, position_indices);
+	read_block(file, header, BB_NORMAL_INDICES, normal_indices);
+	read_block(file, header, BB_TANGENT_INDICES, tangent_indices);
+	read_block(file, header, BB_TEX_COORD_INDICES, tex_coord_indices);
+	read_block(file, header, BB_FACES, faces);
+	read_block(file, header, BB_GROUP_INDICES, group_indices);
+	read_block(file, header, BB_MATERIAL_INDICES, material_indices);
+	size_t nr_colors = size_t(header.block_sizes[BB_COLORS] / color_size);
+	if (nr_colors > 0) {
+		ensure_colors(ColorType(header.color_type), nr_colors);
+		std::memcpy(ref_color_data_ptr(), file.data() + header.block_offsets[BB_COLORS], size_t(header.block_sizes[BB_COLORS]));
+	}
+	group_names.swap(new_group_names);
+	materials.swap(new_materials);
 	return true;
 }
 
@@ -487,17 +972,13 @@ typename simple_mesh<T>::box_type simple_mesh<T>::compute_box() const
 template <typename T>
 void simple_mesh<T>::compute_vertex_normals()
 {
-	// clear previous normal info
-	if (has_normals())
-		normals.clear();
 	// copy position indices to normals
 	normal_indices = position_indices;
-	// initialize normals to null vectors
-	normals.resize(positions.size(), vec3(0.0f));
-	// iterate faces
-	for (idx_type fi = 0; fi < get_nr_faces(); ++fi) {
-		idx_type c0 = begin_corner(fi);
-		idx_type ce = end_corner(fi);
+	// compute normalized face normals, which are null vectors for degenerate faces
+	std::vector<vec3> face_normals(get_nr_faces());
+	cgv::os::parallel_for(0, get_nr_faces(), [&](size_t fi) {
+		idx_type c0 = begin_corner(idx_type(fi));
+		idx_type ce = end_corner(idx_type(fi));
 		vec3 p0 = position(position_indices[c0]);
 		vec3 dj = position(position_indices[c0 + 1]) - p0;
 		vec3 nml(0.0f);
@@ -507,14 +988,18 @@ void simple_mesh<T>::compute_vertex_normals()
 			dj = di;
 		}
 		T nl = nml.length();
-		if (nl > 1e-8f) {
-			nml *= 1.0f/nl;
-			for (idx_type ci = c0; ci < ce; ++ci)
-				normal(normal_indices[ci]) += nml;
-		}
-	}
-	for (auto& n : normals)
-		n.normalize();
+		face_normals[fi] = nl > 1e-8f ? nml * (1.0f / nl) : vec3(0.0f);
+	});
+	// average normals of the faces around each position, which are found in the corner table
+	const corner_table& ct = get_corner_table();
+	normals.resize(positions.size());
+	cgv::os::parallel_for(0, positions.size(), [&](size_t pi) {
+		vec3 nml(0.0f);
+		for (idx_type i = ct.position_corner_begins[pi]; i < ct.position_corner_begins[pi + 1]; ++i)
+			nml += face_normals[ct.c2f[ct.position_corners[i]]];
+		normals[pi] = nml;
+		normals[pi].normalize();
+	});
 }
 
 /// extract vertex attribute array and element array buffers for triangulation and edges in wireframe
@@ -698,35 +1183,30 @@ template <typename T> void simple_mesh<T>::compute_face_tangents(bool construct_
 
 template <typename T> void simple_mesh<T>::ambo()
 {
-	std::vector<uint32_t> c2e;
-	std::vector<uint32_t> e2c;
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	std::vector<uint32_t> p2c;
-	compute_inv(inv, &p2c, 0, &prev);
-	uint32_t e = compute_c2e(inv, c2e, &e2c);
+	const corner_table& ct = get_corner_table();
+	uint32_t e = ct.get_nr_edges();
 	mesh_type new_M;
 	// create one vertex per edge
 	for (uint32_t ei = 0; ei < e; ++ei) {
-		uint32_t pi = c2p(e2c[ei]);
-		uint32_t pj = c2p(inv[e2c[ei]]);
+		uint32_t pi = c2p(ct.e2c[ei]);
+		uint32_t pj = c2p(ct.inv[ct.e2c[ei]]);
 		new_M.new_position(normalize(position(pi) + position(pj)));
 	}
 	// create one face for original faces
 	for (uint32_t fi = 0; fi < get_nr_faces(); ++fi) {
 		uint32_t new_fi = new_M.start_face();
 		for (uint32_t ci = begin_corner(fi); ci < end_corner(fi); ++ci)
-			new_M.new_corner(c2e[ci], new_fi);
+			new_M.new_corner(ct.c2e[ci], new_fi);
 	}
 	// create one face for original vertices
 	for (uint32_t pi = 0; pi < get_nr_positions(); ++pi) {
-		uint32_t c0 = p2c[pi];
+		uint32_t c0 = ct.p2c(pi);
 		uint32_t ci = c0;
 		uint32_t new_fi = new_M.start_face();
 		do {
-			new_M.new_corner(c2e[ci], new_fi);
-			ci = prev[ci];
-			ci = inv[ci];
+			new_M.new_corner(ct.c2e[ci], new_fi);
+			ci = prev_corner(ci);
+			ci = ct.inv[ci];
 		} while (ci != c0);
 	}
 	new_M.compute_face_normals();
@@ -734,16 +1214,13 @@ template <typename T> void simple_mesh<T>::ambo()
 }
 template <typename T> void simple_mesh<T>::truncate(T lambda)
 {
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	std::vector<uint32_t> p2c;
-	compute_inv(inv, &p2c, 0, &prev);
+	const corner_table& ct = get_corner_table();
 	uint32_t c = get_nr_corners();
 	mesh_type new_M;
 	// create one vertex per corner
 	for (uint32_t ci = 0; ci < c; ++ci) {
 		uint32_t pi = c2p(ci);
-		uint32_t pj = c2p(inv[ci]);
+		uint32_t pj = c2p(ct.inv[ci]);
 		new_M.new_position(normalize((1 - lambda) * position(pi) + lambda * position(pj)));
 	}
 	// create one face for original faces
@@ -751,18 +1228,18 @@ template <typename T> void simple_mesh<T>::truncate(T lambda)
 		uint32_t new_fi = new_M.start_face();
 		for (uint32_t ci = begin_corner(fi); ci < end_corner(fi); ++ci) {
 			new_M.new_corner(ci, new_fi);
-			new_M.new_corner(inv[ci], new_fi);
+			new_M.new_corner(ct.inv[ci], new_fi);
 		}
 	}
 	// create one face for original vertices
 	for (uint32_t pi = 0; pi < get_nr_positions(); ++pi) {
-		uint32_t c0 = p2c[pi];
+		uint32_t c0 = ct.p2c(pi);
 		uint32_t ci = c0;
 		uint32_t new_fi = new_M.start_face();
 		do {
 			new_M.new_corner(ci, new_fi);
-			ci = prev[ci];
-			ci = inv[ci];
+			ci = prev_corner(ci);
+			ci = ct.inv[ci];
 		} while (ci != c0);
 	}
 	new_M.compute_face_normals();
@@ -770,16 +1247,13 @@ template <typename T> void simple_mesh<T>::truncate(T lambda)
 }
 template <typename T> void simple_mesh<T>::snub(T lambda)
 {
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	std::vector<uint32_t> p2c;
-	compute_inv(inv, &p2c, 0, &prev);
+	const corner_table& ct = get_corner_table();
 	uint32_t c = get_nr_corners();
 	mesh_type new_M;
 	// create one vertex per corner
 	for (uint32_t ci = 0; ci < c; ++ci) {
 		uint32_t pi = c2p(ci);
-		uint32_t pj = c2p(inv[ci]);
+		uint32_t pj = c2p(ct.inv[ci]);
 		new_M.new_position(normalize((1 - lambda) * position(pi) + lambda * position(pj)));
 	}
 	// create central face for original faces
@@ -793,21 +1267,21 @@ template <typename T> void simple_mesh<T>::snub(T lambda)
 	for (fi = 0; fi < get_nr_faces(); ++fi) {
 		for (uint32_t ci = begin_corner(fi); ci < end_corner(fi); ++ci) {
 			uint32_t new_fi = new_M.start_face();
-			uint32_t prev_ci = prev[ci];
+			uint32_t prev_ci = prev_corner(ci);
 			new_M.new_corner(prev_ci, new_fi);
-			new_M.new_corner(inv[prev_ci], new_fi);
+			new_M.new_corner(ct.inv[prev_ci], new_fi);
 			new_M.new_corner(ci, new_fi);
 		}
 	}
 	// create one face for original vertices
 	for (uint32_t pi = 0; pi < get_nr_positions(); ++pi) {
-		uint32_t c0 = p2c[pi];
+		uint32_t c0 = ct.p2c(pi);
 		uint32_t ci = c0;
 		uint32_t new_fi = new_M.start_face();
 		do {
 			new_M.new_corner(ci, new_fi);
-			ci = prev[ci];
-			ci = inv[ci];
+			ci = prev_corner(ci);
+			ci = ct.inv[ci];
 		} while (ci != c0);
 	}
 	new_M.compute_face_normals();
@@ -815,12 +1289,7 @@ template <typename T> void simple_mesh<T>::snub(T lambda)
 }
 template <typename T> void simple_mesh<T>::dual()
 {
-	std::vector<uint32_t> c2f;
-	std::vector<uint32_t> p2c;
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	compute_inv(inv, &p2c, 0, &prev);
-	compute_c2f(c2f);
+	const corner_table& ct = get_corner_table();
 	uint32_t f = get_nr_faces();
 	mesh_type new_M;
 	// create one vertex per face
@@ -833,13 +1302,13 @@ template <typename T> void simple_mesh<T>::dual()
 	}
 	// create one face for original vertices
 	for (uint32_t pi = 0; pi < get_nr_positions(); ++pi) {
-		uint32_t c0 = p2c[pi];
+		uint32_t c0 = ct.p2c(pi);
 		uint32_t ci = c0;
 		uint32_t new_fi = new_M.start_face();
 		do {
-			new_M.new_corner(c2f[ci], new_fi);
-			ci = prev[ci];
-			ci = inv[ci];
+			new_M.new_corner(ct.c2f[ci], new_fi);
+			ci = prev_corner(ci);
+			ci = ct.inv[ci];
 		} while (ci != c0);
 	}
 	new_M.compute_face_normals();
@@ -847,12 +1316,7 @@ template <typename T> void simple_mesh<T>::dual()
 }
 template <typename T> void simple_mesh<T>::gyro(T lambda)
 {
-	std::vector<uint32_t> c2f;
-	std::vector<uint32_t> p2c;
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	compute_inv(inv, &p2c, 0, &prev);
-	compute_c2f(c2f);
+	const corner_table& ct = get_corner_table();
 	uint32_t v = get_nr_positions();
 	uint32_t f = get_nr_faces();
 	uint32_t c = get_nr_corners();
@@ -872,14 +1336,14 @@ template <typename T> void simple_mesh<T>::gyro(T lambda)
 	uint32_t ci;
 	for (ci = 0; ci < c; ++ci) {
 		uint32_t pi = c2p(ci);
-		uint32_t pj = c2p(inv[ci]);
+		uint32_t pj = c2p(ct.inv[ci]);
 		new_M.new_position(normalize((1 - lambda) * position(pi) + lambda * position(pj)));
 	}
 	// create one face for per original corner
 	for (ci = 0; ci < c; ++ci) {
-		uint32_t inv_ci = inv[ci];
-		uint32_t prev_inv_ci = inv[prev[ci]];
-		uint32_t fi = c2f[ci];
+		uint32_t inv_ci = ct.inv[ci];
+		uint32_t prev_inv_ci = ct.inv[prev_corner(ci)];
+		uint32_t fi = ct.c2f[ci];
 		uint32_t pi = c2p(ci);
 		uint32_t new_fi = new_M.start_face();
 		new_M.new_corner(pi, new_fi);
@@ -899,15 +1363,8 @@ template <typename T> typename simple_mesh<T>::vec3 simple_mesh<T>::compute_norm
 
 template <typename T> void simple_mesh<T>::join()
 {
-	std::vector<uint32_t> c2e;
-	std::vector<uint32_t> e2c;
-	std::vector<uint32_t> inv;
-	std::vector<uint32_t> prev;
-	std::vector<uint32_t> p2c;
-	compute_inv(inv, &p2c, 0, &prev);
-	uint32_t e = compute_c2e(inv, c2e, &e2c);
-	std::vector<uint32_t> c2f;
-	compute_c2f(c2f);
+	const corner_table& ct = get_corner_table();
+	uint32_t e = ct.get_nr_edges();
 
 	uint32_t f = get_nr_faces();
 	uint32_t v = get_nr_positions();
@@ -927,11 +1384,11 @@ template <typename T> void simple_mesh<T>::join()
 
 	// create one face per edge
 	for (uint32_t ei = 0; ei < e; ++ei) {
-		uint32_t ci = e2c[ei];
-		uint32_t fi = c2f[ci];
+		uint32_t ci = ct.e2c[ei];
+		uint32_t fi = ct.c2f[ci];
 		uint32_t pi = c2p(ci);
-		uint32_t cj = inv[ci];
-		uint32_t fj = c2f[cj];
+		uint32_t cj = ct.inv[ci];
+		uint32_t fj = ct.c2f[cj];
 		uint32_t pj = c2p(cj);
 		new_M.start_face();
 		new_M.new_corner(fi + v, ei);
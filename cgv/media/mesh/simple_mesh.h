@@ -1,12 +1,14 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <cgv/math/fvec.h>
 #include <cgv/math/fmat.h>
 #include <cgv/utils/file.h>
 #include <cgv/media/illum/textured_surface_material.h>
 #include <cgv/media/axis_aligned_box.h>
 #include <cgv/media/colored_model.h>
+#include "mesh_simplification.h"
 
 #include "../lib_begin.h"
 
@@ -20,6 +22,34 @@ class simple_mesh_obj_reader;
 template <typename T>
 class CGV_API obj_loader_generic;
 
+/** adjacency information of the corners of a simple mesh, which is built on demand and cached by the mesh. Corners
+    are paired over edges, where the edge of a corner leads from its position to the position of the next corner in
+	its face. Corners of border edges have no inverse and in case of more than two corners per edge the corners are
+	paired in their order. */
+struct corner_table
+{
+	/// index type
+	typedef cgv::type::uint32_type idx_type;
+	/// per corner the inverse corner of the neighboring face, which shares its edge, or -1 at borders
+	std::vector<idx_type> inv;
+	/// per corner its face
+	std::vector<idx_type> c2f;
+	/// per corner its edge
+	std::vector<idx_type> c2e;
+	/// per edge its first corner
+	std::vector<idx_type> e2c;
+	/// per position the index of its first corner in position_corners and a final entry with the number of corners
+	std::vector<idx_type> position_corner_begins;
+	/// corners sorted by position and, for each position, in ascending order
+	std::vector<idx_type> position_corners;
+	/// return number of edges
+	idx_type get_nr_edges() const { return idx_type(e2c.size()); }
+	/// return number of positions for which the table was built
+	idx_type get_nr_positions() const { return idx_type(position_corner_begins.size() - 1); }
+	/// return the last corner of position pi or -1 if it is not used by any face
+	idx_type p2c(idx_type pi) const { return position_corner_begins[pi + 1] == position_corner_begins[pi] ? idx_type(-1) : position_corners[position_corner_begins[pi + 1] - 1]; }
+};
+
 /** coordinate type independent base class of simple mesh data structure that handles indices and colors. */
 class CGV_API simple_mesh_base : public colored_model
 {
@@ -44,6 +74,14 @@ protected:
 	std::vector<std::string> group_names;
 	std::vector<idx_type> material_indices;
 	std::vector<mat_type> materials;
+	/// whether read() caches obj and stl files in binary files
+	static bool binary_cache_enabled;
+	/// corner table, which is shared by copies of the mesh, reset when faces change and rebuilt when the number of positions changes
+	mutable std::shared_ptr<const corner_table> corner_table_ptr;
+	/// build corner table in parallel and store it in corner_table_ptr
+	const corner_table& build_corner_table() const;
+	/// reset corner table after changes of the faces
+	void invalidate_corner_table() { corner_table_ptr.reset(); }
 public:
 	/// default constructor
 	simple_mesh_base();
@@ -69,6 +107,17 @@ public:
 	bool has_tex_coord_indices() const { return tex_coord_indices.size() > 0 && tex_coord_indices.size() == position_indices.size(); }
 	/// return the number of faces
 	idx_type get_nr_faces() const { return idx_type(faces.size()); }
+	/** return the corner table, which is built on first access after the faces or the number of positions changed
+	    and then reused. Building is not thread safe, such that the corner table has to be accessed once before
+		concurrent accesses. */
+	const corner_table& get_corner_table() const
+	{
+		return corner_table_ptr && corner_table_ptr->get_nr_positions() == get_nr_positions() ? *corner_table_ptr : build_corner_table();
+	}
+	/// return the next corner in the face of corner ci based on the corner table
+	idx_type next_corner(idx_type ci) const { idx_type fi = get_corner_table().c2f[ci]; return ci + 1 == end_corner(fi) ? begin_corner(fi) : ci + 1; }
+	/// return the previous corner in the face of corner ci based on the corner table
+	idx_type prev_corner(idx_type ci) const { idx_type fi = get_corner_table().c2f[ci]; return ci == begin_corner(fi) ? end_corner(fi) - 1 : ci - 1; }
 	/// return the number of corners
 	idx_type get_nr_corners() const { return idx_type(position_indices.size()); }
 	/// return index of first corner of face with index fi
@@ -112,12 +161,20 @@ public:
 		const std::vector<idx_type>* face_perm_ptr = 0, std::vector<vec3i>* material_group_start_ptr = 0) const;
 	/// extract element array buffers for edges in wireframe
 	void extract_wireframe_element_buffer(const std::vector<idx_type>& vertex_indices, std::vector<idx_type>& edge_element_buffer) const;
-	/// compute a index vector storing the inv corners per corner and optionally index vectors with per position corner index, per corner next and or prev corner index (implementation assumes closed manifold connectivity)
+	/// compute a index vector storing the inv corners per corner and optionally index vectors with per position corner index, per corner next and or prev corner index from the corner table
 	void compute_inv(std::vector<uint32_t>& inv, std::vector<uint32_t>* p2c_ptr = 0, std::vector<uint32_t>* next_ptr = 0, std::vector<uint32_t>* prev_ptr = 0) const;
 	/// given the inv corners compute index vector per corner its edge index and optionally per edge its corner index and return edge count (implementation assumes closed manifold connectivity)
 	uint32_t compute_c2e(const std::vector<uint32_t>& inv, std::vector<uint32_t>& c2e, std::vector<uint32_t>* e2c_ptr = 0) const;
 	/// compute index vector with per corner its face index
 	void compute_c2f(std::vector<uint32_t>& c2f) const;
+	/** enable or disable that read() stores obj and stl files in a binary cache file next to them with the additional
+	    extension bsm and reads this one as long as the source file did not change (enabled by default). Changes are
+		detected from size, write time and a hash of the first and last 4 KiB of the source file, such that a rewrite
+		within the one second resolution of the write time that keeps the size and only changes the middle of the
+		file is not detected. */
+	static void set_binary_cache_enabled(bool enable) { binary_cache_enabled = enable; }
+	/// return whether the binary cache of read() is enabled
+	static bool is_binary_cache_enabled() { return binary_cache_enabled; }
 };
 
 /// the simple_mesh class is templated over the coordinate type that defaults to float
@@ -219,12 +276,24 @@ public:
 	box_type compute_box() const;
 	/// compute vertex normals by averaging triangle normals
 	void compute_vertex_normals();
+	/** simplify the mesh by quadric error metric based edge collapses of Garland and Heckbert (Surface Simplification
+	    Using Quadric Error Metrics, 1997), where faces are triangulated first and the result is a triangle mesh. Groups,
+		materials, normals, texture coordinates, tangents and per position colors are kept, where collapses across
+		attribute seams are only performed along the seams and borders as well as group and material boundaries are
+		kept in place by additional planes. Unreferenced positions and attributes are removed. */
+	simplification_statistics simplify(const simplification_parameters& params);
 	/// construct from obj loader
 	void construct(const obj_loader_generic<T>& loader, bool copy_grp_info, bool copy_material_info);
-	/// read simple mesh from file (currently only obj and stl are supported)
+	/// read simple mesh from file (currently obj, stl and the binary format bsm are supported), where obj and stl files are read from the binary cache if enabled and if the mesh is empty
 	bool read(const std::string& file_name);
-	/// write simple mesh to file (currently only obj is supported)
+	/// write simple mesh to file (currently obj and the binary format bsm are supported)
 	bool write(const std::string& file_name) const;
+	/// write simple mesh to binary file that stores all arrays as aligned blocks and optionally the name, size, write time and fingerprint of the file the mesh was read from
+	bool write_binary(const std::string& file_name, const std::string& source_file_name = "") const;
+	/** read simple mesh from binary file written with write_binary through a memory mapping. If a source file name
+	    is given, reading fails if the binary file was not written for this source file in its current size, write
+		time and hash of its first and last 4 KiB. The mesh is only changed if reading succeeds. */
+	bool read_binary(const std::string& file_name, const std::string& source_file_name = "");
 	/// extract vertex attribute array, return size of color in bytes
 	unsigned extract_vertex_attribute_buffer(
 		const std::vector<idx_type>& vertex_indices,
@@ -39,6 +39,8 @@ protected:
 	std::deque<vec_type> nmls;
 	/// store a pointer to the callback handler
 	streaming_mesh_callback_handler* smcbh;
+	/// vertex indices of triangles and quads passed to the callback handler, which avoids a static vector per call
+	std::vector<unsigned int> polygon_indices;
 public:
 	/// construct from callback handler
 	streaming_mesh(streaming_mesh_callback_handler* _smcbh = 0) : smcbh(_smcbh), nr_faces(0), idx_off(0) {
@@ -87,24 +89,24 @@ public:
 	}
 	/// construct a new triangle by calling the new polygon method of the callback handler
 	void new_triangle(unsigned int vi, unsigned int vj, unsigned int vk) {
-		static std::vector<unsigned int> vis(3);
-		vis[0] = vi;
-		vis[1] = vj;
-		vis[2] = vk;
+		polygon_indices.resize(3);
+		polygon_indices[0] = vi;
+		polygon_indices[1] = vj;
+		polygon_indices[2] = vk;
 		++nr_faces;
 		if (smcbh)
-			smcbh->new_polygon(vis);
+			smcbh->new_polygon(polygon_indices);
 	}
 	/// construct a new quad by calling the new polygon method of the callback handler
 	void new_quad(unsigned int vi, unsigned int vj, unsigned int vk, unsigned int vl) {
-		static std::vector<unsigned int> vis(4);
-		vis[0] = vi;
-		vis[1] = vj;
-		vis[2] = vk;
-		vis[3] = vl;
+		polygon_indices.resize(4);
+		polygon_indices[0] = vi;
+		polygon_indices[1] = vj;
+		polygon_indices[2] = vk;
+		polygon_indices[3] = vl;
 		++nr_faces;
 		if (smcbh)
-			smcbh->new_polygon(vis);
+			smcbh->new_polygon(polygon_indices);
 	}
 	/// construct a new polygon by calling the new polygon method of the callback handler
 	void new_polygon(const std::vector<unsigned int>& vertex_indices) {
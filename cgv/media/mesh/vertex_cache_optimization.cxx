@@ -0,0 +1,227 @@
+#include "vertex_cache_optimization.h"
+#include <algorithm>
+
+namespace cgv {
+	namespace media {
+		namespace mesh {
+
+typedef cgv::type::uint32_type idx_type;
+
+/// simulate a first in first out post transform vertex cache of given size on a triangle element buffer
+vertex_cache_statistics simulate_vertex_cache(const std::vector<idx_type>& triangle_elements, unsigned cache_size)
+{
+	vertex_cache_statistics s;
+	s.nr_triangles = triangle_elements.size() / 3;
+	size_t nr_elements = 3 * s.nr_triangles;
+	idx_type nr_vertices = 0;
+	for (size_t ei = 0; ei < nr_elements; ++ei)
+		nr_vertices = std::max(nr_vertices, triangle_elements[ei] + 1);
+	// a vertex is in the cache if less than cache_size vertices have been inserted after it, where the time starts
+	// after the cache size such that all vertices are initially outside of the cache
+	std::vector<size_t> time_stamps(nr_vertices, 0);
+	std::vector<bool> referenced(nr_vertices, false);
+	size_t time = cache_size + 1;
+	for (size_t ei = 0; ei < nr_elements; ++ei) {
+		idx_type vi = triangle_elements[ei];
+		if (!referenced[vi]) {
+			referenced[vi] = true;
+			++s.nr_vertices;
+		}
+		if (time - time_stamps[vi] > cache_size) {
+			time_stamps[vi] = time++;
+			++s.nr_cache_misses;
+		}
+	}
+	return s;
+}
+
+/// reorder the triangles of a triangle element buffer with the Tipsify algorithm
+void optimize_triangle_order(std::vector<idx_type>& triangle_elements, size_t nr_vertices,
+	unsigned cache_size, const std::vector<size_t>* range_starts_ptr, std::vector<size_t>* cluster_starts_ptr)
+{
+	size_t nr_elements = triangle_elements.size() / 3 * 3;
+	std::vector<size_t> range_starts = range_starts_ptr ? *range_starts_ptr : std::vector<size_t>(1, 0);
+	if (cluster_starts_ptr)
+		cluster_starts_ptr->clear();
+	// per vertex the number of not emitted triangles, the range of its triangles in the adjacency and its cache time
+	// stamp, which are allocated once for all ranges
+	std::vector<idx_type> live_counts(nr_vertices, 0), adjacency_begins(nr_vertices), adjacency_ends(nr_vertices);
+	std::vector<size_t> time_stamps(nr_vertices, 0);
+	size_t time = cache_size + 1;
+	std::vector<idx_type> range_vertices, adjacency, dead_end_stack, candidates, result;
+	std::vector<bool> emitted;
+	for (size_t ri = 0; ri < range_starts.size(); ++ri) {
+		size_t begin = range_starts[ri];
+		size_t end = ri + 1 < range_starts.size() ? range_starts[ri + 1] : nr_elements;
+		if (begin >= end)
+			continue;
+		size_t nr_triangles = (end - begin) / 3;
+		const idx_type* E = &triangle_elements[begin];
+
+		// build adjacency from vertices to the triangles of the range
+		range_vertices.clear();
+		for (size_t ei = 0; ei < 3 * nr_triangles; ++ei)
+			if (live_counts[E[ei]]++ == 0)
+				range_vertices.push_back(E[ei]);
+		idx_type offset = 0;
+		for (idx_type vi : range_vertices) {
+			adjacency_begins[vi] = adjacency_ends[vi] = offset;
+			offset += live_counts[vi];
+		}
+		adjacency.resize(offset);
+		for (size_t ei = 0; ei < 3 * nr_triangles; ++ei)
+			adjacency[adjacency_ends[E[ei]]++] = idx_type(ei / 3);
+
+		// emit all triangles around the fanning vertex and select the next fanning vertex among their vertices
+		emitted.assign(nr_triangles, false);
+		dead_end_stack.clear();
+		result.clear();
+		size_t cursor = 0;
+		idx_type fanning_vertex = E[0];
+		if (cluster_starts_ptr)
+			cluster_starts_ptr->push_back(begin);
+		while (true) {
+			candidates.clear();
+			for (idx_type ai = adjacency_begins[fanning_vertex]; ai < adjacency_ends[fanning_vertex]; ++ai) {
+				idx_type ti = adjacency[ai];
+				if (emitted[ti])
+					continue;
+				emitted[ti] = true;
+				for (int k = 0; k < 3; ++k) {
+					idx_type vi = E[3 * ti + k];
+					result.push_back(vi);
+					dead_end_stack.push_back(vi);
+					candidates.push_back(vi);
+					--live_counts[vi];
+					if (time - time_stamps[vi] > cache_size)
+						time_stamps[vi] = time++;
+				}
+			}
+			// prefer the oldest candidate that is still in the cache after emitting all of its remaining triangles
+			idx_type next_vertex = idx_type(-1);
+			size_t best_priority = 0;
+			for (idx_type vi : candidates) {
+				if (live_counts[vi] == 0)
+					continue;
+				size_t priority = 0;
+				if (time - time_stamps[vi] + 2 * live_counts[vi] <= cache_size)
+					priority = time - time_stamps[vi];
+				if (next_vertex == idx_type(-1) || priority > best_priority) {
+					next_vertex = vi;
+					best_priority = priority;
+				}
+			}
+			if (next_vertex == idx_type(-1)) {
+				// in a dead end continue with the most recently used vertex with live triangles or with the next vertex in input order
+				while (!dead_end_stack.empty()) {
+					idx_type vi = dead_end_stack.back();
+					dead_end_stack.pop_back();
+					if (live_counts[vi] > 0) {
+						next_vertex = vi;
+						break;
+					}
+				}
+				while (next_vertex == idx_type(-1) && cursor < 3 * nr_triangles) {
+					idx_type vi = E[cursor++];
+					if (live_counts[vi] > 0)
+						next_vertex = vi;
+				}
+				if (next_vertex == idx_type(-1))
+					break;
+				if (cluster_starts_ptr && time - time_stamps[next_vertex] > cache_size)
+					cluster_starts_ptr->push_back(begin + result.size());
+			}
+			fanning_vertex = next_vertex;
+		}
+		std::copy(result.begin(), result.end(), triangle_elements.begin() + begin);
+	}
+}
+
+/// sort the clusters within each range such that clusters facing away from the range center are drawn first
+void optimize_overdraw(std::vector<idx_type>& triangle_elements, const std::vector<cgv::math::fvec<float, 3> >& positions,
+	const std::vector<size_t>& cluster_starts, const std::vector<size_t>* range_starts_ptr)
+{
+	typedef cgv::math::fvec<float, 3> vec3;
+	struct cluster
+	{
+		size_t begin, end;
+		vec3 center, normal;
+		float area;
+		float sort_key;
+		cluster(size_t _begin, size_t _end) : begin(_begin), end(_end), center(0.0f), normal(0.0f), area(0), sort_key(0) {}
+	};
+	size_t nr_elements = triangle_elements.size() / 3 * 3;
+	std::vector<size_t> range_starts = range_starts_ptr ? *range_starts_ptr : std::vector<size_t>(1, 0);
+	std::vector<cluster> clusters;
+	std::vector<idx_type> sorted_elements;
+	size_t ci = 0;
+	for (size_t ri = 0; ri < range_starts.size(); ++ri) {
+		size_t begin = range_starts[ri];
+		size_t end = ri + 1 < range_starts.size() ? range_starts[ri + 1] : nr_elements;
+		// split range at the cluster starts within it
+		clusters.clear();
+		while (ci < cluster_starts.size() && cluster_starts[ci] <= begin)
+			++ci;
+		size_t cluster_begin = begin;
+		for (; ci < cluster_starts.size() && cluster_starts[ci] < end; ++ci) {
+			clusters.push_back({ cluster_begin, cluster_starts[ci] });
+			cluster_begin = cluster_starts[ci];
+		}
+		if (cluster_begin < end)
+			clusters.push_back({ cluster_begin, end });
+		if (clusters.size() < 2)
+			continue;
+
+		// compute area weighted center and normal of clusters and the center of the range
+		vec3 range_center(0.0f);
+		float range_area = 0;
+		for (auto& c : clusters) {
+			for (size_t ei = c.begin; ei + 2 < c.end; ei += 3) {
+				const vec3& p0 = positions[triangle_elements[ei]];
+				const vec3& p1 = positions[triangle_elements[ei + 1]];
+				const vec3& p2 = positions[triangle_elements[ei + 2]];
+				vec3 n = cross(p1 - p0, p2 - p0);
+				float a = n.length();
+				c.normal += n;
+				c.center += (a / 3) * (p0 + p1 + p2);
+				c.area += a;
+			}
+			range_center += c.center;
+			range_area += c.area;
+		}
+		if (range_area > 0)
+			range_center /= range_area;
+		for (auto& c : clusters) {
+			float normal_length = c.normal.length();
+			c.sort_key = 0;
+			if (c.area > 0 && normal_length > 0)
+				c.sort_key = dot(c.center / c.area - range_center, c.normal) / normal_length;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const cluster& c0, const cluster& c1) { return c0.sort_key > c1.sort_key; });
+		sorted_elements.clear();
+		for (const auto& c : clusters)
+			sorted_elements.insert(sorted_elements.end(), triangle_elements.begin() + c.begin, triangle_elements.begin() + c.end);
+		std::copy(sorted_elements.begin(), sorted_elements.end(), triangle_elements.begin() + begin);
+	}
+}
+
+/// order vertices by their first use in the triangle element buffer
+size_t optimize_vertex_fetch(std::vector<idx_type>& triangle_elements, size_t nr_vertices, std::vector<idx_type>& vertex_remap)
+{
+	vertex_remap.assign(nr_vertices, idx_type(-1));
+	idx_type nr_referenced = 0;
+	for (auto& vi : triangle_elements) {
+		if (vertex_remap[vi] == idx_type(-1))
+			vertex_remap[vi] = nr_referenced++;
+		vi = vertex_remap[vi];
+	}
+	idx_type next_index = nr_referenced;
+	for (auto& ri : vertex_remap)
+		if (ri == idx_type(-1))
+			ri = next_index++;
+	return nr_referenced;
+}
+
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cgv/math/fvec.h>
+#include <cgv/type/standard_types.h>
+
+#include "../lib_begin.h"
+
+namespace cgv {
+	namespace media {
+		namespace mesh {
+
+/// result of simulating a post transform vertex cache on a triangle element buffer
+struct vertex_cache_statistics
+{
+	/// number of triangles
+	size_t nr_triangles;
+	/// number of distinct vertices referenced by the triangles
+	size_t nr_vertices;
+	/// number of vertex transformations, i.e. of cache misses
+	size_t nr_cache_misses;
+	/// construct empty statistics
+	vertex_cache_statistics() : nr_triangles(0), nr_vertices(0), nr_cache_misses(0) {}
+	/// average cache miss ratio, i.e. transformed vertices per triangle, which is 3 in the worst case and approaches 0.5 for large regular meshes
+	double get_acmr() const { return nr_triangles == 0 ? 0.0 : double(nr_cache_misses) / nr_triangles; }
+	/// average transform to vertex ratio, i.e. transformations per referenced vertex, which is 1 in the optimal case
+	double get_atvr() const { return nr_vertices == 0 ? 0.0 : double(nr_cache_misses) / nr_vertices; }
+};
+
+/// simulate a first in first out post transform vertex cache of given size on a triangle element buffer
+extern CGV_API vertex_cache_statistics simulate_vertex_cache(const std::vector<cgv::type::uint32_type>& triangle_elements, unsigned cache_size = 16);
+
+/** reorder the triangles of a triangle element buffer with the Tipsify algorithm of Sander, Nehab and Barczak
+    (Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007), which is linear in the number of
+	triangles. The vertex order within each triangle is kept. Triangles are only reordered within ranges, which are
+	given by their first element offsets in ascending order and extend to the next range or the end of the buffer;
+	without range starts the whole buffer is one range. Optionally the element offsets of the clusters are returned,
+	where a cluster starts at the beginning of each range and whenever the algorithm has to continue with a vertex
+	that is not in the cache. */
+extern CGV_API void optimize_triangle_order(std::vector<cgv::type::uint32_type>& triangle_elements, size_t nr_vertices,
+	unsigned cache_size = 16, const std::vector<size_t>* range_starts_ptr = 0, std::vector<size_t>* cluster_starts_ptr = 0);
+
+/** sort the clusters returned by optimize_triangle_order within each range such that clusters facing away from the
+    range center are drawn first, which reduces overdraw of convex parts from all view directions while keeping the
+	vertex cache locality within the clusters. */
+extern CGV_API void optimize_overdraw(std::vector<cgv::type::uint32_type>& triangle_elements, const std::vector<cgv::math::fvec<float, 3> >& positions,
+	const std::vector<size_t>& cluster_starts, const std::vector<size_t>* range_starts_ptr = 0);
+
+/** compute a vertex permutation that orders vertices by their first use in the triangle element buffer, apply it to
+    the buffer and return the number of referenced vertices. vertex_remap maps old to new vertex indices, where
+	unreferenced vertices are appended in their original order. */
+extern CGV_API size_t optimize_vertex_fetch(std::vector<cgv::type::uint32_type>& triangle_elements, size_t nr_vertices,
+	std::vector<cgv::type::uint32_type>& vertex_remap);
+
+		}
+	}
+}
+
+#include <cgv/config/lib_end.h>
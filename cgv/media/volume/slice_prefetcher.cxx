@@ -0,0 +1,162 @@
+#include "slice_prefetcher.h"
+#include <algorithm>
+#include <iostream>
+
+namespace cgv {
+	namespace media {
+		namespace volume {
+
+			double slice_prefetcher::statistics::get_slices_per_second() const
+			{
+				return elapsed_seconds > 0 ? nr_slices / elapsed_seconds : 0.0;
+			}
+
+			double slice_prefetcher::statistics::get_megabytes_per_second() const
+			{
+				return elapsed_seconds > 0 ? nr_bytes / (1024.0*1024.0*elapsed_seconds) : 0.0;
+			}
+
+			slice_prefetcher::slice_prefetcher()
+			{
+				first_slice = next_slice = end_slice = 0;
+				stop_loading = false;
+				stats = statistics();
+			}
+
+			slice_prefetcher::~slice_prefetcher()
+			{
+				stop();
+				for (slot* s : slots)
+					delete s;
+			}
+
+			void slice_prefetcher::load_slices()
+			{
+				int capacity = int(slots.size());
+				std::unique_lock<std::mutex> lock(mtx);
+				while (true) {
+					// wait for a free slot in the window, where the slot of a skipped slice can still be loading
+					slot_free.wait(lock, [&]() {
+						return stop_loading || next_slice >= end_slice ||
+							(next_slice < first_slice + capacity && slots[next_slice % capacity]->state != SS_LOADING);
+					});
+					if (stop_loading || next_slice >= end_slice)
+						return;
+					int i = next_slice++;
+					slot& s = *slots[i % capacity];
+					s.slice_index = i;
+					s.state = SS_LOADING;
+					lock.unlock();
+					auto t0 = std::chrono::steady_clock::now();
+					bool success = ooc_sliced_volume::read_slice_file(file_names[i], s.df, s.dv);
+					auto t1 = std::chrono::steady_clock::now();
+					lock.lock();
+					s.state = success ? SS_READY : SS_FAILED;
+					if (success) {
+						++stats.nr_slices;
+						stats.nr_bytes += s.df.get_nr_bytes();
+					}
+					stats.read_seconds += std::chrono::duration<double>(t1 - t0).count();
+					stats.elapsed_seconds = std::chrono::duration<double>(t1 - start_time).count();
+					slice_ready.notify_all();
+					slot_free.notify_all();
+				}
+			}
+
+			bool slice_prefetcher::start(const ooc_sliced_volume& svol, unsigned nr_threads, unsigned capacity, int begin, int end,
+				const std::vector<std::string>* slice_file_names)
+			{
+				stop();
+				if (end == -1)
+					end = int(svol.get_nr_slices());
+				if (begin < 0 || begin > end || end > int(svol.get_nr_slices())) {
+					std::cerr << "slice range [" << begin << ", " << end << "[ not in [0, " << svol.get_nr_slices() << "[" << std::endl;
+					return false;
+				}
+				if (slice_file_names && slice_file_names->size() < size_t(end)) {
+					std::cerr << "only " << slice_file_names->size() << " slice file names given for " << end << " slices" << std::endl;
+					return false;
+				}
+				file_names.resize(end);
+				for (int i = begin; i < end; ++i)
+					file_names[i] = slice_file_names ? slice_file_names->at(i) : svol.get_slice_file_name(i);
+
+				capacity = std::max(1u, capacity);
+				for (size_t si = capacity; si < slots.size(); ++si)
+					delete slots[si];
+				slots.resize(capacity, 0);
+				for (slot*& s : slots) {
+					if (!s)
+						s = new slot();
+					s->df = svol.get_format();
+					s->dv = cgv::data::data_view();
+					s->slice_index = -1;
+					s->state = SS_FREE;
+				}
+				first_slice = next_slice = begin;
+				end_slice = end;
+				stop_loading = false;
+				stats = statistics();
+				start_time = std::chrono::steady_clock::now();
+
+				if (nr_threads == 0)
+					nr_threads = std::max(1u, std::thread::hardware_concurrency());
+				nr_threads = std::min(nr_threads, capacity);
+				for (unsigned t = 0; t < nr_threads; ++t)
+					loaders.push_back(std::thread(&slice_prefetcher::load_slices, this));
+				return true;
+			}
+
+			void slice_prefetcher::stop()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mtx);
+					stop_loading = true;
+				}
+				slot_free.notify_all();
+				slice_ready.notify_all();
+				for (auto& t : loaders)
+					t.join();
+				loaders.clear();
+			}
+
+			const cgv::data::data_view* slice_prefetcher::get_slice(int i)
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				int capacity = int(slots.size());
+				if (i < first_slice || i >= end_slice || i >= first_slice + capacity) {
+					std::cerr << "slice " << i << " not in window [" << first_slice << ", " << std::min(end_slice, first_slice + capacity) << "[" << std::endl;
+					return 0;
+				}
+				const slot& s = *slots[i % capacity];
+				auto t0 = std::chrono::steady_clock::now();
+				slice_ready.wait(lock, [&]() {
+					return stop_loading || (s.slice_index == i && (s.state == SS_READY || s.state == SS_FAILED));
+				});
+				stats.wait_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				if (s.slice_index != i || s.state != SS_READY)
+					return 0;
+				return &s.dv;
+			}
+
+			void slice_prefetcher::release_slices_before(int i)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mtx);
+					if (i <= first_slice)
+						return;
+					first_slice = std::min(i, end_slice);
+					// slices that have not been scheduled yet are skipped
+					next_slice = std::max(next_slice, first_slice);
+				}
+				slot_free.notify_all();
+			}
+
+			slice_prefetcher::statistics slice_prefetcher::get_statistics()
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				return stats;
+			}
+		}
+	}
+}
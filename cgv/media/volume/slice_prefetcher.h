@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "sliced_volume.h"
+
+#include "../lib_begin.h"
+
+namespace cgv {
+	namespace media {
+		namespace volume {
+
+			/** reads the slices of an ooc_sliced_volume ahead of the consumer with a pool of threads that decode slices into a
+				bounded ring of slice buffers. Slice i is stored in ring slot i modulo the capacity, such that the consumer can
+				access all slices of the window [first, first + capacity) that starts at the first not released slice. Streaming
+				algorithms like marching cubes keep a sliding window of slices and call release_slices_before to let the loader
+				threads refill the freed slots. */
+			class CGV_API slice_prefetcher
+			{
+			public:
+				/// throughput statistics
+				struct statistics
+				{
+					/// number of slices read
+					size_t nr_slices;
+					/// number of bytes of slice data read
+					size_t nr_bytes;
+					/// seconds since start
+					double elapsed_seconds;
+					/// summed seconds spent by loader threads in reading and decoding
+					double read_seconds;
+					/// seconds spent by the consumer in waiting for slices
+					double wait_seconds;
+					/// return slices per second since start
+					double get_slices_per_second() const;
+					/// return megabytes per second since start
+					double get_megabytes_per_second() const;
+				};
+			protected:
+				/// state of a ring slot
+				enum SlotState { SS_FREE, SS_LOADING, SS_READY, SS_FAILED };
+				/// ring slot with its own format and view such that slots can be filled concurrently
+				struct slot
+				{
+					cgv::data::data_format df;
+					cgv::data::data_view dv;
+					int slice_index;
+					SlotState state;
+				};
+				std::vector<slot*> slots;
+				std::vector<std::string> file_names;
+				/// first not released slice, next slice to be scheduled and end of slice range
+				int first_slice, next_slice, end_slice;
+				bool stop_loading;
+				std::vector<std::thread> loaders;
+				std::mutex mtx;
+				std::condition_variable slice_ready, slot_free;
+				statistics stats;
+				std::chrono::steady_clock::time_point start_time;
+				/// thread function of loaders
+				void load_slices();
+			public:
+				/// construct stopped prefetcher
+				slice_prefetcher();
+				/// stop loader threads and free slice buffers
+				~slice_prefetcher();
+				/** start prefetching the slices [begin, end) of an opened volume with nr_threads loader threads (0 ... use
+				    hardware concurrency) into a ring of capacity slice buffers, where end = -1 reads up to the last slice.
+					If slice_file_names is given, the i-th slice is read from its i-th entry instead of the file name
+					generated from the pattern of the volume. */
+				bool start(const ooc_sliced_volume& svol, unsigned nr_threads = 0, unsigned capacity = 16, int begin = 0, int end = -1,
+					const std::vector<std::string>* slice_file_names = 0);
+				/// stop loader threads
+				void stop();
+				/// return capacity of ring
+				unsigned get_capacity() const { return unsigned(slots.size()); }
+				/// return file name from which slice i is read
+				const std::string& get_slice_file_name(int i) const { return file_names[i]; }
+				/// wait for slice i in the window of not released slices and return a view of it, or 0 if it could not be read
+				const cgv::data::data_view* get_slice(int i);
+				/// release all slices before slice i such that their buffers can be refilled
+				void release_slices_before(int i);
+				/// return throughput statistics
+				statistics get_statistics();
+			};
+		}
+	}
+}
+
+#include <cgv/config/lib_end.h>
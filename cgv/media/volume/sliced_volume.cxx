@@ -115,33 +115,39 @@ namespace cgv {
 					return false;
 				}
 				std::string file_name = slice_file_name.empty() ? get_slice_file_name(i) : slice_file_name;
+				return read_slice_file(file_name, df, dv);
+			}
 
+			bool ooc_sliced_volume::read_slice_file(const std::string& file_name, cgv::data::data_format& slice_format, cgv::data::data_view& slice_view)
+			{
 				// detect special case for binary files
 				if (cgv::utils::file::get_extension(file_name).empty()) {
 					size_t file_size = cgv::utils::file::size(file_name);
-					size_t data_size = df.get_nr_bytes();
+					size_t data_size = slice_format.get_nr_bytes();
+					if (file_size == size_t(-1)) {
+						std::cerr << "could not read slice file " << file_name << "." << std::endl;
+						return false;
+					}
 					if (data_size > file_size) {
-						std::cerr << "slice file " << file_name << " too small: only contains " << file_size << " bytes, but " << df.get_nr_bytes() << " bytes needed." << std::endl;
+						std::cerr << "slice file " << file_name << " too small: only contains " << file_size << " bytes, but " << slice_format.get_nr_bytes() << " bytes needed." << std::endl;
 						return false;
 					}
-					char* content = cgv::utils::file::read(file_name);
-					if (!content) {
+					// read data stored at the end of the file directly into the slice
+					if (slice_view.empty())
+						new(&slice_view) data_view(&slice_format);
+					if (!cgv::utils::file::read(file_name, slice_view.get_ptr<char>(), data_size, false, file_size - data_size)) {
 						std::cerr << "could not read slice file " << file_name << "." << std::endl;
 						return false;
 					}
-					size_t offset = file_size - data_size;
-					if (dv.empty())
-						new(&dv) data_view(&df);
-					std::copy(content + offset, content + file_size, dv.get_ptr<char>());
 					return true;
 				}
 				else {
-					cgv::media::image::image_reader ir(df);
+					cgv::media::image::image_reader ir(slice_format);
 					if (!ir.open(file_name)) {
 						std::cerr << "could not open slice file " << file_name << std::endl;
 						return false;
 					}
-					if (!ir.read_image(dv)) {
+					if (!ir.read_image(slice_view)) {
 						std::cerr << "could not read slice file " << file_name << std::endl;
 						return false;
 					}
@@ -32,6 +32,8 @@ namespace cgv {
 				///
 				bool is_open() const;
 				bool read_slice(int i, const std::string& slice_file_name = "");
+				/// read a slice file into the given format and view, which can be called concurrently for different formats and views
+				static bool read_slice_file(const std::string& file_name, cgv::data::data_format& slice_format, cgv::data::data_view& slice_view);
 				/// open for write, set the data format to the slice format (width, height, components, component type) before calling this function
 				bool open_write(const std::string& file_name, const std::string& _file_name_pattern, unsigned nr_slices);
 				/// set the content of the data view through ref_data
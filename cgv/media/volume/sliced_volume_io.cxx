@@ -3,6 +3,7 @@
 #endif
 
 #include "sliced_volume_io.h"
+#include "slice_prefetcher.h"
 #include <cgv/utils/scan.h>
 #include <cgv/utils/file.h>
 #include <cgv/utils/progression.h>
@@ -181,7 +182,8 @@ namespace cgv {
 				}
 				return true;
 			}
-			bool read_from_sliced_volume(const std::string& file_name, volume& V)
+			bool read_from_sliced_volume(const std::string& file_name, volume& V,
+				unsigned nr_prefetch_threads, unsigned prefetch_capacity, slice_prefetcher::statistics* prefetch_statistics)
 			{
 				ooc_sliced_volume svol;
 				if (!svol.open_read(file_name)) {
@@ -283,39 +285,47 @@ namespace cgv {
 				std::size_t slize_size = V.get_voxel_size() * V.get_format().get_width() * V.get_format().get_height();
 				cgv::type::uint8_type* dst_ptr = V.get_data_ptr<cgv::type::uint8_type>();
 
-				for (int i = 0; i < (int)dims(2); ++i) {
-					switch (st) {
-					case ST_INDEX:
-						if (!svol.read_slice(i)) {
-							std::cerr << "could not read slice " << i << " with filename \"" << svol.get_slice_file_name(i) << "\"." << std::endl;
-							return false;
-						}
-						break;
-					case ST_FILTER: {
-						int j = i + svol.offset;
-						if ((unsigned)j > slice_file_names.size()) {
-							std::cerr << "could not read slice " << i << " from with filename with index " << j << " as only " << slice_file_names.size() << " match pattern." << std::endl;
-							return false;
-						}
-						if (!svol.read_slice(i, file_path + slice_file_names[j])) {
-							std::cerr << "could not read slice " << i << " from file \"" << slice_file_names[j] << "\"." << std::endl;
-							return false;
+				// slices of image files are read and decoded ahead by a pool of loader threads
+				slice_prefetcher prefetcher;
+				if (st != ST_VIDEO) {
+					std::vector<std::string> filtered_file_names;
+					if (st == ST_FILTER) {
+						for (int i = 0; i < (int)dims(2); ++i) {
+							int j = i + svol.offset;
+							if ((unsigned)j >= slice_file_names.size()) {
+								std::cerr << "could not read slice " << i << " from with filename with index " << j << " as only " << slice_file_names.size() << " match pattern." << std::endl;
+								return false;
+							}
+							filtered_file_names.push_back(file_path + slice_file_names[j]);
 						}
-						break;
 					}
-					case ST_VIDEO:
+					if (!prefetcher.start(svol, nr_prefetch_threads, prefetch_capacity, 0, dims(2), st == ST_FILTER ? &filtered_file_names : 0))
+						return false;
+				}
+				for (int i = 0; i < (int)dims(2); ++i) {
+					const cgv::type::uint8_type* src_ptr;
+					if (st == ST_VIDEO) {
 						if (!vr_ptr->read_frame(*dv_ptr)) {
 							std::cerr << "could not frame " << i << " from avi file \"" << svol.file_name_pattern << "\"." << std::endl;
 							return false;
 						}
-						break;
+						src_ptr = dv_ptr->get_ptr<cgv::type::uint8_type>();
+					}
+					else {
+						const cgv::data::data_view* slice_ptr = prefetcher.get_slice(i);
+						if (!slice_ptr) {
+							std::cerr << "could not read slice " << i << " from file \"" << prefetcher.get_slice_file_name(i) << "\"." << std::endl;
+							return false;
+						}
+						src_ptr = slice_ptr->get_ptr<cgv::type::uint8_type>();
 					}
-					const cgv::type::uint8_type* src_ptr =
-						st == ST_VIDEO ? dv_ptr->get_ptr<cgv::type::uint8_type>() :
-						svol.get_data_ptr<cgv::type::uint8_type>();
 					std::copy(src_ptr, src_ptr + slize_size, dst_ptr);
 					dst_ptr += slize_size;
+					if (st != ST_VIDEO)
+						prefetcher.release_slices_before(i + 1);
 				}
+				if (prefetch_statistics)
+					*prefetch_statistics = prefetcher.get_statistics();
 				svol.close();
 				return true;
 			}
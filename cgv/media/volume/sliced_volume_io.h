@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sliced_volume.h"
+#include "slice_prefetcher.h"
 
 #include "../lib_begin.h"
 
@@ -34,8 +35,12 @@ namespace cgv {
 			/// </summary>
 			/// <param name="file_name">name of svx file</param>
 			/// <param name="V">volume into which slices are read</param>
+			/// <param name="nr_prefetch_threads">number of threads that read and decode image slices ahead (0 ... use hardware concurrency)</param>
+			/// <param name="prefetch_capacity">number of slices that are buffered ahead of copying them into the volume</param>
+			/// <param name="prefetch_statistics">if given, the throughput statistics of reading the image slices are stored here</param>
 			/// <returns></returns>
-			extern CGV_API bool read_from_sliced_volume(const std::string& file_name, volume& V);
+			extern CGV_API bool read_from_sliced_volume(const std::string& file_name, volume& V,
+				unsigned nr_prefetch_threads = 0, unsigned prefetch_capacity = 16, slice_prefetcher::statistics* prefetch_statistics = 0);
 
 			extern CGV_API bool write_as_sliced_volume(const std::string& file_name, const std::string& file_name_pattern, const volume& V);
 		}
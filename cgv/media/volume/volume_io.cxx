@@ -21,8 +21,6 @@ namespace cgv {
 			volume_info::volume_info(const volume& V, const std::string& _path)
 			{
 				path = _path;
-				cgv::type::info::TypeId type_id;
-				cgv::data::ComponentFormat components;
 				dimensions = V.get_dimensions();
 				type_id = V.get_component_type();
 				components = V.get_format().get_standard_component_format();
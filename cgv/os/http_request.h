@@ -2,13 +2,37 @@
 
 #include <string>
 #include <map>
+#include <memory>
 
 namespace cgv {
 	namespace os {
 
+/** chunked body of a response that is written after handle_request returned, typically from another thread that
+    produces frames or point cloud chunks. All methods are thread safe. */
+struct http_response_stream
+{
+	/// virtual destructor
+	virtual ~http_response_stream() {}
+	/// queue chunk without copying its data, which is kept alive by owner until it has been sent; return false if the client disconnected
+	virtual bool send_chunk(const void* data, size_t size, const std::shared_ptr<const void>& owner) = 0;
+	/// queue copy of chunk and return false if the client disconnected
+	virtual bool send_chunk(const std::string& chunk) = 0;
+	/// return number of queued bytes, which allows producers to skip data for slow clients
+	virtual size_t get_nr_queued_bytes() const = 0;
+	/// return whether the client is still connected
+	virtual bool is_connected() const = 0;
+	/// finish response, after which further responses on the connection are sent
+	virtual void close() = 0;
+};
+
+/// shared pointer to response stream
+typedef std::shared_ptr<http_response_stream> http_response_stream_ptr;
+
 /// structure that contains all input and output parameters of a http request
 struct http_request
 {
+	/// initialize return values
+	http_request() : authentication_given(false), status("200 OK"), answer_data(0), answer_size(0), stream_answer(false) {}
 	/// this is the complete request received by the server
 	std::string request;
 	/**@name information of request split into fields*/
@@ -32,11 +56,17 @@ struct http_request
 	std::string accept_language;
 	std::string accept_encoding;
 	std::string user_agent;
+	/// protocol version, i.e. "HTTP/1.1"
+	std::string version;
+	/// all header fields with lower case names
+	std::map<std::string, std::string> headers;
+	/// body of request, i.e. of a POST request
+	std::string body;
 
 	/**@name return values*/
 	//@{
 	/** status: used to transmit server's error status, such as
-	 - 202 OK (this is set by default)
+	 - 200 OK (this is set by default)
 	 -  404 Not Found 
 	 and so on. */
 	std::string status;
@@ -45,6 +75,21 @@ struct http_request
 	std::string auth_realm;
 	/// set this member to the html page to be returned
 	std::string answer;
+	/// content type of answer, where empty content type selects html
+	std::string content_type;
+	/// additional header fields of the response
+	std::map<std::string, std::string> response_headers;
+	/// binary answer that is sent instead of answer without copy if answer_data is not 0
+	const void* answer_data;
+	size_t answer_size;
+	/// owner that keeps answer_data alive until it has been sent
+	std::shared_ptr<const void> answer_owner;
+	/// name of file that is sent instead of answer if not empty
+	std::string answer_file;
+	/// set to true to send the answer in chunks written to answer_stream after handle_request returned
+	bool stream_answer;
+	/// stream of chunked answer provided by the server
+	http_response_stream_ptr answer_stream;
 };
 
 	}
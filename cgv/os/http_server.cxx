@@ -0,0 +1,646 @@
+#include "http_server.h"
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+namespace cgv {
+	namespace os {
+
+/// content type of answers without content type
+static const char* default_content_type = "text/html; charset=ISO-8859-1";
+
+/// chunk of a streamed answer, which is sent between its size line and a line break
+struct http_server::chunk
+{
+	/// hexadecimal size followed by a line break
+	char size_line[24];
+	/// data copied into the chunk
+	std::string copy;
+	const void* data;
+	size_t size;
+	/// owner keeping referenced data alive
+	std::shared_ptr<const void> owner;
+	/// whether this is the empty chunk that finishes the answer
+	bool last;
+	chunk() : data(0), size(0), last(false) {}
+};
+
+/// request together with the state of its response
+struct http_server::response
+{
+	http_request request;
+	/// whether the handler finished
+	bool ready;
+	bool keep_alive;
+	/// whether the request only asks for the header of the response
+	bool head_only;
+	/// header of response, which is kept until it has been sent
+	std::string head;
+	/// opened answer file and its size
+	std::shared_ptr<FILE> file;
+	uint64_t file_size;
+	/// stream of answer
+	std::shared_ptr<response_stream> stream;
+	/// chunks written to the stream before the header has been sent
+	std::vector<std::shared_ptr<chunk> > pending_chunks;
+	response() : ready(false), keep_alive(true), head_only(false), file_size(0) {}
+};
+
+/// state of a connection, which is accessed in the thread running the server
+struct http_server::connection_state : public std::enable_shared_from_this<connection_state>
+{
+	/// connection or 0 after it has been closed
+	socket_connection* conn;
+	/// responses in request order
+	std::deque<std::shared_ptr<response> > responses;
+	/// request whose body has not been received completely together with the sizes of its header and body
+	std::shared_ptr<response> partial;
+	size_t partial_header_size, partial_body_size;
+	/// whether an interim response was sent to a client expecting it before sending the body
+	bool continue_sent;
+	/// whether the header of the streamed answer at the front of responses has been sent
+	bool streaming;
+	/// whether no further requests are parsed because of a malformed request or a response closing the connection
+	bool failed;
+	connection_state(socket_connection* _conn) : conn(_conn), partial_header_size(0), partial_body_size(0), continue_sent(false), streaming(false), failed(false) {}
+};
+
+/** stream of an answer, which posts chunks to the event loop. The response and connection of the stream are only
+    accessed in the thread running the server as long as the stream is attached. */
+class http_server::response_stream : public http_response_stream, public std::enable_shared_from_this<response_stream>
+{
+public:
+	http_server& server;
+	connection_state* state;
+	response* r;
+	bool attached;
+	/// loop to which chunks are posted, which is reset on detach
+	mutable std::mutex mtx;
+	socket_event_loop* loop;
+	std::atomic<bool> closed;
+	/// number of bytes in posted chunks and in the output queue of the connection
+	std::atomic<size_t> nr_posted_bytes, nr_connection_bytes;
+	response_stream(http_server& _server, connection_state* _state, response* _r)
+		: server(_server), state(_state), r(_r), attached(true), loop(_server.loop.get()), closed(false), nr_posted_bytes(0), nr_connection_bytes(0)
+	{
+	}
+	bool post(const std::shared_ptr<chunk>& c)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!loop)
+			return false;
+		std::shared_ptr<response_stream> s = shared_from_this();
+		loop->post([s, c]() { s->server.write_chunk(*s, c); });
+		return true;
+	}
+	bool send_chunk(const void* data, size_t size, const std::shared_ptr<const void>& owner)
+	{
+		if (closed)
+			return false;
+		// an empty chunk would finish the answer
+		if (size == 0)
+			return is_connected();
+		std::shared_ptr<chunk> c(new chunk());
+		c->data = data;
+		c->size = size;
+		c->owner = owner;
+		nr_posted_bytes += size;
+		return post(c);
+	}
+	bool send_chunk(const std::string& data)
+	{
+		if (closed)
+			return false;
+		if (data.empty())
+			return is_connected();
+		std::shared_ptr<chunk> c(new chunk());
+		c->copy = data;
+		c->data = c->copy.data();
+		c->size = c->copy.size();
+		nr_posted_bytes += c->size;
+		return post(c);
+	}
+	size_t get_nr_queued_bytes() const
+	{
+		return nr_posted_bytes + nr_connection_bytes;
+	}
+	bool is_connected() const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return loop != 0;
+	}
+	void close()
+	{
+		if (closed.exchange(true))
+			return;
+		std::shared_ptr<chunk> c(new chunk());
+		c->last = true;
+		post(c);
+	}
+	/// stop posting chunks, which is called in the thread running the server
+	void detach()
+	{
+		attached = false;
+		std::lock_guard<std::mutex> lock(mtx);
+		loop = 0;
+	}
+};
+
+/// return size of request header including the empty line or 0 if it has not been received completely
+static size_t find_header_end(const char* data, size_t size)
+{
+	const char* end = data + size;
+	for (const char* p = data; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))) != 0; ++p) {
+		if (p + 1 < end && p[1] == '\n')
+			return p + 2 - data;
+		if (p + 2 < end && p[1] == '\r' && p[2] == '\n')
+			return p + 3 - data;
+	}
+	return 0;
+}
+
+/// remove white space at the beginning and end of s
+static std::string trim(const std::string& s)
+{
+	size_t b = s.find_first_not_of(" \t\r");
+	if (b == std::string::npos)
+		return std::string();
+	return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+/// return lower case version of s
+static std::string to_lower(std::string s)
+{
+	for (auto& c : s)
+		c = char(std::tolower((unsigned char)c));
+	return s;
+}
+
+/// decode percent encoded characters and, if plus_is_space is true, pluses in s
+static std::string url_decode(const std::string& s, bool plus_is_space)
+{
+	std::string r;
+	r.reserve(s.size());
+	for (size_t i = 0; i < s.size(); ++i) {
+		if (s[i] == '%' && i + 2 < s.size() && std::isxdigit((unsigned char)s[i + 1]) && std::isxdigit((unsigned char)s[i + 2])) {
+			r += char(std::strtol(s.substr(i + 1, 2).c_str(), 0, 16));
+			i += 2;
+		}
+		else if (s[i] == '+' && plus_is_space)
+			r += ' ';
+		else
+			r += s[i];
+	}
+	return r;
+}
+
+/// decode base64 encoded string
+static std::string base64_decode(const std::string& s)
+{
+	static const std::string digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string r;
+	unsigned bits = 0;
+	int nr_bits = 0;
+	for (char c : s) {
+		size_t d = digits.find(c);
+		if (d == std::string::npos)
+			break;
+		bits = (bits << 6) | unsigned(d);
+		nr_bits += 6;
+		if (nr_bits >= 8) {
+			nr_bits -= 8;
+			r += char((bits >> nr_bits) & 255);
+		}
+	}
+	return r;
+}
+
+/// open file for reading and determine its size
+static std::shared_ptr<FILE> open_file(const std::string& file_name, uint64_t& size)
+{
+	FILE* fp = fopen(file_name.c_str(), "rb");
+	if (!fp)
+		return std::shared_ptr<FILE>();
+	std::shared_ptr<FILE> file(fp, fclose);
+#ifdef WIN32
+	if (_fseeki64(fp, 0, SEEK_END) != 0)
+		return std::shared_ptr<FILE>();
+	size = uint64_t(_ftelli64(fp));
+#else
+	if (fseeko(fp, 0, SEEK_END) != 0)
+		return std::shared_ptr<FILE>();
+	size = uint64_t(ftello(fp));
+#endif
+	return file;
+}
+
+http_server::http_server(const handler_type& _handler, unsigned nr_workers)
+	: handler(_handler), loop(new socket_event_loop()), max_nr_pipelined_requests(16), max_header_size(65536), max_body_size(16777216),
+	  nr_connections(0), nr_open_connections(0), nr_requests(0), date_time(0), running(false)
+{
+	if (nr_workers > 0) {
+		workers.reset(new thread_pool(int(nr_workers)));
+		tasks.reset(new task_group(*workers));
+	}
+}
+
+http_server::~http_server()
+{
+	stop();
+	// handlers post their responses to the loop, which therefore is destructed after all handlers finished
+	if (tasks)
+		tasks->wait();
+	loop.reset();
+	tasks.reset();
+	workers.reset();
+}
+
+bool http_server::listen(int port)
+{
+	// web clients connect from other hosts
+	return loop->listen(port, this, 1024, "0.0.0.0");
+}
+
+void http_server::run()
+{
+	{
+		std::lock_guard<std::mutex> lock(run_mtx);
+		running = true;
+		run_thread_id = std::this_thread::get_id();
+	}
+	loop->run();
+	std::lock_guard<std::mutex> lock(run_mtx);
+	running = false;
+	run_finished.notify_all();
+}
+
+void http_server::stop()
+{
+	loop->stop();
+	std::unique_lock<std::mutex> lock(run_mtx);
+	if (running && run_thread_id != std::this_thread::get_id())
+		run_finished.wait(lock, [this]() { return !running; });
+}
+
+http_server::statistics http_server::get_statistics() const
+{
+	statistics s;
+	s.nr_connections = nr_connections;
+	s.nr_open_connections = nr_open_connections;
+	s.nr_requests = nr_requests;
+	return s;
+}
+
+const std::string& http_server::get_date()
+{
+	std::time_t t = std::time(0);
+	if (t != date_time) {
+		char buffer[64];
+		std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&t));
+		date = buffer;
+		date_time = t;
+	}
+	return date;
+}
+
+void http_server::on_connect(socket_connection& c)
+{
+	std::shared_ptr<connection_state> cs(new connection_state(&c));
+	states[c.get_id()] = cs;
+	c.set_user_data(cs.get());
+	++nr_connections;
+	++nr_open_connections;
+}
+
+void http_server::on_receive(socket_connection& c)
+{
+	parse_requests(*static_cast<connection_state*>(c.get_user_data()));
+}
+
+void http_server::on_sent(socket_connection& c)
+{
+	connection_state& cs = *static_cast<connection_state*>(c.get_user_data());
+	if (cs.streaming)
+		cs.responses.front()->stream->nr_connection_bytes = 0;
+}
+
+void http_server::on_close(socket_connection& c)
+{
+	auto iter = states.find(c.get_id());
+	if (iter == states.end())
+		return;
+	connection_state& cs = *iter->second;
+	cs.conn = 0;
+	for (const auto& r : cs.responses)
+		if (r->stream)
+			r->stream->detach();
+	states.erase(iter);
+	--nr_open_connections;
+}
+
+bool http_server::parse_header(const char* header, size_t header_size, response& r) const
+{
+	http_request& q = r.request;
+	q.request.assign(header, header_size);
+	size_t line_end = q.request.find('\n');
+	std::string line = trim(q.request.substr(0, line_end));
+	// request line consists of method, target and protocol version
+	size_t p0 = line.find(' '), p1 = line.rfind(' ');
+	if (p0 == std::string::npos || p1 == p0)
+		return false;
+	q.method = line.substr(0, p0);
+	std::string target = trim(line.substr(p0 + 1, p1 - p0 - 1));
+	q.version = line.substr(p1 + 1);
+	if (target.empty() || q.version.compare(0, 5, "HTTP/") != 0)
+		return false;
+	size_t query = target.find('?');
+	q.path = url_decode(target.substr(0, query), false);
+	if (query != std::string::npos) {
+		std::string params = target.substr(query + 1);
+		for (size_t b = 0; b < params.size(); ) {
+			size_t e = std::min(params.find('&', b), params.size());
+			std::string param = params.substr(b, e - b);
+			size_t eq = param.find('=');
+			if (!param.empty())
+				q.params[url_decode(param.substr(0, eq), true)] = eq == std::string::npos ? std::string() : url_decode(param.substr(eq + 1), true);
+			b = e + 1;
+		}
+	}
+	// header fields
+	while (line_end != std::string::npos && line_end + 1 < q.request.size()) {
+		size_t b = line_end + 1;
+		line_end = q.request.find('\n', b);
+		line = q.request.substr(b, line_end == std::string::npos ? std::string::npos : line_end - b);
+		size_t colon = line.find(':');
+		if (colon == std::string::npos)
+			continue;
+		std::string name = to_lower(trim(line.substr(0, colon)));
+		std::string value = trim(line.substr(colon + 1));
+		std::string& field = q.headers[name];
+		field = field.empty() ? value : field + ", " + value;
+	}
+	for (const auto& h : q.headers) {
+		if (h.first == "authorization" && to_lower(h.second.substr(0, 6)) == "basic ") {
+			std::string decoded = base64_decode(trim(h.second.substr(6)));
+			size_t colon = decoded.find(':');
+			q.authentication_given = true;
+			q.username = decoded.substr(0, colon);
+			q.password = colon == std::string::npos ? std::string() : decoded.substr(colon + 1);
+		}
+		else if (h.first == "accept")
+			q.accept = h.second;
+		else if (h.first == "accept-language")
+			q.accept_language = h.second;
+		else if (h.first == "accept-encoding")
+			q.accept_encoding = h.second;
+		else if (h.first == "user-agent")
+			q.user_agent = h.second;
+	}
+	// HTTP/1.1 keeps connections alive by default and HTTP/1.0 only on request
+	auto iter = q.headers.find("connection");
+	std::string connection = iter == q.headers.end() ? std::string() : to_lower(iter->second);
+	r.keep_alive = q.version == "HTTP/1.0" ? connection.find("keep-alive") != std::string::npos : connection.find("close") == std::string::npos;
+	r.head_only = q.method == "HEAD";
+	return true;
+}
+
+void http_server::fail(connection_state& cs, const std::string& status)
+{
+	std::shared_ptr<response> r(new response());
+	r->request.status = status;
+	r->request.answer = status;
+	r->keep_alive = false;
+	r->ready = true;
+	cs.partial.reset();
+	cs.failed = true;
+	cs.responses.push_back(r);
+	cs.conn->set_reading_enabled(false);
+	flush(cs);
+}
+
+void http_server::parse_requests(connection_state& cs)
+{
+	socket_connection* c = cs.conn;
+	while (c && !c->is_closed() && !cs.failed) {
+		// stop reading while the pipeline is full
+		if (cs.responses.size() >= max_nr_pipelined_requests) {
+			c->set_reading_enabled(false);
+			return;
+		}
+		c->set_reading_enabled(true);
+		if (!cs.partial) {
+			size_t header_size = find_header_end(c->get_input(), c->get_input_size());
+			if (header_size == 0) {
+				if (c->get_input_size() > max_header_size)
+					fail(cs, "431 Request Header Fields Too Large");
+				return;
+			}
+			std::shared_ptr<response> r(new response());
+			if (header_size > max_header_size) {
+				fail(cs, "431 Request Header Fields Too Large");
+				return;
+			}
+			if (!parse_header(c->get_input(), header_size, *r)) {
+				fail(cs, "400 Bad Request");
+				return;
+			}
+			const auto& headers = r->request.headers;
+			// chunked request bodies are not supported
+			if (headers.find("transfer-encoding") != headers.end()) {
+				fail(cs, "501 Not Implemented");
+				return;
+			}
+			size_t body_size = 0;
+			auto iter = headers.find("content-length");
+			if (iter != headers.end()) {
+				char* end;
+				unsigned long long n = std::strtoull(iter->second.c_str(), &end, 10);
+				if (iter->second.empty() || *end != 0 || !std::isdigit((unsigned char)iter->second[0])) {
+					fail(cs, "400 Bad Request");
+					return;
+				}
+				if (n > max_body_size) {
+					fail(cs, "413 Payload Too Large");
+					return;
+				}
+				body_size = size_t(n);
+			}
+			cs.partial = r;
+			cs.partial_header_size = header_size;
+			cs.partial_body_size = body_size;
+			cs.continue_sent = false;
+		}
+		size_t request_size = cs.partial_header_size + cs.partial_body_size;
+		if (c->get_input_size() < request_size) {
+			// clients expecting an interim response wait before sending the body
+			auto iter = cs.partial->request.headers.find("expect");
+			if (!cs.continue_sent && iter != cs.partial->request.headers.end() && to_lower(iter->second) == "100-continue") {
+				c->send("HTTP/1.1 100 Continue\r\n\r\n");
+				cs.continue_sent = true;
+			}
+			return;
+		}
+		std::shared_ptr<response> r;
+		r.swap(cs.partial);
+		r->request.body.assign(c->get_input() + cs.partial_header_size, cs.partial_body_size);
+		c->consume(request_size);
+		cs.responses.push_back(r);
+		dispatch(cs.shared_from_this(), r);
+	}
+}
+
+void http_server::dispatch(const std::shared_ptr<connection_state>& cs, const std::shared_ptr<response>& r)
+{
+	++nr_requests;
+	r->stream.reset(new response_stream(*this, cs.get(), r.get()));
+	r->request.answer_stream = r->stream;
+	if (!tasks) {
+		handle(*r);
+		r->ready = true;
+		flush(*cs);
+		return;
+	}
+	tasks->run([this, cs, r]() {
+		handle(*r);
+		loop->post([this, cs, r]() {
+			r->ready = true;
+			if (!cs->conn)
+				return;
+			flush(*cs);
+			parse_requests(*cs);
+		});
+	});
+}
+
+void http_server::handle(response& r)
+{
+	http_request& q = r.request;
+	try {
+		handler(q);
+	}
+	catch (...) {
+		q.status = "500 Internal Server Error";
+		q.answer = q.status;
+		q.answer_data = 0;
+		q.answer_file.clear();
+		q.stream_answer = false;
+	}
+	if (q.stream_answer || q.answer_file.empty())
+		return;
+	r.file = open_file(q.answer_file, r.file_size);
+	if (!r.file) {
+		q.status = "404 Not Found";
+		q.answer = q.status;
+		q.answer_data = 0;
+	}
+}
+
+void http_server::flush(connection_state& cs)
+{
+	while (cs.conn && !cs.conn->is_closed() && !cs.streaming && !cs.responses.empty() && cs.responses.front()->ready) {
+		std::shared_ptr<response> r = cs.responses.front();
+		write_response(cs, r);
+		if (!cs.streaming) {
+			finish_response(cs);
+			continue;
+		}
+		// send chunks written before the header, where the last chunk finishes the response
+		std::vector<std::shared_ptr<chunk> > pending;
+		pending.swap(r->pending_chunks);
+		for (const auto& c : pending)
+			write_chunk(*r->stream, c);
+	}
+}
+
+void http_server::write_response(connection_state& cs, const std::shared_ptr<response>& r)
+{
+	http_request& q = r->request;
+	socket_connection& c = *cs.conn;
+	uint64_t size = r->file ? r->file_size : (q.answer_data ? q.answer_size : q.answer.size());
+	std::string& h = r->head;
+	h.reserve(256);
+	h = "HTTP/1.1 ";
+	if (!q.auth_realm.empty()) {
+		h += "401 Unauthorized\r\nWWW-Authenticate: Basic realm=\"";
+		h += q.auth_realm;
+		h += "\"\r\n";
+	}
+	else {
+		h += q.status;
+		h += "\r\n";
+	}
+	h += "Date: ";
+	h += get_date();
+	h += "\r\nServer: cgv web server\r\nContent-Type: ";
+	h += q.content_type.empty() ? default_content_type : q.content_type;
+	if (q.stream_answer)
+		h += "\r\nTransfer-Encoding: chunked";
+	else {
+		h += "\r\nContent-Length: ";
+		h += std::to_string(size);
+	}
+	h += r->keep_alive ? "\r\nConnection: keep-alive\r\n" : "\r\nConnection: close\r\n";
+	for (const auto& f : q.response_headers) {
+		h += f.first;
+		h += ": ";
+		h += f.second;
+		h += "\r\n";
+	}
+	h += "\r\n";
+	if (r->head_only)
+		c.send(h);
+	else if (q.stream_answer) {
+		c.send(h);
+		cs.streaming = true;
+	}
+	else if (r->file) {
+		c.send(h);
+		c.send_file(r->file, 0, r->file_size);
+	}
+	else {
+		// header and answer are sent without copies in one system call, where the response keeps both alive
+		socket_connection::buffer buffers[2] = { { h.data(), h.size() }, { q.answer_data ? q.answer_data : q.answer.data(), size_t(size) } };
+		c.send_shared(buffers, 2, r);
+	}
+}
+
+void http_server::write_chunk(response_stream& s, const std::shared_ptr<chunk>& c)
+{
+	if (!s.attached)
+		return;
+	connection_state& cs = *s.state;
+	if (!cs.streaming || cs.responses.front().get() != s.r) {
+		s.r->pending_chunks.push_back(c);
+		return;
+	}
+	socket_connection& conn = *cs.conn;
+	if (c->last) {
+		conn.send("0\r\n\r\n", 5);
+		cs.streaming = false;
+		finish_response(cs);
+		flush(cs);
+		parse_requests(cs);
+		return;
+	}
+	s.nr_posted_bytes -= c->size;
+	int n = std::snprintf(c->size_line, sizeof(c->size_line), "%llx\r\n", (unsigned long long)c->size);
+	socket_connection::buffer buffers[3] = { { c->size_line, size_t(n) }, { c->data, c->size }, { "\r\n", 2 } };
+	conn.send_shared(buffers, 3, c);
+	s.nr_connection_bytes = conn.get_nr_queued_bytes();
+}
+
+void http_server::finish_response(connection_state& cs)
+{
+	std::shared_ptr<response> r = cs.responses.front();
+	cs.responses.pop_front();
+	if (r->stream)
+		r->stream->detach();
+	if (!r->keep_alive) {
+		cs.failed = true;
+		cs.conn->close();
+	}
+}
+
+	}
+}
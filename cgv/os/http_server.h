@@ -0,0 +1,111 @@
+#pragma once
+
+#include "http_request.h"
+#include "socket_event_loop.h"
+#include "thread_pool.h"
+
+#include <ctime>
+#include <thread>
+#include <condition_variable>
+
+#include "lib_begin.h"
+
+namespace cgv {
+	namespace os {
+
+/** HTTP/1.1 server that serves all connections from a single thread with a socket_event_loop and runs request
+    handlers in a fixed number of worker threads. Connections are kept alive between requests and pipelined requests
+	are handled concurrently, while their responses are sent in request order. Answers are sent without copies from
+	the answer string, from a buffer with an owner or from a file through the kernel where supported. Answers
+	streamed with chunked transfer encoding are written to the answer_stream of the request from any thread. */
+class CGV_API http_server : public socket_connection_handler
+{
+public:
+	/// type of request handlers, which are called in worker threads or in the thread running the server if there are no workers
+	typedef std::function<void(http_request&)> handler_type;
+	/// statistics of server
+	struct statistics
+	{
+		/// number of accepted and of open connections
+		size_t nr_connections, nr_open_connections;
+		/// number of handled requests
+		size_t nr_requests;
+	};
+protected:
+	struct chunk;
+	struct response;
+	struct connection_state;
+	class response_stream;
+	handler_type handler;
+	std::unique_ptr<socket_event_loop> loop;
+	std::unique_ptr<thread_pool> workers;
+	std::unique_ptr<task_group> tasks;
+	/// state of each open connection by socket identifier
+	std::unordered_map<size_t, std::shared_ptr<connection_state> > states;
+	size_t max_nr_pipelined_requests, max_header_size, max_body_size;
+	std::atomic<size_t> nr_connections, nr_open_connections, nr_requests;
+	/// date header field and its time, which is updated once per second
+	std::string date;
+	std::time_t date_time;
+	/// whether and in which thread run() is executed
+	bool running;
+	std::thread::id run_thread_id;
+	std::mutex run_mtx;
+	std::condition_variable run_finished;
+	/// return date in the format of the date header field
+	const std::string& get_date();
+	/// parse and dispatch complete requests in the input buffer of connection
+	void parse_requests(connection_state& cs);
+	/// parse request line and header fields of request and return false if request is malformed
+	bool parse_header(const char* header, size_t header_size, response& r) const;
+	/// append response with given status and close connection after it has been sent
+	void fail(connection_state& cs, const std::string& status);
+	/// hand request to handler in worker or current thread
+	void dispatch(const std::shared_ptr<connection_state>& cs, const std::shared_ptr<response>& r);
+	/// call handler and open answer file, which is called in a worker thread
+	void handle(response& r);
+	/// send finished responses in request order
+	void flush(connection_state& cs);
+	/// send response header and answer or start streaming
+	void write_response(connection_state& cs, const std::shared_ptr<response>& r);
+	/// send chunk of streamed answer or queue it if the response header has not been sent yet
+	void write_chunk(response_stream& s, const std::shared_ptr<chunk>& c);
+	/// remove finished response from front of queue and close connection if it should not be kept alive
+	void finish_response(connection_state& cs);
+	/// create state of accepted connection
+	void on_connect(socket_connection& c);
+	/// parse received requests
+	void on_receive(socket_connection& c);
+	/// update queued bytes of streamed answer
+	void on_sent(socket_connection& c);
+	/// detach streams and remove state of closed connection
+	void on_close(socket_connection& c);
+public:
+	/// construct server with given request handler and number of worker threads, where 0 calls handlers in the thread running the server
+	http_server(const handler_type& _handler, unsigned nr_workers = 4);
+	/// wait for running handlers and close all connections
+	~http_server();
+	/// listen on given port (0 ... port chosen by system)
+	bool listen(int port);
+	/// return port of server
+	int get_port() const { return loop->get_listening_port(); }
+	/// return the last error
+	const std::string& get_last_error() const { return loop->get_last_error(); }
+	/// set maximum number of requests per connection that are handled before their responses have been sent (default 16)
+	void set_max_nr_pipelined_requests(size_t n) { max_nr_pipelined_requests = n; }
+	/// set maximum size of request header (default 65536), where larger requests are rejected
+	void set_max_header_size(size_t n) { max_header_size = n; }
+	/// set maximum size of request body (default 16 MB), where larger requests are rejected
+	void set_max_body_size(size_t n) { max_body_size = n; }
+	/// serve connections until stop is called
+	void run();
+	/// request run() to return and wait until it returned if it runs in another thread, which can be called from any thread
+	void stop();
+	/// return statistics
+	statistics get_statistics() const;
+};
+
+	}
+}
+
+#include <cgv/config/lib_end.h>
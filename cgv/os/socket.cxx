@@ -40,6 +40,13 @@ mutex& ref_show_mutex()
 	return sm;
 }
 
+/// mutex protecting the socket count and the not reentrant host name lookup, such that sockets can be used from several threads
+mutex& ref_socket_mutex()
+{
+	static mutex sm;
+	return sm;
+}
+
 int socket::nr_of_sockets= 0;
 bool socket::show_debug_output = false;
 
@@ -52,6 +59,7 @@ void socket::enable_debug_output(bool enable)
 
 bool socket::begin() 
 {
+	ref_socket_mutex().lock();
 	if (!nr_of_sockets) {
 #ifdef WIN32
 		WSADATA info;
@@ -61,6 +69,7 @@ bool socket::begin()
 				std::cerr << "could not start up windows socket dll" << std::endl;
 				ref_show_mutex().unlock();
 			}
+			ref_socket_mutex().unlock();
 			return false;
 		}
 		else
@@ -72,11 +81,13 @@ bool socket::begin()
 			}
 	}
 	++nr_of_sockets;
+	ref_socket_mutex().unlock();
 	return true;
 }
 
 void socket::end() 
 {
+	ref_socket_mutex().lock();
 	if (--nr_of_sockets == 0) {
 #ifdef WIN32
 		WSACleanup();
@@ -87,6 +98,7 @@ void socket::end()
 			ref_show_mutex().unlock();
 		}
 	}
+	ref_socket_mutex().unlock();
 
 }
 
@@ -134,13 +146,21 @@ std::string socket::get_last_error() const
 
 /// return whether data has arrived
 bool socket::is_data_pending() const
+{
+	return wait_for_data(0);
+}
+
+/// wait up to the given number of milliseconds for arriving data or a pending connection
+bool socket::wait_for_data(unsigned millisec) const
 {
 	fd_set set;
 	FD_ZERO(&set);
 	FD_SET(user_data, &set);
 	timeval t;
-	timerclear(&t);
-	return select(0, &set, 0, 0, &t) == 1;
+	t.tv_sec = millisec / 1000;
+	t.tv_usec = 1000 * (millisec % 1000);
+	// the first argument is ignored on windows and needs to exceed the largest descriptor otherwise
+	return select((int)user_data + 1, &set, 0, 0, &t) == 1;
 }
 
 /// return the number of data bytes that have been arrived at the socket
@@ -195,6 +215,17 @@ std::string socket::receive_data(unsigned int nr_of_bytes)
 	return ret;
 }
 
+int socket::receive_data(void* data, unsigned int max_nr_of_bytes)
+{
+	int received_nr_of_bytes = recv(user_data, (char*)data, (int)max_nr_of_bytes, 0);
+	if (received_nr_of_bytes <= 0) {
+		set_last_error("receive_data", received_nr_of_bytes == SOCKET_ERROR ? "" : "connection closed");
+		return received_nr_of_bytes == SOCKET_ERROR ? -1 : 0;
+	}
+	last_error.clear();
+	return received_nr_of_bytes;
+}
+
 std::string socket::receive_line() 
 {
 	std::string ret;
@@ -226,10 +257,20 @@ bool socket::send_line(const std::string& s)
 
 bool socket::send_data(const std::string& s)
 {
-	int nr_bytes = (int)s.length();
-	const char* buf = s.c_str();
+	return send_data(s.c_str(), (unsigned int)s.length());
+}
+
+bool socket::send_data(const void* data, unsigned int nr_of_bytes)
+{
+	int nr_bytes = (int)nr_of_bytes;
+	const char* buf = (const char*)data;
 	do {
+#ifdef MSG_NOSIGNAL
+		// report a connection closed by the peer as error instead of raising SIGPIPE
+		int nr_bytes_sent = send(user_data, buf, nr_bytes, MSG_NOSIGNAL);
+#else
 		int nr_bytes_sent = send(user_data, buf, nr_bytes, 0);
+#endif
 		if (nr_bytes_sent <= 0)
 			return set_last_error("send_data/line", nr_bytes_sent == SOCKET_ERROR ? "" : "connection closed");
 		nr_bytes -= nr_bytes_sent;
@@ -279,12 +320,16 @@ bool socket_client::connect(const std::string& host, int port)
 	}
 	std::string error;
 	hostent *he;
-	if ((he = gethostbyname(host.c_str())) == 0)
-		return set_last_error("connect");
 	sockaddr_in addr;
+	ref_socket_mutex().lock();
+	if ((he = gethostbyname(host.c_str())) == 0) {
+		ref_socket_mutex().unlock();
+		return set_last_error("connect");
+	}
+	addr.sin_addr = *((in_addr *)he->h_addr);
+	ref_socket_mutex().unlock();
 	addr.sin_family = AF_INET;
 	addr.sin_port = htons(port);
-	addr.sin_addr = *((in_addr *)he->h_addr);
 	memset(&(addr.sin_zero), 0, 8); 
 	if (::connect(user_data, (sockaddr *) &addr, sizeof(sockaddr)))
 		return set_last_error("connect");
@@ -8,8 +8,8 @@
 namespace cgv {
 	namespace os {
 
-/** base class for all sockets */
-class CGV_API socket : public data::ref_counted
+/** base class for all sockets, which are reference counted atomically as socket pointers are shared with threads */
+class CGV_API socket : public data::atomic_ref_counted
 {
 protected:
 	static bool show_debug_output;
@@ -18,6 +18,7 @@ protected:
 	static void end();
 	friend class socket_server;
 	friend class socket_select;
+	friend class socket_event_loop;
 	/// hides constructor from user
 	socket();
 	/// construct from existing socket identifier
@@ -37,16 +38,22 @@ public:
 	std::string get_last_error() const;
 	/// return whether data has arrived
 	bool is_data_pending() const;
+	/// wait up to the given number of milliseconds for arriving data or, in case of a socket server, a pending connection and return whether there is any
+	bool wait_for_data(unsigned millisec) const;
 	/// return the number of data bytes that have been arrived at the socket or -1 if socket is not connected
 	int get_nr_of_arrived_bytes() const;
 	/// receive data up to the next newline excluding the newline char
 	std::string receive_line();
 	/// receive all pending data or if nr_of_bytes is larger than 0, exactly nr_of_bytes
 	std::string receive_data(unsigned int nr_of_bytes = 0);
+	/// block until data arrived, copy up to max_nr_of_bytes into the given buffer and return the number of received bytes, 0 if the connection was closed or -1 on error
+	int receive_data(void* data, unsigned int max_nr_of_bytes);
 	/// extends line by newline and send as data
 	bool send_line(const std::string& content);
 	/// send the data in the string
 	bool send_data(const std::string&);
+	/// send the given number of bytes from the given buffer
+	bool send_data(const void* data, unsigned int nr_of_bytes);
 	/// close the socket
 	bool close();
 };
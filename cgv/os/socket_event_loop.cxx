@@ -0,0 +1,867 @@
+#include <errno.h>
+#ifdef WIN32
+#pragma warning(disable:4996)
+// WSAPoll is available since windows vista
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0600
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#define USE_EPOLL
+#define USE_SENDFILE
+#else
+#include <poll.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include "socket_event_loop.h"
+#include "socket.h"
+
+#ifndef WIN32
+typedef int SOCKET;
+#define INVALID_SOCKET -1
+#define SOCKET_ERROR   -1
+#define closesocket(s) ::close(s)
+#endif
+
+#ifdef WIN32
+typedef int socklen_t;
+#endif
+
+namespace cgv {
+	namespace os {
+
+/// maximum number of buffers passed to one gather send call
+const size_t max_nr_send_buffers = 64;
+/// maximum number of connections accepted per readiness event of a listener, such that a burst of connections does not starve open connections
+const int max_nr_accepts = 64;
+
+/// switch socket to non-blocking mode
+static bool set_non_blocking(SOCKET s)
+{
+#ifdef WIN32
+	u_long arg = 1;
+	return ioctlsocket(s, FIONBIO, &arg) == 0;
+#else
+	int flags = fcntl(s, F_GETFL, 0);
+	return flags != -1 && fcntl(s, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+/// return whether the last socket call failed only because it would have blocked
+static bool would_block()
+{
+#ifdef WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+/// return description of the error of the last socket call
+static std::string get_socket_error_text()
+{
+#ifdef WIN32
+	return std::string("windows socket error ") + std::to_string(WSAGetLastError());
+#else
+	return strerror(errno);
+#endif
+}
+
+struct socket_event_loop::poller
+{
+	/// readiness of a socket, where error is set if the connection was reset or hung up
+	struct event
+	{
+		size_t id;
+		bool readable, writable, error;
+	};
+#ifdef USE_EPOLL
+	int fd;
+	std::vector<epoll_event> epoll_events;
+	poller() : fd(epoll_create1(EPOLL_CLOEXEC)), epoll_events(256) {}
+	~poller() { if (fd != -1) ::close(fd); }
+	bool is_valid() const { return fd != -1; }
+	bool control(int op, size_t id, bool read, bool write)
+	{
+		epoll_event e;
+		e.events = (read ? uint32_t(EPOLLIN) : 0u) | (write ? uint32_t(EPOLLOUT) : 0u);
+		e.data.u64 = id;
+		return epoll_ctl(fd, op, int(id), &e) == 0;
+	}
+	bool add(size_t id, bool read, bool write) { return control(EPOLL_CTL_ADD, id, read, write); }
+	bool modify(size_t id, bool read, bool write) { return control(EPOLL_CTL_MOD, id, read, write); }
+	void remove(size_t id) { control(EPOLL_CTL_DEL, id, false, false); }
+	/// wait for events and return false on error
+	bool wait(int timeout_ms, std::vector<event>& events)
+	{
+		events.clear();
+		int n = epoll_wait(fd, epoll_events.data(), int(epoll_events.size()), timeout_ms);
+		if (n < 0)
+			return errno == EINTR;
+		for (int i = 0; i < n; ++i) {
+			const epoll_event& e = epoll_events[i];
+			event ev = { size_t(e.data.u64), (e.events & EPOLLIN) != 0, (e.events & EPOLLOUT) != 0, (e.events & (EPOLLERR | EPOLLHUP)) != 0 };
+			events.push_back(ev);
+		}
+		return true;
+	}
+#else
+	/// polled sockets and index of each socket in fds
+#ifdef WIN32
+	std::vector<WSAPOLLFD> fds;
+#else
+	std::vector<pollfd> fds;
+#endif
+	std::unordered_map<size_t, size_t> indices;
+	bool is_valid() const { return true; }
+	static short get_mask(bool read, bool write) { return short((read ? POLLIN : 0) | (write ? POLLOUT : 0)); }
+	bool add(size_t id, bool read, bool write)
+	{
+		indices[id] = fds.size();
+		fds.resize(fds.size() + 1);
+		fds.back().fd = SOCKET(id);
+		fds.back().events = get_mask(read, write);
+		fds.back().revents = 0;
+		return true;
+	}
+	bool modify(size_t id, bool read, bool write)
+	{
+		auto iter = indices.find(id);
+		if (iter == indices.end())
+			return false;
+		fds[iter->second].events = get_mask(read, write);
+		return true;
+	}
+	void remove(size_t id)
+	{
+		auto iter = indices.find(id);
+		if (iter == indices.end())
+			return;
+		// move last entry into the gap
+		size_t i = iter->second;
+		indices.erase(iter);
+		if (i + 1 < fds.size()) {
+			fds[i] = fds.back();
+			indices[size_t(fds[i].fd)] = i;
+		}
+		fds.pop_back();
+	}
+	bool wait(int timeout_ms, std::vector<event>& events)
+	{
+		events.clear();
+#ifdef WIN32
+		int n = WSAPoll(fds.data(), ULONG(fds.size()), timeout_ms);
+#else
+		int n = ::poll(fds.data(), nfds_t(fds.size()), timeout_ms);
+#endif
+		if (n < 0)
+			return would_block();
+		for (const auto& f : fds) {
+			if (f.revents == 0)
+				continue;
+			event ev = { size_t(f.fd), (f.revents & POLLIN) != 0, (f.revents & POLLOUT) != 0, (f.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 };
+			events.push_back(ev);
+		}
+		return true;
+	}
+#endif
+};
+
+socket_connection_statistics::socket_connection_statistics()
+{
+	nr_bytes_received = nr_bytes_sent = nr_receive_calls = nr_send_calls = 0;
+	elapsed_seconds = 0;
+}
+
+void socket_connection_statistics::add(const socket_connection_statistics& s)
+{
+	nr_bytes_received += s.nr_bytes_received;
+	nr_bytes_sent += s.nr_bytes_sent;
+	nr_receive_calls += s.nr_receive_calls;
+	nr_send_calls += s.nr_send_calls;
+	elapsed_seconds = std::max(elapsed_seconds, s.elapsed_seconds);
+}
+
+double socket_connection_statistics::get_received_megabytes_per_second() const
+{
+	return elapsed_seconds > 0 ? nr_bytes_received / (1048576.0 * elapsed_seconds) : 0.0;
+}
+
+double socket_connection_statistics::get_sent_megabytes_per_second() const
+{
+	return elapsed_seconds > 0 ? nr_bytes_sent / (1048576.0 * elapsed_seconds) : 0.0;
+}
+
+socket_connection_handler::~socket_connection_handler()
+{
+}
+
+void socket_connection_handler::on_connect(socket_connection&)
+{
+}
+
+void socket_connection_handler::on_sent(socket_connection&)
+{
+}
+
+void socket_connection_handler::on_close(socket_connection&)
+{
+}
+
+socket_connection::socket_connection(socket_event_loop& _loop, socket_connection_handler* _handler, size_t _id)
+	: loop(_loop), handler(_handler), id(_id)
+{
+	input_begin = input_end = 0;
+	nr_queued_bytes = 0;
+	reading_enabled = true;
+	waiting_for_writable = false;
+	closing = closed = false;
+	user_data = 0;
+	start_time = close_time = std::chrono::steady_clock::now();
+}
+
+void socket_connection::reserve_input(size_t n)
+{
+	if (input.size() - input_end >= n)
+		return;
+	if (input_begin > 0) {
+		std::memmove(input.data(), input.data() + input_begin, input_end - input_begin);
+		input_end -= input_begin;
+		input_begin = 0;
+	}
+	if (input.size() - input_end < n)
+		input.resize(input_end + n);
+}
+
+void socket_connection::consume(size_t nr_bytes)
+{
+	input_begin += std::min(nr_bytes, get_input_size());
+	if (input_begin == input_end)
+		input_begin = input_end = 0;
+}
+
+size_t socket_connection::find_line() const
+{
+	const char* begin = get_input();
+	const char* end = static_cast<const char*>(std::memchr(begin, '\n', get_input_size()));
+	return end ? end - begin + 1 : 0;
+}
+
+bool socket_connection::send(const void* data, size_t nr_bytes)
+{
+	buffer b = { data, nr_bytes };
+	return send(&b, 1);
+}
+
+long long socket_connection::send_directly(const buffer* buffers, size_t nr_buffers)
+{
+	// only send directly if nothing is queued to preserve the order of the data
+	if (!output.empty())
+		return 0;
+	long long n = loop.send_buffers(*this, buffers, nr_buffers);
+	if (n < 0)
+		loop.close_connection(*this);
+	return n;
+}
+
+void socket_connection::enqueue(output_segment& segment)
+{
+	nr_queued_bytes += size_t(segment.size);
+	output.push_back(std::move(segment));
+	if (!waiting_for_writable)
+		loop.update_events(*this);
+}
+
+bool socket_connection::send(const buffer* buffers, size_t nr_buffers)
+{
+	if (is_closed())
+		return false;
+	long long n = send_directly(buffers, nr_buffers);
+	if (n < 0)
+		return false;
+	// copy the part that was not accepted by the socket to the last segment if it holds copied data
+	size_t nr_sent = size_t(n);
+	for (size_t i = 0; i < nr_buffers; ++i) {
+		const char* data = static_cast<const char*>(buffers[i].data);
+		size_t size = buffers[i].size;
+		if (nr_sent >= size) {
+			nr_sent -= size;
+			continue;
+		}
+		if (output.empty() || output.back().copy.empty()) {
+			output.push_back(output_segment());
+			output.back().copy.swap(spare_copy);
+		}
+		output_segment& s = output.back();
+		s.copy.insert(s.copy.end(), data + nr_sent, data + size);
+		s.size += size - nr_sent;
+		nr_queued_bytes += size - nr_sent;
+		nr_sent = 0;
+	}
+	if (nr_queued_bytes > 0 && !waiting_for_writable)
+		loop.update_events(*this);
+	return true;
+}
+
+bool socket_connection::send_shared(const void* data, size_t nr_bytes, const std::shared_ptr<const void>& owner)
+{
+	buffer b = { data, nr_bytes };
+	return send_shared(&b, 1, owner);
+}
+
+bool socket_connection::send_shared(const buffer* buffers, size_t nr_buffers, const std::shared_ptr<const void>& owner)
+{
+	if (is_closed())
+		return false;
+	long long n = send_directly(buffers, nr_buffers);
+	if (n < 0)
+		return false;
+	// reference the part that was not accepted by the socket in the output queue
+	size_t nr_sent = size_t(n);
+	for (size_t i = 0; i < nr_buffers; ++i) {
+		if (nr_sent >= buffers[i].size) {
+			nr_sent -= buffers[i].size;
+			continue;
+		}
+		output_segment s;
+		s.data = static_cast<const char*>(buffers[i].data);
+		s.owner = owner;
+		s.offset = nr_sent;
+		s.size = buffers[i].size - nr_sent;
+		enqueue(s);
+		nr_sent = 0;
+	}
+	return true;
+}
+
+bool socket_connection::send_file(const std::shared_ptr<FILE>& file, uint64_t offset, uint64_t size)
+{
+	if (is_closed())
+		return false;
+	if (size == 0)
+		return true;
+	bool start = output.empty();
+	output_segment s;
+	s.owner = file;
+	s.file = file.get();
+	s.offset = offset;
+	s.size = size;
+	enqueue(s);
+	// start streaming immediately as the socket is probably writable
+	if (start) {
+		if (!loop.write_output(*this)) {
+			loop.close_connection(*this);
+			return false;
+		}
+		if (output.empty())
+			loop.update_events(*this);
+	}
+	return true;
+}
+
+void socket_connection::set_reading_enabled(bool enable)
+{
+	if (reading_enabled == enable)
+		return;
+	reading_enabled = enable;
+	if (!closed)
+		loop.update_events(*this);
+}
+
+void socket_connection::close(bool after_sending)
+{
+	if (closed)
+		return;
+	if (after_sending && get_nr_queued_bytes() > 0) {
+		closing = true;
+		loop.update_events(*this);
+	}
+	else
+		loop.close_connection(*this);
+}
+
+socket_connection_statistics socket_connection::get_statistics() const
+{
+	socket_connection_statistics s = stats;
+	s.elapsed_seconds = std::chrono::duration<double>((closed ? close_time : std::chrono::steady_clock::now()) - start_time).count();
+	return s;
+}
+
+socket_event_loop::socket_event_loop() : backend(new poller()), receive_size(65536), next_timer_id(1), wakeup_id(0), wakeup_pending(false), stop_requested(false)
+{
+	if (!socket::begin()) {
+		last_error = "could not initialize os specific socket shared library";
+		return;
+	}
+	if (!backend->is_valid()) {
+		set_last_error("socket_event_loop");
+		return;
+	}
+	// a datagram socket connected to its own loopback address can be waited for on all platforms
+	SOCKET s = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (s == INVALID_SOCKET) {
+		set_last_error("socket_event_loop");
+		return;
+	}
+	sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t len = sizeof(sa);
+	if (bind(s, (sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR ||
+		getsockname(s, (sockaddr*)&sa, &len) == SOCKET_ERROR ||
+		::connect(s, (sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR ||
+		!set_non_blocking(s) || !backend->add(size_t(s), true, false)) {
+		set_last_error("socket_event_loop");
+		closesocket(s);
+		return;
+	}
+	wakeup_id = size_t(s);
+}
+
+socket_event_loop::~socket_event_loop()
+{
+	for (auto& c : connections)
+		close_connection(*c.second);
+	destruct_closed_connections();
+	for (const auto& l : listeners)
+		closesocket(SOCKET(l.id));
+	if (wakeup_id)
+		closesocket(SOCKET(wakeup_id));
+	backend.reset();
+	socket::end();
+}
+
+const char* socket_event_loop::get_backend_name() const
+{
+#ifdef USE_EPOLL
+	return "epoll";
+#else
+	return "poll";
+#endif
+}
+
+bool socket_event_loop::set_last_error(const char* location)
+{
+	last_error = std::string(location) + ": " + get_socket_error_text();
+	return false;
+}
+
+bool socket_event_loop::listen(int port, socket_connection_handler* handler, int max_nr_pending_connections, const std::string& address)
+{
+	if (!wakeup_id)
+		return false;
+	sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+	if (inet_pton(AF_INET, address.c_str(), &sa.sin_addr) != 1) {
+		last_error = "listen: invalid IPv4 address " + address;
+		return false;
+	}
+	SOCKET s = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (s == INVALID_SOCKET)
+		return set_last_error("listen");
+#ifndef WIN32
+	// allow to listen again on the port immediately after the loop was destructed
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+	socklen_t len = sizeof(sa);
+	if (bind(s, (sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR ||
+		::listen(s, max_nr_pending_connections) != 0 ||
+		getsockname(s, (sockaddr*)&sa, &len) == SOCKET_ERROR ||
+		!set_non_blocking(s) || !backend->add(size_t(s), true, false)) {
+		set_last_error("listen");
+		closesocket(s);
+		return false;
+	}
+	listener l = { size_t(s), int(ntohs(sa.sin_port)), address, handler };
+	listeners.push_back(l);
+	last_error.clear();
+	return true;
+}
+
+socket_connection_statistics socket_event_loop::get_total_statistics() const
+{
+	socket_connection_statistics total;
+	for (const auto& c : connections)
+		total.add(c.second->get_statistics());
+	return total;
+}
+
+void socket_event_loop::accept_connections(const listener& l)
+{
+	for (int i = 0; i < max_nr_accepts; ++i) {
+		SOCKET s = ::accept(SOCKET(l.id), 0, 0);
+		if (s == INVALID_SOCKET) {
+			if (!would_block())
+				set_last_error("accept");
+			return;
+		}
+		// messages are collected by the handlers, such that small sends should not be delayed
+		int no_delay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+#ifdef SO_NOSIGPIPE
+		int no_sigpipe = 1;
+		setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+		if (!set_non_blocking(s) || !backend->add(size_t(s), true, false)) {
+			set_last_error("accept");
+			closesocket(s);
+			continue;
+		}
+		socket_connection* c = new socket_connection(*this, l.handler, size_t(s));
+		connections[size_t(s)].reset(c);
+		l.handler->on_connect(*c);
+	}
+}
+
+void socket_event_loop::receive(socket_connection& c)
+{
+	if (c.closed || !c.reading_enabled || c.closing)
+		return;
+	c.reserve_input(receive_size);
+	int n = recv(SOCKET(c.id), c.input.data() + c.input_end, int(c.input.size() - c.input_end), 0);
+	if (n > 0) {
+		c.input_end += n;
+		c.stats.nr_bytes_received += n;
+		++c.stats.nr_receive_calls;
+		c.handler->on_receive(c);
+	}
+	else if (n == 0 || !would_block())
+		close_connection(c);
+}
+
+long long socket_event_loop::send_buffers(socket_connection& c, const socket_connection::buffer* buffers, size_t nr_buffers)
+{
+	long long nr_sent = 0;
+	while (nr_buffers > 0) {
+		size_t m = std::min(nr_buffers, max_nr_send_buffers);
+		size_t size = 0;
+#ifdef WIN32
+		WSABUF wsa_buffers[max_nr_send_buffers];
+		for (size_t i = 0; i < m; ++i) {
+			wsa_buffers[i].buf = (CHAR*)buffers[i].data;
+			wsa_buffers[i].len = ULONG(buffers[i].size);
+			size += buffers[i].size;
+		}
+		DWORD n;
+		if (WSASend(SOCKET(c.id), wsa_buffers, DWORD(m), &n, 0, 0, 0) != 0)
+			return would_block() ? nr_sent : -1;
+#else
+		iovec io_buffers[max_nr_send_buffers];
+		for (size_t i = 0; i < m; ++i) {
+			io_buffers[i].iov_base = const_cast<void*>(buffers[i].data);
+			io_buffers[i].iov_len = buffers[i].size;
+			size += buffers[i].size;
+		}
+		msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = io_buffers;
+		msg.msg_iovlen = m;
+#ifdef MSG_NOSIGNAL
+		// report a connection closed by the peer as error instead of raising SIGPIPE
+		ssize_t n = sendmsg(c.id, &msg, MSG_NOSIGNAL);
+#else
+		ssize_t n = sendmsg(c.id, &msg, 0);
+#endif
+		if (n < 0)
+			return would_block() ? nr_sent : -1;
+#endif
+		c.stats.nr_bytes_sent += n;
+		++c.stats.nr_send_calls;
+		nr_sent += n;
+		// stop if the socket buffer is full
+		if (size_t(n) < size)
+			break;
+		buffers += m;
+		nr_buffers -= m;
+	}
+	return nr_sent;
+}
+
+long long socket_event_loop::send_file_part(socket_connection& c, const socket_connection::output_segment& segment)
+{
+#ifdef USE_SENDFILE
+	// the kernel copies from the page cache to the socket
+	off_t offset = off_t(segment.offset);
+	ssize_t n = sendfile(int(c.id), fileno(segment.file), &offset, size_t(std::min(segment.size, uint64_t(1) << 30)));
+	if (n < 0)
+		return would_block() ? 0 : -1;
+	// a file shorter than announced cannot complete the segment
+	if (n == 0)
+		return -1;
+	c.stats.nr_bytes_sent += n;
+	++c.stats.nr_send_calls;
+	return n;
+#else
+	file_buffer.resize(receive_size);
+	size_t size = size_t(std::min(segment.size, uint64_t(file_buffer.size())));
+#ifdef WIN32
+	if (_fseeki64(segment.file, segment.offset, SEEK_SET) != 0)
+#else
+	if (fseeko(segment.file, off_t(segment.offset), SEEK_SET) != 0)
+#endif
+		return -1;
+	size_t nr_read = fread(file_buffer.data(), 1, size, segment.file);
+	if (nr_read == 0)
+		return -1;
+	socket_connection::buffer b = { file_buffer.data(), nr_read };
+	return send_buffers(c, &b, 1);
+#endif
+}
+
+bool socket_event_loop::write_output(socket_connection& c)
+{
+	while (!c.output.empty()) {
+		socket_connection::output_segment& front = c.output.front();
+		if (front.file) {
+			long long n = send_file_part(c, front);
+			if (n < 0)
+				return false;
+			if (n == 0)
+				return true;
+			front.offset += n;
+			front.size -= n;
+			c.nr_queued_bytes -= size_t(n);
+			if (front.size == 0)
+				c.output.pop_front();
+			continue;
+		}
+		// gather consecutive memory segments into one system call
+		socket_connection::buffer buffers[max_nr_send_buffers];
+		size_t nr_buffers = 0, size = 0;
+		for (auto i = c.output.begin(); i != c.output.end() && !i->file && nr_buffers < max_nr_send_buffers; ++i) {
+			buffers[nr_buffers].data = (i->copy.empty() ? i->data : i->copy.data()) + i->offset;
+			buffers[nr_buffers].size = size_t(i->size);
+			size += size_t(i->size);
+			++nr_buffers;
+		}
+		long long n = send_buffers(c, buffers, nr_buffers);
+		if (n < 0)
+			return false;
+		c.nr_queued_bytes -= size_t(n);
+		for (size_t k = size_t(n); k > 0; ) {
+			socket_connection::output_segment& s = c.output.front();
+			if (k < s.size) {
+				s.offset += k;
+				s.size -= k;
+				break;
+			}
+			k -= size_t(s.size);
+			// keep the copy buffer for the next copy
+			if (s.copy.capacity() > c.spare_copy.capacity() && s.copy.capacity() <= 16 * receive_size) {
+				s.copy.clear();
+				c.spare_copy.swap(s.copy);
+			}
+			c.output.pop_front();
+		}
+		if (size_t(n) < size)
+			return true;
+	}
+	return true;
+}
+
+void socket_event_loop::send_queued(socket_connection& c)
+{
+	if (c.closed || c.output.empty())
+		return;
+	if (!write_output(c)) {
+		close_connection(c);
+		return;
+	}
+	if (!c.output.empty())
+		return;
+	if (c.closing) {
+		close_connection(c);
+		return;
+	}
+	update_events(c);
+	c.handler->on_sent(c);
+}
+
+void socket_event_loop::update_events(socket_connection& c)
+{
+	c.waiting_for_writable = c.get_nr_queued_bytes() > 0;
+	backend->modify(c.id, c.reading_enabled && !c.closing, c.waiting_for_writable);
+}
+
+void socket_event_loop::close_connection(socket_connection& c)
+{
+	if (c.closed)
+		return;
+	c.closed = true;
+	c.close_time = std::chrono::steady_clock::now();
+	backend->remove(c.id);
+	// the socket is closed later, such that its identifier is not reused while events are dispatched
+	closed_connections.push_back(c.id);
+}
+
+void socket_event_loop::destruct_closed_connections()
+{
+	// handlers can close further connections
+	while (!closed_connections.empty()) {
+		std::vector<size_t> ids;
+		ids.swap(closed_connections);
+		for (size_t id : ids) {
+			auto iter = connections.find(id);
+			if (iter == connections.end())
+				continue;
+			iter->second->handler->on_close(*iter->second);
+			closesocket(SOCKET(id));
+			connections.erase(iter);
+		}
+	}
+}
+
+size_t socket_event_loop::add_timer(double delay, const function_type& callback, double period)
+{
+	size_t id = next_timer_id++;
+	timer t = { period, callback };
+	timers[id] = t;
+	auto due = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(delay));
+	activations.push(activation(due, id));
+	return id;
+}
+
+bool socket_event_loop::cancel_timer(size_t timer_id)
+{
+	return timers.erase(timer_id) > 0;
+}
+
+int socket_event_loop::get_timer_timeout()
+{
+	while (!activations.empty() && timers.find(activations.top().second) == timers.end())
+		activations.pop();
+	if (activations.empty())
+		return -1;
+	auto delay = activations.top().first - std::chrono::steady_clock::now();
+	long long us = std::chrono::duration_cast<std::chrono::microseconds>(delay).count();
+	return us <= 0 ? 0 : int((us + 999) / 1000);
+}
+
+void socket_event_loop::process_timers()
+{
+	auto now = std::chrono::steady_clock::now();
+	while (!activations.empty() && activations.top().first <= now) {
+		activation a = activations.top();
+		activations.pop();
+		auto iter = timers.find(a.second);
+		if (iter == timers.end())
+			continue;
+		// copy callback as it can cancel its own timer
+		function_type callback = iter->second.callback;
+		if (iter->second.period > 0) {
+			auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(iter->second.period));
+			activations.push(activation(std::max(a.first + period, now + period / 2), a.second));
+		}
+		else
+			timers.erase(iter);
+		callback();
+	}
+}
+
+void socket_event_loop::post(const function_type& f)
+{
+	{
+		std::lock_guard<std::mutex> lock(posted_mtx);
+		posted_functions.push_back(f);
+	}
+	wake();
+}
+
+void socket_event_loop::process_posted_functions()
+{
+	std::vector<function_type> functions;
+	{
+		std::lock_guard<std::mutex> lock(posted_mtx);
+		functions.swap(posted_functions);
+	}
+	for (auto& f : functions)
+		f();
+}
+
+void socket_event_loop::wake()
+{
+	if (wakeup_id && !wakeup_pending.exchange(true)) {
+		char b = 0;
+		::send(SOCKET(wakeup_id), &b, 1, 0);
+	}
+}
+
+bool socket_event_loop::run_once(int timeout_ms)
+{
+	if (stop_requested)
+		return false;
+	int timer_timeout = get_timer_timeout();
+	if (timer_timeout != -1 && (timeout_ms == -1 || timer_timeout < timeout_ms))
+		timeout_ms = timer_timeout;
+	std::vector<poller::event> events;
+	if (!backend->wait(timeout_ms, events))
+		set_last_error("run_once");
+	for (const auto& e : events) {
+		if (e.id == wakeup_id) {
+			wakeup_pending = false;
+			char b[64];
+			while (recv(SOCKET(wakeup_id), b, sizeof(b), 0) > 0)
+				;
+			continue;
+		}
+		auto li = std::find_if(listeners.begin(), listeners.end(), [&e](const listener& l) { return l.id == e.id; });
+		if (li != listeners.end()) {
+			// copy listener as handlers can add listeners
+			accept_connections(listener(*li));
+			continue;
+		}
+		auto ci = connections.find(e.id);
+		if (ci == connections.end())
+			continue;
+		socket_connection& c = *ci->second;
+		// a reset connection is only handled by receive if reading is enabled to let it see the end of the stream
+		if (e.error && !(c.reading_enabled && !c.closing)) {
+			close_connection(c);
+			continue;
+		}
+		if (e.writable)
+			send_queued(c);
+		if (e.readable || e.error)
+			receive(c);
+	}
+	process_timers();
+	process_posted_functions();
+	destruct_closed_connections();
+	return !stop_requested;
+}
+
+void socket_event_loop::run()
+{
+	while (run_once(-1))
+		;
+	stop_requested = false;
+}
+
+void socket_event_loop::stop()
+{
+	stop_requested = true;
+	wake();
+}
+
+	}
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <queue>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+#include "lib_begin.h"
+
+namespace cgv {
+	namespace os {
+
+class socket_event_loop;
+class socket_connection;
+
+/// throughput counters of a connection managed by a socket_event_loop
+struct CGV_API socket_connection_statistics
+{
+	/// number of received and sent bytes
+	size_t nr_bytes_received, nr_bytes_sent;
+	/// number of receive and send system calls that transferred data
+	size_t nr_receive_calls, nr_send_calls;
+	/// seconds since connection was accepted till now or till it was closed
+	double elapsed_seconds;
+	/// construct zero statistics
+	socket_connection_statistics();
+	/// accumulate statistics of other connection
+	void add(const socket_connection_statistics& s);
+	/// return received megabytes per second
+	double get_received_megabytes_per_second() const;
+	/// return sent megabytes per second
+	double get_sent_megabytes_per_second() const;
+};
+
+/// callbacks of connections accepted by a socket_event_loop, which are called in the thread running the loop
+class CGV_API socket_connection_handler
+{
+public:
+	/// virtual destructor
+	virtual ~socket_connection_handler();
+	/// called after a connection has been accepted
+	virtual void on_connect(socket_connection& c);
+	/// called after data has been appended to the input buffer of the connection, from which processed data is removed with consume()
+	virtual void on_receive(socket_connection& c) = 0;
+	/// called when all queued output of the connection has been sent
+	virtual void on_sent(socket_connection& c);
+	/// called before the connection is destructed because the peer closed it, an error occurred or close() was called
+	virtual void on_close(socket_connection& c);
+};
+
+/** connection of a socket_event_loop. Received data is appended to an input buffer, which is reused over the
+    lifetime of the connection, such that handlers parse messages in place without allocations. Sends are
+	attempted immediately and only the part that the socket did not accept is added to an output queue, which
+	is sent when the socket becomes writable. The queue copies data passed to send(), references data passed
+	to send_shared() together with an owner keeping it alive and streams files passed to send_file() without
+	copies through the kernel where supported. All methods must be called from the thread running the loop. */
+class CGV_API socket_connection
+{
+public:
+	/// buffer of a scatter/gather send
+	struct buffer
+	{
+		const void* data;
+		size_t size;
+	};
+protected:
+	friend class socket_event_loop;
+	socket_event_loop& loop;
+	socket_connection_handler* handler;
+	/// platform dependent socket identifier
+	size_t id;
+	/// input buffer, whose range [input_begin,input_end) holds the received and not consumed data
+	std::vector<char> input;
+	size_t input_begin, input_end;
+	/// part of the output queue
+	struct output_segment
+	{
+		/// data copied into the segment
+		std::vector<char> copy;
+		/// data referenced by the segment if copy is empty
+		const char* data;
+		/// owner keeping referenced data or file alive
+		std::shared_ptr<const void> owner;
+		/// file streamed by the segment or 0
+		FILE* file;
+		/// offset of remaining data in copy, data or file
+		uint64_t offset;
+		/// number of remaining bytes
+		uint64_t size;
+		/// construct empty segment
+		output_segment() : data(0), file(0), offset(0), size(0) {}
+	};
+	std::deque<output_segment> output;
+	/// number of bytes in the output queue
+	size_t nr_queued_bytes;
+	/// copy buffer of a sent segment that is reused for the next copy
+	std::vector<char> spare_copy;
+	bool reading_enabled;
+	/// whether the loop waits for the socket to become writable
+	bool waiting_for_writable;
+	/// whether connection is closed after the output queue has been sent
+	bool closing;
+	/// whether connection is closed and waits for destruction
+	bool closed;
+	void* user_data;
+	socket_connection_statistics stats;
+	std::chrono::steady_clock::time_point start_time, close_time;
+	/// construct connection of loop for accepted socket
+	socket_connection(socket_event_loop& _loop, socket_connection_handler* _handler, size_t _id);
+	/// ensure that at least n bytes can be appended to the input buffer and move unconsumed data to the buffer start if necessary
+	void reserve_input(size_t n);
+	/// send buffers directly if the output queue is empty and return number of sent bytes or -1 if connection was closed
+	long long send_directly(const buffer* buffers, size_t nr_buffers);
+	/// append segment to output queue and wait for the socket to become writable
+	void enqueue(output_segment& segment);
+public:
+	/// return platform dependent socket identifier
+	size_t get_id() const { return id; }
+	/// return the event loop of the connection
+	socket_event_loop& get_loop() const { return loop; }
+	/// return pointer to received data that has not been consumed yet
+	const char* get_input() const { return input.data() + input_begin; }
+	/// return number of received bytes that have not been consumed yet
+	size_t get_input_size() const { return input_end - input_begin; }
+	/// remove the given number of bytes from the front of the input buffer
+	void consume(size_t nr_bytes);
+	/// return length of the first line in the input buffer including its newline or 0 if no complete line has been received
+	size_t find_line() const;
+	/// queue data for sending and return false if connection is closed
+	bool send(const void* data, size_t nr_bytes);
+	/// queue string for sending and return false if connection is closed
+	bool send(const std::string& data) { return send(data.data(), data.size()); }
+	/// queue the concatenation of the given buffers for sending with a single system call if possible and return false if connection is closed
+	bool send(const buffer* buffers, size_t nr_buffers);
+	/// queue the concatenation of the given buffers without copying them, where owner keeps the data alive until it has been sent
+	bool send_shared(const buffer* buffers, size_t nr_buffers, const std::shared_ptr<const void>& owner);
+	/// queue data without copying it, where owner keeps the data alive until it has been sent
+	bool send_shared(const void* data, size_t nr_bytes, const std::shared_ptr<const void>& owner);
+	/// queue size bytes of file starting at offset, which is closed by the deleter of file after it has been sent
+	bool send_file(const std::shared_ptr<FILE>& file, uint64_t offset, uint64_t size);
+	/// return number of bytes queued but not sent yet
+	size_t get_nr_queued_bytes() const { return nr_queued_bytes; }
+	/// suspend or resume reading, which lets the socket buffers of a fast peer fill up; data already received remains in the input buffer and is not delivered again
+	void set_reading_enabled(bool enable);
+	/// return whether reading is enabled
+	bool is_reading_enabled() const { return reading_enabled; }
+	/// close connection after the output queue has been sent or immediately
+	void close(bool after_sending = true);
+	/// return whether close has been called or the connection was closed by the peer
+	bool is_closed() const { return closed || closing; }
+	/// set pointer to data of handler
+	void set_user_data(void* _user_data) { user_data = _user_data; }
+	/// return pointer to data of handler
+	void* get_user_data() const { return user_data; }
+	/// return throughput counters
+	socket_connection_statistics get_statistics() const;
+};
+
+/** event loop that serves many connections from a single thread with non-blocking sockets. On linux readiness is
+    queried with epoll, whose cost does not grow with the number of idle connections, and on other platforms with
+	poll. Besides listening sockets and their connections the loop manages timers and functions posted from other
+	threads. Apart from stop() and post() all methods must be called from the thread running the loop or before the
+	loop is run. */
+class CGV_API socket_event_loop
+{
+public:
+	/// type of timer callbacks and posted functions
+	typedef std::function<void()> function_type;
+protected:
+	friend class socket_connection;
+	/// platform dependent readiness notification
+	struct poller;
+	std::unique_ptr<poller> backend;
+	/// listening socket with the handler of its connections
+	struct listener
+	{
+		size_t id;
+		int port;
+		std::string address;
+		socket_connection_handler* handler;
+	};
+	std::vector<listener> listeners;
+	std::unordered_map<size_t, std::unique_ptr<socket_connection> > connections;
+	/// connections to be destructed after the current events have been dispatched
+	std::vector<size_t> closed_connections;
+	/// number of bytes attempted per receive call
+	size_t receive_size;
+	/// timer with its period or 0 for single shot timers
+	struct timer
+	{
+		double period;
+		function_type callback;
+	};
+	std::map<size_t, timer> timers;
+	/// pending timer activations ordered by time, which are skipped if their timer has been cancelled
+	typedef std::pair<std::chrono::steady_clock::time_point, size_t> activation;
+	std::priority_queue<activation, std::vector<activation>, std::greater<activation> > activations;
+	size_t next_timer_id;
+	/// loopback socket sending to itself to wake the loop from other threads
+	size_t wakeup_id;
+	std::atomic<bool> wakeup_pending;
+	std::atomic<bool> stop_requested;
+	std::mutex posted_mtx;
+	std::vector<function_type> posted_functions;
+	std::string last_error;
+	/// set last error including the error of the last socket call and return false
+	bool set_last_error(const char* location);
+	/// accept pending connections of listener
+	void accept_connections(const listener& l);
+	/// receive into the input buffer of connection and call its handler
+	void receive(socket_connection& c);
+	/// send from the output queue of connection when its socket became writable
+	void send_queued(socket_connection& c);
+	/// send from the output queue of connection until the socket does not accept more data and return false on error
+	bool write_output(socket_connection& c);
+	/// send buffers without blocking and return number of sent bytes or -1 on error
+	long long send_buffers(socket_connection& c, const socket_connection::buffer* buffers, size_t nr_buffers);
+	/// send part of the file of an output segment without blocking and return number of sent bytes or -1 on error
+	long long send_file_part(socket_connection& c, const socket_connection::output_segment& segment);
+	/// buffer for reading files on platforms without sendfile
+	std::vector<char> file_buffer;
+	/// update the events the loop waits for on connection
+	void update_events(socket_connection& c);
+	/// close connection and schedule its destruction
+	void close_connection(socket_connection& c);
+	/// destruct closed connections after calling their handlers
+	void destruct_closed_connections();
+	/// return milliseconds till the next timer activation or -1 if no timer is active
+	int get_timer_timeout();
+	/// call callbacks of due timers
+	void process_timers();
+	/// call posted functions
+	void process_posted_functions();
+	/// send byte to wakeup socket
+	void wake();
+public:
+	/// construct loop without listeners
+	socket_event_loop();
+	/// close all sockets, where on_close of the handlers of open connections is called
+	~socket_event_loop();
+	/// return name of readiness notification backend, i.e. "epoll" or "poll"
+	const char* get_backend_name() const;
+	/// return the last error
+	const std::string& get_last_error() const { return last_error; }
+	/** listen on given port (0 ... port chosen by system) of the interface with the given IPv4 address and handle accepted
+	    connections with given handler. By default only local connections are accepted, "0.0.0.0" accepts connections
+		from other hosts on all interfaces. */
+	bool listen(int port, socket_connection_handler* handler, int max_nr_pending_connections = 128, const std::string& address = "127.0.0.1");
+	/// return port of i-th listener
+	int get_listening_port(size_t i = 0) const { return listeners[i].port; }
+	/// return address of the interface of i-th listener
+	const std::string& get_listening_address(size_t i = 0) const { return listeners[i].address; }
+	/// set number of bytes attempted per receive call, which is the minimum size of input buffers (default 65536)
+	void set_receive_size(size_t _receive_size) { receive_size = _receive_size; }
+	/// return number of open connections
+	size_t get_nr_connections() const { return connections.size(); }
+	/// return statistics accumulated over all open connections
+	socket_connection_statistics get_total_statistics() const;
+	/// call callback after delay seconds and then every period seconds if period is larger than 0; return timer id
+	size_t add_timer(double delay, const function_type& callback, double period = 0);
+	/// cancel timer and return whether it was active
+	bool cancel_timer(size_t timer_id);
+	/// call function in the thread running the loop, which can be called from any thread
+	void post(const function_type& f);
+	/// wait up to timeout milliseconds (-1 ... no timeout) for events, dispatch them and return false if stop was requested
+	bool run_once(int timeout_ms = -1);
+	/// dispatch events until stop is called
+	void run();
+	/// request run() to return, which can be called from any thread
+	void stop();
+};
+
+	}
+}
+
+#include <cgv/config/lib_end.h>
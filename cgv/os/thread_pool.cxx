@@ -0,0 +1,190 @@
+#include "thread_pool.h"
+#include <chrono>
+
+namespace cgv {
+	namespace os {
+
+/// pool and queue index of the worker executed by the current thread
+static thread_local thread_pool* current_pool = 0;
+static thread_local unsigned current_queue_index = 0;
+
+task_group::task_group(thread_pool& _pool) : pool(_pool), nr_open_tasks(0)
+{
+}
+
+task_group::~task_group()
+{
+	try {
+		wait();
+	}
+	catch (...) {
+	}
+}
+
+void task_group::run(const std::function<void()>& task)
+{
+	++nr_open_tasks;
+	pool.submit(*this, task);
+}
+
+void task_group::wait()
+{
+	unsigned nr_idle_rounds = 0;
+	while (nr_open_tasks.load(std::memory_order_acquire) > 0) {
+		if (pool.execute_pending_task())
+			nr_idle_rounds = 0;
+		// remaining tasks are executed by other threads
+		else if (++nr_idle_rounds < 64)
+			std::this_thread::yield();
+		else
+			std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+	std::exception_ptr e;
+	{
+		std::lock_guard<std::mutex> lock(exception_mtx);
+		std::swap(e, exception);
+	}
+	if (e)
+		std::rethrow_exception(e);
+}
+
+thread_pool::thread_pool(int nr_workers) : nr_queued_tasks(0), nr_sleeping_workers(0), stop_workers(false)
+{
+	set_nr_workers(nr_workers);
+}
+
+thread_pool::~thread_pool()
+{
+	stop();
+}
+
+void thread_pool::set_nr_workers(int nr_workers)
+{
+	if (nr_workers < 0)
+		nr_workers = std::max(1, int(std::thread::hardware_concurrency())) - 1;
+	stop();
+	start(unsigned(nr_workers));
+}
+
+void thread_pool::start(unsigned nr_workers)
+{
+	queues.clear();
+	for (unsigned i = 0; i <= nr_workers; ++i)
+		queues.push_back(std::unique_ptr<task_queue>(new task_queue()));
+	for (unsigned i = 0; i < nr_workers; ++i)
+		workers.push_back(std::thread(&thread_pool::run_worker, this, i));
+}
+
+void thread_pool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mtx);
+		stop_workers = true;
+	}
+	task_available.notify_all();
+	for (auto& w : workers)
+		w.join();
+	workers.clear();
+	stop_workers = false;
+}
+
+void thread_pool::submit(task_group& group, const task_type& task)
+{
+	unsigned qi = current_pool == this ? current_queue_index : unsigned(queues.size() - 1);
+	// count task before it becomes visible, such that the count cannot drop below zero
+	++nr_queued_tasks;
+	{
+		std::lock_guard<std::mutex> lock(queues[qi]->mtx);
+		task_entry entry = { task, &group };
+		queues[qi]->tasks.push_back(entry);
+	}
+	if (nr_sleeping_workers.load() > 0) {
+		std::lock_guard<std::mutex> lock(sleep_mtx);
+		task_available.notify_one();
+	}
+}
+
+bool thread_pool::find_task(unsigned queue_index, task_entry& entry)
+{
+	if (nr_queued_tasks.load(std::memory_order_acquire) == 0)
+		return false;
+	// take newest task of own queue
+	{
+		task_queue& q = *queues[queue_index];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		if (!q.tasks.empty()) {
+			entry = q.tasks.back();
+			q.tasks.pop_back();
+			--nr_queued_tasks;
+			return true;
+		}
+	}
+	// steal oldest task from other queues
+	unsigned n = unsigned(queues.size());
+	for (unsigned k = 1; k < n; ++k) {
+		task_queue& q = *queues[(queue_index + k) % n];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		if (!q.tasks.empty()) {
+			entry = q.tasks.front();
+			q.tasks.pop_front();
+			--nr_queued_tasks;
+			return true;
+		}
+	}
+	return false;
+}
+
+void thread_pool::execute(task_entry& entry)
+{
+	task_group& group = *entry.group;
+	try {
+		entry.task();
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(group.exception_mtx);
+		if (!group.exception)
+			group.exception = std::current_exception();
+	}
+	entry.task = task_type();
+	// group can be destructed after last task finished
+	--group.nr_open_tasks;
+}
+
+bool thread_pool::execute_pending_task()
+{
+	unsigned qi = current_pool == this ? current_queue_index : unsigned(queues.size() - 1);
+	task_entry entry;
+	if (!find_task(qi, entry))
+		return false;
+	execute(entry);
+	return true;
+}
+
+void thread_pool::run_worker(unsigned worker_index)
+{
+	current_pool = this;
+	current_queue_index = worker_index;
+	for (;;) {
+		task_entry entry;
+		if (find_task(worker_index, entry)) {
+			execute(entry);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleep_mtx);
+		++nr_sleeping_workers;
+		task_available.wait(lock, [this]() { return stop_workers || nr_queued_tasks.load() > 0; });
+		--nr_sleeping_workers;
+		if (stop_workers)
+			return;
+	}
+}
+
+thread_pool& get_thread_pool()
+{
+	// never destructed, as joining threads during static destruction of a dll can deadlock
+	static thread_pool* pool = new thread_pool();
+	return *pool;
+}
+
+	}
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <algorithm>
+
+#include "lib_begin.h"
+
+namespace cgv {
+	namespace os {
+
+class thread_pool;
+
+/** group of tasks executed in a thread pool, whose completion can be awaited with wait(). Tasks can run further
+    tasks in the same or other groups. The thread calling wait() executes pending tasks of the pool until all tasks
+	of the group are finished, such that nested parallelism does not block workers. If a task throws, the first
+	exception is rethrown by wait(). */
+class CGV_API task_group
+{
+protected:
+	friend class thread_pool;
+	thread_pool& pool;
+	/// number of tasks run but not finished
+	std::atomic<size_t> nr_open_tasks;
+	/// first exception thrown by a task
+	std::exception_ptr exception;
+	std::mutex exception_mtx;
+public:
+	/// construct group for given pool
+	task_group(thread_pool& _pool);
+	/// wait for completion of tasks, where exceptions of tasks are discarded
+	~task_group();
+	/// run a task in the pool
+	void run(const std::function<void()>& task);
+	/// execute pending tasks until all tasks of the group are finished and rethrow the first exception of a task
+	void wait();
+};
+
+/** pool of worker threads executing tasks with work stealing. Each worker has its own task queue, at whose back
+    it adds and removes tasks, which keeps recently split work local to a worker. Idle workers steal the oldest
+	tasks from the front of the queues of other workers, which are typically the largest ones in recursive
+	splitting. Tasks run from threads outside of the pool are added to a shared queue. The thread waiting for a
+	task_group participates in task execution, such that a pool with n workers executes tasks in n+1 threads.
+	parallel_for and parallel_reduce split ranges recursively into tasks, which balances the load among the
+	threads without knowing the cost of the iterations in advance. */
+class CGV_API thread_pool
+{
+public:
+	/// type of tasks
+	typedef std::function<void()> task_type;
+protected:
+	friend class task_group;
+	/// task together with its group
+	struct task_entry
+	{
+		task_type task;
+		task_group* group;
+	};
+	/// queue of a worker or the shared queue
+	struct task_queue
+	{
+		std::mutex mtx;
+		std::deque<task_entry> tasks;
+	};
+	/// queues of the workers followed by the shared queue
+	std::vector<std::unique_ptr<task_queue> > queues;
+	std::vector<std::thread> workers;
+	/// number of queued tasks
+	std::atomic<size_t> nr_queued_tasks;
+	/// number of workers waiting for tasks
+	std::atomic<unsigned> nr_sleeping_workers;
+	bool stop_workers;
+	std::mutex sleep_mtx;
+	std::condition_variable task_available;
+	/// add task to queue of current worker or to shared queue
+	void submit(task_group& group, const task_type& task);
+	/// remove the newest task from the queue of the given index or steal the oldest of another queue and return whether one was found
+	bool find_task(unsigned queue_index, task_entry& entry);
+	/// execute a task and signal its completion to its group
+	void execute(task_entry& entry);
+	/// try to find and execute one task and return whether a task was executed
+	bool execute_pending_task();
+	/// thread function of workers
+	void run_worker(unsigned worker_index);
+	/// start the given number of workers
+	void start(unsigned nr_workers);
+	/// stop all workers after they finished their current tasks
+	void stop();
+	/// split [begin,end) recursively into tasks of at most grain_size iterations and call f(b,e) on each of them
+	template <typename F>
+	void split_range(task_group& group, size_t begin, size_t end, size_t grain_size, const F& f)
+	{
+		while (end - begin > grain_size) {
+			size_t middle = begin + (end - begin) / 2;
+			group.run([this, &group, middle, end, grain_size, &f]() { split_range(group, middle, end, grain_size, f); });
+			end = middle;
+		}
+		f(begin, end);
+	}
+public:
+	/// construct pool with given number of workers, where -1 yields one worker less than the number of hardware threads
+	thread_pool(int nr_workers = -1);
+	/// stop workers, which must not be called while tasks are running
+	~thread_pool();
+	/// return number of workers
+	unsigned get_nr_workers() const { return unsigned(workers.size()); }
+	/// return number of threads executing tasks including the thread waiting for a task group
+	unsigned get_concurrency() const { return get_nr_workers() + 1; }
+	/// change number of workers, where -1 yields one worker less than the number of hardware threads; must not be called while tasks are running
+	void set_nr_workers(int nr_workers);
+	/// return default grain size, which splits n iterations in about eight tasks per thread
+	size_t get_default_grain_size(size_t n) const { return std::max(size_t(1), n / (8 * size_t(get_concurrency()))); }
+	/// call f(b,e) on subranges [b,e) of [begin,end) with at most grain_size iterations each (0 ... default grain size) in parallel and wait for completion
+	template <typename F>
+	void parallel_for_range(size_t begin, size_t end, const F& f, size_t grain_size = 0)
+	{
+		if (begin >= end)
+			return;
+		if (grain_size == 0)
+			grain_size = get_default_grain_size(end - begin);
+		if (workers.empty() || end - begin <= grain_size) {
+			for (size_t b = begin; b < end; b += grain_size)
+				f(b, std::min(end, b + grain_size));
+			return;
+		}
+		task_group group(*this);
+		split_range(group, begin, end, grain_size, f);
+		group.wait();
+	}
+	/// call f(i) for all i in [begin,end) in parallel with at most grain_size iterations per task (0 ... default grain size)
+	template <typename F>
+	void parallel_for(size_t begin, size_t end, const F& f, size_t grain_size = 0)
+	{
+		parallel_for_range(begin, end, [&f](size_t b, size_t e) {
+			for (size_t i = b; i < e; ++i)
+				f(i);
+		}, grain_size);
+	}
+	/** reduce [begin,end) with map(b,e) computing the value of a subrange and combine(a,b) combining two values.
+	    The range is split into blocks of grain_size iterations (0 ... default grain size), whose values are combined
+		in the order of the blocks starting with identity, such that the result does not depend on the scheduling. */
+	template <typename T, typename M, typename C>
+	T parallel_reduce(size_t begin, size_t end, const T& identity, const M& map, const C& combine, size_t grain_size = 0)
+	{
+		if (begin >= end)
+			return identity;
+		if (grain_size == 0)
+			grain_size = get_default_grain_size(end - begin);
+		size_t nr_blocks = (end - begin + grain_size - 1) / grain_size;
+		std::vector<T> values(nr_blocks, identity);
+		parallel_for(0, nr_blocks, [&](size_t bi) {
+			values[bi] = map(begin + bi * grain_size, std::min(end, begin + (bi + 1) * grain_size));
+		}, 1);
+		T result = identity;
+		for (const auto& v : values)
+			result = combine(result, v);
+		return result;
+	}
+};
+
+/// return the thread pool shared by all libraries, which is constructed on first use with one worker less than the number of hardware threads
+extern CGV_API thread_pool& get_thread_pool();
+
+/// call f(b,e) on subranges [b,e) of [begin,end) in the shared thread pool, see thread_pool::parallel_for_range
+template <typename F>
+void parallel_for_range(size_t begin, size_t end, const F& f, size_t grain_size = 0)
+{
+	get_thread_pool().parallel_for_range(begin, end, f, grain_size);
+}
+
+/// call f(i) for all i in [begin,end) in the shared thread pool, see thread_pool::parallel_for
+template <typename F>
+void parallel_for(size_t begin, size_t end, const F& f, size_t grain_size = 0)
+{
+	get_thread_pool().parallel_for(begin, end, f, grain_size);
+}
+
+/// reduce [begin,end) in the shared thread pool, see thread_pool::parallel_reduce
+template <typename T, typename M, typename C>
+T parallel_reduce(size_t begin, size_t end, const T& identity, const M& map, const C& combine, size_t grain_size = 0)
+{
+	return get_thread_pool().parallel_reduce(begin, end, identity, map, combine, grain_size);
+}
+
+	}
+}
+
+#include <cgv/config/lib_end.h>
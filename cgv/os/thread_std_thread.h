@@ -109,10 +109,10 @@ void thread::kill()
 ///join the current thread
 void thread::wait_for_completion()
 {
-	if (running) {
-		std::thread& t = *((std::thread*&) thread_ptr);
-		t.join();
-	}
+	// a thread that finished its run method still has to be joined
+	std::thread* std_thread_ptr = reinterpret_cast<std::thread*>(thread_ptr);
+	if (std_thread_ptr && std_thread_ptr->joinable() && std_thread_ptr->get_id() != std::this_thread::get_id())
+		std_thread_ptr->join();
 }
 
 ///standard destructor (a running thread will be killed)
@@ -122,6 +122,13 @@ thread::~thread()
 		kill();
 	if (thread_ptr) {
 		std::thread* std_thread_ptr = reinterpret_cast<std::thread*>(thread_ptr);
+		// destructing a joinable std::thread terminates the program
+		if (std_thread_ptr->joinable()) {
+			if (std_thread_ptr->get_id() == std::this_thread::get_id())
+				std_thread_ptr->detach();
+			else
+				std_thread_ptr->join();
+		}
 		delete std_thread_ptr;
 		std_thread_ptr = 0;
 	}
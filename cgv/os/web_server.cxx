@@ -53,11 +53,11 @@ void web_server_thread::start()
 	thread::start();
 }
 
-/// calls the stop method of the web_server
+/// calls the stop method of the web_server and waits for the thread to finish
 web_server_thread::~web_server_thread()
 {
-	thread::kill();
 	web_server::stop();
+	thread::wait_for_completion();
 }
 
 /// reimplements the run method that simply starts the web server
@@ -177,7 +177,10 @@ size_t size(const std::string& file_name, bool ascii)
 	void* handle = find_first(file_name);
 	if (handle == 0)
 		return (size_t)-1;
-	return find_size(handle);
+	size_t s = find_size(handle);
+	// make sure that internal data structure is removed
+	find_next(handle);
+	return s;
 #ifdef _WIN32
 	int fh = _open(file_name.c_str(), ascii ? _O_RDONLY : (_O_BINARY | _O_RDONLY) );
 	if (fh == -1) return (size_t)-1;
@@ -353,7 +356,9 @@ void* find_next(void* handle)
 #else
 	fi->index+=1;
 	if(fi->globResults->gl_pathc > fi->index) return fi;
-	//std::cerr << "Not Implemented" << std::endl;
+	globfree(fi->globResults);
+	delete fi->globResults;
+	delete fi;
 	return NULL;
 #endif
 }
@@ -0,0 +1,107 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cgv {
+	namespace utils {
+
+mapped_file::mapped_file() : ptr(0), nr_bytes(0), file_handle(0), mapping_handle(0)
+{
+}
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const std::string& _file_name)
+{
+	close();
+	HANDLE fh = CreateFileA(_file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fh == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(fh, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(fh);
+		return false;
+	}
+	HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (!mh) {
+		CloseHandle(fh);
+		return false;
+	}
+	void* p = MapViewOfFile(mh, FILE_MAP_COPY, 0, 0, 0);
+	if (!p) {
+		CloseHandle(mh);
+		CloseHandle(fh);
+		return false;
+	}
+	file_handle = fh;
+	mapping_handle = mh;
+	ptr = static_cast<char*>(p);
+	nr_bytes = size_t(file_size.QuadPart);
+	file_name = _file_name;
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mapping_handle)
+		CloseHandle((HANDLE)mapping_handle);
+	if (file_handle)
+		CloseHandle((HANDLE)file_handle);
+	ptr = 0;
+	nr_bytes = 0;
+	file_handle = 0;
+	mapping_handle = 0;
+	file_name.clear();
+}
+
+#else
+
+bool mapped_file::open(const std::string& _file_name)
+{
+	close();
+	int fd = ::open(_file_name.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* p = mmap(0, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid after closing the file descriptor
+	::close(fd);
+	if (p == MAP_FAILED)
+		return false;
+	ptr = static_cast<char*>(p);
+	nr_bytes = size_t(st.st_size);
+	file_name = _file_name;
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (ptr)
+		munmap(ptr, nr_bytes);
+	ptr = 0;
+	nr_bytes = 0;
+	file_name.clear();
+}
+
+#endif
+
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+
+#include "lib_begin.h"
+
+namespace cgv {
+	namespace utils {
+
+/** read only memory mapping of a complete file. The mapping is private: unmodified pages are shared with all other
+    processes that map the same file and are only copied when written to, in which case the modification is never
+	written back to the file. */
+class CGV_API mapped_file
+{
+protected:
+	std::string file_name;
+	char* ptr;
+	size_t nr_bytes;
+	void* file_handle;
+	void* mapping_handle;
+	/// no copy construction
+	mapped_file(const mapped_file&);
+	/// no assignment
+	mapped_file& operator = (const mapped_file&);
+public:
+	/// construct unmapped instance
+	mapped_file();
+	/// unmap file on destruction
+	~mapped_file();
+	/// map the given file and return whether this succeeded; empty files cannot be mapped
+	bool open(const std::string& file_name);
+	/// unmap file
+	void close();
+	/// check whether a file is mapped
+	bool is_open() const { return ptr != 0; }
+	/// return name of mapped file
+	const std::string& get_file_name() const { return file_name; }
+	/// return size of mapped file in bytes
+	size_t size() const { return nr_bytes; }
+	/// return pointer to the beginning of the mapping
+	const char* data() const { return ptr; }
+	/// return writable pointer to the beginning of the mapping, where writes only create process local page copies
+	char* data() { return ptr; }
+	/// return typed pointer to the given byte offset
+	template <typename T>
+	const T* get(size_t offset) const { return reinterpret_cast<const T*>(ptr + offset); }
+	/// return writable typed pointer to the given byte offset
+	template <typename T>
+	T* get(size_t offset) { return reinterpret_cast<T*>(ptr + offset); }
+};
+
+	}
+}
+
+#include <cgv/config/lib_end.h>
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "mapped_file.h"
+
+namespace cgv {
+	namespace utils {
+
+/** vector of trivially copyable elements that either owns its elements in a std::vector or provides a view into a
+    memory mapped file. Element access through a view does not copy any data. As the mapping is private, writing to
+	elements only copies the touched pages. Operations that change the number of elements or the capacity turn a view
+	into owned storage by copying the mapped elements. Copies of a mapped_vector always own their elements. */
+template <typename T>
+class mapped_vector
+{
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+protected:
+	/// owned elements
+	std::vector<T> elements;
+	/// mapping that is referenced by a view
+	std::shared_ptr<mapped_file> mapping;
+	/// pointer to first element of view or 0 if elements are owned
+	T* view_ptr;
+	/// number of elements in view
+	size_t view_size;
+public:
+	/// construct empty vector
+	mapped_vector() : view_ptr(0), view_size(0) {}
+	/// construct with n copies of the given value
+	explicit mapped_vector(size_t n, const T& value = T()) : elements(n, value), view_ptr(0), view_size(0) {}
+	/// copy construction copies the elements
+	mapped_vector(const mapped_vector& mv) : elements(mv.begin(), mv.end()), view_ptr(0), view_size(0) {}
+	/// construct from std::vector
+	mapped_vector(const std::vector<T>& v) : elements(v), view_ptr(0), view_size(0) {}
+	/// assignment copies the elements
+	mapped_vector& operator = (const mapped_vector& mv) {
+		if (this != &mv) {
+			std::vector<T> tmp(mv.begin(), mv.end());
+			release();
+			elements.swap(tmp);
+		}
+		return *this;
+	}
+	/// assign from std::vector
+	mapped_vector& operator = (const std::vector<T>& v) {
+		release();
+		elements = v;
+		return *this;
+	}
+	/// make this vector a view onto n elements of the given mapping starting at the given byte offset
+	void attach(const std::shared_ptr<mapped_file>& _mapping, size_t offset, size_t n) {
+		release();
+		mapping = _mapping;
+		view_ptr = mapping->template get<T>(offset);
+		view_size = n;
+	}
+	/// check whether the vector is a view onto a mapped file
+	bool is_mapped() const { return view_ptr != 0; }
+	/// turn a view into owned storage by copying the elements
+	void detach() {
+		if (!view_ptr)
+			return;
+		std::vector<T> tmp(view_ptr, view_ptr + view_size);
+		release();
+		elements.swap(tmp);
+	}
+	/// release view and owned elements
+	void release() {
+		elements.clear();
+		mapping.reset();
+		view_ptr = 0;
+		view_size = 0;
+	}
+
+	/**@name read and write access without copying*/
+	//@{
+	size_t size() const { return view_ptr ? view_size : elements.size(); }
+	bool empty() const { return size() == 0; }
+	size_t capacity() const { return view_ptr ? view_size : elements.capacity(); }
+	T* data() { return view_ptr ? view_ptr : elements.data(); }
+	const T* data() const { return view_ptr ? view_ptr : elements.data(); }
+	iterator begin() { return data(); }
+	iterator end() { return data() + size(); }
+	const_iterator begin() const { return data(); }
+	const_iterator end() const { return data() + size(); }
+	T& operator [] (size_t i) { return data()[i]; }
+	const T& operator [] (size_t i) const { return data()[i]; }
+	T& at(size_t i) { return data()[i]; }
+	const T& at(size_t i) const { return data()[i]; }
+	T& front() { return data()[0]; }
+	const T& front() const { return data()[0]; }
+	T& back() { return data()[size() - 1]; }
+	const T& back() const { return data()[size() - 1]; }
+	//@}
+
+	/**@name modifications that detach views*/
+	//@{
+	void clear() { release(); }
+	void reserve(size_t n) { detach(); elements.reserve(n); }
+	void resize(size_t n) { if (n == size()) return; detach(); elements.resize(n); }
+	void resize(size_t n, const T& value) { if (n == size()) return; detach(); elements.resize(n, value); }
+	void push_back(const T& value) { detach(); elements.push_back(value); }
+	void pop_back() { detach(); elements.pop_back(); }
+	template <typename InputIt>
+	void assign(InputIt first, InputIt last) { std::vector<T> tmp(first, last); release(); elements.swap(tmp); }
+	void assign(size_t n, const T& value) { release(); elements.assign(n, value); }
+	iterator insert(const_iterator pos, const T& value) {
+		size_t i = pos - begin();
+		detach();
+		elements.insert(elements.begin() + i, value);
+		return begin() + i;
+	}
+	template <typename InputIt>
+	iterator insert(const_iterator pos, InputIt first, InputIt last) {
+		size_t i = pos - begin();
+		detach();
+		elements.insert(elements.begin() + i, first, last);
+		return begin() + i;
+	}
+	iterator erase(const_iterator pos) {
+		size_t i = pos - begin();
+		detach();
+		elements.erase(elements.begin() + i);
+		return begin() + i;
+	}
+	iterator erase(const_iterator first, const_iterator last) {
+		size_t i = first - begin(), j = last - begin();
+		detach();
+		elements.erase(elements.begin() + i, elements.begin() + j);
+		return begin() + i;
+	}
+	void swap(mapped_vector& mv) {
+		elements.swap(mv.elements);
+		mapping.swap(mv.mapping);
+		std::swap(view_ptr, mv.view_ptr);
+		std::swap(view_size, mv.view_size);
+	}
+	//@}
+};
+
+	}
+}
@@ -10,6 +10,16 @@ mesh_render_info::mesh_render_info() :
 {
 	nr_triangle_elements = 0;
 	nr_edge_elements = 0;
+	optimize_vertex_cache = false;
+	optimize_overdraw = false;
+	vertex_cache_size = 16;
+}
+///
+void mesh_render_info::set_element_order_optimization(bool vertex_cache, bool overdraw, unsigned cache_size)
+{
+	optimize_vertex_cache = vertex_cache;
+	optimize_overdraw = overdraw;
+	vertex_cache_size = cache_size;
 }
 ///
 void mesh_render_info::destruct(cgv::render::context& ctx)
@@ -55,6 +65,41 @@ void mesh_render_info::construct_vbos_base(
 	mesh.extract_wireframe_element_buffer(vertex_indices, edge_element_buffer);
 	nr_edge_elements = edge_element_buffer.size();
 	ct = mesh.get_color_storage_type();
+	// the simulation is a full pass over the triangles and only of interest when the element order is optimized
+	if (optimize_vertex_cache)
+		original_cache_statistics = cache_statistics = cgv::media::mesh::simulate_vertex_cache(triangle_element_buffer, vertex_cache_size);
+	else
+		original_cache_statistics = cache_statistics = cgv::media::mesh::vertex_cache_statistics();
+}
+
+///
+void mesh_render_info::optimize_element_order(std::vector<idx_type>& vertex_indices, std::vector<vec4i>& unique_quartuples,
+	std::vector<idx_type>& triangle_element_buffer, std::vector<idx_type>& edge_element_buffer,
+	const std::vector<cgv::math::fvec<float, 3> >* vertex_positions_ptr)
+{
+	// reorder triangles only within fragments such that draw calls stay valid
+	std::vector<size_t> fragment_starts;
+	for (const auto& mps : material_primitive_start)
+		fragment_starts.push_back(mps[2]);
+	std::vector<size_t> cluster_starts;
+	cgv::media::mesh::optimize_triangle_order(triangle_element_buffer, nr_vertices, vertex_cache_size,
+		fragment_starts.empty() ? 0 : &fragment_starts, vertex_positions_ptr ? &cluster_starts : 0);
+	if (vertex_positions_ptr)
+		cgv::media::mesh::optimize_overdraw(triangle_element_buffer, *vertex_positions_ptr, cluster_starts,
+			fragment_starts.empty() ? 0 : &fragment_starts);
+	cache_statistics = cgv::media::mesh::simulate_vertex_cache(triangle_element_buffer, vertex_cache_size);
+
+	// store vertices in order of their first use and update all references to them
+	std::vector<idx_type> vertex_remap;
+	cgv::media::mesh::optimize_vertex_fetch(triangle_element_buffer, nr_vertices, vertex_remap);
+	std::vector<vec4i> reordered_quartuples(unique_quartuples.size());
+	for (size_t vi = 0; vi < unique_quartuples.size(); ++vi)
+		reordered_quartuples[vertex_remap[vi]] = unique_quartuples[vi];
+	unique_quartuples.swap(reordered_quartuples);
+	for (auto& vi : vertex_indices)
+		vi = vertex_remap[vi];
+	for (auto& vi : edge_element_buffer)
+		vi = vertex_remap[vi];
 }
 
 ///
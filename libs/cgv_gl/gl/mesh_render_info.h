@@ -2,6 +2,7 @@
 
 #include "render_info.h"
 #include <cgv/media/mesh/simple_mesh.h>
+#include <cgv/media/mesh/vertex_cache_optimization.h>
 
 #include "lib_begin.h"
 
@@ -50,10 +51,22 @@ protected:
 	size_t color_increment;
 	/// color type
 	cgv::media::ColorType ct;
+	/// whether triangles and vertices are reordered for the vertex cache and vertex fetches before upload
+	bool optimize_vertex_cache;
+	/// whether clusters of triangles are additionally sorted to reduce overdraw
+	bool optimize_overdraw;
+	/// size of the post transform vertex cache assumed in the optimization
+	unsigned vertex_cache_size;
+	/// simulated vertex cache statistics of the triangle elements before optimization and as uploaded
+	cgv::media::mesh::vertex_cache_statistics original_cache_statistics, cache_statistics;
 	/// helper function to construct vbos
 	void construct_vbos_base(cgv::render::context& c, const cgv::media::mesh::simple_mesh_base& mesh,
 		std::vector<idx_type>& vertex_indices, std::vector<vec4i>& unique_quartuples,
 		std::vector<idx_type>& triangle_element_buffer, std::vector<idx_type>& edge_element_buffer);
+	/// reorder triangles within each fragment and vertices by first use, where positions per vertex are only needed to reduce overdraw
+	void optimize_element_order(std::vector<idx_type>& vertex_indices, std::vector<vec4i>& unique_quartuples,
+		std::vector<idx_type>& triangle_element_buffer, std::vector<idx_type>& edge_element_buffer,
+		const std::vector<cgv::math::fvec<float, 3> >* vertex_positions_ptr);
 	/// helper function for mesh render info consrtuctions
 	void finish_construct_vbos_base(cgv::render::context& ctx,
 		const std::vector<idx_type>& triangle_element_buffer,
@@ -77,6 +90,16 @@ public:
 		std::vector<idx_type> triangle_element_buffer;
 		std::vector<idx_type> edge_element_buffer;
 		construct_vbos_base(ctx, mesh, vertex_indices, unique_quartuples, triangle_element_buffer, edge_element_buffer);
+		if (optimize_vertex_cache) {
+			std::vector<cgv::math::fvec<float, 3> > vertex_positions;
+			if (optimize_overdraw) {
+				vertex_positions.reserve(unique_quartuples.size());
+				for (const auto& q : unique_quartuples)
+					vertex_positions.push_back(cgv::math::fvec<float, 3>(mesh.position(q[0])));
+			}
+			optimize_element_order(vertex_indices, unique_quartuples, triangle_element_buffer, edge_element_buffer,
+				optimize_overdraw ? &vertex_positions : 0);
+		}
 		std::vector<T> attrib_buffer;
 		color_increment = mesh.extract_vertex_attribute_buffer(vertex_indices, unique_quartuples, include_tex_coords, include_normals, include_tangents, attrib_buffer, &include_colors);
 		ref_vbos().push_back(new cgv::render::vertex_buffer(cgv::render::VBT_VERTICES));
@@ -87,6 +110,11 @@ public:
 		finish_construct_vbos_base(ctx, triangle_element_buffer, edge_element_buffer);
 		construct_draw_calls(ctx);
 	}
+	/** enable reordering of triangles and vertices in construct for a post transform vertex cache of given size and
+	    for vertex fetches, optionally sorting clusters of triangles to reduce overdraw (disabled by default) */
+	void set_element_order_optimization(bool vertex_cache, bool overdraw = false, unsigned cache_size = 16);
+	/// return simulated vertex cache statistics of the constructed triangle elements, optionally of their order before optimization, which are only computed if the vertex cache optimization is enabled
+	const cgv::media::mesh::vertex_cache_statistics& get_vertex_cache_statistics(bool before_optimization = false) const { return before_optimization ? original_cache_statistics : cache_statistics; }
 	/// set the number of to be drawn instances - in case of 0, instanced drawing is turned off
 	void set_nr_instances(unsigned nr);
 	/// return number of mesh primitives
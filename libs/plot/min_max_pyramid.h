@@ -0,0 +1,186 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace cgv {
+	namespace plot {
+
+/** incrementally maintained pyramid of the minimum and maximum value over blocks of 2^l consecutive samples of a
+    time series. For each block the indices of the samples with minimum and maximum value are stored, such that
+	a line through the first, minimum, maximum and last sample of each block in index order covers the same value
+	range as the line through all samples of the block. With blocks not wider than a pixel, such a line is
+	indistinguishable from the full line and no spikes are lost. The finest stored level has blocks of
+	2^first_level samples, finer levels use the samples themselves. Appending a sample updates one block per level.
+	Samples are addressed by the number of samples appended before them. With a finite capacity only the last
+	capacity samples are retained as in a ring buffer, blocks of overwritten samples are discarded and blocks that
+	are only partially retained are recomputed from the retained samples on extraction. */
+class min_max_pyramid
+{
+public:
+	/// indices of samples with minimum and maximum value in a block
+	struct block
+	{
+		size_t min_index, max_index;
+	};
+	/// blocks of one level starting with the block of index begin
+	struct level
+	{
+		size_t begin;
+		std::deque<block> blocks;
+	};
+	/// finest stored level
+	static const unsigned first_level = 2;
+protected:
+	/// maximum number of retained samples
+	size_t capacity;
+	/// number of appended samples
+	size_t nr_samples;
+	/// levels first_level, first_level+1, ...
+	std::vector<level> levels;
+	/// combine two blocks, where earlier samples are preferred on equal values
+	template <typename F>
+	static block merge(const block& b0, const block& b1, const F& value) {
+		block b;
+		b.min_index = value(b1.min_index) < value(b0.min_index) ? b1.min_index : b0.min_index;
+		b.max_index = value(b1.max_index) > value(b0.max_index) ? b1.max_index : b0.max_index;
+		return b;
+	}
+	/// merge block b into the block of index bi in level L, which is either the last block or the next one
+	template <typename F>
+	static void add_block(level& L, size_t bi, const block& b, const F& value) {
+		if (bi - L.begin == L.blocks.size())
+			L.blocks.push_back(b);
+		else
+			L.blocks.back() = merge(L.blocks.back(), b, value);
+	}
+public:
+	/// construct empty pyramid that retains at most the given number of samples
+	min_max_pyramid(size_t _capacity = size_t(-1)) : capacity(_capacity), nr_samples(0) {}
+	/// remove all samples
+	void clear() { nr_samples = 0; levels.clear(); }
+	/// remove all samples and set the maximum number of retained samples
+	void set_capacity(size_t _capacity) { clear(); capacity = _capacity; }
+	/// return the maximum number of retained samples
+	size_t get_capacity() const { return capacity; }
+	/// return number of appended samples
+	size_t get_nr_samples() const { return nr_samples; }
+	/// return the index of the first retained sample
+	size_t get_first_sample() const { return nr_samples > capacity ? nr_samples - capacity : 0; }
+	/// return number of levels including level 0 formed by the samples
+	unsigned get_nr_levels() const { return levels.empty() ? 1 : unsigned(first_level + levels.size()); }
+	/// return the blocks of level l >= first_level
+	const level& get_level(unsigned l) const { return levels[l - first_level]; }
+	/** append samples up to new_nr_samples, where value(i) returns the value of the i-th sample. A smaller
+	    number of samples than appended before restarts the pyramid. */
+	template <typename F>
+	void append(size_t new_nr_samples, const F& value) {
+		if (new_nr_samples < nr_samples)
+			clear();
+		// restart at the first retained sample if all appended samples are overwritten
+		size_t first = new_nr_samples > capacity ? new_nr_samples - capacity : 0;
+		if (first > nr_samples) {
+			levels.clear();
+			nr_samples = first;
+		}
+		for (size_t i = nr_samples; i < new_nr_samples; ++i) {
+			auto v = value(i);
+			for (unsigned li = 0; li < levels.size(); ++li) {
+				level& L = levels[li];
+				size_t bi = i >> (first_level + li);
+				if (bi - L.begin == L.blocks.size()) {
+					block b = { i, i };
+					L.blocks.push_back(b);
+					continue;
+				}
+				block& b = L.blocks.back();
+				if (v < value(b.min_index))
+					b.min_index = i;
+				if (v > value(b.max_index))
+					b.max_index = i;
+			}
+			// add coarser level as soon as the retained samples span two of its blocks, where levels
+			// with more than half of the capacity per block are never chosen
+			size_t fi = i >= capacity ? i + 1 - capacity : 0;
+			unsigned l = unsigned(first_level + levels.size());
+			while ((size_t(2) << l) <= capacity && (i >> l) > (fi >> l)) {
+				level N;
+				N.begin = fi >> l;
+				if (levels.empty()) {
+					for (size_t j = fi; j <= i; ++j) {
+						block bj = { j, j };
+						add_block(N, j >> l, bj, value);
+					}
+				}
+				else {
+					const level& P = levels.back();
+					N.begin = P.begin >> 1;
+					for (size_t k = 0; k < P.blocks.size(); ++k)
+						add_block(N, (P.begin + k) >> 1, P.blocks[k], value);
+				}
+				levels.push_back(N);
+				++l;
+			}
+		}
+		nr_samples = std::max(nr_samples, new_nr_samples);
+		// discard blocks of overwritten samples
+		for (unsigned li = 0; li < levels.size(); ++li) {
+			level& L = levels[li];
+			while (!L.blocks.empty() && ((L.begin + 1) << (first_level + li)) <= first) {
+				L.blocks.pop_front();
+				++L.begin;
+			}
+		}
+	}
+	/// return the level for which nr_visible_samples are represented by one to two blocks per pixel, or 0 if the samples themselves are not denser
+	unsigned choose_level(size_t nr_visible_samples, double nr_pixels) const {
+		if (nr_pixels < 1)
+			nr_pixels = 1;
+		unsigned l = 0;
+		while (l + 1 < get_nr_levels() && double(size_t(2) << l) * nr_pixels <= double(nr_visible_samples))
+			++l;
+		return l < first_level ? 0 : l;
+	}
+	/** append the sample indices to be drawn for the retained samples in [begin, end) at the given level in increasing
+	    order, where value(i) returns the value of the i-th sample. Level 0 yields all samples, coarser levels the first,
+		minimum, maximum and last sample of each block that overlaps the range. */
+	template <typename F>
+	void extract(size_t begin, size_t end, unsigned level, std::vector<size_t>& indices, const F& value) const {
+		size_t first = get_first_sample();
+		begin = std::max(begin, first);
+		end = std::min(end, nr_samples);
+		if (begin >= end)
+			return;
+		if (level < first_level) {
+			for (size_t i = begin; i < end; ++i)
+				indices.push_back(i);
+			return;
+		}
+		const min_max_pyramid::level& L = get_level(level);
+		size_t bi_end = ((end - 1) >> level) + 1;
+		for (size_t bi = begin >> level; bi < bi_end; ++bi) {
+			size_t i0 = std::max(bi << level, first);
+			size_t i1 = std::min((bi + 1) << level, nr_samples) - 1;
+			block b;
+			if ((bi << level) < first) {
+				b.min_index = b.max_index = i0;
+				for (size_t j = i0 + 1; j <= i1; ++j) {
+					block bj = { j, j };
+					b = merge(b, bj, value);
+				}
+			}
+			else
+				b = L.blocks[bi - L.begin];
+			size_t I[4] = { i0, b.min_index, b.max_index, i1 };
+			std::sort(I + 1, I + 3);
+			for (int k = 0; k < 4; ++k)
+				if (indices.empty() || indices.back() != I[k])
+					indices.push_back(I[k]);
+		}
+	}
+};
+
+	}
+}
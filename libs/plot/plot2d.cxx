@@ -3,6 +3,7 @@
 #include <cgv/media/color_scale.h>
 #include <cgv/render/attribute_array_binding.h>
 #include <cgv/math/ftransform.h>
+#include <cstring>
 
 namespace cgv {
 	namespace plot {
@@ -10,6 +11,7 @@ namespace cgv {
 /** extend common plot configuration with parameters specific to 1d plot */
 plot2d_config::plot2d_config(const std::string& _name) : plot_base_config(_name, 2)
 {
+	line_level_of_detail = false;
 	configure_chart(CT_LINE_CHART);
 };
 
@@ -81,6 +83,7 @@ unsigned plot2d::add_sub_plot(const std::string& name)
 	// create new point container
 	samples.push_back(std::vector<plot2d::vec2>());
 	strips.push_back(std::vector<unsigned>());
+	lods.push_back(lod_info());
 	attribute_source_arrays.push_back(attribute_source_array());
 	attribute_source_arrays.back().attribute_sources.push_back(attribute_source(i, 0, 0, 2 * sizeof(float)));
 	attribute_source_arrays.back().attribute_sources.push_back(attribute_source(i, 1, 0, 2 * sizeof(float)));
@@ -95,6 +98,7 @@ void plot2d::delete_sub_plot(unsigned i)
 	configs.erase(configs.begin() + i);
 	samples.erase(samples.begin() + i);
 	strips.erase(strips.begin() + i);
+	lods.erase(lods.begin() + i);
 }
 
 /// return a reference to the plot base configuration of the i-th plot
@@ -146,6 +150,11 @@ void plot2d::clear(cgv::render::context& ctx)
 	point_prog.destruct(ctx);
 	line_prog.destruct(ctx);
 	rectangle_prog.destruct(ctx);
+	for (auto& lod : lods) {
+		lod.aab.destruct(ctx);
+		lod.vbo.destruct(ctx);
+		lod.vertices.clear();
+	}
 	plot_base::clear(ctx);
 }
 
@@ -188,12 +197,183 @@ bool plot2d::draw_point_plot(cgv::render::context& ctx, int i, int layer_idx)
 	disable_attributes(ctx, i);
 	return result;
 }
+void plot2d::lod_info::restart(AttributeSource _source, bool _ringbuffer, size_t capacity)
+{
+	pyramid.set_capacity(capacity);
+	source = _source;
+	ringbuffer = _ringbuffer;
+	last_decrease = 0;
+	vbo_samples.clear();
+	if (source == AS_VBO)
+		vbo_samples.resize(capacity);
+	vertices.clear();
+}
+template <typename F>
+bool plot2d::update_lod_vertices(lod_info& lod, size_t nr_samples, const F& sample, double nr_pixels)
+{
+	// check x-coordinates of new samples and append them to pyramid
+	size_t first = nr_samples > lod.pyramid.get_capacity() ? nr_samples - lod.pyramid.get_capacity() : 0;
+	for (size_t k = std::max(lod.pyramid.get_nr_samples(), first + 1); k < nr_samples; ++k)
+		if (sample(k)[0] < sample(k - 1)[0])
+			lod.last_decrease = k;
+	lod.pyramid.append(nr_samples, [&sample](size_t k) { return sample(k)[1]; });
+	if (nr_samples == 0 || lod.last_decrease > first)
+		return false;
+	// find visible samples including one neighbor on each side such that lines reach the domain border
+	const axis_config& acx = get_domain_config_ptr()->axis_configs[0];
+	size_t lo = first, hi = nr_samples;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (sample(mid)[0] < acx.get_attribute_min())
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	size_t begin = lo;
+	hi = nr_samples;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (acx.get_attribute_max() < sample(mid)[0])
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	size_t end = lo;
+	if (begin > first)
+		--begin;
+	if (end < nr_samples)
+		++end;
+	unsigned level = lod.pyramid.choose_level(end - begin, nr_pixels);
+	// extract samples only if visible range, level or number of samples changed
+	if (!lod.vertices.empty() && begin == lod.begin && end == lod.end && level == lod.level && nr_samples == lod.nr_samples)
+		return true;
+	lod.indices.clear();
+	lod.pyramid.extract(begin, end, level, lod.indices, [&sample](size_t k) { return sample(k)[1]; });
+	lod.vertices.resize(lod.indices.size());
+	for (size_t k = 0; k < lod.indices.size(); ++k)
+		lod.vertices[k] = sample(lod.indices[k]);
+	lod.begin = begin;
+	lod.end = end;
+	lod.level = level;
+	lod.nr_samples = nr_samples;
+	lod.vertices_out_of_date = true;
+	return true;
+}
+size_t plot2d::enable_lod_attributes(cgv::render::context& ctx, int i)
+{
+	// level of detail is restricted to a single strip through x- and y-coordinates of the same source type
+	const plot2d_config& spc = ref_sub_plot2d_config(i);
+	const auto& asa = attribute_source_arrays[i];
+	const auto& ass = asa.attribute_sources;
+	if (!strips[i].empty() || ass.size() != 2 || ass[0].source != ass[1].source)
+		return 0;
+	const axis_config& acx = get_domain_config_ptr()->axis_configs[0];
+	if (acx.get_log_scale())
+		return 0;
+	// measure plot width in pixels
+	dmat4 MPW = ctx.get_modelview_projection_window_matrix();
+	dvec4 p0 = MPW * dvec4(-0.5 * extent[0], 0.0, 0.0, 1.0);
+	dvec4 p1 = MPW * dvec4(0.5 * extent[0], 0.0, 0.0, 1.0);
+	if (p0[3] <= 0.0 || p1[3] <= 0.0)
+		return 0;
+	double nr_pixels = fabs(p1[0] / p1[3] - p0[0] / p0[3]);
+	lod_info& lod = lods[i];
+	bool applicable = false;
+	switch (ass[0].source) {
+	case AS_SAMPLE_CONTAINER:
+	{
+		for (unsigned ai = 0; ai < 2; ++ai)
+			if ((ass[ai].sub_plot_index != -1 && ass[ai].sub_plot_index != i) || ass[ai].offset != ai)
+				return 0;
+		if (spc.begin_sample != 0 || spc.end_sample != size_t(-1))
+			return 0;
+		// restart pyramid if samples were removed or the last appended sample was replaced
+		const std::vector<vec2>& S = samples[i];
+		size_t n = lod.pyramid.get_nr_samples();
+		if (lod.source != AS_SAMPLE_CONTAINER || S.size() < n || (n > 0 && std::memcmp(&S[n - 1], &lod.last_sample, sizeof(vec2)) != 0))
+			lod.restart(AS_SAMPLE_CONTAINER, false, size_t(-1));
+		applicable = update_lod_vertices(lod, S.size(), [&S](size_t k) { return S[k]; }, nr_pixels);
+		if (!S.empty())
+			lod.last_sample = S.back();
+		break;
+	}
+	case AS_POINTER:
+	case AS_VBO:
+	{
+		// external sources of equal size are either arrays that are rebuilt whenever samples are out of date or
+		// ring buffers, into which nr_written_samples have been written, while vbos are only supported as ring buffers
+		size_t capacity = ass[0].count;
+		bool ringbuffer = spc.nr_written_samples > 0;
+		if (capacity == 0 || ass[1].count != capacity)
+			return 0;
+		if (!ringbuffer && (ass[0].source == AS_VBO || spc.begin_sample != 0 || spc.end_sample != size_t(-1)))
+			return 0;
+		size_t n = ringbuffer ? spc.nr_written_samples : capacity;
+		if (lod.source != ass[0].source || lod.ringbuffer != ringbuffer || lod.pyramid.get_capacity() != capacity ||
+			n < lod.pyramid.get_nr_samples() || (!ringbuffer && asa.samples_out_of_date))
+			lod.restart(ass[0].source, ringbuffer, capacity);
+		if (ass[0].source == AS_POINTER) {
+			applicable = update_lod_vertices(lod, n, [&ass, capacity](size_t k) {
+				size_t j = k % capacity;
+				return vec2(*reinterpret_cast<const float*>(reinterpret_cast<const char*>(ass[0].pointer) + j * ass[0].stride),
+					*reinterpret_cast<const float*>(reinterpret_cast<const char*>(ass[1].pointer) + j * ass[1].stride));
+			}, nr_pixels);
+			break;
+		}
+		// read back ring buffer slots of new samples in at most two contiguous ranges
+		size_t first = n > capacity ? n - capacity : 0;
+		size_t k0 = std::max(lod.pyramid.get_nr_samples(), first);
+		std::vector<char> buffer;
+		while (k0 < n) {
+			size_t j0 = k0 % capacity;
+			size_t j1 = std::min(j0 + (n - k0), capacity);
+			for (unsigned ai = 0; ai < 2; ++ai) {
+				buffer.resize((j1 - j0 - 1) * ass[ai].stride + sizeof(float));
+				const_cast<cgv::render::vertex_buffer*>(ass[ai].vbo_ptr)->copy(ctx, ass[ai].offset + j0 * ass[ai].stride, buffer.data(), buffer.size());
+				for (size_t j = j0; j < j1; ++j)
+					std::memcpy(&lod.vbo_samples[j][ai], buffer.data() + (j - j0) * ass[ai].stride, sizeof(float));
+			}
+			k0 += j1 - j0;
+		}
+		const std::vector<vec2>& R = lod.vbo_samples;
+		applicable = update_lod_vertices(lod, n, [&R, capacity](size_t k) { return R[k % capacity]; }, nr_pixels);
+		break;
+	}
+	default:
+		return 0;
+	}
+	if (!applicable)
+		return 0;
+	// upload extracted samples
+	if (lod.vertices_out_of_date) {
+		size_t nr_bytes = lod.vertices.size() * sizeof(vec2);
+		if (lod.vbo.get_size_in_bytes() < nr_bytes) {
+			lod.vbo.destruct(ctx);
+			lod.vbo.create(ctx, 2 * nr_bytes);
+		}
+		lod.vbo.replace(ctx, 0, lod.vertices.data(), lod.vertices.size());
+		if (!lod.aab.is_created())
+			lod.aab.create(ctx);
+		float f;
+		lod.aab.set_attribute_array(ctx, 0, cgv::render::get_element_type(f), lod.vbo, 0, lod.vertices.size(), sizeof(vec2));
+		lod.aab.set_attribute_array(ctx, 1, cgv::render::get_element_type(f), lod.vbo, sizeof(float), lod.vertices.size(), sizeof(vec2));
+		lod.vertices_out_of_date = false;
+	}
+	lod.aab.enable(ctx);
+	return lod.vertices.size();
+}
 bool plot2d::draw_line_plot(cgv::render::context& ctx, int i, int layer_idx)
 {
 	// skip unvisible and empty sub plots
 	if (!ref_sub_plot2d_config(i).show_plot)
 		return false;
-	GLsizei count = (GLsizei)enable_attributes(ctx, i, samples);
+	// draw long lines from min/max pyramid if possible
+	GLsizei count = 0;
+	if (ref_sub_plot2d_config(i).line_level_of_detail && ref_sub_plot2d_config(i).show_lines && line_prog.is_linked())
+		count = (GLsizei)enable_lod_attributes(ctx, i);
+	bool use_lod = count > 0;
+	if (!use_lod)
+		count = (GLsizei)enable_attributes(ctx, i, samples);
 	bool result = false;
 	if (count > 0) {
 		const plot2d_config& spc = ref_sub_plot2d_config(i);
@@ -221,7 +401,9 @@ bool plot2d::draw_line_plot(cgv::render::context& ctx, int i, int layer_idx)
 			line_prog.set_attribute(ctx, "secondary_color", spc.line_halo_color.color);
 			line_prog.set_attribute(ctx, "size", spc.line_width.size);
 			line_prog.enable(ctx);
-			if (strips[i].empty())
+			if (use_lod)
+				glDrawArrays(GL_LINE_STRIP, 0, count);
+			else if (strips[i].empty())
 				draw_sub_plot_samples(count, spc, true);
 			else {
 				unsigned fst = 0;
@@ -234,7 +416,10 @@ bool plot2d::draw_line_plot(cgv::render::context& ctx, int i, int layer_idx)
 			result = true;
 		}
 	}
-	disable_attributes(ctx, i);
+	if (use_lod)
+		lods[i].aab.disable(ctx);
+	else
+		disable_attributes(ctx, i);
 	return result;
 }
 bool plot2d::draw_stick_plot(cgv::render::context& ctx, int i, int layer_idx)
@@ -649,6 +834,14 @@ void plot2d::create_point_config_gui(cgv::base::base* bp, cgv::gui::provider& p,
 	plot_base::create_point_config_gui(bp, p, pbc);
 }
 
+/// create the gui for a line subplot
+void plot2d::create_line_config_gui(cgv::base::base* bp, cgv::gui::provider& p, plot_base_config& pbc)
+{
+	auto& p2dc = reinterpret_cast<plot2d_config&>(pbc);
+	plot_base::create_line_config_gui(bp, p, pbc);
+	p.add_member_control(bp, "Level of Detail", p2dc.line_level_of_detail, "toggle");
+}
+
 /// create the gui for a stick subplot
 void plot2d::create_stick_config_gui(cgv::base::base* bp, cgv::gui::provider& p, plot_base_config& pbc)
 {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "plot_base.h"
+#include "min_max_pyramid.h"
 //#include "mark2d_provider.h"
 #include <cgv/render/shader_program.h>
 
@@ -15,6 +16,8 @@ struct CGV_API plot2d_config : public plot_base_config
 {
 	/// set default values
 	plot2d_config(const std::string& _name);
+	/// whether to draw the lines of sub plots with more samples than pixels from a min/max pyramid, which requires non decreasing x-coordinates and samples that are only appended or cleared, or external ring buffer sources with known number of written samples
+	bool line_level_of_detail;
 	/// configure the sub plot to a specific chart type
 	void configure_chart(ChartType chart_type);
 	/// list of styles for provider based marks
@@ -41,6 +44,40 @@ protected:
 	void extract_domain_tick_rectangles_and_tick_labels(std::vector<box2>& R, std::vector<rgb>& C, std::vector<float>& D, std::vector<label_info>& tick_labels, std::vector<tick_batch_info>& tick_batches);
 	void draw_domain(cgv::render::context& ctx, int si = -1, bool no_fill = false);
 protected:
+	/// level of detail information of a sub plot used to draw lines
+	struct lod_info
+	{
+		/// min/max pyramid over y-coordinates
+		min_max_pyramid pyramid;
+		/// source of samples and whether external sources are used as ring buffers
+		AttributeSource source;
+		bool ringbuffer;
+		/// index of last sample with smaller x-coordinate than its predecessor or 0 if x-coordinates do not decrease
+		size_t last_decrease;
+		/// last appended sample of sample containers used to detect replaced samples
+		vec2 last_sample;
+		/// ring buffer samples read back from vbo sources
+		std::vector<vec2> vbo_samples;
+		/// sample range, level and number of samples from which the drawn samples were extracted
+		size_t begin, end, nr_samples;
+		unsigned level;
+		/// indices and coordinates of the drawn samples
+		std::vector<size_t> indices;
+		std::vector<vec2> vertices;
+		bool vertices_out_of_date;
+		cgv::render::vertex_buffer vbo;
+		cgv::render::attribute_array_binding aab;
+		lod_info() : source(AS_NONE), ringbuffer(false), last_decrease(0), begin(0), end(0), nr_samples(0), level(0), vertices_out_of_date(false) {}
+		/// remove all samples and restart with given source and capacity
+		void restart(AttributeSource _source, bool _ringbuffer, size_t capacity);
+	};
+	/// level of detail information per sub plot
+	std::vector<lod_info> lods;
+	/// append new samples to the pyramid of lod, where sample(k) returns the k-th sample, and extract the visible samples if they changed; return false if x-coordinates decrease
+	template <typename F>
+	bool update_lod_vertices(lod_info& lod, size_t nr_samples, const F& sample, double nr_pixels);
+	/// update pyramid of i-th sub plot, upload the samples of the level with one to two blocks per pixel and return their number or 0 if level of detail is not applicable
+	size_t enable_lod_attributes(cgv::render::context& ctx, int i);
 
 	bool compute_sample_coordinate_interval(int i, int ai, float& samples_min, float& samples_max);
 	/// store 2d samples for data series
@@ -85,6 +122,8 @@ public:
 
 	/// create the gui for a point subplot
 	void create_point_config_gui(cgv::base::base* bp, cgv::gui::provider& p, plot_base_config& pbc);
+	/// create the gui for a line subplot
+	void create_line_config_gui(cgv::base::base* bp, cgv::gui::provider& p, plot_base_config& pbc);
 	/// create the gui for a stick subplot
 	void create_stick_config_gui(cgv::base::base* bp, cgv::gui::provider& p, plot_base_config& pbc);
 	/// create the gui for a bar subplot
@@ -47,6 +47,7 @@ plot_base_config::plot_base_config(const std::string& _name, unsigned dim) : nam
 	show_plot = true;
 	begin_sample = 0;
 	end_sample = size_t(-1);
+	nr_written_samples = 0;
 	ref_size = 8;
 	ref_color = rgb(1, 0, 0);
 	ref_opacity = 1.0f;
@@ -136,6 +136,8 @@ struct CGV_API plot_base_config : public cgv::render::render_types
 	size_t begin_sample;
 	/// defaults to -1 and effectively is always the end of the sample vector
 	size_t end_sample;
+	/// total number of samples written to external attribute sources that are used as ring buffers of which begin_sample and end_sample select the valid part, defaults to 0 if unknown
+	size_t nr_written_samples;
 
 	/// whether to show sub plot
 	bool show_plot;
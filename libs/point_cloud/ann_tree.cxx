@@ -1,8 +1,13 @@
 #include "ann_tree.h"
 
+#include <mutex>
+
 #define ANN_USE_FLOAT
 #include <ANN/ANN.h>
 
+/// ANN keeps the state of a search in global variables, such that queries to all trees need to be serialized
+static std::mutex ann_search_mutex;
+
 struct ann_struct
 {
 	ANNpointArray pa;
@@ -102,6 +107,7 @@ void ann_tree::extract_neighbors(Idx i, Idx k, std::vector<Idx>& N) const
 		std::cerr << "no ann_tree built" << std::endl;
 		return;
 	}
+	std::lock_guard<std::mutex> lock(ann_search_mutex);
 	N.resize(k);
 	tmp.resize(k+1);
 	dists.resize(k+1);
@@ -116,6 +122,7 @@ ann_tree::Idx ann_tree::find_closest(const Pnt& p) const
 		std::cerr << "no ann_tree built" << std::endl;
 		return -1;
 	}
+	std::lock_guard<std::mutex> lock(ann_search_mutex);
 	float dist;
 	unsigned int result;
 	ann->ps->annkSearch(const_cast<ANNpoint>(&p[0]), 1, (ANNidxArray)&result, &dist);
@@ -131,6 +138,7 @@ void ann_tree::find_closest_points(const Pnt& p, Idx k, std::vector<const Pnt*>&
 	knn.resize(k);
 	ANNdistArray dist_array = new ANNdist[k];
 	ANNidxArray index_array = new ANNidx[k];
+	std::lock_guard<std::mutex> lock(ann_search_mutex);
 	ann->ps->annkSearch(const_cast<ANNpoint>(&p[0]), 1, (ANNidxArray)&index_array, dist_array);
 	for (Idx i = 0; i < k; ++i)
 		knn[i] = reinterpret_cast<const Pnt*>(ann->ps->thePoints()[index_array[i]]);
@@ -25,7 +25,8 @@ public:
 	void build(const point_cloud& pc);
 	/// build from given components
 	void build(const point_cloud& pc, const std::vector<Idx>& component_indices);
-	/// provide necessary method for building a neighbor graph
+	/** provide necessary method for building a neighbor graph, which can be called concurrently from several threads
+	    but serializes the queries, as ANN stores the search state in global variables; use kd_tree for parallel queries */
 	void extract_neighbors(Idx i, Idx k, std::vector<Idx>& N) const;
 	/// addition query method to find the closest neighbor
 	Idx find_closest(const Pnt& p) const;
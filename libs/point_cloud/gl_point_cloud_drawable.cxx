@@ -41,6 +41,8 @@ gl_point_cloud_drawable::gl_point_cloud_drawable()
 
 	use_component_colors = false;
 	use_component_transformations = false;
+
+	max_lod_uploads_per_frame = 16;
 }
 
 bool gl_point_cloud_drawable::ensure_file_name(std::string& fn, const std::string* data_path_ptr) const
@@ -68,6 +70,18 @@ bool gl_point_cloud_drawable::read(std::string& fn, const std::string* data_path
 {
 	if (!ensure_file_name(fn, data_path_ptr))
 		return false;
+	if (cgv::utils::to_lower(get_extension(fn)) == "poct") {
+		if (!lod_streamer.open(fn)) {
+			last_error = "could not open level of detail octree ";
+			last_error += fn;
+			return false;
+		}
+		pc.clear();
+		show_point_begin = show_point_end = 0;
+		post_redraw();
+		return true;
+	}
+	lod_streamer.close();
 	if (!pc.read(fn)) {
 		last_error = "could not read point cloud ";
 		last_error += fn;
@@ -110,6 +124,15 @@ bool gl_point_cloud_drawable::append(std::string& fn, bool add_component, const
 }
 bool gl_point_cloud_drawable::write(const std::string& fn)
 {
+	if (cgv::utils::to_lower(get_extension(fn)) == "poct") {
+		lod_octree_converter converter;
+		if (!converter.convert(pc, fn)) {
+			last_error = "could not write level of detail octree ";
+			last_error += fn;
+			return false;
+		}
+		return true;
+	}
 	if (!pc.write(fn)) {
 		last_error = "could not write point cloud ";
 		last_error += fn;
@@ -326,8 +349,84 @@ bool gl_point_cloud_drawable::init(cgv::render::context& ctx)
 	return true;
 }
 
+void gl_point_cloud_drawable::clear_lod_vbos(cgv::render::context& ctx)
+{
+	for (auto& v : lod_vbos) {
+		v.second->destruct(ctx);
+		delete v.second;
+	}
+	lod_vbos.clear();
+}
+
+void gl_point_cloud_drawable::draw_lod_octree(cgv::render::context& ctx)
+{
+	if (show_box)
+		draw_box(ctx, lod_streamer.get_box(), box_color);
+	if (!show_points)
+		return;
+	// select chunks for current view
+	cgv::render::render_types::dmat4 MV = ctx.get_modelview_matrix();
+	cgv::render::render_types::dmat4 P = ctx.get_projection_matrix();
+	HMat MVP(P * MV);
+	Pnt eye;
+	if (view_ptr || ensure_view_pointer())
+		eye = Pnt(view_ptr->get_eye());
+	else
+		eye = Pnt(ctx.get_model_point(ctx.get_width() / 2, ctx.get_height() / 2, 0.0));
+	Crd pixel_scale = Crd(0.5 * ctx.get_height() * P(1, 1));
+	bool loading = lod_streamer.update(MVP, eye, pixel_scale);
+
+	// free buffers of evicted chunks
+	for (auto iter = lod_vbos.begin(); iter != lod_vbos.end(); ) {
+		if (lod_streamer.get_chunk(iter->first))
+			++iter;
+		else {
+			iter->second->destruct(ctx);
+			delete iter->second;
+			iter = lod_vbos.erase(iter);
+		}
+	}
+	// upload limited number of new chunks and render all uploaded chunks
+	unsigned nr_uploads = 0;
+	bool has_clrs = lod_streamer.get_file().has_clrs;
+	bool has_nmls = lod_streamer.get_file().has_nmls;
+	for (Idx ni : lod_streamer.get_selected_nodes()) {
+		const lod_octree_streamer::chunk* c = lod_streamer.get_chunk(ni);
+		if (!c || c->P.empty())
+			continue;
+		size_t n = c->P.size();
+		auto iter = lod_vbos.find(ni);
+		if (iter == lod_vbos.end()) {
+			if (nr_uploads >= max_lod_uploads_per_frame) {
+				loading = true;
+				continue;
+			}
+			cgv::render::vertex_buffer* vbo = new cgv::render::vertex_buffer();
+			vbo->create(ctx, n * (sizeof(Pnt) + (has_clrs ? sizeof(Clr) : 0) + (has_nmls ? sizeof(Nml) : 0)));
+			vbo->replace(ctx, 0, c->P.data(), n);
+			if (has_clrs)
+				vbo->replace(ctx, n * sizeof(Pnt), c->C.data(), n);
+			if (has_nmls)
+				vbo->replace(ctx, n * (sizeof(Pnt) + (has_clrs ? sizeof(Clr) : 0)), c->N.data(), n);
+			iter = lod_vbos.insert(std::make_pair(ni, vbo)).first;
+			++nr_uploads;
+		}
+		const cgv::render::vertex_buffer& vbo = *iter->second;
+		s_renderer.set_position_array<Pnt>(ctx, vbo, 0, n, sizeof(Pnt));
+		if (has_clrs)
+			s_renderer.set_color_array<Clr>(ctx, vbo, n * sizeof(Pnt), n, sizeof(Clr));
+		if (has_nmls)
+			s_renderer.set_normal_array<Nml>(ctx, vbo, n * (sizeof(Pnt) + (has_clrs ? sizeof(Clr) : 0)), n, sizeof(Nml));
+		s_renderer.render(ctx, 0, n);
+	}
+	if (loading)
+		post_redraw();
+}
+
 void gl_point_cloud_drawable::clear(cgv::render::context& ctx)
 {
+	clear_lod_vbos(ctx);
+	lod_streamer.close();
 	s_renderer.clear(ctx);
 	a_renderer.clear(ctx);
 	b_renderer.clear(ctx);
@@ -336,6 +435,12 @@ void gl_point_cloud_drawable::clear(cgv::render::context& ctx)
 
 void gl_point_cloud_drawable::draw(context& ctx)
 {
+	if (lod_streamer.is_open()) {
+		draw_lod_octree(ctx);
+		return;
+	}
+	if (!lod_vbos.empty())
+		clear_lod_vbos(ctx);
 	if (pc.get_nr_points() == 0)
 		return;
 
@@ -3,8 +3,10 @@
 #include <cgv/render/drawable.h>
 #include <cgv/render/shader_program.h>
 #include <cgv/render/view.h>
+#include <cgv/render/vertex_buffer.h>
 
 #include "point_cloud.h"
+#include "lod_octree.h"
 
 #include <cgv_gl/surfel_renderer.h>
 #include <cgv_gl/arrow_renderer.h>
@@ -50,14 +52,30 @@ protected:
 	unsigned nr_draw_calls;
 	cgv::render::view* view_ptr;
 	mutable std::string last_error;
+
+	/**@name out-of-core rendering of level of detail octree files*/
+	//@{
+	/// streamer that loads chunks of level of detail octree files in a background thread
+	lod_octree_streamer lod_streamer;
+	/// vertex buffers of uploaded chunks
+	std::unordered_map<Idx, cgv::render::vertex_buffer*> lod_vbos;
+	/// maximum number of chunks uploaded to the GPU per frame
+	unsigned max_lod_uploads_per_frame;
+	/// free vertex buffers of all chunks
+	void clear_lod_vbos(cgv::render::context& ctx);
+	/// update selected chunks, upload new chunks and render them
+	void draw_lod_octree(cgv::render::context& ctx);
+	//@}
 	bool ensure_view_pointer();
 	void set_arrays(cgv::render::context& ctx, size_t offset = 0, size_t count = -1);
 	bool ensure_file_name(std::string& _file_name, const std::string* data_path_ptr = 0) const;
 public:
 	gl_point_cloud_drawable();
 
+	/// read point cloud or open level of detail octree file (extension poct) for out-of-core rendering
 	bool read(std::string& file_name, const std::string* data_path_ptr = 0);
 	bool append(std::string& file_name, bool add_component = true, const std::string* data_path_ptr = 0);
+	/// write point cloud or convert it to a level of detail octree file (extension poct)
 	bool write(const std::string& file_name);
 	
 	void render_boxes(cgv::render::context& ctx, cgv::render::group_renderer& R, cgv::render::group_render_style& RS);
@@ -0,0 +1,270 @@
+#include "kd_tree.h"
+#include "neighbor_graph.h"
+#include <algorithm>
+#include <cgv/os/thread_pool.h>
+
+kd_tree::kd_tree()
+{
+	pc = 0;
+	depth = 0;
+}
+
+void kd_tree::clear()
+{
+	pc = 0;
+	depth = 0;
+	indices.clear();
+	X.clear();
+	Y.clear();
+	Z.clear();
+	split_values.clear();
+	split_axes.clear();
+}
+
+bool kd_tree::is_empty() const
+{
+	return pc == 0;
+}
+
+void kd_tree::build(const point_cloud& _pc, unsigned nr_threads)
+{
+	clear();
+	pc = &_pc;
+	indices.resize(pc->get_nr_points());
+	for (Idx i = 0; i < (Idx)indices.size(); ++i)
+		indices[i] = i;
+	build_tree(nr_threads);
+}
+
+void kd_tree::build(const point_cloud& _pc, const std::vector<Idx>& component_indices, unsigned nr_threads)
+{
+	clear();
+	pc = &_pc;
+	for (Idx ci : component_indices) {
+		Idx pi_begin = Idx(pc->component_point_range(ci).index_of_first_point);
+		Idx pi_end = Idx(pi_begin + pc->component_point_range(ci).nr_points);
+		for (Idx pi = pi_begin; pi < pi_end; ++pi)
+			indices.push_back(pi);
+	}
+	build_tree(nr_threads);
+}
+
+void kd_tree::build_tree(unsigned nr_threads)
+{
+	Cnt n = Cnt(indices.size());
+	depth = 0;
+	while ((n >> depth) > max_leaf_size)
+		++depth;
+	split_values.resize((size_t(1) << depth) - 1);
+	split_axes.resize(split_values.size());
+	unsigned parallel_levels = 0;
+	nr_threads = neighbor_graph_nr_threads(nr_threads);
+	while ((1u << parallel_levels) < nr_threads)
+		++parallel_levels;
+	if (n > 0)
+		build_node(0, 0, 0, Idx(n), parallel_levels);
+	// copy coordinates in tree order
+	X.resize(n);
+	Y.resize(n);
+	Z.resize(n);
+	for (Cnt j = 0; j < n; ++j) {
+		const Pnt& p = pc->pnt(indices[j]);
+		X[j] = p[0];
+		Y[j] = p[1];
+		Z[j] = p[2];
+	}
+}
+
+void kd_tree::build_node(Idx ni, unsigned level, Idx b, Idx e, unsigned parallel_levels)
+{
+	if (level == depth)
+		return;
+	// split along axis of largest extent
+	Box box;
+	for (Idx j = b; j < e; ++j)
+		box.add_point(pc->pnt(indices[j]));
+	int axis = box.get_max_extent_coord_index();
+	Idx m = b + (e - b) / 2;
+	std::nth_element(indices.begin() + b, indices.begin() + m, indices.begin() + e, [this, axis](Idx i, Idx j) {
+		return pc->pnt(i)[axis] < pc->pnt(j)[axis];
+	});
+	split_values[ni] = pc->pnt(indices[m])[axis];
+	split_axes[ni] = cgv::type::uint8_type(axis);
+	if (parallel_levels > 0) {
+		cgv::os::task_group group(cgv::os::get_thread_pool());
+		group.run([=]() { build_node(2 * ni + 1, level + 1, b, m, parallel_levels - 1); });
+		build_node(2 * ni + 2, level + 1, m, e, parallel_levels - 1);
+		group.wait();
+	}
+	else {
+		build_node(2 * ni + 1, level + 1, b, m, 0);
+		build_node(2 * ni + 2, level + 1, m, e, 0);
+	}
+}
+
+void kd_tree::knn_recursive(const Crd* q, Idx ni, unsigned level, Idx b, Idx e, Cnt k, std::vector<std::pair<Crd, Idx> >& nn) const
+{
+	if (level == depth) {
+		// compute distances in a separate loop that can be vectorized
+		Crd d2[2 * max_leaf_size];
+		Idx n = e - b;
+		const Crd* x = &X[b], * y = &Y[b], * z = &Z[b];
+		for (Idx j = 0; j < n; ++j) {
+			Crd dx = x[j] - q[0], dy = y[j] - q[1], dz = z[j] - q[2];
+			d2[j] = dx * dx + dy * dy + dz * dz;
+		}
+		for (Idx j = 0; j < n; ++j) {
+			if (nn.size() < k) {
+				nn.push_back(std::make_pair(d2[j], b + j));
+				std::push_heap(nn.begin(), nn.end());
+			}
+			else if (d2[j] < nn.front().first) {
+				std::pop_heap(nn.begin(), nn.end());
+				nn.back() = std::make_pair(d2[j], b + j);
+				std::push_heap(nn.begin(), nn.end());
+			}
+		}
+		return;
+	}
+	Idx m = b + (e - b) / 2;
+	Crd diff = q[split_axes[ni]] - split_values[ni];
+	if (diff < 0) {
+		knn_recursive(q, 2 * ni + 1, level + 1, b, m, k, nn);
+		if (nn.size() < k || diff * diff < nn.front().first)
+			knn_recursive(q, 2 * ni + 2, level + 1, m, e, k, nn);
+	}
+	else {
+		knn_recursive(q, 2 * ni + 2, level + 1, m, e, k, nn);
+		if (nn.size() < k || diff * diff < nn.front().first)
+			knn_recursive(q, 2 * ni + 1, level + 1, b, m, k, nn);
+	}
+}
+
+void kd_tree::radius_recursive(const Crd* q, Crd sqr_radius, Idx ni, unsigned level, Idx b, Idx e, std::vector<std::pair<Crd, Idx> >& result) const
+{
+	if (level == depth) {
+		Crd d2[2 * max_leaf_size];
+		Idx n = e - b;
+		const Crd* x = &X[b], * y = &Y[b], * z = &Z[b];
+		for (Idx j = 0; j < n; ++j) {
+			Crd dx = x[j] - q[0], dy = y[j] - q[1], dz = z[j] - q[2];
+			d2[j] = dx * dx + dy * dy + dz * dz;
+		}
+		for (Idx j = 0; j < n; ++j)
+			if (d2[j] <= sqr_radius)
+				result.push_back(std::make_pair(d2[j], b + j));
+		return;
+	}
+	Idx m = b + (e - b) / 2;
+	Crd diff = q[split_axes[ni]] - split_values[ni];
+	if (diff <= 0 || diff * diff <= sqr_radius)
+		radius_recursive(q, sqr_radius, 2 * ni + 1, level + 1, b, m, result);
+	if (diff >= 0 || diff * diff <= sqr_radius)
+		radius_recursive(q, sqr_radius, 2 * ni + 2, level + 1, m, e, result);
+}
+
+void kd_tree::box_recursive(const Box& box, Idx ni, unsigned level, Idx b, Idx e, std::vector<Idx>& result) const
+{
+	if (level == depth) {
+		const Pnt& l = box.get_min_pnt();
+		const Pnt& h = box.get_max_pnt();
+		for (Idx j = b; j < e; ++j)
+			if (X[j] >= l[0] && X[j] <= h[0] && Y[j] >= l[1] && Y[j] <= h[1] && Z[j] >= l[2] && Z[j] <= h[2])
+				result.push_back(indices[j]);
+		return;
+	}
+	Idx m = b + (e - b) / 2;
+	int axis = split_axes[ni];
+	if (box.get_min_pnt()[axis] <= split_values[ni])
+		box_recursive(box, 2 * ni + 1, level + 1, b, m, result);
+	if (box.get_max_pnt()[axis] >= split_values[ni])
+		box_recursive(box, 2 * ni + 2, level + 1, m, e, result);
+}
+
+void kd_tree::find_knn(const Pnt& p, Idx k, std::vector<Idx>& knn, std::vector<Crd>* sqr_dists) const
+{
+	thread_local std::vector<std::pair<Crd, Idx> > nn;
+	nn.clear();
+	knn.clear();
+	if (sqr_dists)
+		sqr_dists->clear();
+	if (indices.empty() || k <= 0)
+		return;
+	knn_recursive(&p[0], 0, 0, 0, Idx(indices.size()), Cnt(k), nn);
+	std::sort_heap(nn.begin(), nn.end());
+	knn.resize(nn.size());
+	for (size_t j = 0; j < nn.size(); ++j)
+		knn[j] = indices[nn[j].second];
+	if (sqr_dists) {
+		sqr_dists->resize(nn.size());
+		for (size_t j = 0; j < nn.size(); ++j)
+			(*sqr_dists)[j] = nn[j].first;
+	}
+}
+
+void kd_tree::find_knn(const std::vector<Pnt>& queries, Idx k, std::vector<Idx>& knn_indices, unsigned nr_threads) const
+{
+	knn_indices.resize(queries.size() * k);
+	neighbor_graph_for_each_point(Cnt(queries.size()), nr_threads, neighbor_graph_progress_callback(), [&](Idx qi, std::vector<Idx>& N) {
+		find_knn(queries[qi], k, N);
+		N.resize(k, -1);
+		std::copy(N.begin(), N.end(), knn_indices.begin() + size_t(qi) * k);
+	});
+}
+
+void kd_tree::find_in_radius(const Pnt& p, Crd radius, std::vector<Idx>& result, std::vector<Crd>* sqr_dists) const
+{
+	thread_local std::vector<std::pair<Crd, Idx> > nn;
+	nn.clear();
+	result.clear();
+	if (sqr_dists)
+		sqr_dists->clear();
+	if (indices.empty())
+		return;
+	radius_recursive(&p[0], radius * radius, 0, 0, 0, Idx(indices.size()), nn);
+	std::sort(nn.begin(), nn.end());
+	result.resize(nn.size());
+	for (size_t j = 0; j < nn.size(); ++j)
+		result[j] = indices[nn[j].second];
+	if (sqr_dists) {
+		sqr_dists->resize(nn.size());
+		for (size_t j = 0; j < nn.size(); ++j)
+			(*sqr_dists)[j] = nn[j].first;
+	}
+}
+
+void kd_tree::find_in_box(const Box& box, std::vector<Idx>& result) const
+{
+	result.clear();
+	if (!indices.empty())
+		box_recursive(box, 0, 0, 0, Idx(indices.size()), result);
+}
+
+void kd_tree::extract_neighbors(Idx i, Idx k, std::vector<Idx>& N) const
+{
+	find_knn(pc->pnt(i), k + 1, N);
+	auto iter = std::find(N.begin(), N.end(), i);
+	if (iter != N.end())
+		N.erase(iter);
+	else if (!N.empty())
+		N.pop_back();
+}
+
+kd_tree::Idx kd_tree::find_closest(const Pnt& p) const
+{
+	if (indices.empty())
+		return -1;
+	thread_local std::vector<std::pair<Crd, Idx> > nn;
+	nn.clear();
+	knn_recursive(&p[0], 0, 0, 0, Idx(indices.size()), 1, nn);
+	return indices[nn.front().second];
+}
+
+void kd_tree::find_closest_points(const Pnt& p, Idx k, std::vector<const Pnt*>& knn) const
+{
+	std::vector<Idx> N;
+	find_knn(p, k, N);
+	knn.resize(N.size());
+	for (size_t j = 0; j < N.size(); ++j)
+		knn[j] = &pc->pnt(N[j]);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include "point_cloud.h"
+
+#include "lib_begin.h"
+
+/** native k-d tree over the points of a point cloud that can replace ann_tree without depending on a third party library.
+    The tree is balanced by median splits such that its layout is implicit: inner node ni has children 2*ni+1 and 2*ni+2
+	and only the split axis and value are stored per node. The point coordinates are copied in tree order into separate
+	x, y and z arrays, such that the distance computations of the leaf scans are vectorized by the compiler. The tree is
+	built in parallel and all queries are const and can be called concurrently from several threads. */
+class CGV_API kd_tree : public point_cloud_types
+{
+public:
+	/// maximum number of points per leaf
+	static const Cnt max_leaf_size = 16;
+protected:
+	/// point cloud from which tree has been built
+	const point_cloud* pc;
+	/// point cloud indices of points in tree order
+	std::vector<Idx> indices;
+	/// coordinates of points in tree order
+	std::vector<Crd> X, Y, Z;
+	/// split values of inner nodes
+	std::vector<Crd> split_values;
+	/// split axes of inner nodes
+	std::vector<cgv::type::uint8_type> split_axes;
+	/// depth of leaf nodes, where root has depth 0
+	unsigned depth;
+	/// recursively construct subtree of node ni over the tree order range [b,e)
+	void build_node(Idx ni, unsigned level, Idx b, Idx e, unsigned parallel_levels);
+	/// build tree over the points in indices
+	void build_tree(unsigned nr_threads);
+	/// recursive knn query, where nn is a max heap of (squared distance, tree order position) pairs
+	void knn_recursive(const Crd* q, Idx ni, unsigned level, Idx b, Idx e, Cnt k, std::vector<std::pair<Crd, Idx> >& nn) const;
+	/// recursive radius query collecting tree order positions
+	void radius_recursive(const Crd* q, Crd sqr_radius, Idx ni, unsigned level, Idx b, Idx e, std::vector<std::pair<Crd, Idx> >& result) const;
+	/// recursive box query collecting point cloud indices
+	void box_recursive(const Box& box, Idx ni, unsigned level, Idx b, Idx e, std::vector<Idx>& result) const;
+public:
+	/// construct empty tree
+	kd_tree();
+	/// clear the used memory
+	void clear();
+	/// check whether the tree has been built
+	bool is_empty() const;
+	/// return number of points in tree
+	Cnt get_nr_points() const { return Cnt(indices.size()); }
+	/// build from complete point cloud with given number of threads (0 ... use concurrency of the shared thread pool)
+	void build(const point_cloud& pc, unsigned nr_threads = 0);
+	/// build from given components with given number of threads (0 ... use concurrency of the shared thread pool)
+	void build(const point_cloud& pc, const std::vector<Idx>& component_indices, unsigned nr_threads = 0);
+
+	/**@name queries compatible to ann_tree */
+	//@{
+	/// provide necessary method for building a neighbor graph, which excludes point i from its neighbors and can be called concurrently
+	void extract_neighbors(Idx i, Idx k, std::vector<Idx>& N) const;
+	/// find index of closest point or -1 if tree is empty
+	Idx find_closest(const Pnt& p) const;
+	/// knn query that returns pointers to points sorted by increasing distance
+	void find_closest_points(const Pnt& p, Idx k, std::vector<const Pnt*>& knn) const;
+	//@}
+
+	/**@name extended queries */
+	//@{
+	/// find indices of k nearest neighbors of p sorted by increasing distance and optionally their squared distances
+	void find_knn(const Pnt& p, Idx k, std::vector<Idx>& knn, std::vector<Crd>* sqr_dists = 0) const;
+	/// batched knn query in parallel, where knn_indices receives k indices per query point in a flat array
+	void find_knn(const std::vector<Pnt>& queries, Idx k, std::vector<Idx>& knn_indices, unsigned nr_threads = 0) const;
+	/// find indices of all points within the given radius around p sorted by increasing distance and optionally their squared distances
+	void find_in_radius(const Pnt& p, Crd radius, std::vector<Idx>& result, std::vector<Crd>* sqr_dists = 0) const;
+	/// find indices of all points inside the given box in tree order
+	void find_in_box(const Box& box, std::vector<Idx>& result) const;
+	//@}
+};
+
+#include <cgv/config/lib_end.h>
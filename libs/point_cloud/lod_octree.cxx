@@ -0,0 +1,535 @@
+#include "lod_octree.h"
+#include <unordered_set>
+#include <algorithm>
+#include <queue>
+#include <iostream>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+#pragma warning(disable:4996)
+
+/// seek to 64 bit file offset
+static bool seek_64(FILE* fp, cgv::type::uint64_type offset)
+{
+#ifdef _MSC_VER
+	return _fseeki64(fp, __int64(offset), SEEK_SET) == 0;
+#else
+	return fseeko(fp, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+/// determine size of file without changing the file position
+static bool get_file_size(FILE* fp, cgv::type::uint64_type& size)
+{
+#ifdef _MSC_VER
+	__int64 pos = _ftelli64(fp);
+	if (pos < 0 || _fseeki64(fp, 0, SEEK_END) != 0)
+		return false;
+	__int64 end = _ftelli64(fp);
+	size = cgv::type::uint64_type(end);
+	return end >= 0 && _fseeki64(fp, pos, SEEK_SET) == 0;
+#else
+	off_t pos = ftello(fp);
+	if (pos < 0 || fseeko(fp, 0, SEEK_END) != 0)
+		return false;
+	off_t end = ftello(fp);
+	size = cgv::type::uint64_type(end);
+	return end >= 0 && fseeko(fp, pos, SEEK_SET) == 0;
+#endif
+}
+
+/// copy size bytes from src to dst and advance dst
+static void write_field(char*& dst, const void* src, size_t size)
+{
+	memcpy(dst, src, size);
+	dst += size;
+}
+
+/// copy size bytes from src to dst and advance src
+static void read_field(const char*& src, void* dst, size_t size)
+{
+	memcpy(dst, src, size);
+	src += size;
+}
+
+bool lod_octree_node::is_leaf() const
+{
+	for (int i = 0; i < 8; ++i)
+		if (children[i] != -1)
+			return false;
+	return true;
+}
+
+lod_octree_file::lod_octree_file() : has_clrs(false), has_nmls(false), nr_points(0)
+{
+}
+
+size_t lod_octree_file::get_point_size() const
+{
+	return sizeof(Pnt) + (has_clrs ? sizeof(Clr) : 0) + (has_nmls ? sizeof(Nml) : 0);
+}
+
+size_t lod_octree_file::get_header_size() const
+{
+	return 5 * sizeof(cgv::type::uint32_type) + sizeof(cgv::type::uint64_type) + nodes.size() * node_record_size;
+}
+
+bool lod_octree_file::read_header(FILE* fp)
+{
+	nodes.clear();
+	cgv::type::uint32_type header[5];
+	cgv::type::uint64_type file_size;
+	if (!get_file_size(fp, file_size) || fread(header, sizeof(cgv::type::uint32_type), 2, fp) != 2 || header[0] != magic) {
+		std::cerr << "lod_octree_file::read_header: no level of detail octree file" << std::endl;
+		return false;
+	}
+	if (header[1] != version) {
+		std::cerr << "lod_octree_file::read_header: unsupported version " << header[1] << ", convert the point cloud again" << std::endl;
+		return false;
+	}
+	if (fread(header + 2, sizeof(cgv::type::uint32_type), 3, fp) != 3 || fread(&nr_points, sizeof(nr_points), 1, fp) != 1)
+		return false;
+	if (header[4] != node_record_size) {
+		std::cerr << "lod_octree_file::read_header: node records of " << header[4] << " bytes instead of " << node_record_size << std::endl;
+		return false;
+	}
+	has_clrs = (header[2] & 1) != 0;
+	has_nmls = (header[2] & 2) != 0;
+	cgv::type::uint32_type nr_nodes = header[3];
+	if (nr_nodes == 0 || 5 * sizeof(cgv::type::uint32_type) + sizeof(cgv::type::uint64_type) + cgv::type::uint64_type(nr_nodes) * node_record_size > file_size) {
+		std::cerr << "lod_octree_file::read_header: node table does not fit into file" << std::endl;
+		return false;
+	}
+	std::vector<char> table(size_t(nr_nodes) * node_record_size);
+	if (fread(table.data(), 1, table.size(), fp) != table.size())
+		return false;
+	nodes.resize(nr_nodes);
+	const char* src = table.data();
+	cgv::type::uint64_type nr_chunk_points = 0;
+	bool valid = true;
+	for (Idx ni = 0; ni < Idx(nr_nodes); ++ni) {
+		lod_octree_node& node = nodes[ni];
+		read_field(src, &node.box.ref_min_pnt(), sizeof(Pnt));
+		read_field(src, &node.box.ref_max_pnt(), sizeof(Pnt));
+		read_field(src, &node.spacing, sizeof(Crd));
+		read_field(src, &node.nr_points, sizeof(Cnt));
+		read_field(src, node.children, sizeof(node.children));
+		read_field(src, &node.chunk_offset, sizeof(node.chunk_offset));
+		// children are stored after their parent and chunks need to lie behind the node table inside of the file
+		for (Idx ci : node.children)
+			valid = valid && (ci == -1 || (ci > ni && ci < Idx(nr_nodes)));
+		valid = valid && node.chunk_offset >= get_header_size() &&
+			node.chunk_offset + cgv::type::uint64_type(node.nr_points) * get_point_size() <= file_size;
+		nr_chunk_points += node.nr_points;
+	}
+	if (!valid || nr_chunk_points != nr_points) {
+		std::cerr << "lod_octree_file::read_header: inconsistent node table" << std::endl;
+		nodes.clear();
+		return false;
+	}
+	return true;
+}
+
+bool lod_octree_file::write_header(FILE* fp) const
+{
+	cgv::type::uint32_type header[5] = { magic, version, cgv::type::uint32_type((has_clrs ? 1 : 0) + (has_nmls ? 2 : 0)), cgv::type::uint32_type(nodes.size()), node_record_size };
+	std::vector<char> table(nodes.size() * node_record_size);
+	char* dst = table.data();
+	for (const auto& node : nodes) {
+		write_field(dst, &node.box.get_min_pnt(), sizeof(Pnt));
+		write_field(dst, &node.box.get_max_pnt(), sizeof(Pnt));
+		write_field(dst, &node.spacing, sizeof(Crd));
+		write_field(dst, &node.nr_points, sizeof(Cnt));
+		write_field(dst, node.children, sizeof(node.children));
+		write_field(dst, &node.chunk_offset, sizeof(node.chunk_offset));
+	}
+	return fwrite(header, sizeof(header), 1, fp) == 1 && fwrite(&nr_points, sizeof(nr_points), 1, fp) == 1 &&
+		(table.empty() || fwrite(table.data(), 1, table.size(), fp) == table.size());
+}
+
+lod_octree_converter::lod_octree_converter()
+{
+	pc = 0;
+	file = 0;
+	max_chunk_size = 65536;
+	grid_resolution = 128;
+	max_depth = 20;
+}
+
+void lod_octree_converter::build_node(Idx ni, size_t b, size_t e, unsigned level)
+{
+	Box box = file->nodes[ni].box;
+	std::fill(file->nodes[ni].children, file->nodes[ni].children + 8, -1);
+	Crd cell_size = box.get_extent()[0] / grid_resolution;
+	if (e - b <= max_chunk_size || level >= max_depth || !(cell_size > 0)) {
+		chunk_indices.insert(chunk_indices.end(), indices.begin() + b, indices.begin() + e);
+		file->nodes[ni].nr_points = Cnt(e - b);
+		file->nodes[ni].spacing = 0;
+		return;
+	}
+	// keep first point in each cell of the subsampling grid in this node
+	std::unordered_set<cgv::type::uint64_type> occupied_cells;
+	std::vector<Idx> rest;
+	size_t nr_selected = 0;
+	for (size_t j = b; j < e; ++j) {
+		Pnt q = (pc->pnt(indices[j]) - box.get_min_pnt()) / cell_size;
+		cgv::type::uint64_type cell[3];
+		for (int c = 0; c < 3; ++c)
+			cell[c] = cgv::type::uint64_type(std::min(std::max(q[c], Crd(0)), Crd(grid_resolution - 1)));
+		if (occupied_cells.insert((cell[2] * grid_resolution + cell[1]) * grid_resolution + cell[0]).second) {
+			chunk_indices.push_back(indices[j]);
+			++nr_selected;
+		}
+		else
+			rest.push_back(indices[j]);
+	}
+	file->nodes[ni].nr_points = Cnt(nr_selected);
+	file->nodes[ni].spacing = cell_size;
+
+	// sort remaining points into octants
+	Pnt center = box.get_center();
+	size_t octant_begin[9] = { 0 };
+	auto octant = [&](Idx i) {
+		const Pnt& p = pc->pnt(i);
+		return (p[0] >= center[0] ? 1 : 0) + (p[1] >= center[1] ? 2 : 0) + (p[2] >= center[2] ? 4 : 0);
+	};
+	for (Idx i : rest)
+		++octant_begin[octant(i) + 1];
+	for (int o = 0; o < 8; ++o)
+		octant_begin[o + 1] += octant_begin[o];
+	size_t octant_pos[8];
+	std::copy(octant_begin, octant_begin + 8, octant_pos);
+	for (Idx i : rest)
+		indices[b + octant_pos[octant(i)]++] = i;
+	rest.clear();
+	rest.shrink_to_fit();
+
+	// recursively build children
+	for (int o = 0; o < 8; ++o) {
+		if (octant_begin[o] == octant_begin[o + 1])
+			continue;
+		lod_octree_node child;
+		for (int c = 0; c < 3; ++c) {
+			child.box.ref_min_pnt()[c] = (o & (1 << c)) ? center[c] : box.get_min_pnt()[c];
+			child.box.ref_max_pnt()[c] = (o & (1 << c)) ? box.get_max_pnt()[c] : center[c];
+		}
+		Idx ci = Idx(file->nodes.size());
+		file->nodes[ni].children[o] = ci;
+		file->nodes.push_back(child);
+		build_node(ci, b + octant_begin[o], b + octant_begin[o + 1], level + 1);
+	}
+}
+
+bool lod_octree_converter::convert(const point_cloud& _pc, const std::string& file_name)
+{
+	lod_octree_file lof;
+	pc = &_pc;
+	file = &lof;
+	lof.has_clrs = pc->has_colors();
+	lof.has_nmls = pc->has_normals();
+	lof.nr_points = pc->get_nr_points();
+
+	// build octree over cubic root cell
+	indices.resize(pc->get_nr_points());
+	for (size_t i = 0; i < indices.size(); ++i)
+		indices[i] = Idx(i);
+	chunk_indices.clear();
+	chunk_indices.reserve(indices.size());
+	Box box;
+	for (Idx i : indices)
+		box.add_point(pc->pnt(i));
+	// use a unit cube around coincident points to avoid a root cell of zero size
+	Crd half_size = Crd(0.5001) * box.get_extent()[box.get_max_extent_coord_index()];
+	if (!(half_size > 0))
+		half_size = Crd(0.5);
+	lod_octree_node root;
+	root.box = Box(box.get_center() - Pnt(half_size), box.get_center() + Pnt(half_size));
+	lof.nodes.push_back(root);
+	if (!indices.empty())
+		build_node(0, 0, indices.size(), 0);
+	else {
+		lof.nodes[0].nr_points = 0;
+		lof.nodes[0].spacing = 0;
+		std::fill(lof.nodes[0].children, lof.nodes[0].children + 8, -1);
+	}
+	indices.clear();
+	indices.shrink_to_fit();
+
+	// chunks are stored in node order, which is the order of chunk_indices
+	cgv::type::uint64_type offset = lof.get_header_size();
+	for (auto& node : lof.nodes) {
+		node.chunk_offset = offset;
+		offset += node.nr_points * lof.get_point_size();
+	}
+	FILE* fp = fopen(file_name.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool success = lof.write_header(fp);
+	size_t j = 0;
+	std::vector<char> buffer;
+	for (const auto& node : lof.nodes) {
+		if (!success)
+			break;
+		buffer.resize(node.nr_points * lof.get_point_size());
+		char* ptr = buffer.data();
+		for (Cnt l = 0; l < node.nr_points; ++l, ptr += sizeof(Pnt))
+			memcpy(ptr, &pc->pnt(chunk_indices[j + l]), sizeof(Pnt));
+		if (lof.has_clrs)
+			for (Cnt l = 0; l < node.nr_points; ++l, ptr += sizeof(Clr))
+				memcpy(ptr, &pc->clr(chunk_indices[j + l]), sizeof(Clr));
+		if (lof.has_nmls)
+			for (Cnt l = 0; l < node.nr_points; ++l, ptr += sizeof(Nml))
+				memcpy(ptr, &pc->nml(chunk_indices[j + l]), sizeof(Nml));
+		j += node.nr_points;
+		success = buffer.empty() || fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+	}
+	chunk_indices.clear();
+	chunk_indices.shrink_to_fit();
+	pc = 0;
+	file = 0;
+	return fclose(fp) == 0 && success;
+}
+
+bool lod_octree_converter::convert(const std::string& input_file_name, const std::string& output_file_name)
+{
+	point_cloud input;
+	if (!input.read(input_file_name))
+		return false;
+	return convert(input, output_file_name);
+}
+
+lod_octree_streamer::lod_octree_streamer()
+{
+	nr_resident_points = 0;
+	frame_index = 0;
+	loading_node = -1;
+	stop_loader = false;
+	point_budget = 20000000;
+	max_screen_space_error = 1.5f;
+}
+
+lod_octree_streamer::~lod_octree_streamer()
+{
+	close();
+}
+
+bool lod_octree_streamer::open(const std::string& _file_name)
+{
+	close();
+	FILE* fp = fopen(_file_name.c_str(), "rb");
+	if (!fp)
+		return false;
+	bool success = file.read_header(fp);
+	fclose(fp);
+	if (!success || file.nodes.empty()) {
+		file.nodes.clear();
+		return false;
+	}
+	file_name = _file_name;
+	stop_loader = false;
+	loader = std::thread(&lod_octree_streamer::load_chunks, this);
+	return true;
+}
+
+void lod_octree_streamer::close()
+{
+	if (loader.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(loader_mutex);
+			stop_loader = true;
+		}
+		loader_condition.notify_all();
+		loader.join();
+	}
+	requests.clear();
+	for (auto& l : loaded)
+		delete l.second;
+	loaded.clear();
+	for (auto& r : resident)
+		delete r.second;
+	resident.clear();
+	selected_nodes.clear();
+	nr_resident_points = 0;
+	file.nodes.clear();
+	file_name.clear();
+}
+
+const lod_octree_streamer::Box& lod_octree_streamer::get_box() const
+{
+	return file.nodes.front().box;
+}
+
+const lod_octree_streamer::chunk* lod_octree_streamer::get_chunk(Idx ni) const
+{
+	auto iter = resident.find(ni);
+	return iter == resident.end() ? 0 : iter->second;
+}
+
+void lod_octree_streamer::load_chunks()
+{
+	FILE* fp = fopen(file_name.c_str(), "rb");
+	if (!fp) {
+		std::cerr << "lod_octree_streamer: could not open " << file_name << std::endl;
+		return;
+	}
+	std::vector<char> buffer;
+	while (true) {
+		Idx ni;
+		{
+			std::unique_lock<std::mutex> lock(loader_mutex);
+			loader_condition.wait(lock, [this]() { return stop_loader || !requests.empty(); });
+			if (stop_loader)
+				break;
+			ni = requests.front();
+			requests.erase(requests.begin());
+			loading_node = ni;
+		}
+		const lod_octree_node& node = file.nodes[ni];
+		chunk* c = new chunk;
+		c->last_used_frame = 0;
+		buffer.resize(node.nr_points * file.get_point_size());
+		bool success =
+			seek_64(fp, node.chunk_offset) &&
+			fread(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+		if (!success)
+			std::cerr << "lod_octree_streamer: could not read chunk " << ni << std::endl;
+		else {
+			const char* ptr = buffer.data();
+			const Pnt* P = reinterpret_cast<const Pnt*>(ptr);
+			c->P.assign(P, P + node.nr_points);
+			ptr += node.nr_points * sizeof(Pnt);
+			if (file.has_clrs) {
+				const Clr* C = reinterpret_cast<const Clr*>(ptr);
+				c->C.assign(C, C + node.nr_points);
+				ptr += node.nr_points * sizeof(Clr);
+			}
+			if (file.has_nmls) {
+				const Nml* N = reinterpret_cast<const Nml*>(ptr);
+				c->N.assign(N, N + node.nr_points);
+			}
+		}
+		std::lock_guard<std::mutex> lock(loader_mutex);
+		loaded.push_back(std::make_pair(ni, c));
+		loading_node = -1;
+	}
+	fclose(fp);
+}
+
+void lod_octree_streamer::evict(size_t nr_required_points)
+{
+	if (nr_resident_points + nr_required_points <= point_budget)
+		return;
+	std::vector<std::pair<unsigned, Idx> > candidates;
+	for (const auto& r : resident)
+		if (r.second->last_used_frame != frame_index)
+			candidates.push_back(std::make_pair(r.second->last_used_frame, r.first));
+	std::sort(candidates.begin(), candidates.end());
+	for (const auto& c : candidates) {
+		if (nr_resident_points + nr_required_points <= point_budget)
+			break;
+		auto iter = resident.find(c.second);
+		nr_resident_points -= iter->second->P.size();
+		delete iter->second;
+		resident.erase(iter);
+	}
+}
+
+bool lod_octree_streamer::update(const HMat& mvp, const Pnt& eye, Crd pixel_scale)
+{
+	if (!is_open())
+		return false;
+	++frame_index;
+	std::vector<std::pair<Idx, chunk*> > new_chunks;
+	{
+		std::lock_guard<std::mutex> lock(loader_mutex);
+		new_chunks.swap(loaded);
+	}
+	for (auto& nc : new_chunks) {
+		if (resident.find(nc.first) != resident.end()) {
+			delete nc.second;
+			continue;
+		}
+		resident[nc.first] = nc.second;
+		nr_resident_points += nc.second->P.size();
+	}
+	// extract frustum planes in model coordinates
+	HVec planes[6];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			planes[2 * i][j] = mvp(3, j) + mvp(i, j);
+			planes[2 * i + 1][j] = mvp(3, j) - mvp(i, j);
+		}
+	}
+	auto is_visible = [&planes](const Box& box) {
+		for (const auto& pl : planes) {
+			// test box corner that is furthest in direction of plane normal
+			Crd d = pl[3];
+			for (int c = 0; c < 3; ++c)
+				d += pl[c] * (pl[c] > 0 ? box.get_max_pnt()[c] : box.get_min_pnt()[c]);
+			if (d < 0)
+				return false;
+		}
+		return true;
+	};
+	auto distance = [&eye](const Box& box) {
+		Crd d2 = 0;
+		for (int c = 0; c < 3; ++c) {
+			Crd d = std::max(std::max(box.get_min_pnt()[c] - eye[c], eye[c] - box.get_max_pnt()[c]), Crd(0));
+			d2 += d * d;
+		}
+		return std::max(sqrt(d2), std::numeric_limits<Crd>::epsilon());
+	};
+	// select nodes in order of decreasing projected size until point budget is exhausted
+	selected_nodes.clear();
+	std::priority_queue<std::pair<Crd, Idx> > queue;
+	if (is_visible(file.nodes[0].box))
+		queue.push(std::make_pair(std::numeric_limits<Crd>::max(), 0));
+	size_t nr_selected_points = 0;
+	while (!queue.empty()) {
+		Idx ni = queue.top().second;
+		queue.pop();
+		const lod_octree_node& node = file.nodes[ni];
+		if (nr_selected_points + node.nr_points > point_budget)
+			break;
+		selected_nodes.push_back(ni);
+		nr_selected_points += node.nr_points;
+		Crd dist = distance(node.box);
+		if (node.spacing * pixel_scale / dist <= max_screen_space_error)
+			continue;
+		for (int o = 0; o < 8; ++o) {
+			Idx ci = node.children[o];
+			if (ci != -1 && is_visible(file.nodes[ci].box))
+				queue.push(std::make_pair(file.nodes[ci].box.get_extent()[0] * pixel_scale / distance(file.nodes[ci].box), ci));
+		}
+	}
+	// mark used chunks and collect missing chunks in order of priority
+	std::vector<Idx> missing;
+	size_t nr_missing_points = 0;
+	for (Idx ni : selected_nodes) {
+		auto iter = resident.find(ni);
+		if (iter != resident.end())
+			iter->second->last_used_frame = frame_index;
+		else {
+			missing.push_back(ni);
+			nr_missing_points += file.nodes[ni].nr_points;
+		}
+	}
+	evict(nr_missing_points);
+	std::lock_guard<std::mutex> lock(loader_mutex);
+	requests.clear();
+	for (Idx ni : missing) {
+		if (ni == loading_node)
+			continue;
+		bool is_loaded = false;
+		for (const auto& l : loaded)
+			if (l.first == ni) {
+				is_loaded = true;
+				break;
+			}
+		if (!is_loaded)
+			requests.push_back(ni);
+	}
+	loader_condition.notify_one();
+	return !missing.empty();
+}
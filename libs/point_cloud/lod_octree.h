@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include "point_cloud.h"
+
+#include "lib_begin.h"
+
+/** node of a level of detail octree. Each point of the cloud is stored in exactly one node. Inner nodes store a
+    subsample of their points with a minimum spacing, such that rendering a node together with its ancestors
+	reproduces all points in the node box up to the spacing of the node. */
+struct lod_octree_node : public point_cloud_types
+{
+	/// bounding box of node cell
+	Box box;
+	/// minimum distance of points in node, which is zero for leaves that store all their points
+	Crd spacing;
+	/// number of points stored in node chunk
+	Cnt nr_points;
+	/// indices of child nodes or -1 for empty octants
+	Idx children[8];
+	/// byte offset of node chunk in file
+	cgv::type::uint64_type chunk_offset;
+	/// check whether node is a leaf
+	bool is_leaf() const;
+};
+
+/** out-of-core point cloud file with spatially sorted level of detail chunks. The file starts with a header, followed
+    by the node table and the chunks. The header consists of the magic number, the version, flags, the number of nodes,
+	the size of a node record and the total number of points. Node records store the fields of lod_octree_node one
+	after the other without padding. Each chunk contains the positions, colors and normals of one node in consecutive
+	blocks. Use lod_octree_converter to create files and lod_octree_streamer to load chunks during rendering. */
+struct CGV_API lod_octree_file : public point_cloud_types
+{
+	/// magic number identifying file type
+	static const cgv::type::uint32_type magic = 0x54434f50;
+	/// current file version, where version 1 stored the node table in the memory layout of lod_octree_node
+	static const cgv::type::uint32_type version = 2;
+	/// size of a node record in the node table in bytes
+	static const cgv::type::uint32_type node_record_size = 7 * sizeof(Crd) + sizeof(Cnt) + 8 * sizeof(Idx) + sizeof(cgv::type::uint64_type);
+	/// whether chunks contain colors
+	bool has_clrs;
+	/// whether chunks contain normals
+	bool has_nmls;
+	/// total number of points
+	cgv::type::uint64_type nr_points;
+	/// nodes, where the root is the first node
+	std::vector<lod_octree_node> nodes;
+	/// construct empty file description
+	lod_octree_file();
+	/// return size of one point in a chunk in bytes
+	size_t get_point_size() const;
+	/// read header and node table and validate them against the size of the file, return whether this succeeded
+	bool read_header(FILE* fp);
+	/// write header and node table, return whether this succeeded
+	bool write_header(FILE* fp) const;
+	/// return size of header and node table in bytes
+	size_t get_header_size() const;
+};
+
+/** converts point clouds into level of detail octree files. The conversion is done in memory, such that very large
+    inputs should be provided in the memory mapped bin format that is handled by point_cloud::read_mapped_bin. */
+class CGV_API lod_octree_converter : public point_cloud_types
+{
+protected:
+	const point_cloud* pc;
+	lod_octree_file* file;
+	std::vector<Idx> indices;
+	std::vector<Idx> chunk_indices;
+	/// recursively construct node ni for the points in indices[b,e)
+	void build_node(Idx ni, size_t b, size_t e, unsigned level);
+public:
+	/// maximum number of points per chunk
+	Cnt max_chunk_size;
+	/// resolution of the subsampling grid in inner nodes
+	Cnt grid_resolution;
+	/// maximum octree depth beyond which all points are stored in leaves
+	unsigned max_depth;
+	/// construct with default parameters
+	lod_octree_converter();
+	/// convert point cloud and write result to given file
+	bool convert(const point_cloud& pc, const std::string& file_name);
+	/// read point cloud from input file with point_cloud::read, convert it and write result to output file
+	bool convert(const std::string& input_file_name, const std::string& output_file_name);
+};
+
+/** streams the chunks of a level of detail octree file from a background loader thread. For each frame, update
+    selects the nodes within the view frustum whose parents exceed the screen space error threshold, in the order
+	of decreasing screen space error until the point budget is exhausted. Missing chunks are requested from the
+	loader thread and least recently used chunks are evicted, such that the number of resident points stays bounded. */
+class CGV_API lod_octree_streamer : public point_cloud_types
+{
+public:
+	/// point data of a loaded node
+	struct chunk
+	{
+		std::vector<Pnt> P;
+		std::vector<Clr> C;
+		std::vector<Nml> N;
+		/// frame in which chunk has been used last
+		unsigned last_used_frame;
+	};
+protected:
+	std::string file_name;
+	lod_octree_file file;
+	/// resident chunks accessed only from the rendering thread
+	std::unordered_map<Idx, chunk*> resident;
+	/// number of resident points
+	size_t nr_resident_points;
+	/// nodes selected in last update
+	std::vector<Idx> selected_nodes;
+	/// frame counter
+	unsigned frame_index;
+
+	/**@name communication with loader thread*/
+	//@{
+	std::thread loader;
+	std::mutex loader_mutex;
+	std::condition_variable loader_condition;
+	/// load requests in order of decreasing priority
+	std::vector<Idx> requests;
+	/// node that is currently loaded
+	Idx loading_node;
+	/// chunks that have been loaded and not yet been collected by update
+	std::vector<std::pair<Idx, chunk*> > loaded;
+	/// set to stop loader thread
+	bool stop_loader;
+	/// thread function of loader
+	void load_chunks();
+	//@}
+	/// evict least recently used chunks that are not selected until the given number of points fits the budget
+	void evict(size_t nr_required_points);
+public:
+	/// maximum number of points that are kept in memory
+	size_t point_budget;
+	/// screen space error threshold in pixels above which nodes are refined
+	Crd max_screen_space_error;
+	/// construct streamer
+	lod_octree_streamer();
+	/// stop loader thread and free memory
+	~lod_octree_streamer();
+	/// open file and start loader thread
+	bool open(const std::string& file_name);
+	/// stop loader thread and free all chunks
+	void close();
+	/// check whether a file is open
+	bool is_open() const { return !file.nodes.empty(); }
+	/// return file description
+	const lod_octree_file& get_file() const { return file; }
+	/// return bounding box of all points
+	const Box& get_box() const;
+	/** select nodes for given modelview projection matrix, eye position in model coordinates and the scale that maps
+	    a length at unit distance to pixels, i.e. half the viewport height times the (1,1) entry of the projection matrix.
+		Returns whether not all selected chunks are resident such that further updates are needed. */
+	bool update(const HMat& modelview_projection, const Pnt& eye, Crd pixel_scale);
+	/// return nodes selected in last update
+	const std::vector<Idx>& get_selected_nodes() const { return selected_nodes; }
+	/// return chunk of node or 0 if it is not resident
+	const chunk* get_chunk(Idx ni) const;
+	/// return number of resident points
+	size_t get_nr_resident_points() const { return nr_resident_points; }
+};
+
+#include <cgv/config/lib_end.h>
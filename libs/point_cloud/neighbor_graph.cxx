@@ -1,6 +1,7 @@
 #include "neighbor_graph.h"
 #include <cgv/utils/progression.h>
 #include <algorithm>
+#include <iostream>
 
 using namespace std;
 
@@ -94,3 +95,31 @@ void neighbor_graph::symmetrize()
 		}
 	}
 }
+
+csr_neighbor_graph::csr_neighbor_graph() {}
+
+void csr_neighbor_graph::clear()
+{
+	row_offsets.clear();
+	neighbors.clear();
+}
+
+void csr_neighbor_graph::build(const neighbor_graph& ng)
+{
+	row_offsets.resize(ng.size() + 1);
+	row_offsets[0] = 0;
+	for (size_t i = 0; i < ng.size(); ++i)
+		row_offsets[i + 1] = row_offsets[i] + ng[i].size();
+	neighbors.resize(row_offsets.back());
+	for (size_t i = 0; i < ng.size(); ++i)
+		std::copy(ng[i].begin(), ng[i].end(), neighbors.begin() + row_offsets[i]);
+}
+
+void csr_neighbor_graph::extract(neighbor_graph& ng) const
+{
+	ng.clear();
+	ng.resize(get_nr_vertices());
+	for (Idx i = 0; i < (Idx)get_nr_vertices(); ++i)
+		ng[i].assign(begin(i), end(i));
+	ng.nr_half_edges = Cnt(get_nr_half_edges());
+}
@@ -2,7 +2,12 @@
 
 #include <vector>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
 #include <cgv/utils/statistics.h>
+#include <cgv/os/thread_pool.h>
 #include <cgv/type/standard_types.h>
 
 #include "lib_begin.h"
@@ -27,6 +32,49 @@ struct graph_location
 	}
 };
 
+/// callback used to report progress of neighbor graph construction with the number of processed points and the total number of points
+typedef std::function<void(graph_location::Cnt, graph_location::Cnt)> neighbor_graph_progress_callback;
+
+/// return number of threads to be used for nr_threads = 0, which is the concurrency of the shared thread pool, or the given number otherwise
+inline unsigned neighbor_graph_nr_threads(unsigned nr_threads)
+{
+	if (nr_threads == 0)
+		nr_threads = cgv::os::get_thread_pool().get_concurrency();
+	return nr_threads;
+}
+
+/** process points [0,n) in blocks of fixed size with the given number of tasks in the shared thread pool by calling
+    f(i, S) with a task local scratch object S, which defaults to a neighbor vector. Progress is reported from the
+	calling thread only. */
+template <typename S = std::vector<graph_location::Idx>, typename F>
+void neighbor_graph_for_each_point(graph_location::Cnt n, unsigned nr_threads, const neighbor_graph_progress_callback& progress, F f)
+{
+	typedef graph_location::Cnt Cnt;
+	typedef graph_location::Idx Idx;
+	const Cnt block_size = 4096;
+	std::atomic<Cnt> next_block(0), nr_done(0);
+	std::thread::id caller_id = std::this_thread::get_id();
+	auto worker = [&]() {
+		bool report = std::this_thread::get_id() == caller_id;
+		S N;
+		while (true) {
+			size_t begin = size_t(block_size) * next_block.fetch_add(1);
+			if (begin >= n)
+				break;
+			Cnt end = Cnt(std::min(size_t(n), begin + block_size));
+			for (Cnt i = Cnt(begin); i < end; ++i)
+				f(Idx(i), N);
+			Cnt done = nr_done.fetch_add(end - Cnt(begin)) + end - Cnt(begin);
+			if (report && progress)
+				progress(done, n);
+		}
+	};
+	nr_threads = std::min(neighbor_graph_nr_threads(nr_threads), unsigned(n / block_size + 1));
+	cgv::os::get_thread_pool().parallel_for(0, nr_threads, [&](size_t) { worker(); }, 1);
+	if (progress)
+		progress(n, n);
+}
+
 /** Data structure used to store a knn-neighbor graph. */
 struct CGV_API neighbor_graph : public std::vector<std::vector<graph_location::Idx> >
 {
@@ -67,26 +115,79 @@ struct CGV_API neighbor_graph : public std::vector<std::vector<graph_location::I
 
 	/**@name construction */
 	//@{
-	/// build a knn neighbor graph for n points from a data structure that provides the method extract_neighbors(i, k, vector<Idx>&).
+	/** build a knn neighbor graph for n points from a data structure that provides the method extract_neighbors(i, k, vector<Idx>&),
+	    which needs to be callable concurrently from several threads. The point range is split into blocks that are processed 
+		by nr_threads tasks in the shared thread pool (0 ... use concurrency of the pool). The result does not depend on the number of threads. */
 	template <typename knn_info>
-	void build(Cnt n, Cnt k, const knn_info& knn, cgv::utils::statistics* he_stats = 0) {
+	void build(Cnt n, Cnt k, const knn_info& knn, cgv::utils::statistics* he_stats = 0, 
+		const neighbor_graph_progress_callback& progress = neighbor_graph_progress_callback(), unsigned nr_threads = 1) {
 		if (he_stats)
 			he_stats->init();
 		clear();
 		resize(n);
-		nr_half_edges = 0;
-		for (Idx i = 0; i < (Idx)n; ++i) {
-			if (i % 10000 == 0)
-				std::cout << "build ng " << i << " nr half edges = " << nr_half_edges << std::endl;
+		neighbor_graph_for_each_point(n, nr_threads, progress, [&](Idx i, std::vector<Idx>&) {
 			knn.extract_neighbors(i, k, at(i));
-			if (he_stats)
+		});
+		if (he_stats) {
+			for (Cnt i = 0; i < n; ++i)
 				he_stats->update(k);
-			nr_half_edges += k;
 		}
+		nr_half_edges = n * k;
 	}
 	/// ensure the neighbor graph to be symmetric
 	void symmetrize();
 	//@}
 };
 
+/** Compressed row storage of a knn-neighbor graph, where the neighbors of all points are stored consecutively in one 
+    flat array and point i has neighbors neighbors[row_offsets[i]] ... neighbors[row_offsets[i+1]-1]. */
+struct CGV_API csr_neighbor_graph
+{
+	/// index type
+	typedef graph_location::Idx Idx;
+	/// count type
+	typedef graph_location::Cnt Cnt;
+	/// offsets of the rows into the neighbors array with one additional entry at the end
+	std::vector<size_t> row_offsets;
+	/// flat array of neighbor indices
+	std::vector<Idx> neighbors;
+	/// construct empty graph
+	csr_neighbor_graph();
+	/// remove all vertices and neighbors
+	void clear();
+	/// return number of vertices
+	Cnt get_nr_vertices() const { return row_offsets.empty() ? 0 : Cnt(row_offsets.size() - 1); }
+	/// return number of directed edges
+	size_t get_nr_half_edges() const { return neighbors.size(); }
+	/// return number of neighbors of vertex vi
+	Cnt get_degree(Idx vi) const { return Cnt(row_offsets[vi + 1] - row_offsets[vi]); }
+	/// return pointer to first neighbor of vertex vi
+	const Idx* begin(Idx vi) const { return &neighbors[0] + row_offsets[vi]; }
+	/// return pointer after last neighbor of vertex vi
+	const Idx* end(Idx vi) const { return &neighbors[0] + row_offsets[vi + 1]; }
+	/// build from the given neighbor graph
+	void build(const neighbor_graph& ng);
+	/// copy to a neighbor graph in vector of vector form
+	void extract(neighbor_graph& ng) const;
+	/** build a knn neighbor graph with k neighbors per point in parallel from a data structure that provides the method 
+	    extract_neighbors(i, k, vector<Idx>&). Each row is written to its preallocated location in the flat neighbor array
+		such that the result does not depend on the number of threads. Rows of points with less than k neighbors, which
+		happens if there are not more than k points, are padded with the index of the point itself. */
+	template <typename knn_info>
+	void build(Cnt n, Cnt k, const knn_info& knn, 
+		const neighbor_graph_progress_callback& progress = neighbor_graph_progress_callback(), unsigned nr_threads = 1) {
+		row_offsets.resize(size_t(n) + 1);
+		for (size_t i = 0; i <= n; ++i)
+			row_offsets[i] = i * k;
+		neighbors.resize(size_t(n) * k);
+		neighbor_graph_for_each_point(n, nr_threads, progress, [&](Idx i, std::vector<Idx>& N) {
+			knn.extract_neighbors(i, k, N);
+			auto row = neighbors.begin() + row_offsets[i];
+			size_t m = std::min(N.size(), size_t(k));
+			std::copy(N.begin(), N.begin() + m, row);
+			std::fill(row + m, row + k, i);
+		});
+	}
+};
+
 #include <cgv/config/lib_end.h>
@@ -1,4 +1,5 @@
 #include "normal_estimator.h"
+#include "normal_orientation.h"
 #include <cgv/math/normal_estimation.h>
 #include <cmath>
 #include <cgv/math/functions.h>
@@ -14,6 +15,18 @@ normal_estimator::normal_estimator(point_cloud& _pc, neighbor_graph& _ng) : pc(_
 
 	noise_to_sampling_ratio = 0.1f;
 	use_orientation = true;
+	bw_type = BWT_GAUSS_ON_NORMALS;
+	nr_threads = 0;
+}
+
+void normal_estimator::prepare_normal_buffer()
+{
+	normal_buffer.resize(pc.get_nr_points());
+}
+
+void normal_estimator::swap_normal_buffer()
+{
+	pc.N.swap(normal_buffer);
 }
 
 /// compute geometric quality of a triangle
@@ -53,18 +66,8 @@ void normal_estimator::smooth_normals()
 	if (!pc.has_normals())
 		compute_weighted_normals(false);
 
-	std::vector<Crd> weights;
-	std::vector<Pnt> points;
-
-	// copy current normals
-	std::vector<Nml> NS;
-	NS.resize(pc.get_nr_points());
-	Idx i, n = (Idx) pc.get_nr_points();
-	for (i = 0; i < n; ++i)
-		NS[i] = pc.nml(i);
-
-	for (Idx vi = 0; vi < (Idx)pc.get_nr_points(); ++vi) {
-		const Pnt& pi = pc.pnt(vi);
+	prepare_normal_buffer();
+	neighbor_graph_for_each_point<scratch>((Cnt)pc.get_nr_points(), nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, scratch&) {
 		const Nml& nml_i = pc.nml(vi);
 		const std::vector<Idx> &Ni = ng.at(vi);
 		unsigned ni = (unsigned) Ni.size();
@@ -95,15 +98,14 @@ void normal_estimator::smooth_normals()
 			weight_sum += w;
 		}
 		center = (1.0f/weight_sum)*center;
-		NS[vi] = normalize(pc.nml(vi) + 0.4f*normalize(
+		normal_buffer[vi] = normalize(pc.nml(vi) + 0.4f*normalize(
 			     nml_avg
 //		   +0.5f*ortho
 //			-3*(dot(N[vi], center - P[vi])/sqrt(l0_sqr))*repulse
 			-repulse
 			));
-	}
-	for (i = 0; i < n; ++i)
-		pc.nml(i) = NS[i];
+	});
+	swap_normal_buffer();
 }
 
 /// recompute normals from neighbor graph and distance and normal weights
@@ -138,16 +140,15 @@ void normal_estimator::compute_weighted_normals(bool reorient)
 		pc.create_normals();
 		reorient = false;
 	}
-	std::vector<Crd> weights;
-	std::vector<Pnt> points;
-	for (Idx vi = 0; vi < (Idx)pc.get_nr_points(); ++vi) {
-		compute_weights(vi, weights, &points);
+	// weights do not depend on normals such that each normal can be overwritten in place
+	neighbor_graph_for_each_point<scratch>((Cnt)pc.get_nr_points(), nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, scratch& S) {
+		compute_weights(vi, S.weights, &S.points);
 		Nml new_nml;
-		cgv::math::estimate_normal_wls((unsigned)points.size(), points[0], &weights[0], new_nml);
+		cgv::math::estimate_normal_wls((unsigned)S.points.size(), S.points[0], &S.weights[0], new_nml);
 		if (reorient && (dot(new_nml,pc.nml(vi)) < 0))
 			new_nml = -new_nml;
 		pc.nml(vi) = new_nml;
-	}
+	});
 }
 
 /// recompute normals from neighbor graph and distance and normal weights
@@ -185,26 +186,15 @@ void normal_estimator::compute_bilateral_weighted_normals(bool reorient)
 	if (!pc.has_normals())
 		compute_weighted_normals(reorient);
 
-	std::vector<Crd> weights;
-	std::vector<Pnt> points;
-
-	// copy current normals
-	std::vector<Nml> NS;
-	NS.resize(pc.get_nr_points());
-	Idx i, n = (Idx) pc.get_nr_points();
-	for (i = 0; i < n; ++i)
-		NS[i] = pc.nml(i);
-
-	for (Idx vi = 0; vi < (Idx)pc.get_nr_points(); ++vi) {
-
-		compute_bilateral_weights(vi, weights, &points);
-
-		cgv::math::estimate_normal_wls((unsigned)points.size(), points[0], &weights[0], NS[vi]);
-		if (reorient && (dot(NS[vi],pc.nml(vi)) < 0))
-			NS[vi] = -NS[vi];
-	}
-	for (i = 0; i < n; ++i)
-		pc.nml(i) = NS[i];
+	prepare_normal_buffer();
+	neighbor_graph_for_each_point<scratch>((Cnt)pc.get_nr_points(), nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, scratch& S) {
+		compute_bilateral_weights(vi, S.weights, &S.points);
+		Nml& new_nml = normal_buffer[vi];
+		cgv::math::estimate_normal_wls((unsigned)S.points.size(), S.points[0], &S.weights[0], new_nml);
+		if (reorient && (dot(new_nml,pc.nml(vi)) < 0))
+			new_nml = -new_nml;
+	});
+	swap_normal_buffer();
 }
 
 /// recompute normals from neighbor graph and distance and normal weights
@@ -213,19 +203,11 @@ void normal_estimator::compute_plane_bilateral_weighted_normals(bool reorient)
 	if (!pc.has_normals())
 		compute_weighted_normals(reorient);
 
-	std::vector<Crd> weights;
-	std::vector<Pnt> points;
-
-	// copy current normals
-	std::vector<Nml> NS;
-	NS.resize(pc.get_nr_points());
-	Idx i, n = (Idx) pc.get_nr_points();
-	for (i = 0; i < n; ++i)
-		NS[i] = pc.nml(i);
-
-	for (Idx vi = 0; vi < (Idx)pc.get_nr_points(); ++vi) {
+	prepare_normal_buffer();
+	neighbor_graph_for_each_point<scratch>((Cnt)pc.get_nr_points(), nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, scratch& S) {
+		std::vector<Crd>& weights = S.weights;
+		std::vector<Pnt>& points = S.points;
 		const Pnt& pi = pc.pnt(vi);
-		const Nml& nml_i = pc.nml(vi);
 		const std::vector<Idx> &Ni = ng.at(vi);
 		unsigned ni = (unsigned) Ni.size();
 		weights.resize(ni+1);
@@ -246,51 +228,14 @@ void normal_estimator::compute_plane_bilateral_weighted_normals(bool reorient)
 			weights[j+1] = w;
 			points[j+1] = pc.pnt(vj);
 		}
-		cgv::math::estimate_normal_wls((unsigned)points.size(), points[0], &weights[0], NS[vi]);
-		if (reorient && (dot(NS[vi],pc.nml(vi)) < 0))
-			NS[vi] = -NS[vi];
-	}
-	for (i = 0; i < n; ++i)
-		pc.nml(i) = NS[i];
+		Nml& new_nml = normal_buffer[vi];
+		cgv::math::estimate_normal_wls((unsigned)points.size(), points[0], &weights[0], new_nml);
+		if (reorient && (dot(new_nml,pc.nml(vi)) < 0))
+			new_nml = -new_nml;
+	});
+	swap_normal_buffer();
 }
 
-#include <cgv/math/union_find.h>
-#include <limits>
-
-struct neighbor_info 
-{
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	neighbor_info(unsigned _vj = 0, bool _flip = false) : vj(_vj), flip(_flip) {}
-};
-
-struct edge_info 
-{
-	unsigned vi;
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	edge_info(unsigned _vi, unsigned _vj, bool _flip) : vi(_vi), vj(_vj), flip(_flip) {}
-};
-
-struct weighted_edge_info 
-{
-	unsigned vi;
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	float w;
-	weighted_edge_info(unsigned _vi, unsigned _vj, float signed_w) : vi(_vi), vj(_vj), w(fabs(signed_w)), flip(signed_w < 0) {}
-	bool operator < (const weighted_edge_info& ei) const 
-	{
-		return w < ei.w;
-	}
-};
-
 /// orient normals towards given point
 void normal_estimator::orient_normals(const Pnt& view_point)
 {
@@ -304,86 +249,15 @@ void normal_estimator::orient_normals(const Pnt& view_point)
 }
 
 
-/// recompute normals from neighbor graph and distance and normal weights
+/// compute consistent normal orientation along a maximum spanning forest of the neighbor graph
 void normal_estimator::orient_normals()
 {
 	if (!pc.has_normals())
 		compute_weighted_normals(false);
 	std::cout << "orienting normals\n=================" << std::endl;
-
-	// compute weighted edges and initial point with smallest x-component
-	std::cout << "computing weighted edges" << std::endl;
-	std::vector<weighted_edge_info> E;
-	Crd min_x = std::numeric_limits<Crd>::max();
-	Idx vi, v0 = 0;
-	for (vi = 0; vi < (Idx)pc.get_nr_points(); ++vi) {
-		const Pnt& pi = pc.pnt(vi);
-		if (pi[0] < min_x) {
-			min_x = pi(0);
-			v0 = vi;
-		}
-		const Nml& nml_i = pc.nml(vi);
-		const std::vector<Idx> &Ni = ng.at(vi);
-		unsigned ni = (unsigned) Ni.size();
-		for (unsigned j=0; j < ni; ++j) {
-			Idx vj = Ni[j];
-			const Pnt& pj = pc.pnt(vj);
-			const Nml& nml_j = pc.nml(vj);
-			Dir d = normalize(pj-pi);
-			Dir nml_ip = nml_i - 2*dot(nml_i,d)*d;
-			E.push_back(weighted_edge_info(vi,vj,dot(nml_ip, nml_j)));
-		}
-	}
-
-	std::cout << "construct MST" << std::endl;
-	// compute MST as simple neighborgraph
-	cgv::math::union_find uf(pc.get_nr_points());
-	std::sort(E.begin(), E.end());
-	std::vector<std::vector<neighbor_info> > MST(pc.get_nr_points());
-	for (vi = 1; vi < (Idx)pc.get_nr_points(); ) {
-		if (E.empty()) {
-			std::cerr << "warning: impossible to build MST over neighbor graph " << pc.get_nr_points()-vi <<  " unreachable vertices" << std::endl;
-			break;
-		}
-		const weighted_edge_info& wei = E.back();
-		if (uf.find(wei.vi) != uf.find(wei.vj)) {
-			uf.unite(wei.vi,wei.vj);
-			MST[wei.vi].push_back(neighbor_info(wei.vj, wei.flip));
-			MST[wei.vj].push_back(neighbor_info(wei.vi, wei.flip));
-			++vi;
-		}
-		E.pop_back();
-	}
-	E.clear();
-
-	/*
-	for (vi = 0; vi < n; ++vi) {
-		(*ng)[vi].clear();
-		for (unsigned i=0;i<MST[vi].size(); ++i)
-			(*ng)[vi].push_back(MST[vi][i].vj);
-	}*/
-
-	std::cout << "flipping edges starting at v0=" << v0 << std::endl;
-	unsigned nr = 0;
-	// flip starting with v0
-	std::vector<edge_info> Q;
-	Q.push_back(edge_info(v0,-1,pc.nml(v0)(0)>0));
-	if (pc.nml(v0)(0)>0)
-		pc.nml(v0) = -pc.nml(v0);
-	while (!Q.empty()) {
-		edge_info ei = Q.back();
-		Q.pop_back();
-		const std::vector<neighbor_info>& ni = MST[ei.vi];
-		for (unsigned i=0; i<ni.size(); ++i) {
-			unsigned vj = ni[i].vj;
-			if (vj == ei.vj)
-				continue;
-			if (ni[i].flip != ei.flip) {
-				pc.nml(vj) = -pc.nml(vj);
-				++nr;
-			}
-			Q.push_back(edge_info(vj,ei.vi,ei.flip ^ ni[i].flip));
-		}
-	}
-	std::cout << "flipped " << nr << " edges" << std::endl;
+	csr_neighbor_graph g;
+	g.build(ng);
+	normal_orientation no(nr_threads);
+	no.orient(pc, g);
+	std::cout << "flipped " << no.get_nr_flipped() << " normals in " << no.get_nr_components() << " components" << std::endl;
 }
@@ -11,13 +11,30 @@ enum BilateralWeightType {
 };
 
 /** the normal estimator class needs a reference to a point_cloud and a neighbor_graph and allows to
-    compute [[bilaterally] weighted] least squares normals and to consistently orient the normals */
+    compute [[bilaterally] weighted] least squares normals and to consistently orient the normals. 
+	Normals are computed in parallel, where passes that read neighbor normals write into a second normal
+	buffer that is swapped with the normals of the point cloud at the end of the pass. */
 class CGV_API normal_estimator : public point_cloud_types
 {
 protected:
 	point_cloud& pc;
 	neighbor_graph& ng;
+	/// per thread scratch memory that is reused for all points processed by a thread
+	struct scratch
+	{
+		std::vector<Crd> weights;
+		std::vector<Pnt> points;
+	};
+	/// second normal buffer used by passes that read neighbor normals
+	cgv::utils::mapped_vector<Nml> normal_buffer;
+	/// resize second normal buffer to the number of points
+	void prepare_normal_buffer();
+	/// make second normal buffer the normals of the point cloud
+	void swap_normal_buffer();
 public:
+	/// number of threads used to compute normals, where 0 uses all available cores
+	unsigned nr_threads;
+
 	Crd normal_quality_exp;
 
 	Crd localization_scale;
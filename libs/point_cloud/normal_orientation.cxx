@@ -0,0 +1,176 @@
+#include "normal_orientation.h"
+#include <algorithm>
+#include <limits>
+
+normal_orientation::normal_orientation(unsigned _nr_threads) : nr_components(0), nr_flipped(0), nr_threads(_nr_threads)
+{
+}
+
+/// reflect normal at the plane orthogonal to d, where coincident points with d = 0 keep the normal
+static normal_orientation::Dir reflect_normal(const normal_orientation::Nml& nml, const normal_orientation::Dir& d)
+{
+	normal_orientation::Crd l2 = dot(d, d);
+	if (!(l2 > 0))
+		return nml;
+	return nml - (2 * dot(nml, d) / l2) * d;
+}
+
+void normal_orientation::compute_weights(const point_cloud& pc, const csr_neighbor_graph& g)
+{
+	weights.resize(g.get_nr_half_edges());
+	neighbor_graph_for_each_point(g.get_nr_vertices(), nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, std::vector<Idx>&) {
+		const Pnt& pi = pc.pnt(vi);
+		const Nml& nml_i = pc.nml(vi);
+		for (size_t e = g.row_offsets[vi]; e < g.row_offsets[vi + 1]; ++e) {
+			Idx vj = g.neighbors[e];
+			float w = fabs(dot(reflect_normal(nml_i, pc.pnt(vj) - pi), pc.nml(vj)));
+			// invalid normals yield the lowest weight
+			weights[e] = w >= 0 ? w : 0.0f;
+		}
+	});
+}
+
+/// return whether edge (vi,vj) with weight wi is better than edge (vk,vl) with weight wk, where ties in the weights are
+/// broken by the smaller and then by the larger vertex index
+static bool is_better_edge(float wi, int vi, int vj, float wk, int vk, int vl)
+{
+	if (wi != wk)
+		return wi > wk;
+	int mi = std::min(vi, vj), mk = std::min(vk, vl);
+	if (mi != mk)
+		return mi < mk;
+	return std::max(vi, vj) < std::max(vk, vl);
+}
+
+void normal_orientation::compute_forest(const csr_neighbor_graph& g, cgv::data::concurrent_union_find& uf)
+{
+	Cnt n = g.get_nr_vertices();
+	uf.init(n);
+	forest.clear();
+	forest.reserve(n > 0 ? n - 1 : 0);
+	const size_t no_edge = size_t(-1);
+	// per vertex representative and best outgoing edge, per component vertex with best outgoing edge
+	std::vector<Idx> root(n), best_vertex(n, -1), candidates;
+	std::vector<size_t> best_edge(n, no_edge);
+	// vertices whose neighbors are all in the same component
+	std::vector<char> done(n, 0);
+	auto better = [&](size_t e, Idx vi, size_t f, Idx vk) {
+		return is_better_edge(weights[e], vi, g.neighbors[e], weights[f], vk, g.neighbors[f]);
+	};
+	while (true) {
+		// find best outgoing edge per vertex in parallel, where the union find is not modified
+		neighbor_graph_for_each_point(n, nr_threads, neighbor_graph_progress_callback(), [&](Idx vi, std::vector<Idx>&) {
+			best_edge[vi] = no_edge;
+			if (done[vi])
+				return;
+			Idx ri = root[vi] = Idx(uf.find(vi));
+			for (size_t e = g.row_offsets[vi]; e < g.row_offsets[vi + 1]; ++e) {
+				if (uf.find(g.neighbors[e]) != unsigned(ri) && (best_edge[vi] == no_edge || better(e, vi, best_edge[vi], vi)))
+					best_edge[vi] = e;
+			}
+			if (best_edge[vi] == no_edge)
+				done[vi] = 1;
+		});
+		// select best edge per component and add the candidates in the order of decreasing quality, such that the
+		// forest does not depend on the thread timing even if components choose edges that form cycles
+		candidates.clear();
+		for (Cnt vi = 0; vi < n; ++vi) {
+			if (best_edge[vi] == no_edge)
+				continue;
+			Idx& vk = best_vertex[root[vi]];
+			if (vk == -1)
+				candidates.push_back(root[vi]);
+			if (vk == -1 || better(best_edge[vi], vi, best_edge[vk], vk))
+				vk = vi;
+		}
+		for (Idx& ri : candidates) {
+			Idx vi = best_vertex[ri];
+			best_vertex[ri] = -1;
+			ri = vi;
+		}
+		std::sort(candidates.begin(), candidates.end(), [&](Idx vi, Idx vk) { return better(best_edge[vi], vi, best_edge[vk], vk); });
+		size_t nr_edges_before = forest.size();
+		for (Idx vi : candidates) {
+			Idx vj = g.neighbors[best_edge[vi]];
+			if (uf.unify(vi, vj))
+				forest.push_back(std::make_pair(vi, vj));
+		}
+		if (forest.size() == nr_edges_before)
+			break;
+	}
+}
+
+void normal_orientation::orient(point_cloud& pc, const csr_neighbor_graph& g)
+{
+	Cnt n = g.get_nr_vertices();
+	if (!pc.has_normals() || n == 0) {
+		nr_components = 0;
+		nr_flipped = 0;
+		return;
+	}
+	compute_weights(pc, g);
+	cgv::data::concurrent_union_find uf;
+	compute_forest(g, uf);
+	weights.clear();
+
+	// build forest adjacency in compressed row storage
+	std::vector<size_t> offsets(size_t(n) + 1, 0);
+	for (const auto& e : forest) {
+		++offsets[e.first + 1];
+		++offsets[e.second + 1];
+	}
+	for (Cnt vi = 0; vi < n; ++vi)
+		offsets[vi + 1] += offsets[vi];
+	std::vector<Idx> adjacency(offsets[n]);
+	{
+		std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+		for (const auto& e : forest) {
+			adjacency[fill[e.first]++] = e.second;
+			adjacency[fill[e.second]++] = e.first;
+		}
+	}
+	// per component start at point with smallest x-coordinate
+	std::vector<Idx> start(n, -1);
+	std::vector<Idx> components;
+	for (Cnt vi = 0; vi < n; ++vi) {
+		Idx ri = uf.find(vi);
+		if (start[ri] == -1) {
+			components.push_back(ri);
+			start[ri] = vi;
+		}
+		else if (pc.pnt(vi)[0] < pc.pnt(start[ri])[0])
+			start[ri] = vi;
+	}
+	nr_components = Cnt(components.size());
+
+	// orient components independently by breadth first traversal of their trees
+	std::atomic<size_t> flipped(0);
+	typedef std::vector<std::pair<Idx, Idx> > queue_type;
+	neighbor_graph_for_each_point<queue_type>(nr_components, nr_threads, neighbor_graph_progress_callback(), [&](Idx ci, queue_type& Q) {
+		size_t nr = 0;
+		Idx v0 = start[components[ci]];
+		if (pc.nml(v0)[0] > 0) {
+			pc.nml(v0) = -pc.nml(v0);
+			++nr;
+		}
+		Q.clear();
+		Q.push_back(std::make_pair(v0, Idx(-1)));
+		for (size_t qi = 0; qi < Q.size(); ++qi) {
+			Idx vi = Q[qi].first;
+			const Pnt& pi = pc.pnt(vi);
+			const Nml& nml_i = pc.nml(vi);
+			for (size_t e = offsets[vi]; e < offsets[vi + 1]; ++e) {
+				Idx vj = adjacency[e];
+				if (vj == Q[qi].second)
+					continue;
+				if (dot(reflect_normal(nml_i, pc.pnt(vj) - pi), pc.nml(vj)) < 0) {
+					pc.nml(vj) = -pc.nml(vj);
+					++nr;
+				}
+				Q.push_back(std::make_pair(vj, vi));
+			}
+		}
+		flipped += nr;
+	});
+	nr_flipped = flipped;
+}
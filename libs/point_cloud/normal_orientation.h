@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include "point_cloud.h"
+#include "neighbor_graph.h"
+#include <cgv/data/union_find.h>
+
+#include "lib_begin.h"
+
+/** consistently orients the normals of a point cloud along a maximum spanning forest of a neighbor graph in compressed
+    row storage. Edge weights measure how well the normals at both edge ends agree after reflecting one normal at the
+	plane orthogonal to the edge, where normals of coincident points are compared directly. The forest is computed with
+	a Boruvka algorithm that searches the best outgoing edges of all vertices in parallel. Ties in the weights are broken
+	by the vertex indices and the best edges of the components are added in the order of decreasing weight, such that
+	the forest does not depend on the number of threads. As each component only considers the outgoing edges of its
+	vertices, the forest approximates the maximum spanning forest for asymmetric knn graphs. Each connected component is
+	then oriented independently by a breadth first traversal that starts at its point with the smallest x-coordinate,
+	whose normal is oriented towards negative x. */
+class CGV_API normal_orientation : public point_cloud_types
+{
+protected:
+	/// absolute edge weights per half edge of the graph
+	std::vector<float> weights;
+	/// edges of spanning forest
+	std::vector<std::pair<Idx, Idx> > forest;
+	/// number of connected components of last orientation
+	Cnt nr_components;
+	/// number of flipped normals of last orientation
+	size_t nr_flipped;
+	/// compute edge weights from the current normals
+	void compute_weights(const point_cloud& pc, const csr_neighbor_graph& g);
+	/// compute spanning forest and keep union find with one representative per component
+	void compute_forest(const csr_neighbor_graph& g, cgv::data::concurrent_union_find& uf);
+public:
+	/// number of threads, where 0 uses all available cores
+	unsigned nr_threads;
+	/// construct orientation engine
+	normal_orientation(unsigned _nr_threads = 0);
+	/// orient normals of point cloud that has been used to build the given graph
+	void orient(point_cloud& pc, const csr_neighbor_graph& g);
+	/// return number of connected components of last orientation
+	Cnt get_nr_components() const { return nr_components; }
+	/// return number of flipped normals of last orientation
+	size_t get_nr_flipped() const { return nr_flipped; }
+	/// return edges of spanning forest of last orientation
+	const std::vector<std::pair<Idx, Idx> >& get_forest() const { return forest; }
+};
+
+#include <cgv/config/lib_end.h>
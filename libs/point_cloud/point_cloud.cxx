@@ -7,6 +7,9 @@
 #include <cgv/utils/advanced_scan.h>
 #include <cgv/media/mesh/obj_reader.h>
 #include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <memory>
 
 #pragma warning(disable:4996)
 
@@ -18,12 +21,12 @@ using namespace cgv::media::mesh;
 class point_cloud_obj_loader : public obj_reader, public point_cloud_types
 {
 protected:
-	std::vector<Pnt>& P;
-	std::vector<Nml>& N;
-	std::vector<Clr>& C;
+	cgv::utils::mapped_vector<Pnt>& P;
+	cgv::utils::mapped_vector<Nml>& N;
+	cgv::utils::mapped_vector<Clr>& C;
 public:
 	///
-	point_cloud_obj_loader(std::vector<Pnt>& _P, std::vector<Nml>& _N, std::vector<Clr>& _C) : P(_P), N(_N), C(_C) {}
+	point_cloud_obj_loader(cgv::utils::mapped_vector<Pnt>& _P, cgv::utils::mapped_vector<Nml>& _N, cgv::utils::mapped_vector<Clr>& _C) : P(_P), N(_N), C(_C) {}
 	/// overide this function to process a vertex
 	void process_vertex(const v3d_type& p)
 	{
@@ -266,15 +269,15 @@ void point_cloud::clip(const Box clip_box)
 /// permute points
 void point_cloud::permute(std::vector<Idx>& perm, bool permute_component_indices)
 {
-	cgv::math::permute_vector(P, perm);
+	cgv::math::permute_array(P.size(), P.data(), &perm.front());
 	if (has_normals())
-		cgv::math::permute_vector(N, perm);
+		cgv::math::permute_array(N.size(), N.data(), &perm.front());
 	if (has_colors())
-		cgv::math::permute_vector(C, perm);
+		cgv::math::permute_array(C.size(), C.data(), &perm.front());
 	if (has_texture_coordinates())
-		cgv::math::permute_vector(T, perm);
+		cgv::math::permute_array(T.size(), T.data(), &perm.front());
 	if (has_pixel_coordinates())
-		cgv::math::permute_vector(I, perm);
+		cgv::math::permute_array(I.size(), I.data(), &perm.front());
 	if (permute_component_indices && has_components())
 		cgv::math::permute_vector(component_indices, perm);
 }
@@ -864,7 +867,39 @@ enum BPCFlags
 	BPC_HAS_COMPS = 16,
 	BPC_HAS_COMP_CLRS = 32,
 	BPC_HAS_COMP_TRANS = 64,
-	BPC_HAS_BYTE_CLRS = 128
+	BPC_HAS_BYTE_CLRS = 128,
+	BPC_ALIGNED_LAYOUT = 256
+};
+
+/// version of the aligned bin layout
+const cgv::type::uint32_type bpc_aligned_layout_version = 2;
+/// alignment of all blocks in the aligned bin layout in bytes
+const size_t bpc_block_alignment = 64;
+
+/// indices of the blocks of the aligned bin layout
+enum BPCBlock
+{
+	BPCB_PNTS, BPCB_NMLS, BPCB_CLRS, BPCB_TCS, BPCB_PIXCRDS, BPCB_COMPS, BPCB_COMP_CLRS, BPCB_COMP_ROTS, BPCB_COMP_TRANS, 
+	BPCB_COMP_NAMES, BPCB_NR_BLOCKS
+};
+
+/// header of the aligned bin layout, where the first three words are compatible to the flags based bin format
+struct bpc_aligned_header
+{
+	/// zero to mark flags based format
+	cgv::type::uint32_type zero;
+	/// number of points
+	cgv::type::uint32_type n;
+	/// flags including BPC_ALIGNED_LAYOUT
+	cgv::type::uint32_type flags;
+	/// layout version
+	cgv::type::uint32_type version;
+	/// number of components
+	cgv::type::uint32_type nr_components;
+	/// size of color components in bytes
+	cgv::type::uint32_type color_component_size;
+	/// byte offsets of blocks or 0 for not present blocks
+	cgv::type::uint64_type block_offsets[BPCB_NR_BLOCKS];
 };
 
 bool point_cloud::read_bin(const string& file_name)
@@ -894,6 +929,11 @@ bool point_cloud::read_bin(const string& file_name)
 		}
 	}
 
+	if (success && (flags & BPC_ALIGNED_LAYOUT) != 0) {
+		fclose(fp);
+		return read_mapped_bin(file_name);
+	}
+
 	if (success) {
 		P.resize(n);
 		success = fread(&P[0][0], sizeof(Pnt), n, fp) == n;
@@ -1179,65 +1219,181 @@ bool point_cloud::write_ascii(const std::string& file_name, bool write_nmls) con
 	return !os.fail();
 }
 
+/// write the given block padded to the block alignment and store its offset in the header unless block is BPCB_NR_BLOCKS
+static bool write_bpc_block(FILE* fp, bpc_aligned_header& header, BPCBlock block, const void* data, size_t size, size_t& offset)
+{
+	static const char zeros[bpc_block_alignment] = { 0 };
+	if (block < BPCB_NR_BLOCKS)
+		header.block_offsets[block] = offset;
+	if (size > 0 && fwrite(data, 1, size, fp) != size)
+		return false;
+	offset += size;
+	size_t padding = (bpc_block_alignment - offset % bpc_block_alignment) % bpc_block_alignment;
+	if (padding > 0 && fwrite(zeros, 1, padding, fp) != padding)
+		return false;
+	offset += padding;
+	return true;
+}
+
 bool point_cloud::write_bin(const std::string& file_name) const
 {
-	FILE* fp = fopen(file_name.c_str(), "wb");
+	// write to a temporary file that replaces the target in the end, such that clouds mapped from the target stay valid
+	std::string tmp_file_name = file_name + ".tmp";
+	FILE* fp = fopen(tmp_file_name.c_str(), "wb");
 	if (!fp)
 		return false;
 	Cnt n = (Cnt)P.size();
-	Cnt m = (Cnt)N.size();
-	Cnt m1 = m;
-	Cnt flags = has_colors() ? BPC_HAS_CLRS : 0;
-	flags += has_normals() ? BPC_HAS_NMLS : 0;
-	flags += has_texture_coordinates() ? BPC_HAS_TCS : 0;
-	flags += has_pixel_coordinates() ? BPC_HAS_PIXCRDS : 0;
-	flags += has_components() ? BPC_HAS_COMPS : 0;
-	flags += has_component_colors() ? BPC_HAS_COMP_CLRS : 0;
-	flags += has_component_transformations() ? BPC_HAS_COMP_TRANS : 0;
+	bpc_aligned_header header;
+	memset(&header, 0, sizeof(header));
+	header.n = n;
+	header.flags = BPC_ALIGNED_LAYOUT;
+	header.flags += (has_colors() && C.size() == n) ? BPC_HAS_CLRS : 0;
+	header.flags += (has_normals() && N.size() == n) ? BPC_HAS_NMLS : 0;
+	header.flags += has_texture_coordinates() ? BPC_HAS_TCS : 0;
+	header.flags += has_pixel_coordinates() ? BPC_HAS_PIXCRDS : 0;
+	header.flags += has_components() ? BPC_HAS_COMPS : 0;
+	header.flags += has_component_colors() ? BPC_HAS_COMP_CLRS : 0;
+	header.flags += has_component_transformations() ? BPC_HAS_COMP_TRANS : 0;
 #ifdef BYTE_COLORS
-	flags += BPC_HAS_BYTE_CLRS;
+	header.flags += BPC_HAS_BYTE_CLRS;
 #endif
-	if (has_colors() && C.size() == n)
-		m1 = 2*n+m;
-	bool success;
-	if (false) {
-		success =
-			fwrite(&n, sizeof(Cnt), 1, fp) == 1 &&
-			fwrite(&m1, sizeof(Cnt), 1, fp) == 1 &&
-			fwrite(&P[0][0], sizeof(Pnt), n, fp) == n;
-		if (has_normals())
-			success = success && (fwrite(&N[0][0], sizeof(Nml), m, fp) == m);
-		if (has_colors() && C.size() == n)
-			success = success && (fwrite(&C[0][0], sizeof(Clr), n, fp) == n);
+	header.version = bpc_aligned_layout_version;
+	header.nr_components = has_components() ? Cnt(get_nr_components()) : 0;
+	header.color_component_size = sizeof(ClrComp);
+
+	// write preliminary header and blocks, then rewrite header with block offsets
+	size_t offset = 0;
+	bool success = write_bpc_block(fp, header, BPCB_NR_BLOCKS, &header, sizeof(header), offset);
+	success = success && write_bpc_block(fp, header, BPCB_PNTS, P.data(), n * sizeof(Pnt), offset);
+	if (header.flags & BPC_HAS_NMLS)
+		success = success && write_bpc_block(fp, header, BPCB_NMLS, N.data(), n * sizeof(Nml), offset);
+	if (header.flags & BPC_HAS_CLRS)
+		success = success && write_bpc_block(fp, header, BPCB_CLRS, C.data(), n * sizeof(Clr), offset);
+	if (header.flags & BPC_HAS_TCS)
+		success = success && write_bpc_block(fp, header, BPCB_TCS, T.data(), n * sizeof(TexCrd), offset);
+	if (header.flags & BPC_HAS_PIXCRDS)
+		success = success && write_bpc_block(fp, header, BPCB_PIXCRDS, I.data(), n * sizeof(PixCrd), offset);
+	if (header.flags & BPC_HAS_COMPS) {
+		// store point ranges only as component_info contains a string
+		std::vector<cgv::type::uint64_type> ranges;
+		for (const auto& ci : components) {
+			ranges.push_back(ci.index_of_first_point);
+			ranges.push_back(ci.nr_points);
+		}
+		success = success && write_bpc_block(fp, header, BPCB_COMPS, ranges.data(), ranges.size() * sizeof(cgv::type::uint64_type), offset);
+		// store component names as consecutive zero terminated strings
+		std::string names;
+		for (const auto& ci : components)
+			names.append(ci.name.c_str(), ci.name.size() + 1);
+		success = success && write_bpc_block(fp, header, BPCB_COMP_NAMES, names.data(), names.size(), offset);
+		if (header.flags & BPC_HAS_COMP_CLRS)
+			success = success && write_bpc_block(fp, header, BPCB_COMP_CLRS, component_colors.data(), header.nr_components * sizeof(RGBA), offset);
+		if (header.flags & BPC_HAS_COMP_TRANS) {
+			success = success && write_bpc_block(fp, header, BPCB_COMP_ROTS, component_rotations.data(), header.nr_components * sizeof(Qat), offset);
+			success = success && write_bpc_block(fp, header, BPCB_COMP_TRANS, component_translations.data(), header.nr_components * sizeof(Dir), offset);
+		}
 	}
-	else {
-		m = 0;
-		success =
-			fwrite(&m, sizeof(Cnt), 1, fp) == 1 &&
-			fwrite(&n, sizeof(Cnt), 1, fp) == 1 &&
-			fwrite(&flags, sizeof(Cnt), 1, fp) == 1 &&
-			fwrite(&P[0][0], sizeof(Pnt), n, fp) == n;
-		if (has_normals())
-			success = success && (fwrite(&N[0][0], sizeof(Nml), n, fp) == n);
-		if (has_colors() && C.size() == n)
-			success = success && (fwrite(&C[0][0], sizeof(Clr), n, fp) == n);
+	success = success && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+	success = fclose(fp) == 0 && success;
+	// rename does not replace existing files on all platforms, where a mapped target cannot be removed either
+	if (success && std::rename(tmp_file_name.c_str(), file_name.c_str()) != 0)
+		success = cgv::utils::file::exists(file_name) && std::remove(file_name.c_str()) == 0 &&
+			std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+	if (!success)
+		std::remove(tmp_file_name.c_str());
+	return success;
+}
 
-		if (has_texture_coordinates()) 
-			success = success && (fwrite(&T[0][0], sizeof(TexCrd), n, fp) == n);
-		if (has_pixel_coordinates())
-			success = success && (fwrite(&I[0][0], sizeof(PixCrd), n, fp) == n);
-		if (has_components()) {
-			Cnt nr_comps = Cnt(get_nr_components());
-			success = success && (fwrite(&nr_comps, sizeof(Cnt), 1, fp) == 1) && (fwrite(&components[0], sizeof(component_info), nr_comps, fp) == nr_comps);
+bool point_cloud::read_mapped_bin(const std::string& file_name)
+{
+	std::shared_ptr<cgv::utils::mapped_file> mapping(new cgv::utils::mapped_file());
+	if (!mapping->open(file_name) || mapping->size() < sizeof(bpc_aligned_header))
+		return false;
+	const bpc_aligned_header& header = *mapping->get<bpc_aligned_header>(0);
+	if (header.zero != 0 || (header.flags & BPC_ALIGNED_LAYOUT) == 0 || header.version != bpc_aligned_layout_version) {
+		std::cerr << "point_cloud::read_mapped_bin: unsupported layout in " << file_name << std::endl;
+		return false;
+	}
+	if ((header.flags & BPC_HAS_CLRS) != 0 && header.color_component_size != 1 && header.color_component_size != 4) {
+		std::cerr << "point_cloud::read_mapped_bin: unsupported color component size " << header.color_component_size << " in " << file_name << std::endl;
+		return false;
+	}
+	size_t n = header.n;
+	size_t nc = header.nr_components;
+	// check that all present blocks are inside of the file, where the names need at least one terminating zero per component
+	size_t block_sizes[BPCB_NR_BLOCKS] = {
+		n * sizeof(Pnt), n * sizeof(Nml), n * header.color_component_size * 3, n * sizeof(TexCrd), n * sizeof(PixCrd),
+		nc * 2 * sizeof(cgv::type::uint64_type), nc * sizeof(RGBA), nc * sizeof(Qat), nc * sizeof(Dir), nc
+	};
+	bool block_present[BPCB_NR_BLOCKS] = {
+		true, (header.flags & BPC_HAS_NMLS) != 0, (header.flags & BPC_HAS_CLRS) != 0, (header.flags & BPC_HAS_TCS) != 0,
+		(header.flags & BPC_HAS_PIXCRDS) != 0, (header.flags & BPC_HAS_COMPS) != 0, 
+		(header.flags & BPC_HAS_COMPS) != 0 && (header.flags & BPC_HAS_COMP_CLRS) != 0,
+		(header.flags & BPC_HAS_COMPS) != 0 && (header.flags & BPC_HAS_COMP_TRANS) != 0,
+		(header.flags & BPC_HAS_COMPS) != 0 && (header.flags & BPC_HAS_COMP_TRANS) != 0,
+		(header.flags & BPC_HAS_COMPS) != 0
+	};
+	for (int b = 0; b < BPCB_NR_BLOCKS; ++b) {
+		if (block_present[b] && (header.block_offsets[b] == 0 || header.block_offsets[b] + block_sizes[b] > mapping->size())) {
+			std::cerr << "point_cloud::read_mapped_bin: truncated file " << file_name << std::endl;
+			return false;
+		}
+	}
+	clear();
+	P.attach(mapping, size_t(header.block_offsets[BPCB_PNTS]), n);
+	if (block_present[BPCB_NMLS])
+		N.attach(mapping, size_t(header.block_offsets[BPCB_NMLS]), n);
+	if (block_present[BPCB_CLRS]) {
+		if (header.color_component_size == sizeof(ClrComp))
+			C.attach(mapping, size_t(header.block_offsets[BPCB_CLRS]), n);
+		else {
+			// convert colors stored with a different color component type
+			C.resize(n);
+			if (header.color_component_size == 1) {
+				const cgv::type::uint8_type* c = mapping->get<cgv::type::uint8_type>(size_t(header.block_offsets[BPCB_CLRS]));
+				for (size_t i = 0; i < n; ++i, c += 3)
+					C[i] = Clr(byte_to_color_component(c[0]), byte_to_color_component(c[1]), byte_to_color_component(c[2]));
+			}
+			else {
+				const float* c = mapping->get<float>(size_t(header.block_offsets[BPCB_CLRS]));
+				for (size_t i = 0; i < n; ++i, c += 3)
+					C[i] = Clr(float_to_color_component(c[0]), float_to_color_component(c[1]), float_to_color_component(c[2]));
+			}
 		}
-		if (has_component_colors())
-			success = success && (fwrite(&component_colors[0][0], sizeof(RGBA), get_nr_components(), fp) == get_nr_components());
-		if (has_component_transformations()) {
-			success = success && (fwrite(&component_rotations[0][0], sizeof(Qat), get_nr_components(), fp) == get_nr_components());
-			success = success && (fwrite(&component_translations[0][0], sizeof(Dir), get_nr_components(), fp) == get_nr_components());
+	}
+	if (block_present[BPCB_TCS])
+		T.attach(mapping, size_t(header.block_offsets[BPCB_TCS]), n);
+	if (block_present[BPCB_PIXCRDS])
+		I.attach(mapping, size_t(header.block_offsets[BPCB_PIXCRDS]), n);
+	if (block_present[BPCB_COMPS]) {
+		const cgv::type::uint64_type* ranges = mapping->get<cgv::type::uint64_type>(size_t(header.block_offsets[BPCB_COMPS]));
+		components.resize(nc);
+		component_indices.resize(n);
+		for (size_t ci = 0; ci < nc; ++ci) {
+			components[ci] = component_info(size_t(ranges[2 * ci]), size_t(ranges[2 * ci + 1]));
+			size_t end = std::min(n, components[ci].index_of_first_point + components[ci].nr_points);
+			for (size_t i = components[ci].index_of_first_point; i < end; ++i)
+				component_indices[i] = unsigned(ci);
+		}
+		const char* name = mapping->get<char>(size_t(header.block_offsets[BPCB_COMP_NAMES]));
+		const char* names_end = mapping->get<char>(0) + mapping->size();
+		for (size_t ci = 0; ci < nc && name < names_end; ++ci) {
+			const char* name_end = std::find(name, names_end, 0);
+			components[ci].name.assign(name, name_end);
+			name = name_end + 1;
+		}
+		if (block_present[BPCB_COMP_CLRS]) {
+			const RGBA* cc = mapping->get<RGBA>(size_t(header.block_offsets[BPCB_COMP_CLRS]));
+			component_colors.assign(cc, cc + nc);
+		}
+		if (block_present[BPCB_COMP_ROTS]) {
+			const Qat* cr = mapping->get<Qat>(size_t(header.block_offsets[BPCB_COMP_ROTS]));
+			component_rotations.assign(cr, cr + nc);
+			const Dir* ct = mapping->get<Dir>(size_t(header.block_offsets[BPCB_COMP_TRANS]));
+			component_translations.assign(ct, ct + nc);
 		}
 	}
-	return fclose(fp) == 0 && success;
+	return true;
 }
 
 bool point_cloud::write_obj(const std::string& file_name) const
@@ -7,6 +7,7 @@
 #include <cgv/math/quaternion.h>
 #include <cgv/media/color.h>
 #include <cgv/media/axis_aligned_box.h>
+#include <cgv/utils/mapped_vector.h>
 
 #include "lib_begin.h"
 
@@ -109,16 +110,16 @@ public:
 class CGV_API point_cloud : public point_cloud_types
 {	
 protected:
-	/// container for point positions
-	std::vector<Pnt> P;
+	/// container for point positions, which is a view into the file after reading a bin file in aligned layout
+	cgv::utils::mapped_vector<Pnt> P;
 	/// container for point normals
-	std::vector<Nml> N;
+	cgv::utils::mapped_vector<Nml> N;
 	/// container for point colors
-	std::vector<Clr> C;
+	cgv::utils::mapped_vector<Clr> C;
 	/// container for point texture coordinates 
-	std::vector<TexCrd> T;
+	cgv::utils::mapped_vector<TexCrd> T;
 	/// container for point pixel coordinates 
-	std::vector<PixCrd> I;
+	cgv::utils::mapped_vector<PixCrd> I;
 
 	/// container to store  one component index per point
 	std::vector<unsigned> component_indices;
@@ -149,6 +150,7 @@ protected:
 	friend class point_cloud_interactable;
 	friend class point_cloud_viewer;
 	friend class gl_point_cloud_drawable;
+	friend class normal_estimator;
 private:
 	mutable std::vector<bool> comp_box_out_of_date;
 	mutable std::vector<bool> comp_pixrng_out_of_date;
@@ -189,8 +191,14 @@ protected:
 	/*! Binary format has 8 bytes header encoding two 32-bit unsigned ints n and m.
 	    n is the number of points. In case no colors are provided m is the number of normals, i.e. m=0 in case no normals are provided.
 		In case colors are present there must be the same number n of colors as points and m is set to 2*n+nr_normals. This is a hack
-		resulting from the extension of the format with colors. */
+		resulting from the extension of the format with colors. If n is zero, m is the number of points and a flags word follows.
+		Files written in the versioned aligned layout are forwarded to read_mapped_bin. */
 	bool read_bin(const std::string& file_name);
+	//! read bin file in aligned layout by memory mapping it
+	/*! All per point attributes become views into the mapping such that no data is copied. Pages are shared with other
+	    processes that map the same file and only copied once a point attribute is written. Changing the number of points 
+		copies the mapped attributes. */
+	bool read_mapped_bin(const std::string& file_name);
 	//! read a ply format.
 	/*! Ignores all but the vertex elements and from the vertex elements the properties x,y,z,nx,ny,nz:Float32 and red,green,blue,alpha:Uint8.
 	    Colors are transformed to 32-bit floats in the range [0,1] and alpha components are ignored. */
@@ -199,7 +207,7 @@ protected:
 	bool read_txt(const std::string& file_name);
 	/// write ascii format, see read_ascii for format description
 	bool write_ascii(const std::string& file_name, bool write_nmls = true) const;
-	/// write binary format, see read_bin for format description
+	/// write binary format in the versioned aligned layout that is read with read_mapped_bin, where the file is replaced only after writing such that a mapped cloud can be written back to its file
 	bool write_bin(const std::string& file_name) const;
 	/// write obj format, see read_obj for format description
 	bool write_obj(const std::string& file_name) const;
@@ -256,6 +264,8 @@ public:
 	//@}
 
 	/**@name access to geometry*/
+	/// check whether point positions are a view into a memory mapped bin file
+	bool is_mapped() const { return P.is_mapped(); }
 	/// return the number of points
 	Cnt get_nr_points() const { return (Cnt)P.size(); }
 	/// return the i-th point as const reference
@@ -2,7 +2,7 @@
 #include "point_cloud_interactable.h"
 #include <cgv/gui/trigger.h>
 #include <cgv/gui/key_event.h>
-#include <libs/point_cloud/ann_tree.h>
+#include <libs/point_cloud/kd_tree.h>
 #include <cgv/base/find_action.h>
 #include <cgv/signal/rebind.h>
 #include <cgv/base/import.h>
@@ -19,10 +19,10 @@
 
 #define FILE_OPEN_TITLE "Open Point Cloud"
 #define FILE_APPEND_TITLE "Append Point Cloud"
-#define FILE_OPEN_FILTER "Point Clouds (apc,bpc):*.apc;*.bpc|Mesh Files (obj,ply,pct):*.obj;*.ply;*.pct|All Files:*.*"
+#define FILE_OPEN_FILTER "Point Clouds (apc,bpc):*.apc;*.bpc|Level of Detail Octrees (poct):*.poct|Mesh Files (obj,ply,pct):*.obj;*.ply;*.pct|All Files:*.*"
 
 #define FILE_SAVE_TITLE "Save Point Cloud"
-#define FILE_SAVE_FILTER "Point Clouds (apc,bpc):*.apc;*.bpc|Mesh Files (obj,ply):*.obj;*.ply|All Files:*.*"
+#define FILE_SAVE_FILTER "Point Clouds (apc,bpc):*.apc;*.bpc|Level of Detail Octrees (poct):*.poct|Mesh Files (obj,ply):*.obj;*.ply|All Files:*.*"
 
 void point_cloud_interactable::update_file_name(const std::string& ffn, bool append)
 {
@@ -145,7 +145,7 @@ void point_cloud_interactable::ensure_tree_ds()
 	if (tree_ds_out_of_date) {
 		if (tree_ds)
 			delete tree_ds;
-		tree_ds = new ann_tree;
+		tree_ds = new kd_tree;
 		tree_ds->build(pc);
 		tree_ds_out_of_date = false;
 	}
@@ -161,7 +161,13 @@ void point_cloud_interactable::build_neighbor_graph()
 	ng.clear();
 	ensure_tree_ds();
 	cgv::utils::statistics he_stats;
-	ng.build(pc.get_nr_points(), k, *tree_ds, &he_stats);
+	Cnt next_report = 0;
+	ng.build(pc.get_nr_points(), k, *tree_ds, &he_stats, [&next_report](Cnt i, Cnt n) {
+		if (i < next_report)
+			return;
+		std::cout << "build ng " << i << " of " << n << std::endl;
+		next_report = i + n / 10;
+	}, 0);
 	if (do_symmetrize)
 		ng.symmetrize();
 	on_point_cloud_change_callback(PCC_NEIGHBORGRAPH_CREATE);
@@ -182,7 +188,7 @@ void point_cloud_interactable::build_neighbor_graph_componentwise()
 	std::cout << "build_neighbor_graph_componentwise(" << pc.get_nr_components() << "):"; std::cout.flush();
 	for (Idx ci = 0; ci < (Idx)pc.get_nr_components(); ++ci) {
 		std::cout << " " << ci << ":"; std::cout.flush();
-		ann_tree* T = new ann_tree;
+		kd_tree* T = new kd_tree;
 		std::vector<Idx> C(1, Idx(ci));
 		T->build(pc, C);
 		Idx n = Idx(pc.component_point_range(ci).nr_points);
@@ -190,10 +196,9 @@ void point_cloud_interactable::build_neighbor_graph_componentwise()
 		for (Idx l = 0; l < n; ++l) {
 			Idx i = l + offset;
 			std::vector<Idx>& Ni = ng[i];
+			// kd_tree reports point cloud indices such that no offset needs to be added
 			T->extract_neighbors(i, k, Ni);
-			for (auto& ni : Ni) 
-				ni += offset;
-			ng.nr_half_edges += k;
+			ng.nr_half_edges += Cnt(Ni.size());
 		}
 		delete T;
 		std::cout << "*"; std::cout.flush();
@@ -345,7 +350,12 @@ point_cloud_interactable::point_cloud_interactable() : ne(pc, ng)
 }
 void point_cloud_interactable::auto_set_view()
 {
-	if (pc.get_nr_points() == 0)
+	Box box;
+	if (lod_streamer.is_open())
+		box = lod_streamer.get_box();
+	else if (pc.get_nr_points() > 0)
+		box = pc.box();
+	else
 		return;
 
 	std::vector<cgv::render::view*> view_ptrs;
@@ -355,8 +365,8 @@ void point_cloud_interactable::auto_set_view()
 		return;
 	}
 	cgv::gui::animate_with_rotation(view_ptrs[0]->ref_view_up_dir(), dvec3(0, 1, 0), 0.5)->set_base_ptr(this);
-	cgv::gui::animate_with_geometric_blend(view_ptrs[0]->ref_y_extent_at_focus(), 1.5*pc.box().get_extent()(1), 0.5)->set_base_ptr(this);
-	cgv::gui::animate_with_linear_blend(view_ptrs[0]->ref_focus(), dvec3(pc.box().get_center()), 0.5)->set_base_ptr(this);
+	cgv::gui::animate_with_geometric_blend(view_ptrs[0]->ref_y_extent_at_focus(), 1.5*box.get_extent()(1), 0.5)->set_base_ptr(this);
+	cgv::gui::animate_with_linear_blend(view_ptrs[0]->ref_focus(), dvec3(box.get_center()), 0.5)->set_base_ptr(this);
 	post_redraw();
 }
 
@@ -824,6 +834,14 @@ void point_cloud_interactable::create_gui()
 			align("\b");
 			end_tree_node(show_point_step);
 		}
+		if (begin_tree_node("level of detail", lod_streamer.point_budget, false, "level=3")) {
+			align("\a");
+			add_member_control(this, "point_budget", lod_streamer.point_budget, "value_slider", "min=100000;max=100000000;log=true;ticks=true");
+			add_member_control(this, "max_screen_space_error", lod_streamer.max_screen_space_error, "value_slider", "min=0.5;max=20;log=true;ticks=true");
+			add_member_control(this, "max_uploads_per_frame", max_lod_uploads_per_frame, "value_slider", "min=1;max=256;log=true;ticks=true");
+			align("\b");
+			end_tree_node(lod_streamer.point_budget);
+		}
 		add_member_control(this, "accelerate_picking", accelerate_picking, "check");
 		align("\b");
 		end_tree_node(show_points);
@@ -2,6 +2,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include "surface_reconstructor.h"
+#include "normal_orientation.h"
 #include <cgv/math/fvec.h>
 #include <cgv/math/normal_estimation.h>
 
@@ -351,123 +352,13 @@ void surface_reconstructor::compute_bilateral_weighted_normals(bool reorient)
 }
 
 
-#include <cgv/data/union_find.h>
-#include <limits>
-
-struct neighbor_info 
-{
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	neighbor_info(unsigned _vj = 0, bool _flip = false) : vj(_vj), flip(_flip) {}
-};
-
-struct edge_info 
-{
-	unsigned vi;
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	edge_info(unsigned _vi, unsigned _vj, bool _flip) : vi(_vi), vj(_vj), flip(_flip) {}
-};
-
-struct weighted_edge_info 
-{
-	unsigned vi;
-	struct {
-		unsigned  vj : 31;
-		bool flip : 1;
-	};
-	float w;
-	weighted_edge_info(unsigned _vi, unsigned _vj, float signed_w) : vi(_vi), vj(_vj), w(fabs(signed_w)), flip(signed_w < 0) {}
-	bool operator < (const weighted_edge_info& ei) const 
-	{
-		return w < ei.w;
-	}
-};
-
-/// recompute normals from neighbor graph and distance and normal weights
+/// compute consistent normal orientation along a maximum spanning forest of the neighbor graph
 void surface_reconstructor::orient_normals()
 {
 	std::cout << "orienting normals\n=================" << std::endl;
-	unsigned int vi;
-	unsigned int n = (unsigned int) pc->get_nr_points();
-
-	// compute weighted edges and initial point with smallest x-component
-	std::cout << "computing weighted edges" << std::endl;
-	std::vector<weighted_edge_info> E;
-	Crd min_x = std::numeric_limits<Crd>::max();
-	unsigned v0 = 0;
-	for (vi = 0; vi < n; ++vi) {
-		const Pnt& pi = pc->pnt(vi);
-		if (pi[0] < min_x) {
-			min_x = pi[0];
-			v0 = vi;
-		}
-		const Nml& nml_i = pc->nml(vi);
-		const std::vector<Idx> &Ni = ng->at(vi);
-		unsigned int ni = (unsigned int) Ni.size();
-		for (unsigned int j=0; j < ni; ++j) {
-			unsigned int vj = Ni[j];
-			const Pnt& pj = pc->pnt(vj);
-			const Nml& nml_j = pc->nml(vj);
-			Vec d = normalize(pj-pi);
-			Vec nml_ip = nml_i - 2*dot(nml_i,d)*d;
-			E.push_back(weighted_edge_info(vi,vj,dot(nml_ip, nml_j)));
-		}
-	}
-
-	std::cout << "construct MST" << std::endl;
-	// compute MST as simple neighborgraph
-	cgv::data::union_find uf(n);
-	std::sort(E.begin(), E.end());
-	std::vector<std::vector<neighbor_info> > MST(n);
-	for (vi = 1; vi < n; ) {
-		if (E.empty()) {
-			std::cerr << "warning: impossible to build MST over neighbor graph " << n-vi <<  " unreachable vertices" << std::endl;
-			break;
-		}
-		const weighted_edge_info& wei = E.back();
-		if (uf.find(wei.vi) != uf.find(wei.vj)) {
-			uf.unify(wei.vi,wei.vj);
-			MST[wei.vi].push_back(neighbor_info(wei.vj, wei.flip));
-			MST[wei.vj].push_back(neighbor_info(wei.vi, wei.flip));
-			++vi;
-		}
-		E.pop_back();
-	}
-	E.clear();
-
-	/*
-	for (vi = 0; vi < n; ++vi) {
-		(*ng)[vi].clear();
-		for (unsigned i=0;i<MST[vi].size(); ++i)
-			(*ng)[vi].push_back(MST[vi][i].vj);
-	}*/
-
-	std::cout << "flipping edges starting at v0=" << v0 << std::endl;
-	unsigned nr = 0;
-	// flip starting with v0
-	std::vector<edge_info> Q;
-	Q.push_back(edge_info(v0,-1,pc->nml(v0)[0]>0));
-	if (pc->nml(v0)[0]>0)
-		pc->nml(v0) = -pc->nml(v0);
-	while (!Q.empty()) {
-		edge_info ei = Q.back();
-		Q.pop_back();
-		const std::vector<neighbor_info>& ni = MST[ei.vi];
-		for (unsigned i=0; i<ni.size(); ++i) {
-			unsigned vj = ni[i].vj;
-			if (vj == ei.vj)
-				continue;
-			if (ni[i].flip != ei.flip) {
-				pc->nml(vj) = -pc->nml(vj);
-				++nr;
-			}
-			Q.push_back(edge_info(vj,ei.vi,ei.flip ^ ni[i].flip));
-		}
-	}
-	std::cout << "flipped " << nr << " edges" << std::endl;
+	csr_neighbor_graph g;
+	g.build(*ng);
+	normal_orientation no;
+	no.orient(*pc, g);
+	std::cout << "flipped " << no.get_nr_flipped() << " normals in " << no.get_nr_components() << " components" << std::endl;
 }
@@ -2,23 +2,85 @@
 #include "rgbd_input.h"
 
 #include <cgv/utils/file.h>
+#include <iostream>
+#include <cstring>
+#include <chrono>
 
 using namespace std;
 
 namespace rgbd {
 
+	/// streams that can be emulated
+	static const InputStreams emulated_streams[] = { IS_COLOR, IS_DEPTH, IS_INFRARED };
+
+	/// return index of single emulated stream or -1
+	static int get_stream_index(InputStreams is)
+	{
+		switch (is) {
+		case IS_COLOR: return 0;
+		case IS_DEPTH: return 1;
+		case IS_INFRARED: return 2;
+		default: return -1;
+		}
+	}
+
 	rgbd_emulation::rgbd_emulation(const std::string& fn)
 	{
-		file_name = fn;
-		flags = idx = 0;
+		fps = 30;
+		running = false;
+		attach(fn);
 	}
 
 	bool rgbd_emulation::attach(const std::string& fn)
 	{
 		file_name = fn;
 		flags = idx = 0;
+		recording.close();
+		if (is_recording_file_name(fn) && !recording.open(fn))
+			cerr << "rgbd_emulation::attach: could not open recording " << fn << endl;
+		rewind();
 		return true;
 	}
+	bool rgbd_emulation::find_stream_format(InputStreams is, frame_format& ff) const
+	{
+		static const PixelFormat color_formats[] = { PF_BGR, PF_BGRA, PF_RGB, PF_RGBA, PF_BAYER };
+		static const PixelFormat depth_formats[] = { PF_DEPTH, PF_DEPTH_AND_PLAYER };
+		static const PixelFormat infrared_formats[] = { PF_I };
+		const PixelFormat* pfs = color_formats;
+		unsigned nr_pfs = 5;
+		if (is == IS_DEPTH) {
+			pfs = depth_formats;
+			nr_pfs = 2;
+		}
+		else if (is == IS_INFRARED) {
+			pfs = infrared_formats;
+			nr_pfs = 1;
+		}
+		for (unsigned i = 0; i < nr_pfs; ++i) {
+			for (unsigned nr_bits = 8; nr_bits <= 32; nr_bits += 8) {
+				ff.pixel_format = pfs[i];
+				ff.nr_bits_per_pixel = nr_bits;
+				string fn = compose_file_name(file_name, ff, 0);
+				frame_type frame;
+				if (cgv::utils::file::exists(fn) && rgbd_input::read_frame(fn, frame)) {
+					ff = frame;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	void rgbd_emulation::rewind()
+	{
+		for (int si = 0; si < 3; ++si) {
+			if (recording.is_open())
+				has_format[si] = recording.get_frame_format(emulated_streams[si], formats[si]);
+			else
+				has_format[si] = !file_name.empty() && find_stream_format(emulated_streams[si], formats[si]);
+			frame_indices[si] = 0;
+			frame_times[si] = -1e10;
+		}
+	}
 	bool rgbd_emulation::is_attached() const
 	{
 		return !file_name.empty();
@@ -26,6 +88,7 @@ namespace rgbd {
 	
 	bool rgbd_emulation::detach()
 	{
+		recording.close();
 		file_name = "";
 		return true;
 	}
@@ -61,22 +124,29 @@ namespace rgbd {
 	}
 	void rgbd_emulation::query_stream_formats(InputStreams is, std::vector<stream_format>& stream_formats) const
 	{
-
+		for (int si = 0; si < 3; ++si)
+			if ((is & emulated_streams[si]) != 0 && has_format[si])
+				stream_formats.push_back(stream_format(formats[si].width, formats[si].height, formats[si].pixel_format,
+					fps, formats[si].nr_bits_per_pixel, formats[si].buffer_size));
 	}
 	bool rgbd_emulation::start_device(InputStreams is, std::vector<stream_format>& stream_formats)
 	{
-		return true;
+		rewind();
+		query_stream_formats(is, stream_formats);
+		return running = true;
 	}
 	bool rgbd_emulation::start_device(const std::vector<stream_format>& stream_formats)
 	{
-		return true;
+		rewind();
+		return running = true;
 	}
 	bool rgbd_emulation::is_running() const
 	{
-		return true; 
+		return running;
 	}
 	bool rgbd_emulation::stop_device()
 	{
+		running = false;
 		return true;
 	}
 	unsigned rgbd_emulation::get_width(InputStreams) const
@@ -89,19 +159,63 @@ namespace rgbd {
 	}
 	bool rgbd_emulation::get_frame(InputStreams is, frame_type& frame, int timeOut)
 	{	
-		string fn = compose_file_name(file_name, frame, frame.frame_index);
+		int si = get_stream_index(is);
+		if (!running || si == -1 || !has_format[si])
+			return false;
+		// deliver frames with frame rate of replay
+		double t = 1e-6 * chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+		if (t - frame_times[si] < 1.0 / fps)
+			return false;
+		if (recording.is_open()) {
+			if (frame_indices[si] >= recording.get_nr_frames(is))
+				frame_indices[si] = 0;
+			if (!recording.read_frame(is, frame_indices[si]++, frame))
+				return false;
+			frame_times[si] = t;
+			return true;
+		}
+		string fn = compose_file_name(file_name, formats[si], frame_indices[si]);
 		if (!cgv::utils::file::exists(fn)) {
-			idx = 0;
-			fn = compose_file_name(file_name, frame, 0);
+			frame_indices[si] = 0;
+			fn = compose_file_name(file_name, formats[si], 0);
 		}
-//		if (!rgbd_input::read_frame(fn, data_ptr, get_frame_size(ff)))
-//			return false;
+		if (!rgbd_input::read_frame(fn, frame))
+			return false;
+		frame.frame_index = frame_indices[si]++;
+		frame_times[si] = t;
 		return true;
 	}
+	bool rgbd_emulation::seek(double time)
+	{
+		if (!recording.is_open())
+			return false;
+		for (int si = 0; si < 3; ++si)
+			frame_indices[si] = unsigned(recording.find_frame(emulated_streams[si], time));
+		return true;
+	}
+	/// recorded color frames are not registered to the depth frames and only resampled to the depth resolution
 	void rgbd_emulation::map_color_to_depth(const frame_type& depth_frame, const frame_type& color_frame,
 		frame_type& warped_color_frame) const
 	{
-
+		static_cast<frame_format&>(warped_color_frame) = color_frame;
+		warped_color_frame.width = depth_frame.width;
+		warped_color_frame.height = depth_frame.height;
+		warped_color_frame.frame_index = depth_frame.frame_index;
+		warped_color_frame.time = depth_frame.time;
+		warped_color_frame.compute_buffer_size();
+		warped_color_frame.frame_data.resize(warped_color_frame.buffer_size);
+		unsigned entry_size = color_frame.nr_bits_per_pixel / 8;
+		if (!color_frame.is_allocated() || depth_frame.width <= 0 || depth_frame.height <= 0)
+			return;
+		char* dst_ptr = &warped_color_frame.frame_data.front();
+		for (int y = 0; y < depth_frame.height; ++y) {
+			int cy = y * color_frame.height / depth_frame.height;
+			for (int x = 0; x < depth_frame.width; ++x) {
+				int cx = x * color_frame.width / depth_frame.width;
+				memcpy(dst_ptr, &color_frame.frame_data[(cy * color_frame.width + cx) * entry_size], entry_size);
+				dst_ptr += entry_size;
+			}
+		}
 	}
 
 
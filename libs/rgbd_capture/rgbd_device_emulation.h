@@ -1,15 +1,22 @@
 #include "rgbd_device.h"
+#include "rgbd_recording.h"
 
 using namespace std;
 
 namespace rgbd {
 
+/** emulation device that replays frames recorded with the protocol of rgbd_input. If the file name has the
+    extension of recordings, frames are read from the recording file. Otherwise frame i of a stream is read from the
+	file composed of the base file name, the index i and the extension of the recorded frame format. Frames are
+	delivered with the frame rate fps and replay restarts at index 0 after the last recorded frame. */
 class rgbd_emulation : public rgbd_device
 {
 public:
 	string file_name;
 	unsigned idx;
 	unsigned flags;
+	/// frame rate of replay
+	float fps;
 
 	rgbd_emulation(const std::string& fn);
 
@@ -37,6 +44,21 @@ public:
 	bool get_frame(InputStreams is, frame_type& frame, int timeOut);
 	void map_color_to_depth(const frame_type& depth_frame, const frame_type& color_frame,
 		frame_type& warped_color_frame) const;
+	/// continue replay of a recording file at the frames of the given time and return false if replay is not from a recording file
+	bool seek(double time);
+protected:
+	bool running;
+	/// recording file or closed if frames are read from individual files
+	rgbd_recording recording;
+	/// per stream in the order color, depth, infrared the recorded format, next frame index and time of last frame
+	frame_format formats[3];
+	bool has_format[3];
+	unsigned frame_indices[3];
+	double frame_times[3];
+	/// find format of recorded stream by probing the extensions of the first frame file
+	bool find_stream_format(InputStreams is, frame_format& ff) const;
+	/// probe recorded formats and reset replay
+	void rewind();
 };
 
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include "rgbd_input.h"
 #include "rgbd_device_emulation.h"
 #include <cgv/utils/file.h>
@@ -101,6 +102,7 @@ rgbd_input::rgbd_input(const string& serial)
 
 bool rgbd_input::attach(const string& serial)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (is_attached())
 		detach();
 
@@ -125,6 +127,7 @@ const std::string& rgbd_input::get_serial() const
 
 bool rgbd_input::attach_path(const string& path)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (is_attached())
 		detach();
 	rgbd = new rgbd_emulation(path);
@@ -134,6 +137,7 @@ bool rgbd_input::attach_path(const string& path)
 
 bool rgbd_input::is_attached() const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (rgbd == 0)
 		return false;
 	return rgbd->is_attached();
@@ -141,6 +145,7 @@ bool rgbd_input::is_attached() const
 
 bool rgbd_input::detach()
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached())
 		return true;
 	if (is_started())
@@ -153,14 +158,20 @@ bool rgbd_input::detach()
 
 void rgbd_input::enable_protocol(const std::string& path)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	protocol_path = path;
 	protocol_idx  = 0;
 	protocol_flags = 0;
+	if (is_recording_file_name(path) && !recorder.open(path))
+		cerr << "rgbd_input::enable_protocol: could not create recording " << path << endl;
 }
 
 /// disable protocolation
 void rgbd_input::disable_protocol()
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
+	if (!recorder.close())
+		cerr << "rgbd_input::disable_protocol: could not write recording " << protocol_path << endl;
 	protocol_path = "";
 	protocol_idx  = 0;
 	protocol_flags = 0;
@@ -169,6 +180,7 @@ void rgbd_input::disable_protocol()
 
 bool rgbd_input::set_pitch(float y)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::set_pitch called on device that has not been attached to motor" << endl;
 		return false;
@@ -179,6 +191,7 @@ bool rgbd_input::set_pitch(float y)
 /// query the current measurement of the acceleration sensors 
 bool rgbd_input::put_IMU_measurement(IMU_measurement& m, unsigned time_out) const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::put_acceleration_measurements called on device that has not been attached" << endl;
 		return false;
@@ -188,6 +201,7 @@ bool rgbd_input::put_IMU_measurement(IMU_measurement& m, unsigned time_out) cons
 
 bool rgbd_input::check_input_stream_configuration(InputStreams is) const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::check_input_stream_configuration called on device that has not been attached" << endl;
 		return false;
@@ -197,6 +211,7 @@ bool rgbd_input::check_input_stream_configuration(InputStreams is) const
 /// query the stream formats available for a given stream configuration
 void rgbd_input::query_stream_formats(InputStreams is, std::vector<stream_format>& stream_formats) const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::query_stream_formats called on device that has not been attached" << endl;
 		return;
@@ -206,6 +221,7 @@ void rgbd_input::query_stream_formats(InputStreams is, std::vector<stream_format
 
 bool rgbd_input::start(InputStreams is, std::vector<stream_format>& stream_formats)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::start called on device that has not been attached" << endl;
 		return false;
@@ -217,6 +233,7 @@ bool rgbd_input::start(InputStreams is, std::vector<stream_format>& stream_forma
 
 bool rgbd_input::start(const std::vector<stream_format>& stream_formats)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::start called on device that has not been attached" << endl;
 		return false;
@@ -228,11 +245,13 @@ bool rgbd_input::start(const std::vector<stream_format>& stream_formats)
 
 bool rgbd_input::is_started() const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	return started;
 }
 
 bool rgbd_input::stop()
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::stop called on device that has not been attached" << endl;
 		return false;
@@ -244,6 +263,7 @@ bool rgbd_input::stop()
 
 bool rgbd_input::set_near_mode(bool on)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::set_near_mode called on device that has not been attached" << endl;
 		return false;
@@ -254,6 +274,7 @@ bool rgbd_input::set_near_mode(bool on)
 
 bool rgbd_input::get_frame(InputStreams is, frame_type& frame, int timeOut)
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::get_frame called on device that has not been attached" << endl;
 		return false;
@@ -263,9 +284,20 @@ bool rgbd_input::get_frame(InputStreams is, frame_type& frame, int timeOut)
 		return false;
 	}
 	if (rgbd->get_frame(is, frame, timeOut)) {
-		if (!protocol_path.empty()) {
-			string fn = compose_file_name(protocol_path, frame, frame.frame_index);
-			if (!cgv::utils::file::write(fn, &frame.frame_data.front(), frame.frame_data.size(), false))
+		if (recorder.is_open()) {
+			if (!recorder.write_frame(is, frame))
+				std::cerr << "rgbd_input::get_frame: could not record frame to " << protocol_path << std::endl;
+		}
+		else if (!protocol_path.empty()) {
+			// start next protocol index as soon as a stream delivers its second frame for the current index
+			if ((protocol_flags & is) != 0) {
+				++protocol_idx;
+				protocol_flags = 0;
+			}
+			protocol_flags |= is;
+			// save frames with header such that they can be replayed with rgbd_emulation
+			string fn = compose_file_name(protocol_path, frame, protocol_idx);
+			if (!write_frame(fn, frame))
 				std::cerr << "rgbd_input::get_frame: could not protocol frame to " << fn << std::endl;
 		}
 		return true;
@@ -277,6 +309,7 @@ bool rgbd_input::get_frame(InputStreams is, frame_type& frame, int timeOut)
 void rgbd_input::map_color_to_depth(const frame_type& depth_frame, const frame_type& color_frame,
 	frame_type& warped_color_frame) const
 {
+	std::lock_guard<std::recursive_mutex> lock(device_mutex);
 	if (!is_attached()) {
 		cerr << "rgbd_input::map_color_to_depth called on device that has not been attached" << endl;
 		return;
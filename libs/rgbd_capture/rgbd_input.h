@@ -1,6 +1,8 @@
 #pragma once
 
 #include "rgbd_driver.h"
+#include "rgbd_recording.h"
+#include <mutex>
 
 #include "lib_begin.h"
 
@@ -8,7 +10,8 @@ namespace rgbd {
 
 /** interface to provided access to rgbd devices. This is independent of device driver. 
     Different plugins can implement the rgbd_driver and rgbd_device classes and seemlessly
-	integrate into the rgbd_input class. */
+	integrate into the rgbd_input class. Calls to the attached device are serialized, such that for example frames
+	can be mapped in a background thread while another thread queries new frames. */
 class CGV_API rgbd_input
 {
 public:
@@ -58,7 +61,7 @@ public:
 	static bool write_frame(const std::string& file_name, const frame_type& frame);
 	/// attach to a directory that contains saved frames
 	bool attach_path(const std::string& path);
-	/// enable protocolation of all frames acquired by the attached rgbd input device
+	/// enable protocolation of all frames acquired by the attached rgbd input device into individual files with the given base name or into a single recording file if path has the recording extension
 	void enable_protocol(const std::string& path);
 	/// disable protocolation
 	void disable_protocol();
@@ -106,6 +109,10 @@ protected:
 	int protocol_idx;
 	/// flags used to determine which frames have been saved to file for current index
 	unsigned protocol_flags;
+	/// recorder used if protocol path has recording extension
+	rgbd_recorder recorder;
+	/// serializes access to the device, where public methods call each other while holding the lock
+	mutable std::recursive_mutex device_mutex;
 };
 
 /// helper template to register a driver
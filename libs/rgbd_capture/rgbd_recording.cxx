@@ -0,0 +1,446 @@
+#include "rgbd_recording.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+#pragma warning(disable:4996)
+
+namespace rgbd {
+
+	/// "RGBR" as little endian 32 bit integer at start of recording files
+	static const uint32_t recording_magic = 0x52424752;
+	static const uint32_t recording_version = 1;
+	/// "RIDX" as little endian 32 bit integer at end of footer
+	static const uint32_t index_magic = 0x58444952;
+
+	/// footer at end of closed recording
+	struct recording_footer
+	{
+		uint64_t index_offset;
+		uint32_t nr_records;
+		uint32_t magic;
+	};
+
+	/// seek to 64 bit file offset
+	static bool seek_64(FILE* fp, uint64_t offset)
+	{
+#ifdef _MSC_VER
+		return _fseeki64(fp, __int64(offset), SEEK_SET) == 0;
+#else
+		return fseeko(fp, off_t(offset), SEEK_SET) == 0;
+#endif
+	}
+
+	/// return 64 bit file size
+	static uint64_t get_file_size_64(FILE* fp)
+	{
+#ifdef _MSC_VER
+		_fseeki64(fp, 0, SEEK_END);
+		return uint64_t(_ftelli64(fp));
+#else
+		fseeko(fp, 0, SEEK_END);
+		return uint64_t(ftello(fp));
+#endif
+	}
+
+	/// return index of single recorded stream or -1
+	static int get_recorded_stream_index(InputStreams is)
+	{
+		switch (is) {
+		case IS_COLOR: return 0;
+		case IS_DEPTH: return 1;
+		case IS_INFRARED: return 2;
+		default: return -1;
+		}
+	}
+
+	/// transform frame data into differences that compress well
+	static void encode_differences(const frame_format& ff, const char* data, size_t n, std::vector<char>& out)
+	{
+		out.resize(n);
+		unsigned char* dst = reinterpret_cast<unsigned char*>(out.data());
+		if (ff.nr_bits_per_pixel == 16 && (n & 1) == 0) {
+			// zig-zag coded difference to left neighbor split into low and high byte plane
+			const uint16_t* src = reinterpret_cast<const uint16_t*>(data);
+			size_t N = n / 2, w = ff.width > 0 && size_t(ff.width) * ff.height == N ? ff.width : N;
+			for (size_t i = 0; i < N; ++i) {
+				int16_t d = int16_t(src[i] - (i % w == 0 ? 0 : src[i - 1]));
+				uint16_t z = uint16_t((uint16_t(d) << 1) ^ uint16_t(d >> 15));
+				dst[i] = uint8_t(z);
+				dst[N + i] = uint8_t(z >> 8);
+			}
+		}
+		else {
+			// byte wise difference to same channel of left pixel
+			const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+			size_t stride = std::max(1u, ff.nr_bits_per_pixel / 8);
+			for (size_t i = 0; i < std::min(stride, n); ++i)
+				dst[i] = src[i];
+			for (size_t i = stride; i < n; ++i)
+				dst[i] = uint8_t(src[i] - src[i - stride]);
+		}
+	}
+
+	/// invert encode_differences
+	static void decode_differences(const frame_format& ff, const std::vector<char>& in, char* data, size_t n)
+	{
+		const unsigned char* src = reinterpret_cast<const unsigned char*>(in.data());
+		if (ff.nr_bits_per_pixel == 16 && (n & 1) == 0) {
+			uint16_t* dst = reinterpret_cast<uint16_t*>(data);
+			size_t N = n / 2, w = ff.width > 0 && size_t(ff.width) * ff.height == N ? ff.width : N;
+			for (size_t i = 0; i < N; ++i) {
+				uint16_t z = uint16_t(src[i] | (src[N + i] << 8));
+				uint16_t d = uint16_t((z >> 1) ^ (0 - (z & 1)));
+				dst[i] = uint16_t(d + (i % w == 0 ? 0 : dst[i - 1]));
+			}
+		}
+		else {
+			unsigned char* dst = reinterpret_cast<unsigned char*>(data);
+			size_t stride = std::max(1u, ff.nr_bits_per_pixel / 8);
+			for (size_t i = 0; i < std::min(stride, n); ++i)
+				dst[i] = src[i];
+			for (size_t i = stride; i < n; ++i)
+				dst[i] = uint8_t(src[i] + dst[i - stride]);
+		}
+	}
+
+	const char* get_recording_extension()
+	{
+		return "rgbdr";
+	}
+
+	bool is_recording_file_name(const std::string& file_name)
+	{
+		std::string ext = std::string(".") + get_recording_extension();
+		return file_name.size() > ext.size() && file_name.compare(file_name.size() - ext.size(), ext.size(), ext) == 0;
+	}
+
+	double rgbd_recorder::statistics::get_compression_ratio() const
+	{
+		return nr_raw_bytes == 0 ? 1.0 : double(nr_compressed_bytes) / nr_raw_bytes;
+	}
+
+	rgbd_recorder::rgbd_recorder()
+	{
+		fp = 0;
+		compress_color = false;
+		max_nr_queued_frames = 8;
+		chunk_size = 4194304;
+		stop_encoding = false;
+		write_failed = false;
+		chunk_offset = 0;
+		stats.nr_frames = stats.nr_raw_bytes = stats.nr_compressed_bytes = 0;
+	}
+
+	rgbd_recorder::~rgbd_recorder()
+	{
+		close();
+		for (auto f : free_frames)
+			delete f;
+	}
+
+	bool rgbd_recorder::open(const std::string& file_name, bool _compress_color, size_t _max_nr_queued_frames, size_t _chunk_size)
+	{
+		close();
+		fp = fopen(file_name.c_str(), "wb");
+		if (!fp)
+			return false;
+		uint32_t header[2] = { recording_magic, recording_version };
+		if (fwrite(header, sizeof(uint32_t), 2, fp) != 2) {
+			fclose(fp);
+			fp = 0;
+			return false;
+		}
+		compress_color = _compress_color;
+		max_nr_queued_frames = std::max(size_t(1), _max_nr_queued_frames);
+		chunk_size = _chunk_size;
+		chunk_offset = sizeof(header);
+		chunk.clear();
+		index.clear();
+		stop_encoding = false;
+		write_failed = false;
+		stats.nr_frames = stats.nr_raw_bytes = stats.nr_compressed_bytes = 0;
+		encoder = std::thread(&rgbd_recorder::encode_frames, this);
+		return true;
+	}
+
+	bool rgbd_recorder::write_frame(InputStreams is, const frame_type& frame)
+	{
+		if (!fp || get_recorded_stream_index(is) == -1 || frame.frame_data.size() != frame.buffer_size)
+			return false;
+		frame_type* f;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			queue_changed.wait(lock, [this]() { return queue.size() < max_nr_queued_frames; });
+			if (write_failed)
+				return false;
+			if (free_frames.empty())
+				f = new frame_type;
+			else {
+				f = free_frames.back();
+				free_frames.pop_back();
+			}
+		}
+		// copy outside of lock into reused frame buffer
+		*f = frame;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			// encoder might have stopped due to a write error during the copy
+			if (write_failed) {
+				free_frames.push_back(f);
+				return false;
+			}
+			queue.push_back(std::make_pair(is, f));
+		}
+		queue_changed.notify_all();
+		return true;
+	}
+
+	bool rgbd_recorder::flush_chunk()
+	{
+		if (chunk.empty())
+			return true;
+		bool success = fwrite(chunk.data(), 1, chunk.size(), fp) == chunk.size();
+		chunk_offset += chunk.size();
+		chunk.clear();
+		return success;
+	}
+
+	void rgbd_recorder::encode_frames()
+	{
+		std::vector<char> differences;
+		for (;;) {
+			std::pair<InputStreams, frame_type*> job;
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				queue_changed.wait(lock, [this]() { return stop_encoding || write_failed || !queue.empty(); });
+				// after a write error queued frames are discarded and waiting writers are released
+				if (write_failed) {
+					for (const auto& j : queue)
+						free_frames.push_back(j.second);
+					queue.clear();
+				}
+				if (queue.empty()) {
+					lock.unlock();
+					queue_changed.notify_all();
+					return;
+				}
+				job = queue.front();
+				queue.pop_front();
+			}
+			queue_changed.notify_all();
+			const frame_type& frame = *job.second;
+			frame_record fr;
+			fr.stream = job.first;
+			fr.width = frame.width;
+			fr.height = frame.height;
+			fr.pixel_format = frame.pixel_format;
+			fr.nr_bits_per_pixel = frame.nr_bits_per_pixel;
+			fr.buffer_size = frame.buffer_size;
+			fr.frame_index = frame.frame_index;
+			fr.time = frame.time;
+			fr.reserved = 0;
+			// compress directly into chunk behind the record and fall back to raw data if compression does not pay off
+			size_t record_pos = chunk.size();
+			size_t data_pos = record_pos + sizeof(frame_record);
+			fr.offset = chunk_offset + data_pos;
+			fr.codec = RC_RAW;
+			fr.size = fr.buffer_size;
+			if (job.first != IS_COLOR || compress_color) {
+				encode_differences(frame, frame.frame_data.data(), frame.buffer_size, differences);
+				uLongf size = compressBound(uLong(frame.buffer_size));
+				chunk.resize(data_pos + size);
+				if (compress2(reinterpret_cast<Bytef*>(&chunk[data_pos]), &size,
+					reinterpret_cast<const Bytef*>(differences.data()), uLong(frame.buffer_size), Z_BEST_SPEED) == Z_OK && size < frame.buffer_size) {
+					fr.codec = RC_DELTA_DEFLATE;
+					fr.size = uint32_t(size);
+				}
+			}
+			chunk.resize(data_pos + fr.size);
+			if (fr.codec == RC_RAW && fr.size > 0)
+				std::memcpy(&chunk[data_pos], frame.frame_data.data(), fr.size);
+			std::memcpy(&chunk[record_pos], &fr, sizeof(frame_record));
+			index.push_back(fr);
+			bool success = chunk.size() < chunk_size || flush_chunk();
+			std::lock_guard<std::mutex> lock(mtx);
+			if (!success)
+				write_failed = true;
+			++stats.nr_frames;
+			stats.nr_raw_bytes += fr.buffer_size;
+			stats.nr_compressed_bytes += fr.size;
+			free_frames.push_back(job.second);
+		}
+	}
+
+	bool rgbd_recorder::close()
+	{
+		if (!fp)
+			return true;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stop_encoding = true;
+		}
+		queue_changed.notify_all();
+		encoder.join();
+		bool success = !write_failed && flush_chunk();
+		recording_footer footer;
+		footer.index_offset = chunk_offset;
+		footer.nr_records = uint32_t(index.size());
+		footer.magic = index_magic;
+		success = success &&
+			(index.empty() || fwrite(index.data(), sizeof(frame_record), index.size(), fp) == index.size()) &&
+			fwrite(&footer, sizeof(recording_footer), 1, fp) == 1;
+		success = fclose(fp) == 0 && success;
+		fp = 0;
+		return success;
+	}
+
+	rgbd_recorder::statistics rgbd_recorder::get_statistics()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return stats;
+	}
+
+	rgbd_recording::rgbd_recording()
+	{
+		fp = 0;
+	}
+
+	rgbd_recording::~rgbd_recording()
+	{
+		close();
+	}
+
+	bool rgbd_recording::open(const std::string& file_name)
+	{
+		close();
+		fp = fopen(file_name.c_str(), "rb");
+		if (!fp)
+			return false;
+		uint32_t header[2];
+		if (fread(header, sizeof(uint32_t), 2, fp) != 2 || header[0] != recording_magic || header[1] > recording_version || !read_index()) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	bool rgbd_recording::read_index()
+	{
+		std::vector<frame_record> index;
+		uint64_t file_size = get_file_size_64(fp);
+		recording_footer footer;
+		if (file_size >= 8 + sizeof(recording_footer) && seek_64(fp, file_size - sizeof(recording_footer)) &&
+			fread(&footer, sizeof(recording_footer), 1, fp) == 1 && footer.magic == index_magic &&
+			footer.index_offset + uint64_t(footer.nr_records) * sizeof(frame_record) + sizeof(recording_footer) == file_size) {
+			index.resize(footer.nr_records);
+			if (!seek_64(fp, footer.index_offset) ||
+				(footer.nr_records > 0 && fread(index.data(), sizeof(frame_record), index.size(), fp) != index.size()))
+				return false;
+		}
+		else {
+			// recording has not been closed properly, such that records are scanned till first incomplete frame
+			uint64_t pos = 8;
+			frame_record fr;
+			while (seek_64(fp, pos) && fread(&fr, sizeof(frame_record), 1, fp) == 1 &&
+				get_recorded_stream_index(InputStreams(fr.stream)) != -1 &&
+				fr.offset == pos + sizeof(frame_record) && fr.offset + fr.size <= file_size) {
+				index.push_back(fr);
+				pos = fr.offset + fr.size;
+			}
+		}
+		for (const auto& fr : index) {
+			int si = get_recorded_stream_index(InputStreams(fr.stream));
+			if (si != -1)
+				records[si].push_back(fr);
+		}
+		for (int si = 0; si < 3; ++si)
+			std::stable_sort(records[si].begin(), records[si].end(),
+				[](const frame_record& r0, const frame_record& r1) { return r0.time < r1.time; });
+		return true;
+	}
+
+	void rgbd_recording::close()
+	{
+		if (fp)
+			fclose(fp);
+		fp = 0;
+		for (int si = 0; si < 3; ++si)
+			records[si].clear();
+	}
+
+	size_t rgbd_recording::get_nr_frames(InputStreams is) const
+	{
+		int si = get_recorded_stream_index(is);
+		return si == -1 ? 0 : records[si].size();
+	}
+
+	const frame_record& rgbd_recording::get_record(InputStreams is, size_t i) const
+	{
+		return records[get_recorded_stream_index(is)][i];
+	}
+
+	bool rgbd_recording::get_frame_format(InputStreams is, frame_format& ff) const
+	{
+		if (get_nr_frames(is) == 0)
+			return false;
+		const frame_record& fr = get_record(is, 0);
+		ff.width = fr.width;
+		ff.height = fr.height;
+		ff.pixel_format = PixelFormat(fr.pixel_format);
+		ff.nr_bits_per_pixel = fr.nr_bits_per_pixel;
+		ff.buffer_size = fr.buffer_size;
+		return true;
+	}
+
+	size_t rgbd_recording::find_frame(InputStreams is, double time) const
+	{
+		size_t n = get_nr_frames(is);
+		if (n == 0)
+			return 0;
+		const std::vector<frame_record>& R = records[get_recorded_stream_index(is)];
+		double t0 = R.front().time, t1 = R.back().time;
+		if (time <= t0)
+			return 0;
+		if (time >= t1)
+			return n - 1;
+		// interpolate position and correct by walking to neighbors
+		size_t i = std::min(n - 1, size_t((time - t0) / (t1 - t0) * (n - 1)));
+		while (i + 1 < n && R[i + 1].time <= time)
+			++i;
+		while (i > 0 && R[i].time > time)
+			--i;
+		return i;
+	}
+
+	bool rgbd_recording::read_frame(InputStreams is, size_t i, frame_type& frame)
+	{
+		if (!fp || i >= get_nr_frames(is))
+			return false;
+		const frame_record& fr = get_record(is, i);
+		frame.width = fr.width;
+		frame.height = fr.height;
+		frame.pixel_format = PixelFormat(fr.pixel_format);
+		frame.nr_bits_per_pixel = fr.nr_bits_per_pixel;
+		frame.buffer_size = fr.buffer_size;
+		frame.frame_index = fr.frame_index;
+		frame.time = fr.time;
+		frame.frame_data.resize(fr.buffer_size);
+		if (!seek_64(fp, fr.offset))
+			return false;
+		if (fr.codec == RC_RAW)
+			return fr.size == fr.buffer_size && (fr.size == 0 || fread(frame.frame_data.data(), 1, fr.size, fp) == fr.size);
+		if (fr.codec != RC_DELTA_DEFLATE)
+			return false;
+		buffer.resize(fr.size);
+		if (fr.size > 0 && fread(buffer.data(), 1, fr.size, fp) != fr.size)
+			return false;
+		differences.resize(fr.buffer_size);
+		uLongf size = fr.buffer_size;
+		if (uncompress(reinterpret_cast<Bytef*>(differences.data()), &size, reinterpret_cast<const Bytef*>(buffer.data()), fr.size) != Z_OK ||
+			size != fr.buffer_size)
+			return false;
+		decode_differences(frame, differences, frame.frame_data.data(), fr.buffer_size);
+		return true;
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "rgbd_device.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "lib_begin.h"
+
+namespace rgbd {
+
+	/// compression of frames in a recording
+	enum RecordingCodec {
+		RC_RAW,
+		/// 16 bit frames are stored as zig-zag coded differences to the left neighbor in two byte planes and other frames as byte wise differences to the left pixel, both followed by deflate
+		RC_DELTA_DEFLATE
+	};
+
+	/** description of a frame in a recording, which precedes the compressed frame data in the file and is repeated in
+	    the frame index at the end of the file */
+	struct frame_record
+	{
+		/// single input stream of frame
+		uint32_t stream;
+		/// codec of frame data
+		uint32_t codec;
+		int32_t width, height;
+		uint32_t pixel_format;
+		uint32_t nr_bits_per_pixel;
+		/// size of uncompressed frame data
+		uint32_t buffer_size;
+		uint32_t frame_index;
+		double time;
+		/// position of compressed frame data in file
+		uint64_t offset;
+		/// size of compressed frame data
+		uint32_t size;
+		uint32_t reserved;
+	};
+
+	/// return the preferred extension of recording files
+	extern CGV_API const char* get_recording_extension();
+	/// return whether file name has the extension of recording files
+	extern CGV_API bool is_recording_file_name(const std::string& file_name);
+
+	/** writer of single file recordings, which hands frames to a background encoder thread that compresses them and
+	    writes them in chunks of several frames. The file starts with a magic number, followed by a frame_record and
+		the compressed data of each frame. On close the frame index of all records is appended together with a footer
+		holding the index position. */
+	class CGV_API rgbd_recorder
+	{
+	public:
+		/// statistics of recorder
+		struct statistics
+		{
+			/// number of written frames
+			size_t nr_frames;
+			/// number of uncompressed and compressed bytes of written frames
+			size_t nr_raw_bytes, nr_compressed_bytes;
+			/// return ratio of compressed to uncompressed size
+			double get_compression_ratio() const;
+		};
+	protected:
+		FILE* fp;
+		bool compress_color;
+		size_t max_nr_queued_frames, chunk_size;
+		/// queued frames with their stream and frame buffers for reuse
+		std::deque<std::pair<InputStreams, frame_type*> > queue;
+		std::vector<frame_type*> free_frames;
+		bool stop_encoding;
+		/// set by the encoder on a write error, after which it stops and further frames are refused
+		bool write_failed;
+		std::thread encoder;
+		std::mutex mtx;
+		std::condition_variable queue_changed;
+		/// chunk of encoded records and file position of chunk
+		std::vector<char> chunk;
+		uint64_t chunk_offset;
+		std::vector<frame_record> index;
+		statistics stats;
+		/// write chunk to file
+		bool flush_chunk();
+		/// thread function of encoder
+		void encode_frames();
+	public:
+		/// construct closed recorder
+		rgbd_recorder();
+		/// close recorder
+		~rgbd_recorder();
+		/** create recording file, where depth and infrared frames are always compressed losslessly and color frames only
+		    if compress_color is true. Frames are written in chunks of about chunk_size bytes. */
+		bool open(const std::string& file_name, bool _compress_color = false, size_t _max_nr_queued_frames = 8, size_t _chunk_size = 4194304);
+		/// return whether recorder is open
+		bool is_open() const { return fp != 0; }
+		/// queue a copy of the frame of the given single stream for encoding and wait if max_nr_queued_frames are queued; return false if writing failed
+		bool write_frame(InputStreams is, const frame_type& frame);
+		/// encode all queued frames, write the frame index and close file
+		bool close();
+		/// return statistics
+		statistics get_statistics();
+	};
+
+	/** reader of recordings written with rgbd_recorder. The frame index is read on open and rebuilt by scanning the
+	    records if the recording was not closed properly. Per stream the frames are sorted by time, such that
+		find_frame locates the frame of a timestamp by interpolation between the first and last timestamp, which
+		only needs a constant number of steps for recordings with approximately constant frame rate. */
+	class CGV_API rgbd_recording
+	{
+	protected:
+		FILE* fp;
+		/// per stream in the order color, depth, infrared the sorted records of the stream
+		std::vector<frame_record> records[3];
+		/// buffers of compressed frame data and decompressed differences
+		std::vector<char> buffer, differences;
+		/// read index from footer or by scanning the records
+		bool read_index();
+	public:
+		/// construct closed recording
+		rgbd_recording();
+		/// close recording
+		~rgbd_recording();
+		/// open recording and read its frame index
+		bool open(const std::string& file_name);
+		/// return whether recording is open
+		bool is_open() const { return fp != 0; }
+		/// close recording
+		void close();
+		/// return number of frames of a single stream
+		size_t get_nr_frames(InputStreams is) const;
+		/// return the record of the i-th frame of a single stream
+		const frame_record& get_record(InputStreams is, size_t i) const;
+		/// return format of first frame of a single stream and false if stream was not recorded
+		bool get_frame_format(InputStreams is, frame_format& ff) const;
+		/// return index of last frame of a single stream with time not after the given time or 0 if time is before the first frame
+		size_t find_frame(InputStreams is, double time) const;
+		/// read and decompress the i-th frame of a single stream
+		bool read_frame(InputStreams is, size_t i, frame_type& frame);
+	};
+}
+
+#include <cgv/config/lib_end.h>
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "streaming_time_series.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace stream_vis {
+
+	/** bounded lock-free queue of indexed value batches with multiple producers and a single consumer. Each batch
+	    consists of up to max_batch_size indexed values with a common timestamp and occupies one slot of a ring with a
+		power of two capacity. A producer claims a slot with a single compare and swap on the enqueue position, copies its
+		values and publishes the slot through the sequence number of the slot. Producers never wait for the consumer: if
+		the ring is full, the batch is dropped, and batches with more than max_batch_size values are rejected as overflow.
+		Resizing and draining must be done from the consumer thread. Once the first batch has been pushed, the ring has a
+		fixed size and resizing fails, such that producers never see a reallocated ring. */
+	class indexed_value_queue
+	{
+	public:
+		/// counters of queue
+		struct statistics
+		{
+			/// number of batches that have been pushed successfully
+			size_t nr_pushed_batches;
+			/// number of batches dropped because the queue was full
+			size_t nr_dropped_batches;
+			/// number of batches rejected because they exceeded the maximum batch size
+			size_t nr_overflow_batches;
+			/// number of batches handed to the consumer
+			size_t nr_drained_batches;
+			/// number of batches currently in queue
+			size_t get_nr_queued_batches() const { return nr_pushed_batches - nr_drained_batches; }
+		};
+	protected:
+		/// ring slot, whose sequence number equals the position of the next push into the slot if free and position + 1 if filled
+		struct slot
+		{
+			std::atomic<size_t> sequence;
+			double timestamp;
+			uint16_t num_values;
+		};
+		/// whether the ring can be resized, is currently resized, or has a fixed size because producers started pushing
+		enum ResizeState { RS_RESIZABLE, RS_RESIZING, RS_FIXED };
+		std::atomic<int> resize_state;
+		size_t capacity;
+		uint16_t max_batch_size;
+		std::unique_ptr<slot[]> slots;
+		/// values of all slots with max_batch_size values per slot
+		std::vector<indexed_value> values;
+		/// padding that keeps the producer and consumer positions in separate cache lines
+		char padding_producer[64];
+		/// position of next push, which also counts successful pushes
+		std::atomic<size_t> enqueue_pos;
+		std::atomic<size_t> nr_dropped_batches;
+		std::atomic<size_t> nr_overflow_batches;
+		char padding_consumer[64];
+		/// position of next drained slot, only written by the consumer
+		std::atomic<size_t> dequeue_pos;
+	public:
+		/// construct queue with capacity rounded up to power of two
+		indexed_value_queue(size_t _capacity = 4096, uint16_t _max_batch_size = 64) : resize_state(RS_RESIZABLE), capacity(0), max_batch_size(0), enqueue_pos(0), nr_dropped_batches(0), nr_overflow_batches(0), dequeue_pos(0)
+		{
+			resize(_capacity, _max_batch_size);
+		}
+		/// reallocate ring from the consumer thread and return false without changing the ring once a batch has been pushed
+		bool resize(size_t _capacity, uint16_t _max_batch_size)
+		{
+			int state = RS_RESIZABLE;
+			if (!resize_state.compare_exchange_strong(state, RS_RESIZING, std::memory_order_acquire))
+				return false;
+			capacity = 1;
+			while (capacity < _capacity)
+				capacity *= 2;
+			max_batch_size = _max_batch_size;
+			slots.reset(new slot[capacity]);
+			values.resize(capacity * max_batch_size);
+			size_t pos = enqueue_pos.load();
+			for (size_t i = 0; i < capacity; ++i)
+				slots[(pos + i) & (capacity - 1)].sequence.store(pos + i);
+			dequeue_pos.store(pos);
+			resize_state.store(RS_RESIZABLE, std::memory_order_release);
+			return true;
+		}
+		/// return whether the ring can still be resized because no batch has been pushed yet
+		bool is_resizable() const { return resize_state.load(std::memory_order_acquire) == RS_RESIZABLE; }
+		/// return number of slots
+		size_t get_capacity() const { return capacity; }
+		/// return maximum number of values per batch
+		uint16_t get_max_batch_size() const { return max_batch_size; }
+		/// push a batch of values with a common timestamp from any thread without blocking and return false if batch was dropped
+		bool push(uint16_t num_values, const indexed_value* batch_values, double timestamp)
+		{
+			if (num_values > max_batch_size) {
+				nr_overflow_batches.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			if (try_push(num_values, batch_values, timestamp))
+				return true;
+			nr_dropped_batches.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		/// push a batch of at most max_batch_size values and return false without counting a drop if queue is full, such that producers can retry later
+		bool try_push(uint16_t num_values, const indexed_value* batch_values, double timestamp)
+		{
+			// the first push fixes the size of the ring, where a push during a concurrent resize finds the queue full
+			int state = resize_state.load(std::memory_order_acquire);
+			while (state == RS_RESIZABLE && !resize_state.compare_exchange_weak(state, RS_FIXED, std::memory_order_acquire))
+				;
+			if (state == RS_RESIZING)
+				return false;
+			size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+			slot* s;
+			for (;;) {
+				s = &slots[pos & (capacity - 1)];
+				size_t seq = s->sequence.load(std::memory_order_acquire);
+				if (seq == pos) {
+					if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				// slot still holds a batch of the previous round, i.e. queue is full
+				else if (ptrdiff_t(seq - pos) < 0)
+					return false;
+				// other producer claimed slot
+				else
+					pos = enqueue_pos.load(std::memory_order_relaxed);
+			}
+			s->timestamp = timestamp;
+			s->num_values = num_values;
+			if (num_values > 0)
+				std::memcpy(values.data() + (pos & (capacity - 1)) * max_batch_size, batch_values, num_values * sizeof(indexed_value));
+			s->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+		/** call f(num_values, values, timestamp) for the queued batches in push order from the consumer thread and free
+		    their slots. At most max_nr_batches are drained such that producers that keep pushing cannot stall the consumer.
+			Return the number of drained batches. */
+		template <typename F>
+		size_t drain(F f, size_t max_nr_batches = size_t(-1))
+		{
+			size_t pos = dequeue_pos.load(std::memory_order_relaxed), n = 0;
+			while (n < max_nr_batches) {
+				slot& s = slots[pos & (capacity - 1)];
+				if (s.sequence.load(std::memory_order_acquire) != pos + 1)
+					break;
+				f(s.num_values, values.data() + (pos & (capacity - 1)) * max_batch_size, s.timestamp);
+				s.sequence.store(pos + capacity, std::memory_order_release);
+				++pos;
+				++n;
+			}
+			dequeue_pos.store(pos, std::memory_order_relaxed);
+			return n;
+		}
+		/// return counters, which can be called from any thread
+		statistics get_statistics() const
+		{
+			statistics stats;
+			stats.nr_drained_batches = dequeue_pos.load(std::memory_order_relaxed);
+			stats.nr_pushed_batches = enqueue_pos.load(std::memory_order_relaxed);
+			stats.nr_dropped_batches = nr_dropped_batches.load(std::memory_order_relaxed);
+			stats.nr_overflow_batches = nr_overflow_batches.load(std::memory_order_relaxed);
+			return stats;
+		}
+	};
+}
@@ -0,0 +1,360 @@
+#include "socket_stream.h"
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+namespace stream_vis {
+
+	using namespace socket_stream_protocol;
+
+	static_assert(sizeof(indexed_value) == value_size, "frames are decoded in place and require packed indexed values");
+
+	socket_stream_statistics::socket_stream_statistics()
+	{
+		connected = false;
+		nr_frames = nr_values = nr_bytes = nr_invalid_frames = nr_dropped_frames = nr_stalls = 0;
+		elapsed_seconds = stall_seconds = 0;
+	}
+	void socket_stream_statistics::add(const socket_stream_statistics& s)
+	{
+		connected = connected || s.connected;
+		nr_frames += s.nr_frames;
+		nr_values += s.nr_values;
+		nr_bytes += s.nr_bytes;
+		nr_invalid_frames += s.nr_invalid_frames;
+		nr_dropped_frames += s.nr_dropped_frames;
+		nr_stalls += s.nr_stalls;
+		elapsed_seconds = std::max(elapsed_seconds, s.elapsed_seconds);
+		stall_seconds += s.stall_seconds;
+	}
+	double socket_stream_statistics::get_values_per_second() const
+	{
+		return elapsed_seconds > 0 ? nr_values / elapsed_seconds : 0.0;
+	}
+	double socket_stream_statistics::get_megabytes_per_second() const
+	{
+		return elapsed_seconds > 0 ? nr_bytes / (1048576.0 * elapsed_seconds) : 0.0;
+	}
+
+	socket_stream_connection::socket_stream_connection(stream_vis_context& _ctx, bool _backpressure)
+		: ctx(_ctx), backpressure(_backpressure), connected(true),
+		  nr_frames(0), nr_values(0), nr_bytes(0), nr_invalid_frames(0), nr_dropped_frames(0), nr_stalls(0),
+		  stall_microseconds(0), elapsed_microseconds(0)
+	{
+		start_time = std::chrono::steady_clock::now();
+		nr_inputs = std::min(ctx.get_first_composed_index(), ctx.get_nr_time_series());
+		max_frame_size = std::max(size_t(262144), get_frame_size(ctx.get_max_batch_size()));
+		stalled = false;
+		retry_timer = 0;
+	}
+	void socket_stream_connection::send_hello(cgv::os::socket_connection& c)
+	{
+		std::vector<char> msg(hello_size);
+		uint16_t nr = uint16_t(nr_inputs), max_batch_size = ctx.get_max_batch_size();
+		std::memcpy(&msg[0], &magic, 4);
+		std::memcpy(&msg[4], &version, 2);
+		std::memcpy(&msg[6], &nr, 2);
+		std::memcpy(&msg[8], &max_batch_size, 2);
+		for (size_t i = 0; i < nr_inputs; ++i) {
+			const streaming_time_series& ts = ctx.get_time_series(i);
+			uint16_t type_id = uint16_t(ts.get_value_type_id()), length = uint16_t(ts.get_name().length());
+			size_t pos = msg.size();
+			msg.resize(pos + declaration_size + length);
+			std::memcpy(&msg[pos], &type_id, 2);
+			std::memcpy(&msg[pos + 2], &length, 2);
+			std::memcpy(&msg[pos + declaration_size], ts.get_name().c_str(), length);
+		}
+		c.send(&msg[0], msg.size());
+	}
+	bool socket_stream_connection::push_frame(uint16_t num_values, const indexed_value* values, double timestamp, socket_stream_statistics& delta)
+	{
+		// a retried frame has been counted already
+		if (!stalled)
+			++delta.nr_frames;
+		bool valid = num_values <= ctx.get_max_batch_size();
+		for (uint16_t vi = 0; valid && vi < num_values; ++vi)
+			if (values[vi].index >= nr_inputs)
+				valid = false;
+		if (!valid) {
+			++delta.nr_invalid_frames;
+			return true;
+		}
+		if (!ctx.try_push_values(num_values, values, timestamp)) {
+			if (!backpressure) {
+				++delta.nr_dropped_frames;
+				return true;
+			}
+			if (!stalled) {
+				stalled = true;
+				stall_start = std::chrono::steady_clock::now();
+				++delta.nr_stalls;
+			}
+			return false;
+		}
+		if (stalled) {
+			stalled = false;
+			delta.stall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stall_start).count();
+		}
+		delta.nr_values += num_values;
+		return true;
+	}
+	void socket_stream_connection::publish(socket_stream_statistics& delta)
+	{
+		nr_frames += delta.nr_frames;
+		nr_values += delta.nr_values;
+		nr_bytes += delta.nr_bytes;
+		nr_invalid_frames += delta.nr_invalid_frames;
+		nr_dropped_frames += delta.nr_dropped_frames;
+		nr_stalls += delta.nr_stalls;
+		stall_microseconds += size_t(1000000 * delta.stall_seconds);
+		delta = socket_stream_statistics();
+	}
+	void socket_stream_connection::process_frames(cgv::os::socket_connection& c)
+	{
+		socket_stream_statistics delta;
+		// decode all complete frames in place, where all frame sizes are even such that the indexed values are aligned
+		while (c.get_input_size() >= frame_header_size) {
+			const char* frame = c.get_input();
+			uint16_t num_values;
+			double timestamp;
+			std::memcpy(&num_values, frame, 2);
+			std::memcpy(&timestamp, frame + 4, 8);
+			size_t frame_size = get_frame_size(num_values);
+			// frame that cannot be buffered is a protocol error
+			if (frame_size > max_frame_size) {
+				c.close(false);
+				break;
+			}
+			if (c.get_input_size() < frame_size)
+				break;
+			if (!push_frame(num_values, reinterpret_cast<const indexed_value*>(frame + frame_header_size), timestamp, delta))
+				break;
+			c.consume(frame_size);
+		}
+		publish(delta);
+		cgv::os::socket_event_loop& loop = c.get_loop();
+		if (stalled && retry_timer == 0) {
+			// suspend reading until the render thread drained the value queue
+			c.set_reading_enabled(false);
+			retry_timer = loop.add_timer(0.001, [this, &c]() { process_frames(c); }, 0.001);
+		}
+		else if (!stalled && retry_timer != 0) {
+			loop.cancel_timer(retry_timer);
+			retry_timer = 0;
+			c.set_reading_enabled(true);
+		}
+	}
+	void socket_stream_connection::close(cgv::os::socket_connection& c)
+	{
+		if (retry_timer != 0) {
+			c.get_loop().cancel_timer(retry_timer);
+			retry_timer = 0;
+		}
+		socket_stream_statistics delta;
+		if (stalled)
+			delta.stall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stall_start).count();
+		publish(delta);
+		elapsed_microseconds = size_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count());
+		connected = false;
+	}
+	socket_stream_statistics socket_stream_connection::get_statistics() const
+	{
+		socket_stream_statistics s;
+		s.connected = connected;
+		s.nr_frames = nr_frames;
+		s.nr_values = nr_values;
+		s.nr_bytes = nr_bytes;
+		s.nr_invalid_frames = nr_invalid_frames;
+		s.nr_dropped_frames = nr_dropped_frames;
+		s.nr_stalls = nr_stalls;
+		s.stall_seconds = 1e-6 * stall_microseconds;
+		if (s.connected)
+			s.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		else
+			s.elapsed_seconds = 1e-6 * elapsed_microseconds;
+		return s;
+	}
+
+	socket_stream_source::socket_stream_source(stream_vis_context& _ctx) : ctx(_ctx), backpressure(true)
+	{
+	}
+	socket_stream_source::~socket_stream_source()
+	{
+		stop();
+		for (auto* c : connections)
+			delete c;
+	}
+	bool socket_stream_source::start(int port, bool _backpressure, const std::string& address)
+	{
+		stop();
+		backpressure = _backpressure;
+		loop.reset(new cgv::os::socket_event_loop());
+		if (!loop->listen(port, this, 128, address)) {
+			std::cerr << "socket_stream_source::start: " << loop->get_last_error() << std::endl;
+			loop.reset();
+			return false;
+		}
+		loop_thread = std::thread(&cgv::os::socket_event_loop::run, loop.get());
+		return true;
+	}
+	void socket_stream_source::on_connect(cgv::os::socket_connection& c)
+	{
+		socket_stream_connection* ssc = new socket_stream_connection(ctx, backpressure);
+		c.set_user_data(ssc);
+		{
+			std::lock_guard<std::mutex> lock(connections_mutex);
+			connections.push_back(ssc);
+		}
+		ssc->send_hello(c);
+	}
+	void socket_stream_source::on_receive(cgv::os::socket_connection& c)
+	{
+		socket_stream_connection* ssc = static_cast<socket_stream_connection*>(c.get_user_data());
+		ssc->nr_bytes = c.get_statistics().nr_bytes_received;
+		// a stalled connection continues with its timer
+		if (!ssc->stalled)
+			ssc->process_frames(c);
+	}
+	void socket_stream_source::on_close(cgv::os::socket_connection& c)
+	{
+		static_cast<socket_stream_connection*>(c.get_user_data())->close(c);
+	}
+	void socket_stream_source::stop()
+	{
+		if (!loop)
+			return;
+		loop->stop();
+		if (loop_thread.joinable())
+			loop_thread.join();
+		// destructing the loop closes all connections
+		loop.reset();
+	}
+	size_t socket_stream_source::get_nr_connections() const
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		return connections.size();
+	}
+	size_t socket_stream_source::get_nr_open_connections() const
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		size_t n = 0;
+		for (auto* c : connections)
+			if (c->is_connected())
+				++n;
+		return n;
+	}
+	socket_stream_statistics socket_stream_source::get_statistics(size_t i) const
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		return connections[i]->get_statistics();
+	}
+	socket_stream_statistics socket_stream_source::get_total_statistics() const
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		socket_stream_statistics total;
+		for (auto* c : connections)
+			total.add(c->get_statistics());
+		return total;
+	}
+	void socket_stream_source::remove_closed_connections()
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex);
+		auto iter = std::remove_if(connections.begin(), connections.end(), [](socket_stream_connection* c) {
+			if (c->is_connected())
+				return false;
+			delete c;
+			return true;
+		});
+		connections.erase(iter, connections.end());
+	}
+
+	socket_stream_client::socket_stream_client(size_t buffer_size) : max_batch_size(0), buffer(buffer_size), buffer_fill(0)
+	{
+	}
+	bool socket_stream_client::fail(const std::string& error)
+	{
+		last_error = error;
+		if (!sock.empty()) {
+			sock->close();
+			sock.clear();
+		}
+		return false;
+	}
+	bool socket_stream_client::connect(const std::string& host, int port)
+	{
+		disconnect();
+		sock = cgv::os::create_socket_client();
+		if (!sock->connect(host, port))
+			return fail(sock->get_last_error());
+		std::string hello = sock->receive_data(hello_size);
+		uint32_t hello_magic;
+		uint16_t hello_version, nr;
+		if (hello.size() < hello_size)
+			return fail("connection closed before hello");
+		std::memcpy(&hello_magic, &hello[0], 4);
+		std::memcpy(&hello_version, &hello[4], 2);
+		std::memcpy(&nr, &hello[6], 2);
+		std::memcpy(&max_batch_size, &hello[8], 2);
+		if (hello_magic != magic || hello_version != version)
+			return fail("no stream_vis socket stream or incompatible protocol version");
+		names.resize(nr);
+		type_ids.resize(nr);
+		for (uint16_t i = 0; i < nr; ++i) {
+			std::string decl = sock->receive_data(declaration_size);
+			if (decl.size() < declaration_size)
+				return fail("connection closed during declarations");
+			uint16_t type_id, length;
+			std::memcpy(&type_id, &decl[0], 2);
+			std::memcpy(&length, &decl[2], 2);
+			type_ids[i] = cgv::type::info::TypeId(type_id);
+			names[i] = length > 0 ? sock->receive_data(length) : std::string();
+			if (names[i].size() < length)
+				return fail("connection closed during declarations");
+		}
+		last_error.clear();
+		return true;
+	}
+	void socket_stream_client::disconnect()
+	{
+		if (sock.empty())
+			return;
+		flush();
+		sock->close();
+		sock.clear();
+	}
+	uint16_t socket_stream_client::find_time_series(const std::string& name) const
+	{
+		auto iter = std::find(names.begin(), names.end(), name);
+		return iter == names.end() ? uint16_t(-1) : uint16_t(iter - names.begin());
+	}
+	bool socket_stream_client::send_values(uint16_t num_values, const indexed_value* values, double timestamp)
+	{
+		size_t frame_size = get_frame_size(num_values);
+		if (buffer_fill + frame_size > buffer.size()) {
+			if (!flush())
+				return false;
+			if (frame_size > buffer.size())
+				buffer.resize(frame_size);
+		}
+		char* frame = &buffer[buffer_fill];
+		uint16_t flags = 0;
+		std::memcpy(frame, &num_values, 2);
+		std::memcpy(frame + 2, &flags, 2);
+		std::memcpy(frame + 4, &timestamp, 8);
+		std::memcpy(frame + frame_header_size, values, value_size * num_values);
+		buffer_fill += frame_size;
+		return true;
+	}
+	bool socket_stream_client::flush()
+	{
+		if (buffer_fill == 0)
+			return true;
+		if (sock.empty())
+			return fail("not connected");
+		size_t nr_bytes = buffer_fill;
+		buffer_fill = 0;
+		if (!sock->send_data(&buffer[0], unsigned(nr_bytes)))
+			return fail(sock->get_last_error());
+		return true;
+	}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "stream_vis_context.h"
+#include <cgv/os/socket.h>
+#include <cgv/os/socket_event_loop.h>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "lib_begin.h"
+
+namespace stream_vis {
+
+	/** binary protocol of socket streams, where all numbers are in the native byte order of the machine as producers
+	    and stream_vis run on the same machine. After a connection is accepted, the server sends a hello message
+		consisting of the magic number, the protocol version, the number of input time series and the maximum number of
+		values per frame followed by one declaration per input time series with its type id and name length and the
+		characters of its name. The index of the declaration is the index to be used in the indexed values. Afterwards the
+		producer sends frames, each of which consists of a frame header followed by num_values indexed values. */
+	namespace socket_stream_protocol {
+		/// "SVIS" as little endian 32 bit integer
+		const uint32_t magic = 0x53495653;
+		const uint16_t version = 1;
+		/// size of hello message without declarations
+		const unsigned hello_size = 10;
+		/// size of one declaration without its name
+		const unsigned declaration_size = 4;
+		/// size of frame header with 16 bit number of values, 16 bit flags and 64 bit timestamp
+		const unsigned frame_header_size = 12;
+		/// size of one indexed value with 16 bit index and 8 byte value
+		const unsigned value_size = 10;
+		/// return size of frame with given number of values
+		inline size_t get_frame_size(uint16_t num_values) { return frame_header_size + size_t(value_size) * num_values; }
+	}
+
+	/// throughput statistics of a socket stream connection
+	struct CGV_API socket_stream_statistics
+	{
+		/// whether connection is still open
+		bool connected;
+		/// number of received frames including invalid and dropped frames
+		size_t nr_frames;
+		/// number of values in pushed frames
+		size_t nr_values;
+		/// number of received bytes
+		size_t nr_bytes;
+		/// number of frames with values of undeclared time series
+		size_t nr_invalid_frames;
+		/// number of frames dropped because the value queue was full
+		size_t nr_dropped_frames;
+		/// number of times reading was suspended because the value queue was full
+		size_t nr_stalls;
+		/// seconds since connection was accepted till now or till it was closed
+		double elapsed_seconds;
+		/// seconds during which reading was suspended
+		double stall_seconds;
+		/// construct zero statistics
+		socket_stream_statistics();
+		/// accumulate statistics of other connection
+		void add(const socket_stream_statistics& s);
+		/// return pushed values per second
+		double get_values_per_second() const;
+		/// return received megabytes per second
+		double get_megabytes_per_second() const;
+	};
+
+	/** connection of a socket_stream_source, which decodes the frames in the input buffer of its event loop connection
+	    and pushes their values to the value queue of the context without further copies. If backpressure is enabled,
+		reading is suspended while the value queue is full, such that the socket buffers fill up and the producer blocks
+		in sending, and the push of the pending frame is retried with a timer. Otherwise frames are dropped. Decoding
+		runs in the thread of the event loop, while statistics can be queried from any thread. */
+	class CGV_API socket_stream_connection
+	{
+	protected:
+		friend class socket_stream_source;
+		stream_vis_context& ctx;
+		bool backpressure;
+		std::atomic<bool> connected;
+		std::atomic<size_t> nr_frames, nr_values, nr_bytes, nr_invalid_frames, nr_dropped_frames, nr_stalls;
+		/// stall time in microseconds
+		std::atomic<size_t> stall_microseconds;
+		std::chrono::steady_clock::time_point start_time;
+		/// end time as duration since start in microseconds valid after connection closed
+		std::atomic<size_t> elapsed_microseconds;
+		/// number of declared input time series
+		size_t nr_inputs;
+		/// size of largest frame that is accepted
+		size_t max_frame_size;
+		/// whether the push of the frame at the front of the input buffer failed because the value queue was full
+		bool stalled;
+		std::chrono::steady_clock::time_point stall_start;
+		/// timer retrying the push of the stalled frame or 0
+		size_t retry_timer;
+		/// send declarations of input time series
+		void send_hello(cgv::os::socket_connection& c);
+		/// push one frame, count it in the statistics delta and return false if it needs to be retried later
+		bool push_frame(uint16_t num_values, const indexed_value* values, double timestamp, socket_stream_statistics& delta);
+		/// add statistics delta to counters and reset it
+		void publish(socket_stream_statistics& delta);
+		/// decode and push all complete frames in the input buffer of c and suspend reading while the value queue is full
+		void process_frames(cgv::os::socket_connection& c);
+		/// record end of connection
+		void close(cgv::os::socket_connection& c);
+	public:
+		/// construct connection
+		socket_stream_connection(stream_vis_context& _ctx, bool _backpressure);
+		/// return whether connection is still open
+		bool is_connected() const { return connected; }
+		/// return current statistics
+		socket_stream_statistics get_statistics() const;
+	};
+
+	/** data source that accepts producer connections on a port and streams their frames into a
+	    stream_vis_context. All connections are served by a single thread running an event loop, such that hundreds of
+		producers do not need a thread each. */
+	class CGV_API socket_stream_source : public cgv::os::socket_connection_handler
+	{
+	protected:
+		stream_vis_context& ctx;
+		bool backpressure;
+		std::unique_ptr<cgv::os::socket_event_loop> loop;
+		std::thread loop_thread;
+		mutable std::mutex connections_mutex;
+		std::vector<socket_stream_connection*> connections;
+		/// send declarations to accepted connection
+		void on_connect(cgv::os::socket_connection& c);
+		/// decode received frames
+		void on_receive(cgv::os::socket_connection& c);
+		/// mark connection as closed
+		void on_close(cgv::os::socket_connection& c);
+	public:
+		/// construct stopped source for given context, whose declarations need to be parsed before the source is started
+		socket_stream_source(stream_vis_context& _ctx);
+		/// stop source
+		~socket_stream_source();
+		/** listen on given port and start accepting connections, where _backpressure selects between suspending reading and
+		    dropping frames if the value queue is full. Only producers on the local host can connect unless the IPv4 address
+			of another interface or "0.0.0.0" for all interfaces is given. */
+		bool start(int port, bool _backpressure = true, const std::string& address = "127.0.0.1");
+		/// stop listening and close all connections
+		void stop();
+		/// return whether source is listening
+		bool is_listening() const { return loop != 0; }
+		/// return port on which source is listening, which is chosen by the system if the source was started on port 0, or -1 if not listening
+		int get_port() const { return loop ? loop->get_listening_port() : -1; }
+		/// return address of the interface on which source is listening or an empty string if not listening
+		std::string get_address() const { return loop ? loop->get_listening_address() : std::string(); }
+		/// return number of accepted connections including closed ones
+		size_t get_nr_connections() const;
+		/// return number of open connections
+		size_t get_nr_open_connections() const;
+		/// return statistics of i-th connection
+		socket_stream_statistics get_statistics(size_t i) const;
+		/// return statistics accumulated over all connections
+		socket_stream_statistics get_total_statistics() const;
+		/// delete closed connections and their statistics
+		void remove_closed_connections();
+	};
+
+	/** producer side of a socket stream that connects to a socket_stream_source, receives the declarations and
+	    collects frames in a send buffer, which is sent when full or when flush is called. */
+	class CGV_API socket_stream_client
+	{
+	protected:
+		cgv::os::socket_client_ptr sock;
+		uint16_t max_batch_size;
+		std::vector<std::string> names;
+		std::vector<cgv::type::info::TypeId> type_ids;
+		std::vector<char> buffer;
+		size_t buffer_fill;
+		std::string last_error;
+		/// set last error, close connection and return false
+		bool fail(const std::string& error);
+	public:
+		/// construct unconnected client with given size of send buffer in bytes
+		socket_stream_client(size_t buffer_size = 65536);
+		/// connect to source on given host and port and receive declarations
+		bool connect(const std::string& host, int port);
+		/// flush and close connection
+		void disconnect();
+		/// return whether client is connected
+		bool is_connected() const { return !sock.empty(); }
+		/// return last error
+		const std::string& get_last_error() const { return last_error; }
+		/// return number of declared input time series
+		size_t get_nr_time_series() const { return names.size(); }
+		/// return name of declared input time series
+		const std::string& get_time_series_name(uint16_t ts_idx) const { return names[ts_idx]; }
+		/// return value type of declared input time series
+		cgv::type::info::TypeId get_time_series_type(uint16_t ts_idx) const { return type_ids[ts_idx]; }
+		/// return index of time series with given name or uint16_t(-1) if not declared
+		uint16_t find_time_series(const std::string& name) const;
+		/// return maximum number of values per frame
+		uint16_t get_max_batch_size() const { return max_batch_size; }
+		/// append frame to send buffer and send buffer if it is full
+		bool send_values(uint16_t num_values, const indexed_value* values, double timestamp);
+		/// send all buffered frames
+		bool flush();
+	};
+}
+
+#include <cgv/config/lib_end.h>
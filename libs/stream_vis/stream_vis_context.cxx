@@ -256,6 +256,12 @@ namespace stream_vis {
 		reader.init(&name2index, &typed_time_series, &offset_infos, &plot_pool);
 		if (reader.parse_declarations()) {
 			nr_uninitialized_offsets = offset_infos.size();
+			// a batch contains at most one value per time series, which can only be ensured before values are pushed
+			if (value_queue.get_max_batch_size() < typed_time_series.size()) {
+				if (!configure_value_queue(value_queue.get_capacity(), uint16_t(std::min(typed_time_series.size(), size_t(uint16_t(-1))))))
+					std::cerr << "stream_vis_context::parse_declarations: value queue cannot be enlarged to batches of "
+						<< typed_time_series.size() << " values after values have been pushed" << std::endl;
+			}
 //			plot_pool.back().view_index = 1;
 			
 			return;
@@ -415,6 +421,40 @@ namespace stream_vis {
 			--nr_uninitialized_offsets;
 		}
 	}
+	bool stream_vis_context::configure_value_queue(size_t capacity, uint16_t max_batch_size)
+	{
+		return value_queue.resize(capacity, max_batch_size);
+	}
+	bool stream_vis_context::push_values(uint16_t num_values, const indexed_value* values, double timestamp)
+	{
+		if (!value_queue.push(num_values, values, timestamp))
+			return false;
+		outofdate = true;
+		return true;
+	}
+	bool stream_vis_context::try_push_values(uint16_t num_values, const indexed_value* values, double timestamp)
+	{
+		if (!value_queue.try_push(num_values, values, timestamp))
+			return false;
+		outofdate = true;
+		return true;
+	}
+	size_t stream_vis_context::drain_value_queue()
+	{
+		// only drain batches that were queued before, such that producers cannot stall the render thread
+		indexed_value_queue::statistics stats = value_queue.get_statistics();
+		return value_queue.drain([this](uint16_t num_values, indexed_value* values, double timestamp) {
+			drained_val_idx_from_ts_idx.assign(typed_time_series.size(), uint16_t(-1));
+			for (uint16_t vi = 0; vi < num_values; ++vi)
+				if (values[vi].index < drained_val_idx_from_ts_idx.size())
+					drained_val_idx_from_ts_idx[values[vi].index] = vi;
+			const uint16_t* val_idx_from_ts_idx = drained_val_idx_from_ts_idx.empty() ? 0 : &drained_val_idx_from_ts_idx.front();
+			announce_values(num_values, values, timestamp, val_idx_from_ts_idx);
+			// resampled time series follow their sampling time series and check for its new value
+			for (auto* ts_ptr : typed_time_series)
+				ts_ptr->set_new_value(ts_ptr->extract_from_values(num_values, values, timestamp, val_idx_from_ts_idx));
+		}, stats.get_nr_queued_batches());
+	}
 	void stream_vis_context::show_plots() const
 	{
 		for (const auto& pl : plot_pool) {
@@ -614,13 +654,14 @@ namespace stream_vis {
 							std::cerr << "ERROR: mismatch in ringbuffer size" << std::endl;
 				}
 				if (nr_samples <= buffer_size) {
-					cfg.begin_sample;
+					cfg.begin_sample = 0;
 					cfg.end_sample = nr_samples;
 				}
 				else {
 					cfg.begin_sample = (nr_samples - buffer_size) % buffer_size;
 					cfg.end_sample = nr_samples % buffer_size;
 				}
+				cfg.nr_written_samples = nr_samples;
 			}
 			// update plot domain
 			float ranges[2][8];
@@ -752,6 +793,9 @@ namespace stream_vis {
 //		else {
 //			if (view_ptr->get_y_extent_at_focus() )
 //		}
+		// while paused, pushed values stay in the queue and further batches are counted as dropped
+		if (!paused)
+			drain_value_queue();
 		update_plot_samples(ctx);
 		update_plot_domains();
 		for (auto& pl : plot_pool)
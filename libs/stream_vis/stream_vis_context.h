@@ -5,6 +5,7 @@
 #include "offset_info.h"
 #include "streaming_time_series.h"
 #include "streaming_aabb.h"
+#include "indexed_value_queue.h"
 #include <cgv/base/node.h>
 #include <cgv/os/thread.h>
 #include <cgv/os/mutex.h>
@@ -78,6 +79,13 @@ namespace stream_vis {
 		std::vector<std::vector<float>> storage_buffers;
 		std::vector<cgv::render::vertex_buffer*> storage_vbos;
 
+		/// queue of value batches pushed by producer threads and drained in init_frame
+		indexed_value_queue value_queue;
+		/// per time series index of value in currently drained batch
+		std::vector<uint16_t> drained_val_idx_from_ts_idx;
+		/// extract all time series from the batches in the value queue and return number of drained batches
+		size_t drain_value_queue();
+
 		static size_t get_component_index(TimeSeriesAccessor accessor, TimeSeriesAccessor accessors);
 
 		void construct_streaming_aabbs();
@@ -89,6 +97,20 @@ namespace stream_vis {
 		~stream_vis_context();
 		virtual size_t get_first_composed_index() const = 0;
 		void announce_values(uint16_t num_values, indexed_value* values, double timestamp, const uint16_t* val_idx_from_ts_idx);
+		/// set capacity in batches and maximum batch size of value queue before any values are pushed and return false if pushing has already begun
+		bool configure_value_queue(size_t capacity, uint16_t max_batch_size);
+		/// push a batch of values with index of time series from any thread without blocking and return false if batch had to be dropped
+		bool push_values(uint16_t num_values, const indexed_value* values, double timestamp);
+		/// push a batch of at most get_max_batch_size() values and return false if the value queue is full, such that the producer can retry later
+		bool try_push_values(uint16_t num_values, const indexed_value* values, double timestamp);
+		/// return maximum number of values in a batch pushed to the value queue
+		uint16_t get_max_batch_size() const { return value_queue.get_max_batch_size(); }
+		/// return number of declared time series including the composed ones
+		size_t get_nr_time_series() const { return typed_time_series.size(); }
+		/// return time series of given index
+		const streaming_time_series& get_time_series(size_t ts_idx) const { return *typed_time_series[ts_idx]; }
+		/// return counters of the value queue
+		indexed_value_queue::statistics get_value_queue_statistics() const { return value_queue.get_statistics(); }
 		void on_set(void* member_ptr);
 		std::string get_type_name() const { return "stream_vis_context"; }
 		virtual void extract_time_series() = 0;
@@ -1,11 +1,7 @@
 #include <cgv/os/web_server.h>
-#include <3rd/webserver/webserver.h>
-
-void request_function(webserver::http_request* r)
-{
-	cgv::os::web_server* ws = (cgv::os::web_server*) r->user_data;
-	ws->handle_request(*r);
-}
+#include <cgv/os/http_server.h>
+#include <iostream>
+#include <mutex>
 
 #ifdef CGV_OS_WEB_EXPORTS
 #	define CGV_EXPORTS
@@ -13,8 +9,12 @@ void request_function(webserver::http_request* r)
 
 #include <cgv/config/lib_begin.h>
 
+/** provider that serves web_server instances with a cgv::os::http_server, which keeps connections alive, answers
+    pipelined requests and runs handle_request in a pool of worker threads. */
 struct CGV_API web_server_provider_impl : public cgv::os::web_server_provider
 {
+	/// protects the user data of instances, which points to their server while it is running
+	std::mutex mtx;
 	void start_web_server(cgv::os::web_server* instance);
 	void stop_web_server(cgv::os::web_server* instance);
 };
@@ -23,16 +23,30 @@ struct CGV_API web_server_provider_impl : public cgv::os::web_server_provider
 
 void web_server_provider_impl::start_web_server(cgv::os::web_server* instance)
 {
-	webserver* w = new webserver(instance);
-	ref_user_data(instance) = w;
-	w->start(instance->get_port(), request_function);
+	cgv::os::http_server* server = new cgv::os::http_server([instance](cgv::os::http_request& request) { instance->handle_request(request); });
+	// publish the server before listening, such that a stop issued meanwhile makes run return immediately
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		ref_user_data(instance) = server;
+	}
+	if (server->listen(int(instance->get_port())))
+		server->run();
+	else
+		std::cerr << "web server could not listen to port " << instance->get_port() << ": " << server->get_last_error() << std::endl;
+	// stop_web_server returns before the server is destructed
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		ref_user_data(instance) = 0;
+	}
+	delete server;
 }
 
 void web_server_provider_impl::stop_web_server(cgv::os::web_server* instance)
 {
-	webserver* w = (webserver*)ref_user_data(instance);
-	w->stop();
-	delete w;
+	std::lock_guard<std::mutex> lock(mtx);
+	cgv::os::http_server* server = (cgv::os::http_server*)ref_user_data(instance);
+	if (server)
+		server->stop();
 }
 
 cgv::os::web_server_provider_registration<web_server_provider_impl> web_server_impl_registration;
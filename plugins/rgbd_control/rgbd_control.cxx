@@ -98,6 +98,7 @@ cgv::math::fvec<float,2> WorldToPixel(const cgv::math::fvec<float,3>& pt)
 
 ///
 rgbd_control::rgbd_control() : 
+	point_cloud_pipeline(rgbd_inp),
 	color_fmt("uint8[B,G,R,A]"),
 	infrared_fmt("uint16[L]"),
 	depth_fmt("uint16[L]"), 
@@ -112,6 +113,8 @@ rgbd_control::rgbd_control() :
 	clr_rot = dquat(1, 0, 0, 0);
 	clr_ctr = dvec2(320, 240);
 	clr_f_p = dvec2(525.0, 525.0);
+	point_cloud_pipeline.set_intrinsics(ctr, f_p);
+	projection_ms = 0;
 
 	validate_color_camera = true;
 	T.identity();
@@ -179,6 +182,9 @@ void rgbd_control::on_set(void* member_ptr)
 	if (member_ptr >= &clr_rot && member_ptr < &clr_rot + 1) {
 		clr_rot(3) = sqrt(1 - reinterpret_cast<dvec3&>(clr_rot).sqr_length());
 	}
+	if ((member_ptr >= &ctr && member_ptr < &ctr + 1) ||
+		(member_ptr >= &f_p && member_ptr < &f_p + 1))
+		point_cloud_pipeline.set_intrinsics(ctr, f_p);
 	/*
 	if (member_ptr >= &T && member_ptr < &T + 1) {
 		P.clear();
@@ -294,6 +300,7 @@ void rgbd_control::on_register()
 /// overload to handle unregistration of instances
 void rgbd_control::unregister()
 {
+	point_cloud_pipeline.stop();
 	rgbd_inp.stop();
 	rgbd_inp.detach();
 }
@@ -628,6 +635,7 @@ void rgbd_control::create_gui()
 	if (begin_tree_node("Point Cloud", always_acquire_next, false, "level=2")) {
 		align("\a");
 		add_member_control(this, "always_acquire_next", always_acquire_next, "toggle");
+		add_view("projection_ms", projection_ms);
 
 		for (unsigned i = 0; i < 4; ++i)
 			for (unsigned j = 0; j < 4; ++j)
@@ -666,33 +674,6 @@ void rgbd_control::create_gui()
 	}
 }
 
-size_t rgbd_control::construct_point_cloud()
-{
-	/*
-	if (remap_color)
-		rgbd_inp.map_color_to_depth(rgbd::FF_DEPTH_RAW, depth2_data.get_ptr<unsigned char>(), rgbd::FF_COLOR_RGB32, color2_data.get_ptr<unsigned char>());
-	P2.clear();
-	C2.clear();
-	std::vector<vec3> Q;
-	unsigned short* d_ptr = depth2_data.get_ptr<unsigned short>();
-	unsigned char* c_ptr = color2_data.get_ptr<unsigned char>();
-	for (unsigned y = 0; y < depth_fmt.get_height(); ++y)
-		for (unsigned x = 0; x < depth_fmt.get_width(); ++x) {
-			float point[3];
-			if (rgbd_inp.map_pixel_to_point(x, y, *d_ptr++, FF_DEPTH_RAW, point)) {
-				P2.push_back(vec3(3, point));
-				C2.push_back(reinterpret_cast<rgba8&>(*c_ptr));
-				Q.push_back(vec3(float(x), float(y), (float)d_ptr[-1]));
-				rgba8& col = C2.back();
-				std::swap(col[0], col[2]);
-				col[3] = 255;
-			}
-			c_ptr += color_fmt.get_entry_size();
-		}
-	compute_homography(P2, Q);
-	*/
-	return P2.size();
-}
 void rgbd_control::calibrate_device()
 {
 	/*
@@ -789,16 +770,11 @@ void rgbd_control::compute_homography(const std::vector<vec3>& P, const std::vec
 
 void rgbd_control::timer_event(double t, double dt)
 {
-	// in case a point cloud is being constructed
-	if (future_handle.valid()) {
-		// check for termination of thread
-		if (future_handle.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
-			size_t N = future_handle.get();
-			// copy computed point cloud
-			P = P2;
-			C = C2;
-			post_redraw();
-		}
+	// take over point cloud finished in background
+	if (point_cloud_pipeline.retrieve_point_cloud(P, C)) {
+		projection_ms = float(1000 * point_cloud_pipeline.get_statistics().projection_seconds);
+		update_member(&projection_ms);
+		post_redraw();
 	}
 	if (rgbd_inp.is_started()) {
 		IMU_measurement m;
@@ -849,11 +825,9 @@ void rgbd_control::timer_event(double t, double dt)
 				post_redraw();
 			if (stream_color && stream_depth && color_frame.is_allocated() && depth_frame.is_allocated() &&
 				(color_frame_changed || depth_frame_changed) ) {
-				if (!future_handle.valid() && (always_acquire_next || acquire_next)) {
+				if (always_acquire_next || acquire_next) {
 					acquire_next = false;
-					color_frame_2 = color_frame;
-					depth_frame_2 = depth_frame;
-					future_handle = std::async(&rgbd_control::construct_point_cloud, this);
+					point_cloud_pipeline.submit_frames(depth_frame, &color_frame, remap_color);
 				}
 				else {
 					if (remap_color)
@@ -987,6 +961,7 @@ void rgbd_control::on_step_cb()
 
 void rgbd_control::on_stop_cb()
 {
+	point_cloud_pipeline.stop();
 	rgbd_inp.stop();
 	stopped = true;
 }
@@ -1083,6 +1058,7 @@ void rgbd_control::update_stream_formats()
 
 void rgbd_control::on_device_select_cb()
 {
+	point_cloud_pipeline.stop();
 	rgbd_inp.detach();
 	if (device_idx == -1)
 		device_mode = DM_PROTOCOL;
@@ -13,10 +13,10 @@
 #include <cgv/render/shader_program.h>
 #include <cgv/render/texture.h>
 #include <cgv_gl/point_renderer.h>
+#include "rgbd_point_cloud_pipeline.h"
 
 #include <string>
 #include <mutex>
-#include <future>
 
 #include "lib_begin.h"
 
@@ -78,8 +78,12 @@ protected:
 	vec2 mouse_pos;
 
 	/// raw point cloud
-	std::vector<vec3> P, P2;
-	std::vector<rgba8> C, C2;
+	std::vector<vec3> P;
+	std::vector<rgba8> C;
+	/// conversion of depth and color frames to point clouds in background threads
+	rgbd_point_cloud_pipeline point_cloud_pipeline;
+	/// milliseconds spent on back projection of last point cloud
+	float projection_ms;
 
 	/// processing parameters
 	bool remap_color;
@@ -125,10 +129,7 @@ private:
 
 	/// internal members used for data storage
 	rgbd::frame_type color_frame, depth_frame, ir_frame, warped_color_frame;
-	rgbd::frame_type color_frame_2, depth_frame_2, ir_frame_2;
 
-	std::future<size_t> future_handle;
-	size_t construct_point_cloud();
 	void compute_homography(const std::vector<vec3>& P, const std::vector<vec3>& Q);
 	bool acquire_next;
 	bool always_acquire_next;
@@ -0,0 +1,294 @@
+#include "rgbd_point_cloud_pipeline.h"
+#include <cgv/os/thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+using namespace rgbd;
+
+/// return seconds since given time point
+static double seconds_since(const std::chrono::steady_clock::time_point& t)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+rgbd_point_cloud_pipeline::rgbd_point_cloud_pipeline(rgbd_input& _rgbd_inp, unsigned _nr_threads) : rgbd_inp(_rgbd_inp)
+{
+	nr_threads = _nr_threads;
+	if (nr_threads == 0)
+		nr_threads = cgv::os::get_thread_pool().get_concurrency();
+	ctr = dvec2(320, 240);
+	f_p = dvec2(571.25, 571.25);
+	intrinsics_changed = true;
+	ray_z = 0.001f;
+	ray_width = ray_height = 0;
+	// one set per stage including the set filled in submit_frames
+	frame_sets.resize(5);
+	for (auto& fs : frame_sets)
+		free_sets.push_back(&fs);
+	submitted_set = mapped_set = 0;
+	stop_pipeline = false;
+	point_cloud_ready = false;
+	stats.nr_frames = stats.nr_skipped_frames = 0;
+	stats.mapping_seconds = stats.projection_seconds = 0;
+}
+
+rgbd_point_cloud_pipeline::~rgbd_point_cloud_pipeline()
+{
+	stop();
+}
+
+void rgbd_point_cloud_pipeline::start()
+{
+	if (mapper.joinable())
+		return;
+	stop_pipeline = false;
+	mapper = std::thread(&rgbd_point_cloud_pipeline::map_colors, this);
+	projector = std::thread(&rgbd_point_cloud_pipeline::project_points, this);
+}
+
+void rgbd_point_cloud_pipeline::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stop_pipeline = true;
+	}
+	frames_available.notify_all();
+	if (mapper.joinable())
+		mapper.join();
+	if (projector.joinable())
+		projector.join();
+	std::lock_guard<std::mutex> lock(mtx);
+	free_sets.clear();
+	for (auto& fs : frame_sets)
+		free_sets.push_back(&fs);
+	submitted_set = mapped_set = 0;
+	stop_pipeline = false;
+}
+
+void rgbd_point_cloud_pipeline::set_intrinsics(const dvec2& _ctr, const dvec2& _f_p)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	ctr = _ctr;
+	f_p = _f_p;
+	intrinsics_changed = true;
+}
+
+void rgbd_point_cloud_pipeline::submit_frames(const frame_type& depth_frame, const frame_type* color_frame, bool remap_color)
+{
+	start();
+	frame_set* fs;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (free_sets.empty()) {
+			++stats.nr_skipped_frames;
+			return;
+		}
+		fs = free_sets.back();
+		free_sets.pop_back();
+	}
+	// copy outside of lock into buffers that are reused from frame to frame
+	fs->depth_frame = depth_frame;
+	fs->has_color = color_frame != 0 && color_frame->is_allocated();
+	if (fs->has_color)
+		fs->color_frame = *color_frame;
+	fs->remap_color = remap_color;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (submitted_set) {
+			free_sets.push_back(submitted_set);
+			++stats.nr_skipped_frames;
+		}
+		submitted_set = fs;
+	}
+	frames_available.notify_all();
+}
+
+bool rgbd_point_cloud_pipeline::retrieve_point_cloud(std::vector<vec3>& P, std::vector<rgba8>& C)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	if (!point_cloud_ready)
+		return false;
+	P.swap(P_ready);
+	C.swap(C_ready);
+	point_cloud_ready = false;
+	return true;
+}
+
+rgbd_point_cloud_pipeline::statistics rgbd_point_cloud_pipeline::get_statistics()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
+
+void rgbd_point_cloud_pipeline::map_colors()
+{
+	for (;;) {
+		frame_set* fs;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			frames_available.wait(lock, [this]() { return stop_pipeline || submitted_set != 0; });
+			if (stop_pipeline)
+				return;
+			fs = submitted_set;
+			submitted_set = 0;
+		}
+		auto start_time = std::chrono::steady_clock::now();
+		const frame_type& df = fs->depth_frame;
+		fs->mapped_color_frame = 0;
+		if (fs->has_color) {
+			if (fs->remap_color) {
+				rgbd_inp.map_color_to_depth(df, fs->color_frame, fs->warped_color_frame);
+				const frame_type& wf = fs->warped_color_frame;
+				if (wf.width == df.width && wf.height == df.height && wf.is_allocated())
+					fs->mapped_color_frame = &wf;
+			}
+			else if (fs->color_frame.width == df.width && fs->color_frame.height == df.height)
+				fs->mapped_color_frame = &fs->color_frame;
+		}
+		double mapping_seconds = seconds_since(start_time);
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stats.mapping_seconds = mapping_seconds;
+			if (mapped_set) {
+				free_sets.push_back(mapped_set);
+				++stats.nr_skipped_frames;
+			}
+			mapped_set = fs;
+		}
+		frames_available.notify_all();
+	}
+}
+
+void rgbd_point_cloud_pipeline::project_points()
+{
+	for (;;) {
+		frame_set* fs;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			frames_available.wait(lock, [this]() { return stop_pipeline || mapped_set != 0; });
+			if (stop_pipeline)
+				return;
+			fs = mapped_set;
+			mapped_set = 0;
+		}
+		auto start_time = std::chrono::steady_clock::now();
+		back_project(fs->depth_frame, fs->mapped_color_frame);
+		double projection_seconds = seconds_since(start_time);
+		std::lock_guard<std::mutex> lock(mtx);
+		P_back.swap(P_ready);
+		C_back.swap(C_ready);
+		point_cloud_ready = true;
+		++stats.nr_frames;
+		stats.projection_seconds = projection_seconds;
+		free_sets.push_back(fs);
+	}
+}
+
+template <typename F>
+void rgbd_point_cloud_pipeline::for_each_block(size_t nr_blocks, const F& f)
+{
+	std::atomic<size_t> next_block(0);
+	auto worker = [&]() {
+		size_t bi;
+		while ((bi = next_block++) < nr_blocks)
+			f(bi);
+	};
+	cgv::os::get_thread_pool().parallel_for(0, std::min(size_t(nr_threads), nr_blocks), [&](size_t) { worker(); }, 1);
+}
+
+void rgbd_point_cloud_pipeline::update_ray_table(int w, int h)
+{
+	dvec2 c, f;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!intrinsics_changed && w == ray_width && h == ray_height)
+			return;
+		c = ctr;
+		f = f_p;
+		intrinsics_changed = false;
+	}
+	// depth values are given in millimeters and points in meters
+	rays_x.resize(w);
+	for (int x = 0; x < w; ++x)
+		rays_x[x] = float(0.001 * (x - c(0)) / f(0));
+	rays_y.resize(h);
+	for (int y = 0; y < h; ++y)
+		rays_y[y] = float(0.001 * (y - c(1)) / f(1));
+	ray_width = w;
+	ray_height = h;
+}
+
+void rgbd_point_cloud_pipeline::back_project(const frame_type& depth_frame, const frame_type* color_frame)
+{
+	int w = depth_frame.width, h = depth_frame.height;
+	if (depth_frame.nr_bits_per_pixel != 16 || w <= 0 || h <= 0 || depth_frame.frame_data.size() < size_t(w) * h * 2) {
+		P_back.clear();
+		C_back.clear();
+		return;
+	}
+	update_ray_table(w, h);
+	const uint16_t* depths = reinterpret_cast<const uint16_t*>(depth_frame.frame_data.data());
+	// kinect v1 stores the player index in the lower three bits
+	unsigned shift = depth_frame.pixel_format == PF_DEPTH_AND_PLAYER ? 3 : 0;
+
+	// determine color channel offsets
+	const unsigned char* colors = 0;
+	unsigned entry_size = 0, ri = 0, gi = 1, bi = 2;
+	if (color_frame && color_frame->nr_bits_per_pixel >= 24) {
+		PixelFormat pf = color_frame->pixel_format;
+		if (pf == PF_BGR || pf == PF_BGRA) {
+			ri = 2;
+			bi = 0;
+		}
+		entry_size = color_frame->nr_bits_per_pixel / 8;
+		if ((pf == PF_RGB || pf == PF_RGBA || pf == PF_BGR || pf == PF_BGRA) &&
+			color_frame->frame_data.size() >= size_t(w) * h * entry_size)
+			colors = reinterpret_cast<const unsigned char*>(color_frame->frame_data.data());
+	}
+
+	// count valid depth values per block of rows to compute output offsets of blocks
+	int rows_per_block = std::max(1, h / int(4 * nr_threads));
+	size_t nr_blocks = (h + rows_per_block - 1) / rows_per_block;
+	block_counts.resize(nr_blocks);
+	for_each_block(nr_blocks, [&](size_t bj) {
+		size_t begin = bj * rows_per_block * w, end = std::min(size_t(h), (bj + 1) * rows_per_block) * w;
+		size_t n = 0;
+		for (size_t i = begin; i < end; ++i)
+			n += (depths[i] >> shift) != 0 ? 1 : 0;
+		block_counts[bj] = n;
+	});
+	size_t nr_points = 0;
+	for (auto& n : block_counts) {
+		size_t offset = nr_points;
+		nr_points += n;
+		n = offset;
+	}
+	P_back.resize(nr_points);
+	C_back.resize(colors ? nr_points : 0);
+
+	// back project valid depth values of each block into its output range
+	for_each_block(nr_blocks, [&](size_t bj) {
+		vec3* points = P_back.data();
+		rgba8* point_colors = C_back.data();
+		size_t k = block_counts[bj];
+		int y_end = std::min(h, int(bj + 1) * rows_per_block);
+		for (int y = int(bj) * rows_per_block; y < y_end; ++y) {
+			const uint16_t* depth_row = depths + size_t(y) * w;
+			const unsigned char* color_row = colors ? colors + size_t(y) * w * entry_size : 0;
+			float ray_y = rays_y[y];
+			for (int x = 0; x < w; ++x) {
+				unsigned d = depth_row[x] >> shift;
+				if (d == 0)
+					continue;
+				float fd = float(d);
+				points[k].set(fd * rays_x[x], fd * ray_y, fd * ray_z);
+				if (color_row) {
+					const unsigned char* c = color_row + x * entry_size;
+					point_colors[k] = rgba8(c[ri], c[gi], c[bi], 255);
+				}
+				++k;
+			}
+		}
+	});
+}
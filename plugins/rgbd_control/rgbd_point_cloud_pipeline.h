@@ -0,0 +1,100 @@
+#pragma once
+
+#include <rgbd_input.h>
+#include <cgv/render/render_types.h>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+/** pipeline that converts depth frames with optional color frames to colored point clouds in background threads.
+    Frames handed over with submit_frames pass a color mapping stage, which maps the color frame to the depth
+	image with the attached rgbd device, and a back projection stage, which splits the depth image into row blocks
+	processed in parallel. The rgbd input serializes the device calls of the color mapping stage with the calls of
+	other threads. Back projection multiplies each depth value with the precomputed ray of its pixel, such
+	that no per pixel division or device call is necessary. As the pinhole model is separable, the ray table is
+	stored as one x-component per column and one y-component per row. The stages run concurrently on successive
+	frames and each stage keeps only the newest frame if the next stage is busy. Finished point clouds are double
+	buffered and swapped out with retrieve_point_cloud without copies. */
+class rgbd_point_cloud_pipeline : public cgv::render::render_types
+{
+public:
+	/// statistics of pipeline
+	struct statistics
+	{
+		/// number of converted frames
+		size_t nr_frames;
+		/// number of frames skipped because a stage was busy
+		size_t nr_skipped_frames;
+		/// seconds spent on color mapping and back projection of last frame
+		double mapping_seconds, projection_seconds;
+	};
+protected:
+	/// frames passed through the pipeline
+	struct frame_set
+	{
+		rgbd::frame_type depth_frame, color_frame, warped_color_frame;
+		bool has_color;
+		bool remap_color;
+		/// color frame at depth resolution after color mapping or 0
+		const rgbd::frame_type* mapped_color_frame;
+	};
+	rgbd::rgbd_input& rgbd_inp;
+	unsigned nr_threads;
+	/// intrinsics of depth camera in pixels with depth values in millimeters
+	dvec2 ctr, f_p;
+	/// whether intrinsics changed since last ray table computation
+	bool intrinsics_changed;
+	/// ray table such that depth value d of pixel (x,y) is back projected to d*(rays_x[x], rays_y[y], ray_z)
+	std::vector<float> rays_x, rays_y;
+	float ray_z;
+	int ray_width, ray_height;
+
+	std::vector<frame_set> frame_sets;
+	std::vector<frame_set*> free_sets;
+	frame_set* submitted_set;
+	frame_set* mapped_set;
+	bool stop_pipeline;
+	std::thread mapper, projector;
+	std::mutex mtx;
+	std::condition_variable frames_available;
+	/// point cloud being constructed and finished point cloud
+	std::vector<vec3> P_back, P_ready;
+	std::vector<rgba8> C_back, C_ready;
+	bool point_cloud_ready;
+	/// number of valid depth values per row block
+	std::vector<size_t> block_counts;
+	statistics stats;
+	/// call f(block_index) for all row blocks with nr_threads tasks in the shared thread pool
+	template <typename F>
+	void for_each_block(size_t nr_blocks, const F& f);
+	/// rebuild ray table if depth resolution or intrinsics changed
+	void update_ray_table(int w, int h);
+	/// back project depth frame with optional color frame at depth resolution into P_back and C_back
+	void back_project(const rgbd::frame_type& depth_frame, const rgbd::frame_type* color_frame);
+	/// thread function of color mapping stage
+	void map_colors();
+	/// thread function of back projection stage
+	void project_points();
+	/// start threads if not running
+	void start();
+public:
+	/// construct stopped pipeline for given rgbd input with nr_threads tasks for back projection in the shared thread pool (0 ... use concurrency of the pool)
+	rgbd_point_cloud_pipeline(rgbd::rgbd_input& _rgbd_inp, unsigned _nr_threads = 0);
+	/// stop pipeline
+	~rgbd_point_cloud_pipeline();
+	/// stop threads and discard frames in flight, which must be called before the rgbd input is detached
+	void stop();
+	/// set intrinsics of depth camera with center and focal lengths in pixels
+	void set_intrinsics(const dvec2& _ctr, const dvec2& _f_p);
+	/** hand over depth frame and optional color frame, which are copied into the pipeline. If remap_color is true,
+	    the color frame is mapped to the depth image with the rgbd input, otherwise it is only used if it has the
+		resolution of the depth frame. Threads are started on first call. */
+	void submit_frames(const rgbd::frame_type& depth_frame, const rgbd::frame_type* color_frame = 0, bool remap_color = true);
+	/// swap newest finished point cloud into P and C and return whether one was available; C is empty if no colors were available
+	bool retrieve_point_cloud(std::vector<vec3>& P, std::vector<rgba8>& C);
+	/// return statistics
+	statistics get_statistics();
+};
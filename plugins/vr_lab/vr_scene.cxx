@@ -656,5 +656,6 @@ void vr_scene::create_gui()
 #include <cg_nui/vr_screen.h>
 
 cgv::base::object_registration<vr::vr_scene> vr_scene_reg("vr_scene");
-cgv::base::object_registration_1<cgv::nui::vr_screen, std::string> vr_screen_reg("vr_screen");
+// the screen captures all monitors on construction and is therefore only constructed once it is addressed by name(vr_screen)
+cgv::base::lazy_object_registration_1<cgv::nui::vr_screen, std::string> vr_screen_reg("vr_screen", "vr_screen");
 cgv::base::object_registration<cgv::nui::vr_table> vr_table_reg("vr_table");
@@ -0,0 +1,129 @@
+#include <cgv/base/named.h>
+#include <cgv/base/register.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace cgv::base;
+
+/// named object registered directly
+struct indexed_test_object : public named
+{
+	indexed_test_object(const std::string& name) : named(name) {}
+	std::string get_type_name() const { return "indexed_test_object"; }
+};
+
+/// named object that counts its constructions and is only registered lazily
+struct lazy_test_object : public named
+{
+	static int nr_constructed;
+	lazy_test_object() { ++nr_constructed; }
+	std::string get_type_name() const { return cgv::type::info::type_name<lazy_test_object>::get_name(); }
+};
+
+int lazy_test_object::nr_constructed = 0;
+
+/// object with a constructor that takes one millisecond
+struct slow_test_object : public base
+{
+	slow_test_object() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+	std::string get_type_name() const { return "slow_test_object"; }
+};
+
+bool test_register()
+{
+	// look up objects by name and by type, where the first registered object of a type is found
+	base_ptr a(new indexed_test_object("register_test_a")), b(new indexed_test_object("register_test_b"));
+	register_object(a);
+	register_object(b);
+	TEST_ASSERT(find_object_by_name("register_test_a") == a->get_named());
+	TEST_ASSERT(find_object_by_name("register_test_b") == b->get_named());
+	TEST_ASSERT(find_object_by_type("indexed_test_object") == a);
+	TEST_ASSERT(find_object_by_name("register_test_c").empty());
+
+	// renamed objects are found only by their new name
+	a->get_named()->set_name("register_test_renamed");
+	TEST_ASSERT(find_object_by_name("register_test_a").empty());
+	TEST_ASSERT(find_object_by_name("register_test_renamed") == a->get_named());
+	TEST_ASSERT(find_object_by_name("register_test_renamed") == a->get_named());
+	b->get_named()->set_name("register_test_a");
+	TEST_ASSERT(find_object_by_name("register_test_a") == b->get_named());
+
+	// unregistered objects are removed from both indices also after renaming
+	unregister_object(a);
+	TEST_ASSERT(find_object_by_name("register_test_renamed").empty());
+	TEST_ASSERT(find_object_by_type("indexed_test_object") == b);
+	unregister_object(b);
+	TEST_ASSERT(find_object_by_name("register_test_a").empty());
+	TEST_ASSERT(find_object_by_type("indexed_test_object").empty());
+	register_object(a);
+	TEST_ASSERT(find_object_by_name("register_test_renamed") == a->get_named());
+	TEST_ASSERT(find_object_by_type("indexed_test_object") == a);
+	unregister_object(a);
+
+	// lazy objects are constructed once on their first lookup by name or by type
+	lazy_test_object::nr_constructed = 0;
+	lazy_object_registration<lazy_test_object> lazy_reg("register_test_lazy");
+	TEST_ASSERT_EQ(lazy_test_object::nr_constructed, 0);
+	named_ptr np = find_object_by_name("register_test_lazy");
+	TEST_ASSERT(!np.empty());
+	TEST_ASSERT_EQ(np->get_name(), std::string("register_test_lazy"));
+	TEST_ASSERT_EQ(lazy_test_object::nr_constructed, 1);
+	TEST_ASSERT(find_object_by_name("register_test_lazy") == np);
+	TEST_ASSERT(find_object_by_type(np->get_type_name())->get_named() == np);
+	TEST_ASSERT_EQ(lazy_test_object::nr_constructed, 1);
+	unregister_object(np);
+
+	lazy_object_registration<lazy_test_object> lazy_type_reg("register_test_lazy_type");
+	base_ptr bp = find_object_by_type(cgv::type::info::type_name<lazy_test_object>::get_name());
+	TEST_ASSERT(!bp.empty());
+	TEST_ASSERT_EQ(lazy_test_object::nr_constructed, 2);
+	TEST_ASSERT(find_object_by_name("register_test_lazy_type") == bp->get_named());
+	unregister_object(bp);
+	TEST_ASSERT(find_object_by_name("register_test_lazy_type").empty());
+	TEST_ASSERT_EQ(lazy_test_object::nr_constructed, 2);
+	return true;
+}
+
+/// measure the time spent in enable_registration for objects with slow constructors that are registered eagerly or lazily
+bool benchmark_register()
+{
+	const int nr_objects = 200;
+	for (bool lazy : { false, true }) {
+		disable_registration();
+		for (int i = 0; i < nr_objects; ++i) {
+			std::string name = "register_benchmark_" + std::to_string(i);
+			if (lazy)
+				lazy_object_registration<slow_test_object> reg(name);
+			else
+				object_registration<slow_test_object> reg("");
+		}
+		auto start = std::chrono::steady_clock::now();
+		enable_registration();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << (lazy ? "lazy" : "eager") << " registration of " << nr_objects << " slow objects: "
+			<< 1000 * seconds << " ms" << std::endl;
+		if (lazy)
+			construct_lazy_objects();
+		int nr_unregistered = 0;
+		for (unsigned i = get_nr_permanently_registered_objects(); i > 0; --i) {
+			base_ptr object = get_permanently_registered_object(i - 1);
+			if (object->get_type_name() == "slow_test_object") {
+				unregister_object(object);
+				++nr_unregistered;
+			}
+		}
+		if (nr_unregistered != nr_objects)
+			return false;
+	}
+	show_registration_timings();
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration register_test_registration(
+	"cgv::base::register", test_register);
+
+extern CGV_API benchmark_registration register_benchmark_registration(
+	"cgv::base::register_benchmark", benchmark_register);
@@ -0,0 +1,131 @@
+#include <cgv/base/register.h>
+#include <cgv/data/ref_ptr.h>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::data;
+
+static std::atomic<int> nr_destructed(0);
+
+class shared_instance : public atomic_ref_counted
+{
+public:
+	int value;
+	shared_instance(int v) : value(v) {}
+	~shared_instance() { ++nr_destructed; }
+};
+
+class local_instance : public ref_counted
+{
+public:
+	int value;
+	local_instance(int v) : value(v) {}
+};
+
+typedef ref_ptr<shared_instance> shared_instance_ptr;
+typedef ref_ptr<local_instance> local_instance_ptr;
+
+/// copy and release ref_ptrs to the same instances concurrently, which must be race free under the thread sanitizer
+bool test_atomic_ref_ptr()
+{
+	const unsigned nr_threads = 8, nr_iterations = 20000;
+	// instances of classes derived from atomic_ref_counted carry their count
+	TEST_ASSERT((std::is_base_of<ref_ptr_impl<shared_instance, true>, shared_instance_ptr>::value));
+
+	// concurrent copies of one instance
+	nr_destructed = 0;
+	{
+		shared_instance_ptr p(new shared_instance(42));
+		std::atomic<int> nr_errors(0);
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < nr_threads; ++t)
+			threads.push_back(std::thread([p, &nr_errors]() {
+				for (unsigned i = 0; i < nr_iterations; ++i) {
+					shared_instance_ptr q(p);
+					shared_instance_ptr r;
+					r = q;
+					if (r->value != 42)
+						++nr_errors;
+				}
+			}));
+		for (auto& t : threads)
+			t.join();
+		TEST_ASSERT_EQ(nr_errors, 0);
+		TEST_ASSERT_EQ(p.get_count(), 1);
+		TEST_ASSERT_EQ(nr_destructed, 0);
+	}
+	TEST_ASSERT_EQ(nr_destructed, 1);
+
+	// instances handed to two threads each, where the last releasing thread deletes the instance
+	nr_destructed = 0;
+	const unsigned nr_instances = 1000;
+	{
+		std::vector<shared_instance_ptr> instances;
+		for (unsigned i = 0; i < nr_instances; ++i)
+			instances.push_back(shared_instance_ptr(new shared_instance(int(i))));
+		std::vector<shared_instance_ptr> first(instances), second(instances);
+		instances.clear();
+		std::atomic<int> sum(0);
+		auto release = [&sum](std::vector<shared_instance_ptr>& P) {
+			for (auto& p : P) {
+				sum += p->value;
+				p.clear();
+			}
+		};
+		std::thread t0(release, std::ref(first)), t1(release, std::ref(second));
+		t0.join();
+		t1.join();
+		TEST_ASSERT_EQ(sum, int(nr_instances * (nr_instances - 1)));
+	}
+	TEST_ASSERT_EQ(nr_destructed, int(nr_instances));
+	return true;
+}
+
+/// return nanoseconds per copy and release of a ref_ptr to a single instance shared by nr_threads threads
+template <typename P>
+double measure_copy_time(const P& p, unsigned nr_threads, unsigned nr_iterations)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < nr_threads; ++t)
+		threads.push_back(std::thread([&p, nr_iterations]() {
+			for (unsigned i = 0; i < nr_iterations; ++i) {
+				P q(p);
+				if (q.empty())
+					break;
+			}
+		}));
+	for (auto& t : threads)
+		t.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return 1e9 * seconds / (double(nr_iterations) * nr_threads);
+}
+
+/// compare the cost of copies of non atomic and atomic ref_ptrs and of atomic ref_ptrs under contention
+bool benchmark_atomic_ref_ptr()
+{
+	const unsigned nr_iterations = 1000000;
+	unsigned nr_threads = std::max(2u, std::thread::hardware_concurrency());
+	local_instance_ptr lp(new local_instance(0));
+	shared_instance_ptr sp(new shared_instance(0));
+	std::cout << "ref_counted copy:                     " << measure_copy_time(lp, 1, nr_iterations) << " ns" << std::endl;
+	std::cout << "atomic_ref_counted copy:              " << measure_copy_time(sp, 1, nr_iterations) << " ns" << std::endl;
+	std::cout << "atomic_ref_counted copy in " << nr_threads << " threads: "
+			  << measure_copy_time(sp, nr_threads, nr_iterations) << " ns" << std::endl;
+	TEST_ASSERT_EQ(sp.get_count(), 1);
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration atomic_ref_ptr_test_registration(
+	"cgv::data::atomic_ref_ptr", test_atomic_ref_ptr);
+
+extern CGV_API benchmark_registration atomic_ref_ptr_benchmark_registration(
+	"cgv::data::atomic_ref_ptr_benchmark", benchmark_atomic_ref_ptr);
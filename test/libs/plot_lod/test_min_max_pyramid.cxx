@@ -0,0 +1,164 @@
+#include <cgv/base/register.h>
+#include <plot/min_max_pyramid.h>
+
+using namespace cgv::base;
+using namespace cgv::plot;
+
+/// value of the k-th sample with many ties and a spike every 97 samples
+static int sample_value(size_t k)
+{
+	return k % 97 == 13 ? 1000 : int(k * 7919 % 101) - 50;
+}
+
+/// return whether the stored blocks of all levels reference the first samples with minimum and maximum value
+static bool check_blocks(const min_max_pyramid& P, size_t seed)
+{
+	for (unsigned l = min_max_pyramid::first_level; l < P.get_nr_levels(); ++l) {
+		const min_max_pyramid::level& L = P.get_level(l);
+		for (size_t bi = 0; bi < L.blocks.size(); ++bi) {
+			size_t i0 = (L.begin + bi) << l, i1 = std::min((L.begin + bi + 1) << l, P.get_nr_samples());
+			size_t min_index = i0, max_index = i0;
+			for (size_t i = i0 + 1; i < i1; ++i) {
+				if (sample_value(i + seed) < sample_value(min_index + seed))
+					min_index = i;
+				if (sample_value(i + seed) > sample_value(max_index + seed))
+					max_index = i;
+			}
+			if (L.blocks[bi].min_index != min_index || L.blocks[bi].max_index != max_index)
+				return false;
+		}
+	}
+	return true;
+}
+
+/** return whether the indices extracted for [begin, end) at the given level are all samples for levels below the first
+    stored level, or increase and contain the first, last, a minimum and a maximum sample of the retained part of each
+	overlapped block */
+static bool check_extraction(const min_max_pyramid& P, size_t begin, size_t end, unsigned level, size_t seed)
+{
+	auto value = [seed](size_t k) { return sample_value(k + seed); };
+	std::vector<size_t> indices;
+	P.extract(begin, end, level, indices, value);
+	size_t first = P.get_first_sample();
+	begin = std::max(begin, first);
+	end = std::min(end, P.get_nr_samples());
+	if (begin >= end)
+		return indices.empty();
+	if (level < min_max_pyramid::first_level) {
+		if (indices.size() != end - begin)
+			return false;
+		for (size_t k = 0; k < indices.size(); ++k)
+			if (indices[k] != begin + k)
+				return false;
+		return true;
+	}
+	for (size_t k = 1; k < indices.size(); ++k)
+		if (indices[k] <= indices[k - 1])
+			return false;
+	size_t k = 0;
+	for (size_t bi = begin >> level; bi <= (end - 1) >> level; ++bi) {
+		size_t i0 = std::max(bi << level, first), i1 = std::min((bi + 1) << level, P.get_nr_samples());
+		if (k >= indices.size() || indices[k] != i0)
+			return false;
+		int min_value = value(i0), max_value = value(i0), extracted_min = value(i0), extracted_max = value(i0);
+		for (size_t i = i0; i < i1; ++i) {
+			min_value = std::min(min_value, value(i));
+			max_value = std::max(max_value, value(i));
+		}
+		for (; k < indices.size() && indices[k] < i1; ++k) {
+			extracted_min = std::min(extracted_min, value(indices[k]));
+			extracted_max = std::max(extracted_max, value(indices[k]));
+		}
+		if (indices[k - 1] != i1 - 1 || extracted_min != min_value || extracted_max != max_value)
+			return false;
+	}
+	return k == indices.size();
+}
+
+bool test_min_max_pyramid()
+{
+	// append in chunks of different sizes and compare blocks with brute force
+	min_max_pyramid P;
+	auto value = [](size_t k) { return sample_value(k); };
+	TEST_ASSERT_EQ(P.get_nr_levels(), 1u);
+	size_t n = 0;
+	for (size_t chunk : { 1, 2, 1, 7, 100, 3, 500, 386 }) {
+		n += chunk;
+		P.append(n, value);
+		TEST_ASSERT_EQ(P.get_nr_samples(), n);
+		TEST_ASSERT(check_blocks(P, 0));
+	}
+	TEST_ASSERT_EQ(n, size_t(1000));
+	TEST_ASSERT_EQ(P.get_nr_levels(), 10u);
+
+	// choose level with one to two blocks per pixel
+	TEST_ASSERT_EQ(P.choose_level(1000, 100), 3u);
+	TEST_ASSERT_EQ(P.choose_level(1000, 250), 2u);
+	TEST_ASSERT_EQ(P.choose_level(1000, 300), 0u);
+	TEST_ASSERT_EQ(P.choose_level(1000, 2000), 0u);
+	TEST_ASSERT_EQ(P.choose_level(1000, 1), 9u);
+	TEST_ASSERT_EQ(P.choose_level(1000, 0.1), 9u);
+	TEST_ASSERT_EQ(P.choose_level(200, 10), 4u);
+
+	// extract ranges at all levels
+	for (unsigned l : { 0u, 2u, 3u, 5u, 9u })
+		for (size_t begin : { 0, 1, 13, 511 })
+			for (size_t end : { 4, 97, 512, 999, 1000, 2000 })
+				TEST_ASSERT(check_extraction(P, begin, end, l, 0));
+	std::vector<size_t> indices;
+	P.extract(0, 1000, 9, indices, value);
+	TEST_ASSERT(indices.size() <= 8);
+	TEST_ASSERT(std::find(indices.begin(), indices.end(), size_t(13)) != indices.end());
+
+	// a smaller number of samples restarts the pyramid
+	P.append(300, [](size_t k) { return sample_value(k + 5); });
+	TEST_ASSERT_EQ(P.get_nr_samples(), size_t(300));
+	TEST_ASSERT_EQ(P.get_nr_levels(), 9u);
+	TEST_ASSERT(check_blocks(P, 5));
+	TEST_ASSERT(check_extraction(P, 0, 300, 4, 5));
+	P.clear();
+	TEST_ASSERT_EQ(P.get_nr_samples(), size_t(0));
+	TEST_ASSERT_EQ(P.get_nr_levels(), 1u);
+	return true;
+}
+
+bool test_min_max_pyramid_ringbuffer()
+{
+	// only the last 100 samples are retained, where blocks of overwritten samples are discarded and levels are
+	// limited to blocks of at most half the capacity
+	min_max_pyramid P(100);
+	auto value = [](size_t k) { return sample_value(k); };
+	size_t n = 0;
+	for (size_t chunk : { 3, 60, 37, 1, 50, 99, 250, 1, 1, 23, 64 }) {
+		n += chunk;
+		P.append(n, value);
+		TEST_ASSERT_EQ(P.get_nr_samples(), n);
+		TEST_ASSERT_EQ(P.get_first_sample(), n > 100 ? n - 100 : 0);
+		TEST_ASSERT(P.get_nr_levels() <= 6u);
+		for (unsigned l = min_max_pyramid::first_level; l < P.get_nr_levels(); ++l) {
+			const min_max_pyramid::level& L = P.get_level(l);
+			TEST_ASSERT_EQ(L.begin, P.get_first_sample() >> l);
+			TEST_ASSERT_EQ(L.begin + L.blocks.size(), ((n - 1) >> l) + 1);
+		}
+		for (unsigned l = 0; l < P.get_nr_levels(); ++l) {
+			TEST_ASSERT(check_extraction(P, 0, n, l, 0));
+			TEST_ASSERT(check_extraction(P, n - std::min(n, size_t(37)), n, l, 0));
+		}
+	}
+	TEST_ASSERT_EQ(P.get_nr_levels(), 6u);
+	TEST_ASSERT_EQ(P.choose_level(100, 1), 5u);
+
+	// setting the capacity removes all samples
+	P.set_capacity(size_t(-1));
+	TEST_ASSERT_EQ(P.get_nr_samples(), size_t(0));
+	TEST_ASSERT_EQ(P.get_capacity(), size_t(-1));
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration min_max_pyramid_test_registration(
+	"cgv::plot::min_max_pyramid", test_min_max_pyramid);
+
+extern CGV_API test_registration min_max_pyramid_ringbuffer_test_registration(
+	"cgv::plot::min_max_pyramid_ringbuffer", test_min_max_pyramid_ringbuffer);
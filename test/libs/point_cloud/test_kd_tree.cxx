@@ -0,0 +1,174 @@
+#include <cgv/base/register.h>
+#include <point_cloud/kd_tree.h>
+#include <algorithm>
+#include <random>
+
+using namespace cgv::base;
+
+typedef point_cloud_types::Pnt Pnt;
+typedef point_cloud_types::Box Box;
+typedef point_cloud_types::Crd Crd;
+typedef point_cloud_types::Idx Idx;
+
+/// construct point cloud with n random points on a grid of spacing 1/8, such that squared distances are exact and ties occur
+static void construct_grid_points(point_cloud& pc, size_t n, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> d(0, 31);
+	for (size_t i = 0; i < n; ++i)
+		pc.add_point(Pnt(d(rng) / 8.0f, d(rng) / 8.0f, d(rng) / 8.0f));
+}
+
+/// squared distance computed as in the leaf scans of kd_tree
+static Crd sqr_dist(const Pnt& p, const Pnt& q)
+{
+	Crd dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/// return sorted squared distances of all points to q
+static std::vector<Crd> brute_force_sqr_dists(const point_cloud& pc, const Pnt& q)
+{
+	std::vector<Crd> D;
+	for (Idx i = 0; i < Idx(pc.get_nr_points()); ++i)
+		D.push_back(sqr_dist(pc.pnt(i), q));
+	std::sort(D.begin(), D.end());
+	return D;
+}
+
+/// return whether knn are k distinct points sorted by distance whose distances are the k smallest ones
+static bool check_knn(const point_cloud& pc, const Pnt& q, Idx k, const std::vector<Idx>& knn, const std::vector<Crd>* sqr_dists = 0)
+{
+	std::vector<Crd> D = brute_force_sqr_dists(pc, q);
+	size_t m = std::min(size_t(k), D.size());
+	if (knn.size() != m)
+		return false;
+	std::vector<Idx> sorted_knn(knn);
+	std::sort(sorted_knn.begin(), sorted_knn.end());
+	if (std::adjacent_find(sorted_knn.begin(), sorted_knn.end()) != sorted_knn.end())
+		return false;
+	for (size_t j = 0; j < m; ++j) {
+		if (knn[j] < 0 || knn[j] >= Idx(pc.get_nr_points()) || sqr_dist(pc.pnt(knn[j]), q) != D[j])
+			return false;
+		if (sqr_dists && (*sqr_dists)[j] != D[j])
+			return false;
+	}
+	return true;
+}
+
+/// return whether p is inside the box including its boundary
+static bool inside_closed(const Box& box, const Pnt& p)
+{
+	for (int c = 0; c < 3; ++c)
+		if (p[c] < box.get_min_pnt()[c] || p[c] > box.get_max_pnt()[c])
+			return false;
+	return true;
+}
+
+bool test_kd_tree()
+{
+	point_cloud pc;
+	construct_grid_points(pc, 5000, 7);
+	kd_tree tree;
+	TEST_ASSERT(tree.is_empty());
+	tree.build(pc, 1);
+	TEST_ASSERT(!tree.is_empty());
+	TEST_ASSERT_EQ(tree.get_nr_points(), point_cloud_types::Cnt(5000));
+
+	// queries at random positions inside and outside of the grid are compared against brute force
+	std::mt19937 rng(11);
+	std::uniform_int_distribution<int> d(-8, 39);
+	std::vector<Pnt> queries;
+	for (int i = 0; i < 200; ++i)
+		queries.push_back(Pnt(d(rng) / 8.0f, d(rng) / 8.0f, d(rng) / 8.0f));
+	queries.push_back(pc.pnt(17));
+
+	for (const Pnt& q : queries) {
+		// single knn
+		for (Idx k : { 1, 7, 32 }) {
+			std::vector<Idx> knn;
+			std::vector<Crd> sqr_dists;
+			tree.find_knn(q, k, knn, &sqr_dists);
+			TEST_ASSERT(check_knn(pc, q, k, knn, &sqr_dists));
+		}
+		// closest point
+		Idx ci = tree.find_closest(q);
+		TEST_ASSERT_EQ(sqr_dist(pc.pnt(ci), q), brute_force_sqr_dists(pc, q).front());
+
+		// radius query with radii that hit grid distances exactly
+		for (Crd radius : { 0.0f, 0.125f, 0.25f, 0.5f }) {
+			std::vector<Idx> result, expected;
+			std::vector<Crd> sqr_dists;
+			tree.find_in_radius(q, radius, result, &sqr_dists);
+			for (Idx i = 0; i < Idx(pc.get_nr_points()); ++i)
+				if (sqr_dist(pc.pnt(i), q) <= radius * radius)
+					expected.push_back(i);
+			TEST_ASSERT_EQ(result.size(), expected.size());
+			TEST_ASSERT(std::is_sorted(sqr_dists.begin(), sqr_dists.end()));
+			bool distances_match = sqr_dists.size() == result.size();
+			for (size_t j = 0; distances_match && j < result.size(); ++j)
+				distances_match = sqr_dists[j] == sqr_dist(pc.pnt(result[j]), q);
+			TEST_ASSERT(distances_match);
+			std::sort(result.begin(), result.end());
+			TEST_ASSERT(result == expected);
+		}
+
+		// box query with box boundaries on the grid, which are inclusive
+		Box box(q - Pnt(0.25f, 0.5f, 0.125f), q + Pnt(0.5f, 0.25f, 0.375f));
+		std::vector<Idx> result, expected;
+		tree.find_in_box(box, result);
+		for (Idx i = 0; i < Idx(pc.get_nr_points()); ++i)
+			if (inside_closed(box, pc.pnt(i)))
+				expected.push_back(i);
+		std::sort(result.begin(), result.end());
+		TEST_ASSERT(result == expected);
+	}
+
+	// batched knn agrees with single queries independent of the number of threads and pads missing neighbors with -1
+	const Idx k = 9;
+	std::vector<Idx> batched, batched_parallel;
+	tree.find_knn(queries, k, batched, 1);
+	tree.find_knn(queries, k, batched_parallel, 0);
+	TEST_ASSERT_EQ(batched.size(), queries.size() * k);
+	TEST_ASSERT(batched == batched_parallel);
+	bool batched_correct = true;
+	for (size_t qi = 0; qi < queries.size(); ++qi) {
+		std::vector<Idx> knn(batched.begin() + qi * k, batched.begin() + (qi + 1) * k);
+		batched_correct = batched_correct && check_knn(pc, queries[qi], k, knn);
+	}
+	TEST_ASSERT(batched_correct);
+	point_cloud small_pc;
+	construct_grid_points(small_pc, 3, 5);
+	kd_tree small_tree;
+	small_tree.build(small_pc);
+	std::vector<Idx> small_batched;
+	small_tree.find_knn(queries, 5, small_batched);
+	TEST_ASSERT_EQ(small_batched.size(), queries.size() * 5);
+	TEST_ASSERT_EQ(std::count(small_batched.begin(), small_batched.end(), Idx(-1)), std::ptrdiff_t(queries.size() * 2));
+
+	// parallel construction yields the same answers
+	kd_tree parallel_tree;
+	parallel_tree.build(pc, 0);
+	std::vector<Idx> parallel_batched;
+	parallel_tree.find_knn(queries, k, parallel_batched, 1);
+	bool parallel_correct = true;
+	for (size_t qi = 0; qi < queries.size(); ++qi) {
+		std::vector<Idx> knn(parallel_batched.begin() + qi * k, parallel_batched.begin() + (qi + 1) * k);
+		parallel_correct = parallel_correct && check_knn(pc, queries[qi], k, knn);
+	}
+	TEST_ASSERT(parallel_correct);
+
+	// an empty tree answers all queries with empty results
+	tree.clear();
+	TEST_ASSERT(tree.is_empty());
+	std::vector<Idx> empty_result;
+	tree.find_in_radius(queries[0], 1.0f, empty_result);
+	TEST_ASSERT(empty_result.empty());
+	TEST_ASSERT_EQ(tree.find_closest(queries[0]), Idx(-1));
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration kd_tree_test_registration(
+	"point_cloud::kd_tree", test_kd_tree);
@@ -0,0 +1,242 @@
+#include <cgv/base/register.h>
+#include <point_cloud/lod_octree.h>
+#include <test/temp_file_name.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+using namespace cgv::base;
+
+typedef point_cloud_types::Pnt Pnt;
+typedef point_cloud_types::Box Box;
+typedef point_cloud_types::HMat HMat;
+typedef point_cloud_types::Crd Crd;
+typedef point_cloud_types::Idx Idx;
+
+/// construct points on a plane with 300 x 300 points in [0,3)x[0,3)x{1}
+static void construct_plane(point_cloud& pc)
+{
+	for (int i = 0; i < 300; ++i)
+		for (int j = 0; j < 300; ++j)
+			pc.add_point(Pnt(0.01f * i, 0.01f * j, 1.0f));
+}
+
+/// convert point cloud and check that the file contains each point exactly once in a node whose box contains it
+static bool check_conversion(const point_cloud& pc, lod_octree_converter& converter, lod_octree_file& lof)
+{
+	std::string file_name = get_temp_file_name("test_lod_octree.poct");
+	if (!converter.convert(pc, file_name))
+		return false;
+	FILE* fp = fopen(file_name.c_str(), "rb");
+	if (!fp)
+		return false;
+	bool success = lof.read_header(fp);
+	size_t nr_points = 0;
+	std::vector<Pnt> P;
+	for (const auto& node : lof.nodes) {
+		if (!success)
+			break;
+		P.resize(node.nr_points);
+		success = fseek(fp, long(node.chunk_offset), SEEK_SET) == 0 &&
+			(P.empty() || fread(&P[0], sizeof(Pnt), P.size(), fp) == P.size());
+		Box box = node.box;
+		box.ref_min_pnt() -= Pnt(1e-5f);
+		box.ref_max_pnt() += Pnt(1e-5f);
+		for (const Pnt& p : P)
+			success = success && box.inside(p);
+		nr_points += P.size();
+	}
+	fclose(fp);
+	std::remove(file_name.c_str());
+	return success && lof.nr_points == pc.get_nr_points() && nr_points == pc.get_nr_points();
+}
+
+bool test_lod_octree()
+{
+	// points on a plane are split into several levels with decreasing spacing
+	point_cloud pc;
+	construct_plane(pc);
+	lod_octree_converter converter;
+	converter.max_chunk_size = 1000;
+	converter.grid_resolution = 16;
+	lod_octree_file lof;
+	TEST_ASSERT(check_conversion(pc, converter, lof));
+	TEST_ASSERT(lof.nodes.size() > 9);
+	TEST_ASSERT(!lof.nodes[0].is_leaf());
+	TEST_ASSERT(lof.nodes[0].spacing > 0);
+	for (const auto& node : lof.nodes)
+		for (int o = 0; o < 8; ++o)
+			if (node.children[o] != -1)
+				TEST_ASSERT(lof.nodes[node.children[o]].spacing < node.spacing);
+
+	// coincident points do not lead to cells of zero size
+	point_cloud coincident_pc;
+	for (int i = 0; i < 5000; ++i)
+		coincident_pc.add_point(Pnt(1, 2, 3));
+	TEST_ASSERT(check_conversion(coincident_pc, converter, lof));
+	TEST_ASSERT(lof.nodes[0].box.get_extent()[0] > 0);
+
+	// empty point clouds result in a single empty node
+	TEST_ASSERT(check_conversion(point_cloud(), converter, lof));
+	TEST_ASSERT_EQ(lof.nodes.size(), size_t(1));
+	return true;
+}
+
+/// return orthographic projection that maps [x0,x1]x[y0,y1]x[-1,3] to the clip cube
+static HMat get_view(Crd x0, Crd x1, Crd y0, Crd y1)
+{
+	HMat M;
+	M.zeros();
+	M(0, 0) = 2 / (x1 - x0);
+	M(0, 3) = -(x1 + x0) / (x1 - x0);
+	M(1, 1) = 2 / (y1 - y0);
+	M(1, 3) = -(y1 + y0) / (y1 - y0);
+	M(2, 2) = 0.5f;
+	M(2, 3) = -0.5f;
+	M(3, 3) = 1;
+	return M;
+}
+
+/// update the streamer until all selected chunks are resident or a timeout is reached
+static bool wait_for_chunks(lod_octree_streamer& streamer, const HMat& view, const Pnt& eye, Crd pixel_scale)
+{
+	auto start = std::chrono::steady_clock::now();
+	while (streamer.update(view, eye, pixel_scale)) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(30))
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+/// return sum of the point counts of the given nodes
+static size_t get_nr_points(const lod_octree_file& lof, const std::vector<Idx>& node_indices)
+{
+	size_t n = 0;
+	for (Idx ni : node_indices)
+		n += lof.nodes[ni].nr_points;
+	return n;
+}
+
+/// overwrite the 32 bit word at the given index of a file, or truncate the file to the given size if size is not zero
+static bool modify_file(const std::string& file_name, size_t word_index, cgv::type::uint32_type value, size_t size = 0)
+{
+	std::ifstream is(file_name.c_str(), std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	is.close();
+	if (size > 0)
+		content.resize(size);
+	else
+		memcpy(&content[word_index * sizeof(value)], &value, sizeof(value));
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	os << content;
+	return os.good();
+}
+
+bool test_lod_octree_streamer()
+{
+	std::string file_name = get_temp_file_name("test_lod_octree_streamer.poct");
+	point_cloud pc;
+	construct_plane(pc);
+	lod_octree_converter converter;
+	converter.max_chunk_size = 1000;
+	converter.grid_resolution = 16;
+	TEST_ASSERT(converter.convert(pc, file_name));
+
+	lod_octree_streamer streamer;
+	TEST_ASSERT(streamer.open(file_name));
+	const lod_octree_file& lof = streamer.get_file();
+	Pnt eye(1.5f, 1.5f, 10.0f);
+	Crd pixel_scale = 500;
+	HMat full_view = get_view(-1, 4, -1, 4);
+
+	// a large screen space error threshold selects only the root, whose chunk is loaded by the loader thread
+	streamer.max_screen_space_error = 1e30f;
+	TEST_ASSERT(streamer.update(full_view, eye, pixel_scale));
+	TEST_ASSERT(streamer.get_selected_nodes() == std::vector<Idx>(1, 0));
+	TEST_ASSERT(wait_for_chunks(streamer, full_view, eye, pixel_scale));
+	TEST_ASSERT(streamer.get_chunk(0) != 0);
+	TEST_ASSERT_EQ(streamer.get_chunk(0)->P.size(), size_t(lof.nodes[0].nr_points));
+	TEST_ASSERT_EQ(streamer.get_nr_resident_points(), size_t(lof.nodes[0].nr_points));
+
+	// without threshold all visible nodes are selected after their parents and together contain all points
+	streamer.max_screen_space_error = 0;
+	TEST_ASSERT(wait_for_chunks(streamer, full_view, eye, pixel_scale));
+	std::vector<Idx> selected = streamer.get_selected_nodes();
+	TEST_ASSERT_EQ(selected.size(), lof.nodes.size());
+	std::vector<size_t> position(lof.nodes.size());
+	for (size_t j = 0; j < selected.size(); ++j)
+		position[selected[j]] = j;
+	bool parents_first = true;
+	for (Idx ni = 0; ni < Idx(lof.nodes.size()); ++ni)
+		for (Idx ci : lof.nodes[ni].children)
+			parents_first = parents_first && (ci == -1 || position[ni] < position[ci]);
+	TEST_ASSERT(parents_first);
+	TEST_ASSERT_EQ(streamer.get_nr_resident_points(), pc.get_nr_points());
+	std::vector<Pnt> P, Q;
+	for (Idx ni : selected)
+		P.insert(P.end(), streamer.get_chunk(ni)->P.begin(), streamer.get_chunk(ni)->P.end());
+	for (size_t i = 0; i < pc.get_nr_points(); ++i)
+		Q.push_back(pc.pnt(i));
+	auto less = [](const Pnt& p, const Pnt& q) { return std::lexicographical_compare(p.begin(), p.end(), q.begin(), q.end()); };
+	std::sort(P.begin(), P.end(), less);
+	std::sort(Q.begin(), Q.end(), less);
+	TEST_ASSERT(P == Q);
+
+	// nodes outside of the view frustum are culled
+	TEST_ASSERT(!streamer.update(get_view(-1, 1.4f, -1, 4), eye, pixel_scale));
+	std::vector<Idx> left = streamer.get_selected_nodes();
+	TEST_ASSERT(left.size() < lof.nodes.size());
+	for (Idx ni : left)
+		TEST_ASSERT(lof.nodes[ni].box.get_min_pnt()[0] <= 1.4f);
+	TEST_ASSERT(!streamer.update(get_view(1.6f, 4, -1, 4), eye, pixel_scale));
+	std::vector<Idx> right = streamer.get_selected_nodes();
+	TEST_ASSERT(right.size() < lof.nodes.size());
+	for (Idx ni : right)
+		TEST_ASSERT(lof.nodes[ni].box.get_max_pnt()[0] >= 1.6f);
+
+	// reducing the point budget evicts the least recently used chunks first, such that the chunks of the right view remain
+	streamer.point_budget = get_nr_points(lof, right);
+	streamer.max_screen_space_error = 1e30f;
+	TEST_ASSERT(!streamer.update(full_view, eye, pixel_scale));
+	TEST_ASSERT_EQ(streamer.get_nr_resident_points(), get_nr_points(lof, right));
+	for (Idx ni : right)
+		TEST_ASSERT(streamer.get_chunk(ni) != 0);
+
+	// the point budget limits the selection and the resident points
+	streamer.max_screen_space_error = 0;
+	streamer.point_budget = lof.nodes[0].nr_points + 2000;
+	TEST_ASSERT(wait_for_chunks(streamer, full_view, eye, pixel_scale));
+	TEST_ASSERT(streamer.get_selected_nodes().size() < lof.nodes.size());
+	TEST_ASSERT(get_nr_points(lof, streamer.get_selected_nodes()) <= streamer.point_budget);
+	TEST_ASSERT(streamer.get_nr_resident_points() <= streamer.point_budget);
+	streamer.close();
+	TEST_ASSERT(!streamer.is_open());
+
+	// files of other versions, with other node record sizes or with truncated node tables are rejected
+	TEST_ASSERT(modify_file(file_name, 1, 1));
+	TEST_ASSERT(!streamer.open(file_name));
+	TEST_ASSERT(converter.convert(pc, file_name));
+	TEST_ASSERT(modify_file(file_name, 4, lod_octree_file::node_record_size + 4));
+	TEST_ASSERT(!streamer.open(file_name));
+	TEST_ASSERT(converter.convert(pc, file_name));
+	TEST_ASSERT(modify_file(file_name, 0, 0, 28 + 5 * lod_octree_file::node_record_size));
+	TEST_ASSERT(!streamer.open(file_name));
+	TEST_ASSERT(converter.convert(pc, file_name));
+	TEST_ASSERT(streamer.open(file_name));
+	streamer.close();
+	std::remove(file_name.c_str());
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration lod_octree_test_registration(
+	"point_cloud::lod_octree", test_lod_octree);
+
+extern CGV_API test_registration lod_octree_streamer_test_registration(
+	"point_cloud::lod_octree_streamer", test_lod_octree_streamer);
\ No newline at end of file
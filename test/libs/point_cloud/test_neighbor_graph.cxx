@@ -0,0 +1,64 @@
+#include <cgv/base/register.h>
+#include <point_cloud/kd_tree.h>
+#include <point_cloud/neighbor_graph.h>
+
+using namespace cgv::base;
+
+typedef point_cloud_types::Pnt Pnt;
+typedef graph_location::Idx Idx;
+
+/// construct point cloud from n points on a helix
+static void construct_helix(point_cloud& pc, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+		pc.add_point(Pnt(cos(0.1f * i), sin(0.1f * i), 0.01f * i));
+}
+
+bool test_neighbor_graph()
+{
+	point_cloud pc;
+	construct_helix(pc, 10000);
+	kd_tree tree;
+	tree.build(pc);
+
+	// flat and vector of vector graphs agree and do not depend on the number of threads
+	const graph_location::Cnt k = 6;
+	neighbor_graph ng;
+	ng.build(graph_location::Cnt(pc.get_nr_points()), k, tree);
+	csr_neighbor_graph g, g0;
+	g.build(graph_location::Cnt(pc.get_nr_points()), k, tree);
+	g0.build(graph_location::Cnt(pc.get_nr_points()), k, tree, neighbor_graph_progress_callback(), 0);
+	TEST_ASSERT_EQ(g.get_nr_vertices(), 10000u);
+	TEST_ASSERT_EQ(g.get_nr_half_edges(), size_t(10000 * k));
+	TEST_ASSERT(g.neighbors == g0.neighbors);
+	bool rows_equal = true;
+	for (Idx i = 0; i < Idx(ng.size()); ++i)
+		if (g.get_degree(i) != ng[i].size() || !std::equal(g.begin(i), g.end(i), ng[i].begin()))
+			rows_equal = false;
+	TEST_ASSERT(rows_equal);
+	csr_neighbor_graph g1;
+	g1.build(ng);
+	TEST_ASSERT(g1.row_offsets == g.row_offsets && g1.neighbors == g.neighbors);
+
+	// rows of points with less than k neighbors are padded with the point itself
+	point_cloud small_pc;
+	construct_helix(small_pc, 4);
+	kd_tree small_tree;
+	small_tree.build(small_pc);
+	csr_neighbor_graph sg;
+	sg.build(4, k, small_tree);
+	TEST_ASSERT_EQ(sg.get_nr_half_edges(), size_t(4 * k));
+	for (Idx i = 0; i < 4; ++i) {
+		std::vector<Idx> N(sg.begin(i), sg.end(i));
+		TEST_ASSERT_EQ(std::count(N.begin(), N.end(), i), std::ptrdiff_t(k - 3));
+		for (Idx j = 0; j < 4; ++j)
+			if (j != i)
+				TEST_ASSERT_EQ(std::count(N.begin(), N.begin() + 3, j), std::ptrdiff_t(1));
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration neighbor_graph_test_registration(
+	"point_cloud::neighbor_graph", test_neighbor_graph);
@@ -0,0 +1,75 @@
+#include <cgv/base/register.h>
+#include <point_cloud/kd_tree.h>
+#include <point_cloud/normal_orientation.h>
+
+using namespace cgv::base;
+
+typedef point_cloud_types::Pnt Pnt;
+typedef point_cloud_types::Nml Nml;
+
+/// orient copy of point cloud with given number of threads and return forest
+static std::vector<std::pair<graph_location::Idx, graph_location::Idx> > orient(point_cloud& pc, unsigned nr_threads, size_t& nr_components)
+{
+	kd_tree tree;
+	tree.build(pc);
+	csr_neighbor_graph g;
+	g.build(graph_location::Cnt(pc.get_nr_points()), 8, tree);
+	normal_orientation no(nr_threads);
+	no.orient(pc, g);
+	nr_components = no.get_nr_components();
+	return no.get_forest();
+}
+
+/// orient normals with random signs on a sphere with coincident points and of a plane with equal edge weights
+bool test_normal_orientation()
+{
+	// points on a sphere with every tenth point duplicated and normals flipped by a fixed pattern
+	point_cloud sphere;
+	sphere.create_normals();
+	const int n = 20000;
+	for (int i = 0; i < n; ++i) {
+		float z = 1 - (2 * i + 1.0f) / n, r = sqrt(1 - z * z), phi = 2.3999632f * i;
+		Pnt p(r * cos(phi), r * sin(phi), z);
+		for (int j = 0; j < (i % 10 == 0 ? 2 : 1); ++j) {
+			size_t pi = sphere.add_point(p);
+			sphere.nml(pi) = ((pi * 7919) % 3 == 0) ? -p : p;
+		}
+	}
+	point_cloud sphere1 = sphere;
+	size_t nr_components, nr_components1;
+	auto forest = orient(sphere, 1, nr_components);
+	auto forest1 = orient(sphere1, 4, nr_components1);
+	TEST_ASSERT_EQ(nr_components, size_t(1));
+	TEST_ASSERT_EQ(nr_components1, size_t(1));
+	TEST_ASSERT(forest == forest1);
+	TEST_ASSERT_EQ(forest.size(), sphere.get_nr_points() - 1);
+	size_t nr_inward = 0;
+	for (size_t i = 0; i < sphere.get_nr_points(); ++i)
+		if (!(dot(sphere.nml(i), sphere.pnt(i)) > 0))
+			++nr_inward;
+	TEST_ASSERT_EQ(nr_inward, size_t(0));
+
+	// ties of the weights on a regular grid do not make the forest depend on the number of threads
+	point_cloud plane;
+	plane.create_normals();
+	for (int i = 0; i < 100; ++i)
+		for (int j = 0; j < 100; ++j) {
+			size_t pi = plane.add_point(Pnt(float(i), float(j), 0));
+			plane.nml(pi) = Nml(0, 0, (i + j) % 2 == 0 ? 1.0f : -1.0f);
+		}
+	point_cloud plane1 = plane;
+	forest = orient(plane, 1, nr_components);
+	forest1 = orient(plane1, 4, nr_components1);
+	TEST_ASSERT(forest == forest1);
+	TEST_ASSERT_EQ(nr_components, size_t(1));
+	bool consistent = true;
+	for (size_t i = 0; i < plane.get_nr_points(); ++i)
+		consistent = consistent && plane.nml(i) == plane.nml(0);
+	TEST_ASSERT(consistent);
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration normal_orientation_test_registration(
+	"point_cloud::normal_orientation", test_normal_orientation);
@@ -0,0 +1,73 @@
+#include <cgv/base/register.h>
+#include <point_cloud/point_cloud.h>
+#include <cstdio>
+
+using namespace cgv::base;
+
+typedef point_cloud_types::Pnt Pnt;
+typedef point_cloud_types::Nml Nml;
+
+/// write point cloud with normals and named components to the aligned bin layout and read it back
+bool test_point_cloud_bin()
+{
+	point_cloud pc;
+	pc.create_normals();
+	pc.create_components();
+	for (int ci = 0; ci < 3; ++ci) {
+		if (ci > 0)
+			pc.add_component();
+		pc.component_name(ci) = ci == 1 ? "" : "scan " + std::to_string(ci);
+		for (int i = 0; i < 10 * (ci + 1); ++i) {
+			size_t pi = pc.add_point(Pnt(float(i), float(ci), 0));
+			pc.nml(pi) = Nml(0, 0, 1);
+		}
+	}
+	TEST_ASSERT(pc.write("test_point_cloud.bpc"));
+
+	point_cloud pc1;
+	TEST_ASSERT(pc1.read("test_point_cloud.bpc"));
+	TEST_ASSERT_EQ(pc1.get_nr_points(), size_t(60));
+	TEST_ASSERT(pc1.has_normals());
+	TEST_ASSERT_EQ(pc1.get_nr_components(), size_t(3));
+	TEST_ASSERT_EQ(pc1.component_name(0), std::string("scan 0"));
+	TEST_ASSERT_EQ(pc1.component_name(1), std::string());
+	TEST_ASSERT_EQ(pc1.component_name(2), std::string("scan 2"));
+	TEST_ASSERT_EQ(pc1.component_point_range(2).index_of_first_point, size_t(30));
+	TEST_ASSERT_EQ(pc1.component_point_range(2).nr_points, size_t(30));
+	TEST_ASSERT(pc1.pnt(59) == Pnt(29, 2, 0));
+	TEST_ASSERT(pc1.nml(59) == Nml(0, 0, 1));
+	TEST_ASSERT(pc1.is_mapped());
+
+	// a mapped cloud can be written back to the file it is mapped from and stays valid
+	TEST_ASSERT(pc1.write("test_point_cloud.bpc"));
+	TEST_ASSERT(pc1.is_mapped());
+	TEST_ASSERT(pc1.pnt(59) == Pnt(29, 2, 0));
+	point_cloud pc3;
+	TEST_ASSERT(pc3.read("test_point_cloud.bpc"));
+	TEST_ASSERT(pc3.is_mapped());
+	TEST_ASSERT_EQ(pc3.get_nr_points(), size_t(60));
+	TEST_ASSERT_EQ(pc3.component_name(2), std::string("scan 2"));
+	TEST_ASSERT(pc3.pnt(59) == Pnt(29, 2, 0));
+	TEST_ASSERT(pc3.nml(59) == Nml(0, 0, 1));
+
+	// color components of other sizes than one or four bytes are rejected
+	point_cloud pc2;
+	pc2.create_colors();
+	pc2.add_point(Pnt(0, 0, 0));
+	TEST_ASSERT(pc2.write("test_point_cloud.bpc"));
+	FILE* fp = fopen("test_point_cloud.bpc", "r+b");
+	TEST_ASSERT(fp != 0);
+	cgv::type::uint32_type color_component_size = 2;
+	// color component size is the sixth word of the header
+	TEST_ASSERT(fseek(fp, 5 * sizeof(cgv::type::uint32_type), SEEK_SET) == 0);
+	TEST_ASSERT(fwrite(&color_component_size, sizeof(color_component_size), 1, fp) == 1);
+	TEST_ASSERT(fclose(fp) == 0);
+	TEST_ASSERT(!pc1.read("test_point_cloud.bpc"));
+	std::remove("test_point_cloud.bpc");
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration point_cloud_bin_test_registration(
+	"point_cloud::point_cloud_bin", test_point_cloud_bin);
@@ -0,0 +1,129 @@
+#include <cgv/base/register.h>
+#include <rgbd_input.h>
+#include <test/temp_file_name.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+using namespace cgv::base;
+using namespace rgbd;
+
+/// construct frame i of a stream with pixel values depending on the frame index
+static void construct_frame(frame_type& frame, int w, int h, PixelFormat pf, unsigned nr_bits, unsigned i)
+{
+	frame.width = w;
+	frame.height = h;
+	frame.pixel_format = pf;
+	frame.nr_bits_per_pixel = nr_bits;
+	frame.compute_buffer_size();
+	frame.frame_index = i;
+	frame.time = i / 30.0;
+	frame.frame_data.resize(frame.buffer_size);
+	for (size_t j = 0; j < frame.frame_data.size(); ++j)
+		frame.frame_data[j] = char(j * 7 + i * 31);
+}
+
+/// return whether two frames have the same format and data
+static bool equal_frames(const frame_type& a, const frame_type& b)
+{
+	return a.width == b.width && a.height == b.height && a.pixel_format == b.pixel_format &&
+		a.nr_bits_per_pixel == b.nr_bits_per_pixel && a.frame_data == b.frame_data;
+}
+
+/// wait for the next frame of the replay, which is delivered with the frame rate of the emulation
+static bool wait_for_frame(rgbd_input& rgbd_inp, InputStreams is, frame_type& frame)
+{
+	auto start = std::chrono::steady_clock::now();
+	while (!rgbd_inp.get_frame(is, frame, 0)) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(2))
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+/// replay frames of both recorded streams twice and check that replay restarts after the last frame
+static bool check_replay(rgbd_input& rgbd_inp, const std::vector<frame_type>& depth_frames, const std::vector<frame_type>& color_frames)
+{
+	std::vector<stream_format> stream_formats;
+	if (!rgbd_inp.start(IS_COLOR_AND_DEPTH, stream_formats) || stream_formats.size() != 2)
+		return false;
+	// recorded formats are reported in the order color, depth
+	if (stream_formats[0].width != 16 || stream_formats[0].height != 12 || stream_formats[0].pixel_format != PF_BGR ||
+		stream_formats[0].nr_bits_per_pixel != 24 || stream_formats[1].width != 8 || stream_formats[1].height != 6 ||
+		stream_formats[1].pixel_format != PF_DEPTH || stream_formats[1].nr_bits_per_pixel != 16)
+		return false;
+	frame_type frame;
+	// infrared has not been recorded
+	if (rgbd_inp.get_frame(IS_INFRARED, frame, 0))
+		return false;
+	for (size_t i = 0; i < 2 * depth_frames.size(); ++i) {
+		if (!wait_for_frame(rgbd_inp, IS_DEPTH, frame) || !equal_frames(frame, depth_frames[i % depth_frames.size()]))
+			return false;
+		if (!wait_for_frame(rgbd_inp, IS_COLOR, frame) || !equal_frames(frame, color_frames[i % color_frames.size()]))
+			return false;
+	}
+	return rgbd_inp.stop();
+}
+
+bool test_rgbd_emulation()
+{
+	const unsigned nr_frames = 3;
+	std::vector<frame_type> depth_frames(nr_frames), color_frames(nr_frames);
+	for (unsigned i = 0; i < nr_frames; ++i) {
+		construct_frame(depth_frames[i], 8, 6, PF_DEPTH, 16, i);
+		construct_frame(color_frames[i], 16, 12, PF_BGR, 24, i);
+	}
+
+	// replay of frames protocolled into individual files
+	std::string base_name = get_temp_file_name("test_rgbd_emulation_");
+	std::vector<std::string> file_names;
+	for (unsigned i = 0; i < nr_frames; ++i) {
+		file_names.push_back(compose_file_name(base_name, depth_frames[i], i));
+		file_names.push_back(compose_file_name(base_name, color_frames[i], i));
+		TEST_ASSERT(rgbd_input::write_frame(file_names[file_names.size() - 2], depth_frames[i]));
+		TEST_ASSERT(rgbd_input::write_frame(file_names.back(), color_frames[i]));
+	}
+	rgbd_input rgbd_inp;
+	TEST_ASSERT(rgbd_inp.attach_path(base_name));
+	TEST_ASSERT(rgbd_inp.is_attached());
+	TEST_ASSERT(check_replay(rgbd_inp, depth_frames, color_frames));
+
+	// recorded color frames are resampled to the depth resolution
+	frame_type warped_color_frame;
+	rgbd_inp.map_color_to_depth(depth_frames[1], color_frames[1], warped_color_frame);
+	TEST_ASSERT_EQ(warped_color_frame.width, 8);
+	TEST_ASSERT_EQ(warped_color_frame.height, 6);
+	TEST_ASSERT_EQ(warped_color_frame.pixel_format, PF_BGR);
+	TEST_ASSERT_EQ(warped_color_frame.frame_data.size(), size_t(8 * 6 * 3));
+	bool resampled = true;
+	for (int y = 0; y < 6; ++y)
+		for (int x = 0; x < 8; ++x)
+			for (int c = 0; c < 3; ++c)
+				resampled = resampled && warped_color_frame.frame_data[(y * 8 + x) * 3 + c] == color_frames[1].frame_data[(2 * y * 16 + 2 * x) * 3 + c];
+	TEST_ASSERT(resampled);
+	TEST_ASSERT(rgbd_inp.detach());
+	for (const auto& fn : file_names)
+		std::remove(fn.c_str());
+
+	// replay of a recording file
+	std::string recording_name = get_temp_file_name(std::string("test_rgbd_emulation.") + get_recording_extension());
+	rgbd_recorder recorder;
+	TEST_ASSERT(recorder.open(recording_name, true));
+	for (unsigned i = 0; i < nr_frames; ++i) {
+		TEST_ASSERT(recorder.write_frame(IS_DEPTH, depth_frames[i]));
+		TEST_ASSERT(recorder.write_frame(IS_COLOR, color_frames[i]));
+	}
+	TEST_ASSERT(recorder.close());
+	TEST_ASSERT(rgbd_inp.attach_path(recording_name));
+	TEST_ASSERT(check_replay(rgbd_inp, depth_frames, color_frames));
+	TEST_ASSERT(rgbd_inp.detach());
+	std::remove(recording_name.c_str());
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration rgbd_emulation_test_registration(
+	"rgbd::rgbd_emulation", test_rgbd_emulation);
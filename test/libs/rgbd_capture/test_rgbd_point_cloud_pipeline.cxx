@@ -0,0 +1,165 @@
+#include <cgv/base/register.h>
+#include <rgbd_point_cloud_pipeline.h>
+#include <test/temp_file_name.h>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace cgv::base;
+using namespace rgbd;
+
+typedef rgbd_point_cloud_pipeline::vec3 vec3;
+typedef rgbd_point_cloud_pipeline::dvec2 dvec2;
+typedef rgbd_point_cloud_pipeline::rgba8 rgba8;
+
+/// construct depth frame with holes, where player indices are stored in the lower three bits if with_player is true
+static void construct_depth_frame(frame_type& frame, int w, int h, bool with_player)
+{
+	frame.width = w;
+	frame.height = h;
+	frame.pixel_format = with_player ? PF_DEPTH_AND_PLAYER : PF_DEPTH;
+	frame.nr_bits_per_pixel = 16;
+	frame.compute_buffer_size();
+	frame.frame_index = 0;
+	frame.time = 0;
+	frame.frame_data.resize(frame.buffer_size);
+	uint16_t* depths = reinterpret_cast<uint16_t*>(frame.frame_data.data());
+	for (int y = 0; y < h; ++y)
+		for (int x = 0; x < w; ++x) {
+			uint16_t d = (7 * x + 3 * y) % 11 == 0 ? 0 : uint16_t(500 + 13 * x + 7 * y);
+			depths[y * w + x] = with_player ? uint16_t(d << 3 | x % 8) : d;
+		}
+}
+
+/// construct color frame with 24 or 32 bits per pixel, whose channels encode the pixel position
+static void construct_color_frame(frame_type& frame, int w, int h, PixelFormat pf)
+{
+	frame.width = w;
+	frame.height = h;
+	frame.pixel_format = pf;
+	frame.nr_bits_per_pixel = pf == PF_RGBA || pf == PF_BGRA ? 32 : 24;
+	frame.compute_buffer_size();
+	frame.frame_index = 0;
+	frame.time = 0;
+	frame.frame_data.resize(frame.buffer_size);
+	unsigned entry_size = frame.nr_bits_per_pixel / 8;
+	for (int y = 0; y < h; ++y)
+		for (int x = 0; x < w; ++x) {
+			char* c = &frame.frame_data[(y * w + x) * entry_size];
+			c[0] = char(x);
+			c[1] = char(y);
+			c[2] = char(x + 2 * y);
+			if (entry_size == 4)
+				c[3] = char(7);
+		}
+}
+
+/** return whether P and C are the back projection of the valid depth values in row major order, where points are
+    computed per pixel with the pinhole model and colors are sampled from the color frame with nearest neighbor */
+static bool check_point_cloud(const frame_type& depth_frame, const frame_type* color_frame, const dvec2& ctr, const dvec2& f,
+	const std::vector<vec3>& P, const std::vector<rgba8>& C)
+{
+	const uint16_t* depths = reinterpret_cast<const uint16_t*>(depth_frame.frame_data.data());
+	unsigned shift = depth_frame.pixel_format == PF_DEPTH_AND_PLAYER ? 3 : 0;
+	int w = depth_frame.width, h = depth_frame.height;
+	size_t k = 0;
+	for (int y = 0; y < h; ++y)
+		for (int x = 0; x < w; ++x) {
+			unsigned d = depths[y * w + x] >> shift;
+			if (d == 0)
+				continue;
+			if (k >= P.size())
+				return false;
+			double z = 0.001 * d;
+			vec3 p(float(z * (x - ctr(0)) / f(0)), float(z * (y - ctr(1)) / f(1)), float(z));
+			if ((P[k] - p).length() > 1e-6f)
+				return false;
+			if (color_frame) {
+				if (k >= C.size())
+					return false;
+				int cx = x * color_frame->width / w, cy = y * color_frame->height / h;
+				unsigned entry_size = color_frame->nr_bits_per_pixel / 8;
+				const unsigned char* c = reinterpret_cast<const unsigned char*>(&color_frame->frame_data[(cy * color_frame->width + cx) * entry_size]);
+				bool bgr = color_frame->pixel_format == PF_BGR || color_frame->pixel_format == PF_BGRA;
+				if (!(C[k] == rgba8(c[bgr ? 2 : 0], c[1], c[bgr ? 0 : 2], 255)))
+					return false;
+			}
+			++k;
+		}
+	return k == P.size() && C.size() == (color_frame ? P.size() : 0);
+}
+
+/// submit frames and wait for the resulting point cloud
+static bool convert_frames(rgbd_point_cloud_pipeline& pipeline, const frame_type& depth_frame, const frame_type* color_frame,
+	bool remap_color, std::vector<vec3>& P, std::vector<rgba8>& C)
+{
+	pipeline.submit_frames(depth_frame, color_frame, remap_color);
+	auto start = std::chrono::steady_clock::now();
+	while (!pipeline.retrieve_point_cloud(P, C)) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10))
+			return false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+bool test_rgbd_point_cloud_pipeline()
+{
+	rgbd_input rgbd_inp;
+	rgbd_point_cloud_pipeline pipeline(rgbd_inp, 3);
+	dvec2 ctr(31.5, 20.25), f(57.5, 61.0);
+	pipeline.set_intrinsics(ctr, f);
+	std::vector<vec3> P;
+	std::vector<rgba8> C;
+
+	// depth frame without colors, whose rows are split into blocks processed by three tasks
+	frame_type depth_frame;
+	construct_depth_frame(depth_frame, 64, 48, false);
+	TEST_ASSERT(convert_frames(pipeline, depth_frame, 0, true, P, C));
+	TEST_ASSERT(check_point_cloud(depth_frame, 0, ctr, f, P, C));
+
+	// depth values with player index and color frames at depth resolution that are not remapped
+	construct_depth_frame(depth_frame, 64, 48, true);
+	frame_type color_frame;
+	for (PixelFormat pf : { PF_BGR, PF_RGB, PF_BGRA, PF_RGBA }) {
+		construct_color_frame(color_frame, 64, 48, pf);
+		TEST_ASSERT(convert_frames(pipeline, depth_frame, &color_frame, false, P, C));
+		TEST_ASSERT(check_point_cloud(depth_frame, &color_frame, ctr, f, P, C));
+	}
+
+	// the ray table follows changes of the resolution and the intrinsics
+	ctr = dvec2(18.0, 11.5);
+	f = dvec2(40.0, 38.5);
+	pipeline.set_intrinsics(ctr, f);
+	construct_depth_frame(depth_frame, 37, 23, false);
+	construct_color_frame(color_frame, 37, 23, PF_RGB);
+	TEST_ASSERT(convert_frames(pipeline, depth_frame, &color_frame, false, P, C));
+	TEST_ASSERT(check_point_cloud(depth_frame, &color_frame, ctr, f, P, C));
+
+	// color frames of other resolution are not used without remapping
+	construct_color_frame(color_frame, 74, 46, PF_RGB);
+	TEST_ASSERT(convert_frames(pipeline, depth_frame, &color_frame, false, P, C));
+	TEST_ASSERT(check_point_cloud(depth_frame, 0, ctr, f, P, C));
+
+	// remapping in the pipeline with the attached emulation device resamples color frames to the depth resolution
+	TEST_ASSERT(rgbd_inp.attach_path(get_temp_file_name("test_rgbd_point_cloud_pipeline_")));
+	TEST_ASSERT(convert_frames(pipeline, depth_frame, &color_frame, true, P, C));
+	TEST_ASSERT(check_point_cloud(depth_frame, &color_frame, ctr, f, P, C));
+
+	// invalid depth frames result in empty point clouds
+	frame_type invalid_frame = depth_frame;
+	invalid_frame.nr_bits_per_pixel = 8;
+	TEST_ASSERT(convert_frames(pipeline, invalid_frame, 0, true, P, C));
+	TEST_ASSERT(P.empty() && C.empty());
+
+	TEST_ASSERT_EQ(pipeline.get_statistics().nr_frames, size_t(9));
+	TEST_ASSERT_EQ(pipeline.get_statistics().nr_skipped_frames, size_t(0));
+	pipeline.stop();
+	rgbd_inp.detach();
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration rgbd_point_cloud_pipeline_test_registration(
+	"rgbd::rgbd_point_cloud_pipeline", test_rgbd_point_cloud_pipeline);
@@ -0,0 +1,213 @@
+#include <cgv/base/register.h>
+#include <rgbd_recording.h>
+#include <test/temp_file_name.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace cgv::base;
+using namespace rgbd;
+
+/// construct frame i of a stream with smooth pixel values that compress well after delta encoding
+static void construct_frame(frame_type& frame, int w, int h, PixelFormat pf, unsigned nr_bits, unsigned i)
+{
+	frame.width = w;
+	frame.height = h;
+	frame.pixel_format = pf;
+	frame.nr_bits_per_pixel = nr_bits;
+	frame.compute_buffer_size();
+	frame.frame_index = i;
+	frame.time = i / 30.0;
+	frame.frame_data.resize(frame.buffer_size);
+	if (nr_bits == 16) {
+		uint16_t* values = reinterpret_cast<uint16_t*>(frame.frame_data.data());
+		for (int y = 0; y < h; ++y)
+			for (int x = 0; x < w; ++x)
+				values[y * w + x] = uint16_t(4000 + 3 * x + 5 * y + 17 * i);
+	}
+	else
+		for (size_t j = 0; j < frame.frame_data.size(); ++j)
+			frame.frame_data[j] = char(j / 3 + i);
+}
+
+/// replace the frame data by random bytes that cannot be compressed
+static void randomize_frame(frame_type& frame, unsigned seed)
+{
+	std::mt19937 gen(seed);
+	for (auto& c : frame.frame_data)
+		c = char(gen());
+}
+
+/// return whether two frames have the same format, index, time and data
+static bool equal_frames(const frame_type& a, const frame_type& b)
+{
+	return a.width == b.width && a.height == b.height && a.pixel_format == b.pixel_format &&
+		a.nr_bits_per_pixel == b.nr_bits_per_pixel && a.buffer_size == b.buffer_size &&
+		a.frame_index == b.frame_index && a.time == b.time && a.frame_data == b.frame_data;
+}
+
+/// return whether the first nr_frames frames of the stream can be read back from the recording
+static bool check_frames(rgbd_recording& recording, InputStreams is, const std::vector<frame_type>& frames, size_t nr_frames)
+{
+	if (recording.get_nr_frames(is) != nr_frames)
+		return false;
+	frame_type frame;
+	for (size_t i = 0; i < nr_frames; ++i)
+		if (!recording.read_frame(is, i, frame) || !equal_frames(frame, frames[i]))
+			return false;
+	return !recording.read_frame(is, nr_frames, frame);
+}
+
+/// copy the first nr_bytes of a file, which corresponds to a recording that was not closed
+static bool copy_file_prefix(const std::string& src_file_name, const std::string& dst_file_name, uint64_t nr_bytes)
+{
+	std::ifstream is(src_file_name.c_str(), std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	if (data.size() < nr_bytes)
+		return false;
+	std::ofstream os(dst_file_name.c_str(), std::ios::binary);
+	os.write(data.data(), std::streamsize(nr_bytes));
+	return os.good();
+}
+
+bool test_rgbd_recording()
+{
+	const unsigned nr_frames = 5;
+	std::vector<frame_type> depth_frames(nr_frames), color_frames(nr_frames);
+	for (unsigned i = 0; i < nr_frames; ++i) {
+		construct_frame(depth_frames[i], 32, 24, PF_DEPTH, 16, i);
+		construct_frame(color_frames[i], 64, 48, PF_BGR, 24, i);
+	}
+	// frame 2 of the depth stream is noise, for which compression does not pay off
+	randomize_frame(depth_frames[2], 2);
+
+	// round trip of depth and color frames in chunks of several frames
+	std::string file_name = get_temp_file_name(std::string("test_rgbd_recording.") + get_recording_extension());
+	TEST_ASSERT(is_recording_file_name(file_name));
+	TEST_ASSERT(!is_recording_file_name(get_temp_file_name("test_rgbd_recording.rgbd")));
+	for (bool compress_color : { false, true }) {
+		rgbd_recorder recorder;
+		TEST_ASSERT(recorder.open(file_name, compress_color, 2, 16384));
+		TEST_ASSERT(recorder.is_open());
+		for (unsigned i = 0; i < nr_frames; ++i) {
+			TEST_ASSERT(recorder.write_frame(IS_DEPTH, depth_frames[i]));
+			TEST_ASSERT(recorder.write_frame(IS_COLOR, color_frames[i]));
+		}
+		// only single recorded streams can be written
+		TEST_ASSERT(!recorder.write_frame(IS_COLOR_AND_DEPTH, color_frames[0]));
+		TEST_ASSERT(recorder.close());
+		TEST_ASSERT(!recorder.is_open());
+		rgbd_recorder::statistics stats = recorder.get_statistics();
+		TEST_ASSERT_EQ(stats.nr_frames, size_t(2 * nr_frames));
+		TEST_ASSERT_EQ(stats.nr_raw_bytes, size_t(nr_frames * (depth_frames[0].buffer_size + color_frames[0].buffer_size)));
+		TEST_ASSERT(stats.get_compression_ratio() < 1.0);
+
+		rgbd_recording recording;
+		TEST_ASSERT(recording.open(file_name));
+		TEST_ASSERT(check_frames(recording, IS_DEPTH, depth_frames, nr_frames));
+		TEST_ASSERT(check_frames(recording, IS_COLOR, color_frames, nr_frames));
+		TEST_ASSERT_EQ(recording.get_nr_frames(IS_INFRARED), size_t(0));
+		frame_format ff;
+		TEST_ASSERT(recording.get_frame_format(IS_DEPTH, ff));
+		TEST_ASSERT(ff.width == 32 && ff.height == 24 && ff.pixel_format == PF_DEPTH && ff.nr_bits_per_pixel == 16);
+		TEST_ASSERT(!recording.get_frame_format(IS_INFRARED, ff));
+		// incompressible frames fall back to raw data and color frames are only compressed on request
+		for (unsigned i = 0; i < nr_frames; ++i) {
+			TEST_ASSERT_EQ(recording.get_record(IS_DEPTH, i).codec, uint32_t(i == 2 ? RC_RAW : RC_DELTA_DEFLATE));
+			TEST_ASSERT_EQ(recording.get_record(IS_COLOR, i).codec, uint32_t(compress_color ? RC_DELTA_DEFLATE : RC_RAW));
+		}
+		TEST_ASSERT_EQ(recording.get_record(IS_DEPTH, 2).size, depth_frames[2].buffer_size);
+	}
+
+	// frames are located by timestamp, where times outside of the recording are clamped to the first and last frame
+	{
+		rgbd_recording recording;
+		TEST_ASSERT(recording.open(file_name));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, -1.0), size_t(0));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 0.0), size_t(0));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 0.5 / 30), size_t(0));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 2.0 / 30), size_t(2));
+		TEST_ASSERT_EQ(recording.find_frame(IS_COLOR, 3.9 / 30), size_t(3));
+		TEST_ASSERT_EQ(recording.find_frame(IS_COLOR, 10.0), size_t(nr_frames - 1));
+		TEST_ASSERT_EQ(recording.find_frame(IS_INFRARED, 1.0), size_t(0));
+	}
+
+	// irregular timestamps need correction of the interpolated position
+	std::string irregular_file_name = get_temp_file_name(std::string("test_rgbd_recording_irregular.") + get_recording_extension());
+	{
+		const double times[] = { 0.0, 0.01, 0.02, 0.03, 0.9, 1.0 };
+		std::vector<frame_type> frames(6);
+		rgbd_recorder recorder;
+		TEST_ASSERT(recorder.open(irregular_file_name));
+		for (unsigned i = 0; i < 6; ++i) {
+			construct_frame(frames[i], 4, 4, PF_DEPTH, 16, i);
+			frames[i].time = times[i];
+			TEST_ASSERT(recorder.write_frame(IS_DEPTH, frames[i]));
+		}
+		TEST_ASSERT(recorder.close());
+		rgbd_recording recording;
+		TEST_ASSERT(recording.open(irregular_file_name));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 0.025), size_t(2));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 0.5), size_t(3));
+		TEST_ASSERT_EQ(recording.find_frame(IS_DEPTH, 0.95), size_t(4));
+	}
+	std::remove(irregular_file_name.c_str());
+
+	// recordings that were never closed lack the index and are recovered up to the last complete frame
+	std::string truncated_file_name = get_temp_file_name(std::string("test_rgbd_recording_truncated.") + get_recording_extension());
+	{
+		uint64_t last_offset, last_size;
+		{
+			rgbd_recording recording;
+			TEST_ASSERT(recording.open(file_name));
+			const frame_record& fr = recording.get_record(IS_COLOR, nr_frames - 1);
+			last_offset = fr.offset;
+			last_size = fr.size;
+		}
+		// all frames before the index
+		TEST_ASSERT(copy_file_prefix(file_name, truncated_file_name, last_offset + last_size));
+		rgbd_recording recording;
+		TEST_ASSERT(recording.open(truncated_file_name));
+		TEST_ASSERT(check_frames(recording, IS_DEPTH, depth_frames, nr_frames));
+		TEST_ASSERT(check_frames(recording, IS_COLOR, color_frames, nr_frames));
+		// last frame only partially written
+		TEST_ASSERT(copy_file_prefix(file_name, truncated_file_name, last_offset + last_size / 2));
+		TEST_ASSERT(recording.open(truncated_file_name));
+		TEST_ASSERT(check_frames(recording, IS_DEPTH, depth_frames, nr_frames));
+		TEST_ASSERT(check_frames(recording, IS_COLOR, color_frames, nr_frames - 1));
+		// only the file header
+		TEST_ASSERT(copy_file_prefix(file_name, truncated_file_name, 8));
+		TEST_ASSERT(recording.open(truncated_file_name));
+		TEST_ASSERT_EQ(recording.get_nr_frames(IS_DEPTH), size_t(0));
+		// no valid file header
+		TEST_ASSERT(copy_file_prefix(file_name, truncated_file_name, 6));
+		TEST_ASSERT(!recording.open(truncated_file_name));
+	}
+	std::remove(truncated_file_name.c_str());
+	std::remove(file_name.c_str());
+
+#ifdef __linux__
+	// after a write error the encoder stops and further frames are refused
+	{
+		frame_type frame;
+		construct_frame(frame, 128, 128, PF_BGR, 24, 0);
+		randomize_frame(frame, 7);
+		rgbd_recorder recorder;
+		TEST_ASSERT(recorder.open("/dev/full", false, 2, 0));
+		bool refused = false;
+		for (unsigned i = 0; i < 100 && !refused; ++i)
+			refused = !recorder.write_frame(IS_COLOR, frame);
+		TEST_ASSERT(refused);
+		TEST_ASSERT(!recorder.close());
+		TEST_ASSERT_EQ(recorder.get_statistics().nr_frames, size_t(1));
+	}
+#endif
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration rgbd_recording_test_registration(
+	"rgbd::rgbd_recording", test_rgbd_recording);
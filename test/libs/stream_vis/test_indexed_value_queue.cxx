@@ -0,0 +1,220 @@
+#include <cgv/base/register.h>
+#include <stream_vis/indexed_value_queue.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace cgv::base;
+using namespace stream_vis;
+
+/// fill a batch whose values store the producer in the index and the batch number and value position in the value
+static void fill_batch(uint16_t producer, uint64_t batch_index, uint16_t num_values, indexed_value* values)
+{
+	for (uint16_t i = 0; i < num_values; ++i) {
+		uint64_t v = batch_index * 1000 + i;
+		values[i].index = producer;
+		std::memcpy(values[i].value, &v, sizeof(v));
+	}
+}
+
+/// return the batch number stored in a non empty batch filled with fill_batch or -1 if the values are inconsistent
+static uint64_t check_batch(uint16_t num_values, const indexed_value* values)
+{
+	uint64_t batch_index = 0;
+	for (uint16_t i = 0; i < num_values; ++i) {
+		uint64_t v;
+		std::memcpy(&v, values[i].value, sizeof(v));
+		if (i == 0)
+			batch_index = v / 1000;
+		if (values[i].index != values[0].index || v != batch_index * 1000 + i)
+			return uint64_t(-1);
+	}
+	return batch_index;
+}
+
+bool test_indexed_value_queue()
+{
+	// single thread: full queue drops, oversized batches overflow and try_push does not count
+	indexed_value_queue Q(3, 4);
+	TEST_ASSERT_EQ(Q.get_capacity(), size_t(4));
+	indexed_value batch[8];
+	fill_batch(0, 0, 8, batch);
+	for (int i = 0; i < 4; ++i)
+		TEST_ASSERT(Q.push(2, batch, i));
+	TEST_ASSERT(!Q.push(2, batch, 4));
+	TEST_ASSERT(!Q.try_push(2, batch, 5));
+	TEST_ASSERT(!Q.push(5, batch, 6));
+	indexed_value_queue::statistics stats = Q.get_statistics();
+	TEST_ASSERT_EQ(stats.nr_pushed_batches, size_t(4));
+	TEST_ASSERT_EQ(stats.nr_dropped_batches, size_t(1));
+	TEST_ASSERT_EQ(stats.nr_overflow_batches, size_t(1));
+	TEST_ASSERT_EQ(stats.get_nr_queued_batches(), size_t(4));
+	std::vector<double> timestamps;
+	TEST_ASSERT_EQ(Q.drain([&](uint16_t, const indexed_value*, double t) { timestamps.push_back(t); }, 3), size_t(3));
+	TEST_ASSERT(Q.push(4, batch, 7));
+	TEST_ASSERT_EQ(Q.drain([&](uint16_t, const indexed_value*, double t) { timestamps.push_back(t); }), size_t(2));
+	TEST_ASSERT(timestamps == std::vector<double>({ 0, 1, 2, 3, 7 }));
+	TEST_ASSERT_EQ(Q.get_statistics().get_nr_queued_batches(), size_t(0));
+
+	// the ring can only be resized until the first batch has been pushed
+	indexed_value_queue R(4, 2);
+	TEST_ASSERT(R.is_resizable());
+	TEST_ASSERT(R.resize(16, 4));
+	TEST_ASSERT(R.push(4, batch, 0));
+	TEST_ASSERT(!R.is_resizable());
+	TEST_ASSERT(!R.resize(64, 8));
+	TEST_ASSERT_EQ(R.get_capacity(), size_t(16));
+	TEST_ASSERT_EQ(R.get_max_batch_size(), uint16_t(4));
+	TEST_ASSERT_EQ(R.drain([](uint16_t, const indexed_value*, double) {}), size_t(1));
+	TEST_ASSERT(!R.resize(64, 8));
+
+	// resizing concurrently to the first pushes either succeeds before them or is refused
+	indexed_value_queue C(2, 1);
+	std::atomic<bool> producer_started(false);
+	std::thread producer([&]() {
+		producer_started = true;
+		for (uint64_t b = 0; b < 1000; ++b) {
+			indexed_value value;
+			fill_batch(0, b, 1, &value);
+			while (!C.try_push(1, &value, double(b)))
+				std::this_thread::yield();
+		}
+	});
+	while (!producer_started)
+		std::this_thread::yield();
+	size_t nr_resizes = 0;
+	while (C.resize(8 + nr_resizes % 2 * 8, 1))
+		++nr_resizes;
+	uint64_t next_b = 0;
+	size_t nr_wrong = 0;
+	while (next_b < 1000)
+		C.drain([&](uint16_t num_values, const indexed_value* values, double) {
+			if (num_values != 1 || check_batch(num_values, values) != next_b)
+				++nr_wrong;
+			++next_b;
+		});
+	producer.join();
+	TEST_ASSERT_EQ(nr_wrong, size_t(0));
+	TEST_ASSERT(!C.is_resizable());
+
+	// multiple producers push while the consumer drains, where every eleventh batch is too large
+	const uint16_t nr_producers = 4;
+	const uint64_t nr_batches = 20000;
+	indexed_value_queue M(64, 8);
+	std::vector<size_t> nr_accepted(nr_producers, 0), nr_rejected(nr_producers, 0), nr_overflown(nr_producers, 0);
+	std::atomic<int> nr_running(nr_producers);
+	std::vector<std::thread> producers;
+	for (uint16_t p = 0; p < nr_producers; ++p)
+		producers.push_back(std::thread([&, p]() {
+			indexed_value values[9];
+			for (uint64_t b = 0; b < nr_batches; ++b) {
+				uint16_t num_values = b % 11 == 10 ? 9 : uint16_t(1 + b % 8);
+				fill_batch(p, b, num_values, values);
+				if (M.push(num_values, values, double(b)))
+					++nr_accepted[p];
+				else if (num_values > M.get_max_batch_size())
+					++nr_overflown[p];
+				else
+					++nr_rejected[p];
+			}
+			--nr_running;
+		}));
+	// batches of each producer have to arrive in push order with intact values
+	std::vector<uint64_t> next_batch(nr_producers, 0);
+	std::vector<size_t> nr_received(nr_producers, 0);
+	size_t nr_corrupt = 0, nr_out_of_order = 0;
+	auto consume = [&](uint16_t num_values, const indexed_value* values, double timestamp) {
+		uint64_t b = check_batch(num_values, values);
+		uint16_t p = values[0].index;
+		if (b == uint64_t(-1) || p >= nr_producers || double(b) != timestamp || uint16_t(1 + b % 8) != num_values) {
+			++nr_corrupt;
+			return;
+		}
+		if (b < next_batch[p])
+			++nr_out_of_order;
+		next_batch[p] = b + 1;
+		++nr_received[p];
+	};
+	while (nr_running > 0)
+		if (M.drain(consume, 16) == 0)
+			std::this_thread::yield();
+	for (auto& t : producers)
+		t.join();
+	M.drain(consume);
+	TEST_ASSERT_EQ(nr_corrupt, size_t(0));
+	TEST_ASSERT_EQ(nr_out_of_order, size_t(0));
+	stats = M.get_statistics();
+	size_t total_accepted = 0, total_rejected = 0, total_overflown = 0, total_received = 0;
+	for (uint16_t p = 0; p < nr_producers; ++p) {
+		TEST_ASSERT_EQ(nr_overflown[p], size_t(nr_batches / 11));
+		TEST_ASSERT_EQ(nr_accepted[p] + nr_rejected[p] + nr_overflown[p], size_t(nr_batches));
+		total_accepted += nr_accepted[p];
+		total_rejected += nr_rejected[p];
+		total_overflown += nr_overflown[p];
+		total_received += nr_received[p];
+	}
+	TEST_ASSERT_EQ(stats.nr_pushed_batches, total_accepted);
+	TEST_ASSERT_EQ(stats.nr_dropped_batches, total_rejected);
+	TEST_ASSERT_EQ(stats.nr_overflow_batches, total_overflown);
+	TEST_ASSERT_EQ(stats.nr_drained_batches, total_accepted);
+	TEST_ASSERT_EQ(total_received, total_accepted);
+	TEST_ASSERT_EQ(stats.get_nr_queued_batches(), size_t(0));
+	return true;
+}
+
+/// measure the latency of push for different numbers of producers while the consumer drains continuously
+bool benchmark_indexed_value_queue()
+{
+	const size_t nr_pushes = 1000000;
+	for (unsigned nr_producers : { 1u, 2u, 4u, 8u }) {
+		indexed_value_queue Q(4096, 16);
+		std::atomic<unsigned> nr_running(nr_producers);
+		std::vector<std::vector<double> > latencies(nr_producers);
+		std::vector<std::thread> producers;
+		for (unsigned p = 0; p < nr_producers; ++p)
+			producers.push_back(std::thread([&, p]() {
+				indexed_value values[16];
+				fill_batch(uint16_t(p), 0, 16, values);
+				std::vector<double>& L = latencies[p];
+				L.reserve(nr_pushes / nr_producers);
+				for (size_t i = 0; i < nr_pushes / nr_producers; ++i) {
+					auto start = std::chrono::steady_clock::now();
+					Q.push(16, values, double(i));
+					L.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+				}
+				--nr_running;
+			}));
+		size_t nr_values = 0;
+		while (nr_running > 0)
+			if (Q.drain([&](uint16_t num_values, const indexed_value*, double) { nr_values += num_values; }) == 0)
+				std::this_thread::yield();
+		for (auto& t : producers)
+			t.join();
+		Q.drain([&](uint16_t num_values, const indexed_value*, double) { nr_values += num_values; });
+		std::vector<double> all;
+		for (const auto& L : latencies)
+			all.insert(all.end(), L.begin(), L.end());
+		std::sort(all.begin(), all.end());
+		double mean = 0;
+		for (double l : all)
+			mean += l;
+		mean /= all.size();
+		indexed_value_queue::statistics stats = Q.get_statistics();
+		std::cout << "indexed value queue with " << nr_producers << " producers: push mean " << mean << " ns, median "
+			<< all[all.size() / 2] << " ns, 99th percentile " << all[all.size() * 99 / 100] << " ns, max " << all.back()
+			<< " ns, " << stats.nr_dropped_batches << " of " << all.size() << " batches dropped" << std::endl;
+		if (nr_values != 16 * stats.nr_pushed_batches)
+			return false;
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration indexed_value_queue_test_registration(
+	"stream_vis::indexed_value_queue", test_indexed_value_queue);
+
+extern CGV_API benchmark_registration indexed_value_queue_benchmark_registration(
+	"stream_vis::indexed_value_queue_benchmark", benchmark_indexed_value_queue);
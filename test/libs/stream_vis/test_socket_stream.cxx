@@ -0,0 +1,145 @@
+#include <cgv/base/register.h>
+#include <stream_vis/socket_stream.h>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+using namespace cgv::base;
+using namespace stream_vis;
+
+/// context with float input time series that are created without declarations and drained without rendering
+struct loopback_context : public stream_vis_context
+{
+	loopback_context(uint16_t nr_time_series, size_t queue_capacity) : stream_vis_context("loopback_context")
+	{
+		nr_uninitialized_offsets = 0;
+		for (uint16_t i = 0; i < nr_time_series; ++i) {
+			typed_time_series.push_back(new float_time_series(i));
+			typed_time_series.back()->set_name(std::string("x") + char('0' + i));
+		}
+		configure_value_queue(queue_capacity, nr_time_series);
+	}
+	size_t get_first_composed_index() const { return typed_time_series.size(); }
+	void extract_time_series() {}
+	void handle_view2d_update(int, const vec2&) {}
+	size_t drain() { return drain_value_queue(); }
+	size_t get_nr_samples(uint16_t ts_idx) const { return typed_time_series[ts_idx]->series().get_nr_samples(); }
+};
+
+/// connect a client and send frames with values of the time series selected by the bits of 1 + frame index % 7
+static void run_producer(int port, size_t nr_frames, bool& success)
+{
+	socket_stream_client client(4096);
+	success = client.connect("localhost", port) && client.get_nr_time_series() == 3 &&
+		client.find_time_series("x2") == 2 && client.get_time_series_type(1) == cgv::type::info::TI_FLT64;
+	indexed_value values[3];
+	for (size_t fi = 0; success && fi < nr_frames; ++fi) {
+		uint16_t num_values = 0;
+		for (uint16_t ti = 0; ti < 3; ++ti)
+			if (((1 + fi % 7) & (size_t(1) << ti)) != 0) {
+				double v = double(fi);
+				values[num_values].index = ti;
+				std::memcpy(values[num_values].value, &v, sizeof(v));
+				++num_values;
+			}
+		success = client.send_values(num_values, values, 0.001 * fi);
+	}
+	client.disconnect();
+}
+
+/// return the number of values sent to time series ts_idx by one producer with run_producer
+static size_t get_nr_sent_values(size_t nr_frames, uint16_t ts_idx)
+{
+	size_t n = 0;
+	for (size_t fi = 0; fi < nr_frames; ++fi)
+		if (((1 + fi % 7) & (size_t(1) << ts_idx)) != 0)
+			++n;
+	return n;
+}
+
+/// wait until all frames of closed connections are counted, while draining the value queue of ctx if requested
+static socket_stream_statistics wait_for_frames(socket_stream_source& source, loopback_context& ctx, size_t nr_frames, bool drain)
+{
+	auto start = std::chrono::steady_clock::now();
+	socket_stream_statistics stats;
+	do {
+		if (drain)
+			ctx.drain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		stats = source.get_total_statistics();
+	} while ((stats.connected || stats.nr_frames < nr_frames || (drain && ctx.get_value_queue_statistics().get_nr_queued_batches() > 0)) &&
+		std::chrono::steady_clock::now() - start < std::chrono::seconds(60));
+	return stats;
+}
+
+/// stream frames of producer threads over loopback connections into a small value queue with and without backpressure
+bool test_socket_stream()
+{
+	const size_t nr_producers = 3, nr_frames = 5000, queue_capacity = 16;
+
+	// with backpressure the producers are throttled by the draining consumer and no frame gets lost
+	{
+		loopback_context ctx(3, queue_capacity);
+		socket_stream_source source(ctx);
+		TEST_ASSERT(source.start(0, true));
+		TEST_ASSERT(source.get_port() > 0);
+		TEST_ASSERT_EQ(source.get_address(), std::string("127.0.0.1"));
+		bool success[nr_producers];
+		std::vector<std::thread> producers;
+		for (size_t pi = 0; pi < nr_producers; ++pi)
+			producers.push_back(std::thread(run_producer, source.get_port(), nr_frames, std::ref(success[pi])));
+		socket_stream_statistics stats = wait_for_frames(source, ctx, nr_producers * nr_frames, true);
+		for (auto& t : producers)
+			t.join();
+		for (size_t pi = 0; pi < nr_producers; ++pi)
+			TEST_ASSERT(success[pi]);
+		TEST_ASSERT_EQ(source.get_nr_connections(), nr_producers);
+		TEST_ASSERT_EQ(source.get_nr_open_connections(), size_t(0));
+		TEST_ASSERT_EQ(stats.nr_frames, nr_producers * nr_frames);
+		TEST_ASSERT_EQ(stats.nr_dropped_frames, size_t(0));
+		TEST_ASSERT_EQ(stats.nr_invalid_frames, size_t(0));
+		TEST_ASSERT(stats.nr_stalls > 0);
+		size_t nr_values = 0;
+		for (uint16_t ti = 0; ti < 3; ++ti) {
+			TEST_ASSERT_EQ(ctx.get_nr_samples(ti), nr_producers * get_nr_sent_values(nr_frames, ti));
+			nr_values += ctx.get_nr_samples(ti);
+		}
+		TEST_ASSERT_EQ(stats.nr_values, nr_values);
+		indexed_value_queue::statistics queue_stats = ctx.get_value_queue_statistics();
+		TEST_ASSERT_EQ(queue_stats.nr_pushed_batches, nr_producers * nr_frames);
+		TEST_ASSERT_EQ(queue_stats.nr_dropped_batches, size_t(0));
+		source.stop();
+	}
+
+	// without backpressure frames that do not fit into the undrained queue are dropped and counted
+	{
+		loopback_context ctx(3, queue_capacity);
+		socket_stream_source source(ctx);
+		TEST_ASSERT(source.start(0, false));
+		bool success[nr_producers];
+		std::vector<std::thread> producers;
+		for (size_t pi = 0; pi < nr_producers; ++pi)
+			producers.push_back(std::thread(run_producer, source.get_port(), nr_frames, std::ref(success[pi])));
+		socket_stream_statistics stats = wait_for_frames(source, ctx, nr_producers * nr_frames, false);
+		for (auto& t : producers)
+			t.join();
+		for (size_t pi = 0; pi < nr_producers; ++pi)
+			TEST_ASSERT(success[pi]);
+		TEST_ASSERT_EQ(stats.nr_frames, nr_producers * nr_frames);
+		TEST_ASSERT_EQ(stats.nr_dropped_frames, nr_producers * nr_frames - queue_capacity);
+		TEST_ASSERT_EQ(stats.nr_stalls, size_t(0));
+		TEST_ASSERT_EQ(ctx.drain(), queue_capacity);
+		size_t nr_values = 0;
+		for (uint16_t ti = 0; ti < 3; ++ti)
+			nr_values += ctx.get_nr_samples(ti);
+		TEST_ASSERT_EQ(stats.nr_values, nr_values);
+		source.stop();
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration socket_stream_test_registration(
+	"stream_vis::socket_stream", test_socket_stream);
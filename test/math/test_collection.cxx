@@ -26,6 +26,7 @@
 #include <test/math/test_distance_transform.h>
 #include <test/math/test_fibo_heap.h>
 #include <test/math/test_statistics.h>
+#include <test/math/test_sparse_les.h>
 
 #include <cgv/base/register.h>
 
@@ -50,6 +51,7 @@ bool test_collection()
 	test_eig();//complete
 	test_mat();//complete
 	test_gaussj();//
+	test_sparse_les();
 //	test_statistics();
 	test_align<float>(100, 100, true, true);
 	test_align<float, double>(100, 100, true, true);
@@ -1,5 +1,63 @@
 #pragma once
 #include <cgv/math/eig.h>
+#include <cgv/math/normal_estimation.h>
+#include <cmath>
+
+/// check eig_sym_3x3 on the matrix Q*diag(l)*Q^T for a fixed rotation Q and eigenvalues l in decreasing order
+void check_eig_sym_3x3(const double* l)
+{
+	using namespace cgv::math;
+	// rotation by 0.7 radians around the axis (1,2,3)
+	double a[3] = { 1 / std::sqrt(14.0), 2 / std::sqrt(14.0), 3 / std::sqrt(14.0) };
+	double c = std::cos(0.7), s = std::sin(0.7), Q[3][3];
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			Q[i][j] = (1 - c) * a[i] * a[j] + (i == j ? c : 0);
+	Q[0][1] -= s * a[2]; Q[1][0] += s * a[2];
+	Q[0][2] += s * a[1]; Q[2][0] -= s * a[1];
+	Q[1][2] -= s * a[0]; Q[2][1] += s * a[0];
+	double M[3][3];
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			M[i][j] = Q[i][0] * l[0] * Q[j][0] + Q[i][1] * l[1] * Q[j][1] + Q[i][2] * l[2] * Q[j][2];
+	double A[6] = { M[0][0], M[0][1], M[0][2], M[1][1], M[1][2], M[2][2] };
+	double scale = std::max(std::abs(l[0]), std::abs(l[2]));
+	double tolerance = 1e-9 * (scale > 0 ? scale : 1);
+
+	double evals[3], evecs[9], evals_only[3];
+	eig_sym_3x3(A, evals, evecs);
+	eig_sym_3x3(A, evals_only);
+	for (int i = 0; i < 3; ++i) {
+		assert(std::abs(evals[i] - l[i]) < tolerance);
+		// without eigenvectors repeated eigenvalues are only accurate up to the square root of the machine precision
+		assert(std::abs(evals_only[i] - l[i]) < 1e2 * tolerance);
+		// eigenvectors are orthonormal and fulfill the eigen equation also for repeated eigenvalues
+		const double* v = evecs + 3 * i;
+		for (int j = 0; j < 3; ++j) {
+			const double* w = evecs + 3 * j;
+			assert(std::abs(v[0] * w[0] + v[1] * w[1] + v[2] * w[2] - (i == j ? 1 : 0)) < 1e-9);
+			double r = M[j][0] * v[0] + M[j][1] * v[1] + M[j][2] * v[2] - evals[i] * v[j];
+			assert(std::abs(r) < tolerance);
+		}
+	}
+}
+
+/// closed form eigen decomposition with distinct, repeated and zero eigenvalues
+void test_eig_sym_3x3()
+{
+	const double L[][3] = {
+		{ 3, 1, -2 }, { 2, 2, 1 }, { 1, -1, -1 }, { 3, 3, 3 }, { 1, 0, 0 }, { 0, 0, -5 }, { 2, 0, -2 },
+		{ 0, 0, 0 }, { 1e-150, 5e-151, 0 }, { 1e150, 1e149, 1e148 }, { 1, 1 - 1e-12, 0.5 }
+	};
+	for (const auto& l : L)
+		check_eig_sym_3x3(l);
+
+	// diagonal matrices are sorted by decreasing eigenvalues
+	double A[6] = { 1, 0, 0, 3, 0, 2 }, evals[3], evecs[9];
+	cgv::math::eig_sym_3x3(A, evals, evecs);
+	assert(evals[0] == 3 && evals[1] == 2 && evals[2] == 1);
+	assert(evecs[1] == 1 && evecs[5] == 1 && evecs[6] == 1);
+}
 
 void test_eig()
 {
@@ -15,4 +73,6 @@ void test_eig()
 	diag_mat<double> w;
 	eig_sym(m,q,w);
 	assert(frobenius_norm(q*w*inv(q)-m) < 0.0001);
+
+	test_eig_sym_3x3();
 }
\ No newline at end of file
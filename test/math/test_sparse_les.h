@@ -0,0 +1,43 @@
+#pragma once
+#include <cgv/math/sparse_les_solvers.h>
+#include <cmath>
+
+/// solve a shifted 2d grid laplacian with all registered symmetric solvers
+void test_sparse_les()
+{
+	using namespace cgv::math;
+	const int w = 40, n = w*w;
+	const std::vector<sparse_les_factory_ptr>& F = sparse_les::get_solver_factories();
+	assert(!sparse_les::create_by_cap(SLC_SYMMETRIC, n, 1).empty());
+	for (size_t fi = 0; fi < F.size(); ++fi) {
+		if ((F[fi]->get_caps() & SLC_SYMMETRIC) == 0)
+			continue;
+		sparse_les_ptr les = F[fi]->create(n, 2, 5 * n);
+		for (int y = 0; y < w; ++y)
+			for (int x = 0; x < w; ++x) {
+				int i = y*w + x;
+				les->set_mat_entry(i, i, 4.01);
+				if (x > 0) les->set_mat_entry(i, i - 1, -1);
+				if (x + 1 < w) les->set_mat_entry(i, i + 1, -1);
+				if (y > 0) les->set_mat_entry(i, i - w, -1);
+				if (y + 1 < w) les->set_mat_entry(i, i + w, -1);
+				les->set_b_entry(i, 0, 1.0);
+				les->set_b_entry(i, 1, sin(0.3*x)*cos(0.2*y));
+			}
+		bool success = les->solve(true);
+		assert(success);
+		// check residuals of native solvers
+		assembled_sparse_les* native_les = dynamic_cast<assembled_sparse_les*>(les.operator->());
+		if (native_les) {
+			assert(native_les->get_residual(0) < 1e-6);
+			assert(native_les->get_residual(1) < 1e-6);
+		}
+		// changing the diagonal after the first solve updates the matrix
+		for (int i = 0; i < n; ++i)
+			les->set_mat_entry(i, i, 5.0);
+		success = les->solve(true);
+		assert(success);
+		if (native_les)
+			assert(native_les->get_residual(0) < 1e-6);
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+/// write content to file and return whether this succeeded
+inline bool write_test_file(const std::string& file_name, const std::string& content)
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	os << content;
+	return os.good();
+}
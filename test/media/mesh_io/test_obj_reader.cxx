@@ -0,0 +1,158 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/obj_reader.h>
+#include "test_file_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+/// reader that stores vertices and faces with positive indices together with their group and material
+struct test_obj_reader : public obj_reader
+{
+	std::vector<v3d_type> positions, normals;
+	std::vector<v2d_type> texcoords;
+	std::vector<color_type> colors;
+	std::vector<int> face_vertices, face_texcoords, face_normals;
+	std::vector<unsigned> face_degrees, face_groups, face_materials, line_degrees;
+	std::vector<std::string> groups, materials;
+	void process_vertex(const v3d_type& p) { positions.push_back(p); }
+	void process_normal(const v3d_type& n) { normals.push_back(n); }
+	void process_texcoord(const v2d_type& t) { texcoords.push_back(t); }
+	void process_color(const color_type& c) { colors.push_back(c); }
+	void process_face(unsigned vcount, int* vertices, int* texcoords, int* normals)
+	{
+		convert_to_positive(vcount, vertices, texcoords, normals, unsigned(positions.size()), unsigned(this->normals.size()), unsigned(this->texcoords.size()));
+		face_degrees.push_back(vcount);
+		face_groups.push_back(get_current_group());
+		face_materials.push_back(get_current_material());
+		for (unsigned i = 0; i < vcount; ++i) {
+			face_vertices.push_back(vertices[i]);
+			face_texcoords.push_back(texcoords ? texcoords[i] : -1);
+			face_normals.push_back(normals ? normals[i] : -1);
+		}
+	}
+	void process_line(unsigned vcount, int* vertices, int* texcoords, int* normals) { line_degrees.push_back(vcount); }
+	void process_group(const std::string& name, const std::string& parameters) { groups.push_back(name); }
+	void process_material(const cgv::media::illum::obj_material& mtl, unsigned idx) { materials.push_back(mtl.get_name()); }
+};
+
+/// read elements, index syntax, negative indices, groups and materials, and a file that is parsed in several chunks
+bool test_obj_reader_parsing()
+{
+	TEST_ASSERT(write_test_file("test_obj_reader.mtl", "newmtl red\nKd 1 0 0\nnewmtl blue\nKd 0 0 1\n"));
+	TEST_ASSERT(write_test_file("test_obj_reader.obj",
+		"mtllib test_obj_reader.mtl\n"
+		"# comment\n"
+		"v 0 0 0\n"
+		"v 1.5 -2.25e1 .5 1 0.5 0.25\r\n"
+		"v 0 1 0\n"
+		"v 1 1\n"
+		"vn 0 0 1\n"
+		"vt 0.5 0.25\n"
+		"vt 1 1\n"
+		"f 1 2 3\n"
+		"usemtl blue\n"
+		"g part  with parameters\n"
+		"f 1/1 2/2 3/1\n"
+		"f 1//1 2//1 3//1\n"
+		"\tf -1/-1/-1 -2/-2/-1 -4/-1/-1   \n"
+		"l 1 2 3 4\n"
+		"g main\n"
+		"usemtl red\n"
+		"f 4 3 2 1"));
+	test_obj_reader r;
+	TEST_ASSERT(r.read_obj("test_obj_reader.obj"));
+	TEST_ASSERT_EQ(r.positions.size(), 4u);
+	TEST_ASSERT_EQ(r.positions[1], test_obj_reader::v3d_type(1.5, -22.5, 0.5));
+	TEST_ASSERT_EQ(r.positions[3], test_obj_reader::v3d_type(0, 0, 0));
+	TEST_ASSERT_EQ(r.colors.size(), 1u);
+	TEST_ASSERT(r.colors[0] == test_obj_reader::color_type(1, 0.5f, 0.25f, 1));
+	TEST_ASSERT_EQ(r.normals.size(), 1u);
+	TEST_ASSERT_EQ(r.texcoords.size(), 2u);
+	TEST_ASSERT_EQ(r.face_degrees.size(), 5u);
+	TEST_ASSERT_EQ(r.line_degrees.size(), 1u);
+	// single indices refer to texture coordinates and normals only if these exist for all corners
+	int expected_vertices[] = { 0, 1, 2,  0, 1, 2,  0, 1, 2,  3, 2, 0,  3, 2, 1, 0 };
+	int expected_texcoords[] = { -1, -1, -1,  0, 1, 0,  -1, -1, -1,  1, 0, 1,  -1, -1, -1, -1 };
+	int expected_normals[] = { -1, -1, -1,  -1, -1, -1,  0, 0, 0,  0, 0, 0,  -1, -1, -1, -1 };
+	TEST_ASSERT_EQ(r.face_vertices.size(), 16u);
+	for (unsigned i = 0; i < 16; ++i) {
+		TEST_ASSERT_EQ(r.face_vertices[i], expected_vertices[i]);
+		TEST_ASSERT_EQ(r.face_texcoords[i], expected_texcoords[i]);
+		TEST_ASSERT_EQ(r.face_normals[i], expected_normals[i]);
+	}
+	TEST_ASSERT_EQ(r.groups.size(), 2u);
+	TEST_ASSERT_EQ(r.groups[1], "part");
+	// the default material of faces before the first usemtl statement replaces the first material
+	TEST_ASSERT_EQ(r.materials.size(), 3u);
+	unsigned expected_groups[] = { 0, 1, 1, 1, 0 };
+	unsigned expected_materials[] = { 0, 1, 1, 1, 0 };
+	for (unsigned i = 0; i < 5; ++i) {
+		TEST_ASSERT_EQ(r.face_groups[i], expected_groups[i]);
+		TEST_ASSERT_EQ(r.face_materials[i], expected_materials[i]);
+	}
+
+	// file that is larger than a chunk, where faces refer to vertices of previous chunks with negative indices
+	const int nr_vertices = 300000;
+	std::string content;
+	for (int i = 0; i < nr_vertices; ++i) {
+		content += "v " + std::to_string(i) + ".25 -" + std::to_string(i % 1000) + ".5e-1 0.125\n";
+		if (i >= 2)
+			content += "f -1 -2 -3\n";
+	}
+	TEST_ASSERT(write_test_file("test_obj_reader.obj", content));
+	test_obj_reader large;
+	TEST_ASSERT(large.read_obj("test_obj_reader.obj"));
+	TEST_ASSERT_EQ(large.positions.size(), size_t(nr_vertices));
+	TEST_ASSERT_EQ(large.face_degrees.size(), size_t(nr_vertices - 2));
+	bool all_equal = true;
+	for (int i = 0; i < nr_vertices && i < int(large.positions.size()); ++i)
+		if (large.positions[i] != test_obj_reader::v3d_type(i + 0.25, -(i % 1000 + 0.5) / 10, 0.125))
+			all_equal = false;
+	for (int i = 0; i + 2 < nr_vertices && 3 * i + 2 < int(large.face_vertices.size()); ++i)
+		if (large.face_vertices[3 * i] != i + 2 || large.face_vertices[3 * i + 2] != i)
+			all_equal = false;
+	TEST_ASSERT(all_equal);
+	std::remove("test_obj_reader.obj");
+	std::remove("test_obj_reader.mtl");
+	return true;
+}
+
+/// measure reading throughput of a mesh with positions, normals, texture coordinates and triangles
+bool benchmark_obj_reader()
+{
+	const int nr_vertices = 1000000;
+	{
+		std::ofstream os("benchmark_obj_reader.obj", std::ios::binary);
+		char line[128];
+		for (int i = 0; i < nr_vertices; ++i) {
+			os.write(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvn 0.5774 0.5774 0.5774\nvt %.5f 0.5\n", i * 1e-3, -i * 2e-3, 0.5, (i % 100) * 0.01));
+			if (i >= 2)
+				os.write(line, std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d -1/-1/-1\n", i - 1, i - 1, i - 1, i, i, i));
+		}
+	}
+	size_t file_size = 0;
+	{
+		std::ifstream is("benchmark_obj_reader.obj", std::ios::binary | std::ios::ate);
+		file_size = size_t(is.tellg());
+	}
+	test_obj_reader r;
+	auto start = std::chrono::steady_clock::now();
+	TEST_ASSERT(r.read_obj("benchmark_obj_reader.obj"));
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	TEST_ASSERT_EQ(r.positions.size(), size_t(nr_vertices));
+	std::cout << "obj reader: " << file_size / (1048576.0 * seconds) << " MB/s, " << r.positions.size() / seconds << " vertices/s" << std::endl;
+	std::remove("benchmark_obj_reader.obj");
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration obj_reader_test_registration(
+	"cgv::media::mesh::obj_reader", test_obj_reader_parsing);
+
+extern CGV_API benchmark_registration obj_reader_benchmark_registration(
+	"cgv::media::mesh::obj_reader_benchmark", benchmark_obj_reader);
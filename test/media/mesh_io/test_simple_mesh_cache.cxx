@@ -0,0 +1,196 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/simple_mesh.h>
+#include "test_file_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+typedef simple_mesh<float> mesh_type;
+
+/// return whether all elements of two meshes are equal
+static bool equal_meshes(const mesh_type& a, const mesh_type& b)
+{
+	if (a.get_nr_positions() != b.get_nr_positions() || a.get_nr_normals() != b.get_nr_normals() ||
+		a.get_nr_tangents() != b.get_nr_tangents() || a.get_nr_tex_coords() != b.get_nr_tex_coords() ||
+		a.get_nr_faces() != b.get_nr_faces() || a.get_nr_corners() != b.get_nr_corners() ||
+		a.get_nr_groups() != b.get_nr_groups() || a.get_nr_materials() != b.get_nr_materials() ||
+		a.get_nr_colors() != b.get_nr_colors() || a.has_normal_indices() != b.has_normal_indices() ||
+		a.has_tex_coord_indices() != b.has_tex_coord_indices())
+		return false;
+	for (unsigned i = 0; i < a.get_nr_positions(); ++i)
+		if (a.position(i) != b.position(i))
+			return false;
+	for (unsigned i = 0; i < a.get_nr_normals(); ++i)
+		if (a.normal(i) != b.normal(i))
+			return false;
+	for (unsigned i = 0; i < a.get_nr_tangents(); ++i)
+		if (a.tangent(i) != b.tangent(i))
+			return false;
+	for (unsigned i = 0; i < a.get_nr_tex_coords(); ++i)
+		if (a.tex_coord(i) != b.tex_coord(i))
+			return false;
+	for (unsigned fi = 0; fi < a.get_nr_faces(); ++fi) {
+		if (a.begin_corner(fi) != b.begin_corner(fi))
+			return false;
+		if (a.get_nr_groups() > 0 && a.group_index(fi) != b.group_index(fi))
+			return false;
+		if (a.get_nr_materials() > 0 && a.material_index(fi) != b.material_index(fi))
+			return false;
+	}
+	for (unsigned ci = 0; ci < a.get_nr_corners(); ++ci) {
+		if (a.c2p(ci) != b.c2p(ci))
+			return false;
+		if (a.has_normal_indices() && a.c2n(ci) != b.c2n(ci))
+			return false;
+		if (a.has_tex_coord_indices() && a.c2t(ci) != b.c2t(ci))
+			return false;
+	}
+	for (size_t i = 0; i < a.get_nr_groups(); ++i)
+		if (a.group_name(i) != b.group_name(i))
+			return false;
+	for (size_t i = 0; i < a.get_nr_materials(); ++i) {
+		const mesh_type::mat_type& ma = a.get_material(i), &mb = b.get_material(i);
+		if (ma.get_name() != mb.get_name() || !(ma.get_diffuse_reflectance() == mb.get_diffuse_reflectance()) ||
+			ma.get_roughness() != mb.get_roughness() || ma.get_nr_image_files() != mb.get_nr_image_files() ||
+			ma.get_diffuse_index() != mb.get_diffuse_index() || ma.get_bump_scale() != mb.get_bump_scale())
+			return false;
+		for (unsigned j = 0; j < ma.get_nr_image_files(); ++j)
+			if (ma.get_image_file_name(j) != mb.get_image_file_name(j))
+				return false;
+	}
+	if (a.get_nr_colors() > 0 && a.get_color_storage_type() != b.get_color_storage_type())
+		return false;
+	for (size_t i = 0; i < a.get_nr_colors(); ++i) {
+		mesh_type::rgba ca, cb;
+		a.put_color(i, ca);
+		b.put_color(i, cb);
+		if (!(ca == cb))
+			return false;
+	}
+	return true;
+}
+
+/// round trip through the binary format and reading of obj files through the binary cache
+bool test_simple_mesh_cache()
+{
+	// grid of quads with all kinds of elements, where groups and materials are defined before the faces refer to them
+	mesh_type M;
+	M.new_group("front");
+	M.new_group("back");
+	M.new_material();
+	M.ref_material(0).set_name("textured");
+	M.ref_material(0).set_diffuse_index(M.ref_material(0).add_image_file("diffuse.png"));
+	M.ref_material(0).set_bump_scale(0.25f);
+	M.new_material();
+	for (int y = 0; y < 4; ++y)
+		for (int x = 0; x < 4; ++x) {
+			M.new_position(mesh_type::vec3(float(x), float(y), 0.5f * x * y));
+			M.new_tex_coord(mesh_type::vec2(x / 3.0f, y / 3.0f));
+		}
+	for (unsigned y = 0; y < 3; ++y)
+		for (unsigned x = 0; x < 3; ++x) {
+			unsigned fi = M.start_face();
+			unsigned corners[4] = { 4 * y + x, 4 * y + x + 1, 4 * y + x + 5, 4 * y + x + 4 };
+			for (unsigned pi : corners)
+				M.new_corner(pi, -1, pi);
+			M.group_index(fi) = fi % 2;
+			M.material_index(fi) = (fi / 2) % 2;
+		}
+	M.compute_face_normals();
+	M.compute_face_tangents();
+	M.ensure_colors(cgv::media::CT_RGB, M.get_nr_positions());
+	for (unsigned i = 0; i < M.get_nr_positions(); ++i)
+		M.set_color(i, mesh_type::rgb(i * 0.05f, 1.0f, 0.5f));
+	TEST_ASSERT(M.write("test_simple_mesh_cache.bsm"));
+	mesh_type R;
+	TEST_ASSERT(R.read("test_simple_mesh_cache.bsm"));
+	TEST_ASSERT(equal_meshes(M, R));
+
+	// reading fails for other source files and for files in other formats without changing the mesh
+	TEST_ASSERT(!R.read_binary("test_simple_mesh_cache.bsm", "test_simple_mesh_cache.obj"));
+	TEST_ASSERT(write_test_file("test_simple_mesh_cache.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n"));
+	TEST_ASSERT(!R.read_binary("test_simple_mesh_cache.obj"));
+	simple_mesh<double> D;
+	TEST_ASSERT(!D.read_binary("test_simple_mesh_cache.bsm"));
+	TEST_ASSERT(equal_meshes(M, R));
+
+	// the first read of an obj file writes the cache, which is used by the next read
+	std::remove("test_simple_mesh_cache.obj.bsm");
+	mesh_type O1, O2;
+	TEST_ASSERT(O1.read("test_simple_mesh_cache.obj"));
+	TEST_ASSERT_EQ(O1.get_nr_faces(), 1u);
+	TEST_ASSERT(std::ifstream("test_simple_mesh_cache.obj.bsm").good());
+	TEST_ASSERT(O2.read("test_simple_mesh_cache.obj"));
+	TEST_ASSERT(equal_meshes(O1, O2));
+	TEST_ASSERT(O2.read_binary("test_simple_mesh_cache.obj.bsm", "test_simple_mesh_cache.obj"));
+	TEST_ASSERT(equal_meshes(O1, O2));
+
+	// changing the source file invalidates the cache
+	TEST_ASSERT(write_test_file("test_simple_mesh_cache.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 3\nf 2 4 3\n"));
+	TEST_ASSERT(!O2.read_binary("test_simple_mesh_cache.obj.bsm", "test_simple_mesh_cache.obj"));
+	mesh_type O3;
+	TEST_ASSERT(O3.read("test_simple_mesh_cache.obj"));
+	TEST_ASSERT_EQ(O3.get_nr_faces(), 2u);
+	TEST_ASSERT(O2.read_binary("test_simple_mesh_cache.obj.bsm", "test_simple_mesh_cache.obj"));
+	TEST_ASSERT_EQ(O2.get_nr_faces(), 2u);
+
+	// a rewrite with the same size within the resolution of the write time is detected by the fingerprint
+	TEST_ASSERT(write_test_file("test_simple_mesh_cache.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 4\nf 1 4 3\n"));
+	TEST_ASSERT(!O2.read_binary("test_simple_mesh_cache.obj.bsm", "test_simple_mesh_cache.obj"));
+	mesh_type O5;
+	TEST_ASSERT(O5.read("test_simple_mesh_cache.obj"));
+	TEST_ASSERT_EQ(O5.c2p(O5.begin_corner(1) + 1), 3u);
+
+	// without cache no cache file is written
+	mesh_type::set_binary_cache_enabled(false);
+	std::remove("test_simple_mesh_cache.obj.bsm");
+	mesh_type O4;
+	TEST_ASSERT(O4.read("test_simple_mesh_cache.obj"));
+	TEST_ASSERT(!std::ifstream("test_simple_mesh_cache.obj.bsm").good());
+	mesh_type::set_binary_cache_enabled(true);
+
+	std::remove("test_simple_mesh_cache.bsm");
+	std::remove("test_simple_mesh_cache.obj");
+	return true;
+}
+
+/// compare the time to read a large obj file with the time to read it again from the binary cache
+bool benchmark_simple_mesh_cache()
+{
+	const int nr_vertices = 1000000;
+	{
+		std::ofstream os("benchmark_simple_mesh_cache.obj", std::ios::binary);
+		char line[128];
+		for (int i = 0; i < nr_vertices; ++i) {
+			os.write(line, std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvn 0.5774 0.5774 0.5774\nvt %.5f 0.5\n", i * 1e-3, -i * 2e-3, 0.5, (i % 100) * 0.01));
+			if (i >= 2)
+				os.write(line, std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d -1/-1/-1\n", i - 1, i - 1, i - 1, i, i, i));
+		}
+	}
+	std::remove("benchmark_simple_mesh_cache.obj.bsm");
+	mesh_type M1, M2;
+	auto start = std::chrono::steady_clock::now();
+	TEST_ASSERT(M1.read("benchmark_simple_mesh_cache.obj"));
+	double parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	start = std::chrono::steady_clock::now();
+	TEST_ASSERT(M2.read("benchmark_simple_mesh_cache.obj"));
+	double cache_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	TEST_ASSERT(equal_meshes(M1, M2));
+	std::cout << "simple mesh: obj read and cache write " << 1000 * parse_seconds << " ms, cache read "
+		<< 1000 * cache_seconds << " ms" << std::endl;
+	std::remove("benchmark_simple_mesh_cache.obj");
+	std::remove("benchmark_simple_mesh_cache.obj.bsm");
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration simple_mesh_cache_test_registration(
+	"cgv::media::mesh::simple_mesh_cache", test_simple_mesh_cache);
+
+extern CGV_API benchmark_registration simple_mesh_cache_benchmark_registration(
+	"cgv::media::mesh::simple_mesh_cache_benchmark", benchmark_simple_mesh_cache);
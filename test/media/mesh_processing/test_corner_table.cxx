@@ -0,0 +1,156 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/simple_mesh.h>
+#include "test_mesh_fixtures.h"
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+typedef simple_mesh<float> mesh_type;
+typedef mesh_type::idx_type idx_type;
+
+/// check that the corner table of M is consistent and return its number of border corners
+static bool check_corner_table(const mesh_type& M, idx_type& nr_border_corners)
+{
+	const corner_table& ct = M.get_corner_table();
+	nr_border_corners = 0;
+	for (idx_type ci = 0; ci < M.get_nr_corners(); ++ci) {
+		if (M.c2p(M.next_corner(M.prev_corner(ci))) != M.c2p(ci) || ct.c2f[ci] >= M.get_nr_faces())
+			return false;
+		if (ct.inv[ci] == idx_type(-1)) {
+			++nr_border_corners;
+			if (ct.e2c[ct.c2e[ci]] != ci)
+				return false;
+			continue;
+		}
+		idx_type cj = ct.inv[ci];
+		if (ct.inv[cj] != ci || M.c2p(cj) != M.c2p(M.next_corner(ci)) || M.c2p(M.next_corner(cj)) != M.c2p(ci))
+			return false;
+		if (ct.c2e[ci] != ct.c2e[cj] || ct.e2c[ct.c2e[ci]] != std::min(ci, cj))
+			return false;
+	}
+	for (idx_type pi = 0; pi < M.get_nr_positions(); ++pi)
+		for (idx_type i = ct.position_corner_begins[pi]; i < ct.position_corner_begins[pi + 1]; ++i)
+			if (M.c2p(ct.position_corners[i]) != pi)
+				return false;
+	return ct.position_corner_begins.back() == M.get_nr_corners();
+}
+
+/// check the corner table of closed and open meshes, its invalidation and the element counts of Conway operators based on it
+bool test_corner_table()
+{
+	// icosahedron has 12 vertices, 30 edges and 20 faces
+	mesh_type M("I");
+	idx_type nr_border_corners;
+	TEST_ASSERT(check_corner_table(M, nr_border_corners));
+	TEST_ASSERT_EQ(nr_border_corners, 0u);
+	TEST_ASSERT_EQ(M.get_corner_table().get_nr_edges(), 30u);
+	for (idx_type pi = 0; pi < M.get_nr_positions(); ++pi)
+		TEST_ASSERT_EQ(M.c2p(M.get_corner_table().p2c(pi)), pi);
+
+	// copies share the table and changes of the faces rebuild it
+	mesh_type C(M);
+	TEST_ASSERT(&C.get_corner_table() == &M.get_corner_table());
+	C.start_face();
+	C.new_corner(0);
+	C.new_corner(1);
+	C.new_corner(2);
+	TEST_ASSERT(&C.get_corner_table() != &M.get_corner_table());
+	TEST_ASSERT(check_corner_table(C, nr_border_corners));
+	TEST_ASSERT_EQ(C.get_corner_table().inv.size(), 63u);
+
+	// single quad with border edges and an unused position
+	mesh_type Q;
+	for (int i = 0; i < 5; ++i)
+		Q.new_position(mesh_type::vec3(float(i % 2), float(i / 2), 0));
+	Q.start_face();
+	Q.new_corner(0);
+	Q.new_corner(1);
+	Q.new_corner(3);
+	Q.new_corner(2);
+	TEST_ASSERT(check_corner_table(Q, nr_border_corners));
+	TEST_ASSERT_EQ(nr_border_corners, 4u);
+	TEST_ASSERT_EQ(Q.get_corner_table().get_nr_edges(), 4u);
+	TEST_ASSERT_EQ(Q.get_corner_table().p2c(4), idx_type(-1));
+
+	// wireframe has one line per edge
+	std::vector<idx_type> vertex_indices, edges;
+	for (idx_type ci = 0; ci < M.get_nr_corners(); ++ci)
+		vertex_indices.push_back(M.c2p(ci));
+	M.extract_wireframe_element_buffer(vertex_indices, edges);
+	TEST_ASSERT_EQ(edges.size(), 60u);
+	TEST_ASSERT(edges[0] != edges[1]);
+
+	// vertex normals of a torus point away from its center circle
+	mesh_type T;
+	construct_torus(T, 40, 20);
+	TEST_ASSERT(check_corner_table(T, nr_border_corners));
+	TEST_ASSERT_EQ(nr_border_corners, 0u);
+	T.compute_vertex_normals();
+	bool outward = true;
+	for (idx_type pi = 0; pi < T.get_nr_positions(); ++pi) {
+		mesh_type::vec3 p = T.position(pi), c(p[0], p[1], 0);
+		c.normalize();
+		if (dot(T.normal(pi), p - c) < 0.9f * (p - c).length())
+			outward = false;
+	}
+	TEST_ASSERT(outward);
+
+	// new positions rebuild the table, which is sized by the number of positions
+	idx_type pi_new = T.new_position(mesh_type::vec3(0, 0, 5));
+	T.compute_vertex_normals();
+	TEST_ASSERT_EQ(T.get_nr_normals(), T.get_nr_positions());
+	TEST_ASSERT_EQ(T.get_corner_table().get_nr_positions(), T.get_nr_positions());
+	TEST_ASSERT(check_corner_table(T, nr_border_corners));
+	std::vector<uint32_t> inv, p2c;
+	T.compute_inv(inv, &p2c);
+	TEST_ASSERT_EQ(p2c.size(), size_t(T.get_nr_positions()));
+	TEST_ASSERT_EQ(p2c[pi_new], idx_type(-1));
+
+	// element counts of Conway operators on the icosahedron with V=12, E=30 and F=20
+	struct { const char* notation; idx_type v, f; } expected[] = {
+		{ "aI", 30, 32 }, { "tI", 60, 32 }, { "dI", 20, 12 }, { "sI", 60, 92 }, { "gI", 92, 60 }, { "jI", 32, 30 }, { "dtI", 32, 60 }
+	};
+	for (const auto& e : expected) {
+		mesh_type P(e.notation);
+		TEST_ASSERT_EQ(P.get_nr_positions(), e.v);
+		TEST_ASSERT_EQ(P.get_nr_faces(), e.f);
+		TEST_ASSERT(check_corner_table(P, nr_border_corners));
+		TEST_ASSERT_EQ(nr_border_corners, 0u);
+		TEST_ASSERT_EQ(P.get_corner_table().get_nr_edges(), e.v + e.f - 2);
+	}
+	return true;
+}
+
+/// measure building the corner table and chaining operators on a torus with ten million triangles
+bool benchmark_corner_table()
+{
+	mesh_type M;
+	construct_torus(M, 2500, 2000);
+	auto measure = [](const char* name, const std::function<void()>& f) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::cout << name << ": " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+	};
+	std::cout << "torus with " << M.get_nr_faces() << " triangles" << std::endl;
+	measure("corner table", [&]() { M.get_corner_table(); });
+	measure("vertex normals", [&]() { M.compute_vertex_normals(); });
+	std::vector<idx_type> vertex_indices(M.get_nr_corners()), edges;
+	for (idx_type ci = 0; ci < M.get_nr_corners(); ++ci)
+		vertex_indices[ci] = M.c2p(ci);
+	measure("wireframe", [&]() { M.extract_wireframe_element_buffer(vertex_indices, edges); });
+	measure("dual", [&]() { M.dual(); });
+	measure("dual of dual", [&]() { M.dual(); });
+	measure("vertex normals of dual of dual", [&]() { M.compute_vertex_normals(); });
+	return M.get_nr_faces() == 10000000;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration corner_table_test_registration(
+	"cgv::media::mesh::corner_table", test_corner_table);
+
+extern CGV_API benchmark_registration corner_table_benchmark_registration(
+	"cgv::media::mesh::corner_table_benchmark", benchmark_corner_table);
@@ -0,0 +1,150 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/marching_cubes.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+typedef marching_cubes<double, double> mc_type;
+typedef mc_type::pnt_type pnt_type;
+typedef std::array<double, 9> triangle_type;
+
+/// squared distance to the origin, whose iso surfaces are spheres
+struct squared_distance : public cgv::math::v3_func<double, double>
+{
+	double evaluate(const cgv::math::vec<double>& p) const { return p(0) * p(0) + p(1) * p(1) + p(2) * p(2); }
+};
+
+/// callback handler that collects the vertices and triangles of the sequential extraction
+struct mesh_collector : public streaming_mesh_callback_handler
+{
+	mc_type* mc_ptr;
+	std::vector<pnt_type> positions;
+	std::vector<unsigned int> triangles;
+	void new_vertex(unsigned int vi) { positions.push_back(mc_ptr->vertex_location(vi)); }
+	void new_polygon(const std::vector<unsigned int>& vertex_indices) { triangles.insert(triangles.end(), vertex_indices.begin(), vertex_indices.end()); }
+	void before_drop_vertex(unsigned int) {}
+};
+
+/// return the triangles by their corner locations, rotated to start with the smallest corner and sorted, such that meshes can be compared independent of the vertex order
+static std::vector<triangle_type> sorted_triangles(const std::vector<pnt_type>& positions, const std::vector<unsigned int>& triangles)
+{
+	std::vector<triangle_type> result;
+	for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3) {
+		std::array<std::array<double, 3>, 3> corners;
+		for (int c = 0; c < 3; ++c)
+			corners[c] = { positions[triangles[ti + c]](0), positions[triangles[ti + c]](1), positions[triangles[ti + c]](2) };
+		std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+		triangle_type t;
+		for (int c = 0; c < 9; ++c)
+			t[c] = corners[c / 3][c % 3];
+		result.push_back(t);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+/// check that the triangles form a closed surface, where each directed edge is matched by its reverse, and return the Euler characteristic over the referenced vertices
+static bool check_closed(const std::vector<unsigned int>& triangles, int& euler_characteristic)
+{
+	std::map<std::pair<unsigned int, unsigned int>, int> edge_counts;
+	std::set<unsigned int> vertices;
+	for (size_t ti = 0; ti + 2 < triangles.size(); ti += 3)
+		for (int c = 0; c < 3; ++c) {
+			unsigned int vi = triangles[ti + c], vj = triangles[ti + (c + 1) % 3];
+			if (vi == vj)
+				return false;
+			vertices.insert(vi);
+			++edge_counts[std::make_pair(vi, vj)];
+		}
+	size_t nr_edges = 0;
+	for (const auto& ec : edge_counts) {
+		auto iter = edge_counts.find(std::make_pair(ec.first.second, ec.first.first));
+		if (iter == edge_counts.end() || iter->second != ec.second)
+			return false;
+		if (ec.first.first < ec.first.second)
+			nr_edges += ec.second;
+	}
+	euler_characteristic = int(vertices.size()) - int(nr_edges) + int(triangles.size() / 3);
+	return true;
+}
+
+/// compare parallel extraction with the sequential one on spheres, where the grid spacings are exact and one radius passes through grid points
+bool test_marching_cubes()
+{
+	squared_distance f;
+	cgv::media::axis_aligned_box<double, 3> box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	const double iso_values[] = { 0.53, 0.25, 0.6 };
+	const unsigned int resolutions[][3] = { { 33, 33, 33 }, { 17, 33, 65 } };
+	for (const auto& res : resolutions)
+		for (double iso : iso_values) {
+			mesh_collector C;
+			mc_type mc(f, &C);
+			C.mc_ptr = &mc;
+			mc.extract(iso, box, res[0], res[1], res[2]);
+			int euler_characteristic = 0;
+			TEST_ASSERT(C.triangles.size() > 0);
+			TEST_ASSERT(check_closed(C.triangles, euler_characteristic));
+			TEST_ASSERT_EQ(euler_characteristic, 2);
+			std::vector<triangle_type> expected = sorted_triangles(C.positions, C.triangles);
+			for (unsigned int nr_threads : { 1u, 3u, 8u }) {
+				std::vector<pnt_type> positions;
+				std::vector<unsigned int> triangles;
+				mc.extract_parallel(iso, box, res[0], res[1], res[2], positions, triangles, nr_threads);
+				TEST_ASSERT_EQ(triangles.size(), C.triangles.size());
+				TEST_ASSERT(check_closed(triangles, euler_characteristic));
+				TEST_ASSERT_EQ(euler_characteristic, 2);
+				TEST_ASSERT(sorted_triangles(positions, triangles) == expected);
+			}
+		}
+	return true;
+}
+
+/// compare sparse extraction over min max block trees of different block sizes with the sequential extraction, where each tree is reused for several iso values
+bool test_marching_cubes_sparse()
+{
+	squared_distance f;
+	cgv::media::axis_aligned_box<double, 3> box(pnt_type(-1, -1, -1), pnt_type(1, 1, 1));
+	const double iso_values[] = { 0.53, 0.25, 0.6 };
+	const unsigned int resolutions[][3] = { { 33, 33, 33 }, { 17, 33, 65 } };
+	for (const auto& res : resolutions)
+		for (unsigned int block_size : { 4u, 8u }) {
+			mc_type mc(f, 0);
+			min_max_block_tree<double> tree;
+			mc.build_block_tree(box, res[0], res[1], res[2], tree, block_size);
+			for (double iso : iso_values) {
+				mesh_collector C;
+				mc_type sequential_mc(f, &C);
+				C.mc_ptr = &sequential_mc;
+				sequential_mc.extract(iso, box, res[0], res[1], res[2]);
+				std::vector<triangle_type> expected = sorted_triangles(C.positions, C.triangles);
+				for (unsigned int nr_threads : { 1u, 3u }) {
+					std::vector<pnt_type> positions;
+					std::vector<unsigned int> triangles;
+					mc.extract_sparse(iso, box, res[0], res[1], res[2], tree, positions, triangles, nr_threads);
+					TEST_ASSERT_EQ(triangles.size(), C.triangles.size());
+					int euler_characteristic = 0;
+					TEST_ASSERT(check_closed(triangles, euler_characteristic));
+					TEST_ASSERT_EQ(euler_characteristic, 2);
+					TEST_ASSERT(sorted_triangles(positions, triangles) == expected);
+				}
+			}
+			// iso values outside of the value range have no active blocks
+			std::vector<pnt_type> positions;
+			std::vector<unsigned int> triangles;
+			mc.extract_sparse(5.0, box, res[0], res[1], res[2], tree, positions, triangles);
+			TEST_ASSERT(positions.empty() && triangles.empty());
+		}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration marching_cubes_test_registration(
+	"cgv::media::mesh::marching_cubes", test_marching_cubes);
+
+extern CGV_API test_registration marching_cubes_sparse_test_registration(
+	"cgv::media::mesh::marching_cubes_sparse", test_marching_cubes_sparse);
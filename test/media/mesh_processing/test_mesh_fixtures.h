@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cgv/media/mesh/simple_mesh.h>
+#include <cmath>
+
+/// construct closed triangulated torus with n x m quads
+inline void construct_torus(cgv::media::mesh::simple_mesh<float>& M, unsigned n, unsigned m)
+{
+	typedef cgv::media::mesh::simple_mesh<float> mesh_type;
+	for (unsigned i = 0; i < n; ++i)
+		for (unsigned j = 0; j < m; ++j) {
+			float u = 6.2831853f * i / n, v = 6.2831853f * j / m;
+			M.new_position(mesh_type::vec3((1 + 0.3f * cos(v)) * cos(u), (1 + 0.3f * cos(v)) * sin(u), 0.3f * sin(v)));
+		}
+	for (unsigned i = 0; i < n; ++i)
+		for (unsigned j = 0; j < m; ++j) {
+			mesh_type::idx_type p00 = i * m + j, p01 = i * m + (j + 1) % m, p10 = ((i + 1) % n) * m + j, p11 = ((i + 1) % n) * m + (j + 1) % m;
+			M.start_face();
+			M.new_corner(p00);
+			M.new_corner(p10);
+			M.new_corner(p11);
+			M.start_face();
+			M.new_corner(p00);
+			M.new_corner(p11);
+			M.new_corner(p01);
+		}
+}
@@ -0,0 +1,138 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/simple_mesh.h>
+#include "test_mesh_fixtures.h"
+#include <chrono>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+typedef simple_mesh<float> mesh_type;
+typedef mesh_type::idx_type idx_type;
+
+/// construct unit square in the xy-plane from n x n quads, where the left and right half use different materials and
+/// separate texture coordinates that are offset by 10 in the right half
+static void construct_plane(mesh_type& M, unsigned n)
+{
+	M.new_material();
+	M.new_material();
+	for (unsigned i = 0; i <= n; ++i)
+		for (unsigned j = 0; j <= n; ++j)
+			M.new_position(mesh_type::vec3(float(j) / n, float(i) / n, 0));
+	for (unsigned m = 0; m < 2; ++m)
+		for (unsigned i = 0; i <= n; ++i)
+			for (unsigned j = 0; j <= n; ++j)
+				M.new_tex_coord(mesh_type::vec2(float(j) / n + 10 * m, float(i) / n));
+	for (unsigned i = 0; i < n; ++i)
+		for (unsigned j = 0; j < n; ++j) {
+			idx_type p = i * (n + 1) + j;
+			idx_type fi = M.start_face();
+			idx_type m = 2 * j < n ? 0 : 1, t = p + m * (n + 1) * (n + 1);
+			M.material_index(fi) = m;
+			M.new_corner(p, -1, t);
+			M.new_corner(p + 1, -1, t + 1);
+			M.new_corner(p + n + 2, -1, t + n + 2);
+			M.new_corner(p + n + 1, -1, t + n + 1);
+		}
+}
+
+/// check that M is a closed manifold torus close to the torus surface with the given tolerance
+static bool check_torus(const mesh_type& M, float tolerance)
+{
+	const corner_table& ct = M.get_corner_table();
+	for (idx_type ci = 0; ci < M.get_nr_corners(); ++ci)
+		if (ct.inv[ci] == idx_type(-1))
+			return false;
+	for (idx_type fi = 0; fi < M.get_nr_faces(); ++fi)
+		if (M.face_degree(fi) != 3)
+			return false;
+	if (M.get_nr_positions() + M.get_nr_faces() != ct.get_nr_edges())
+		return false;
+	for (idx_type pi = 0; pi < M.get_nr_positions(); ++pi) {
+		mesh_type::vec3 p = M.position(pi), c(p[0], p[1], 0);
+		c.normalize();
+		if (std::abs((p - c).length() - 0.3f) > tolerance)
+			return false;
+	}
+	return true;
+}
+
+/// simplify closed and open meshes sequentially and in parallel regions with target triangle count and error bound
+bool test_mesh_simplification()
+{
+	// sequential and parallel simplification to a target number of triangles keep the topology
+	for (unsigned nr_regions : { 1u, 8u }) {
+		mesh_type T;
+		construct_torus(T, 60, 30);
+		simplification_statistics stats = T.simplify(simplification_parameters(900, -1, 10, nr_regions));
+		TEST_ASSERT_EQ(stats.nr_input_triangles, size_t(3600));
+		TEST_ASSERT_EQ(stats.nr_regions, nr_regions);
+		TEST_ASSERT(stats.nr_triangles <= 900 && stats.nr_triangles >= 880);
+		TEST_ASSERT_EQ(size_t(T.get_nr_faces()), stats.nr_triangles);
+		TEST_ASSERT_EQ(stats.nr_collapses, size_t(1800 - T.get_nr_positions()));
+		TEST_ASSERT(check_torus(T, 0.02f));
+		TEST_ASSERT(stats.max_error > 0);
+	}
+
+	// error bound of zero keeps curved surfaces
+	mesh_type T;
+	construct_torus(T, 60, 30);
+	simplification_statistics stats = T.simplify(simplification_parameters(0, 0));
+	TEST_ASSERT_EQ(stats.nr_collapses, 0u);
+	TEST_ASSERT_EQ(T.get_nr_faces(), 3600u);
+
+	// planar interiors collapse within a small error while borders, material boundaries and texture coordinate seams are kept
+	mesh_type P;
+	construct_plane(P, 20);
+	stats = P.simplify(simplification_parameters(0, 1e-3));
+	TEST_ASSERT_EQ(stats.nr_input_triangles, size_t(800));
+	TEST_ASSERT(stats.nr_triangles < 200);
+	TEST_ASSERT(stats.max_error <= 1e-3);
+	TEST_ASSERT(P.get_nr_tex_coords() > P.get_nr_positions());
+	mesh_type::box_type box = P.compute_box();
+	TEST_ASSERT((box.get_min_pnt() - mesh_type::vec3(0, 0, 0)).length() < 1e-5f);
+	TEST_ASSERT((box.get_max_pnt() - mesh_type::vec3(1, 1, 0)).length() < 1e-5f);
+	bool materials_kept = true;
+	for (idx_type fi = 0; fi < P.get_nr_faces(); ++fi) {
+		mesh_type::vec3 c = P.compute_face_center(fi);
+		if (P.material_index(fi) != (c[0] < 0.5f ? 0u : 1u))
+			materials_kept = false;
+		for (idx_type ci = P.begin_corner(fi); ci < P.end_corner(fi); ++ci)
+			if (P.c2t(ci) >= P.get_nr_tex_coords() || (P.tex_coord(P.c2t(ci))[0] > 5) != (P.material_index(fi) == 1))
+				materials_kept = false;
+	}
+	TEST_ASSERT(materials_kept);
+
+	// polygons are triangulated also if no collapse is requested
+	mesh_type C("C");
+	stats = C.simplify(simplification_parameters());
+	TEST_ASSERT_EQ(stats.nr_input_triangles, size_t(12));
+	TEST_ASSERT_EQ(C.get_nr_faces(), 12u);
+	TEST_ASSERT_EQ(C.get_nr_positions(), 8u);
+	return true;
+}
+
+/// measure simplification of a torus with two million triangles to ten percent sequentially and in parallel regions
+bool benchmark_mesh_simplification()
+{
+	for (unsigned nr_regions : { 1u, 0u }) {
+		mesh_type M;
+		construct_torus(M, 1000, 1000);
+		auto start = std::chrono::steady_clock::now();
+		simplification_statistics stats = M.simplify(simplification_parameters(M.get_nr_faces() / 10, -1, 10, nr_regions));
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "simplification in " << stats.nr_regions << " regions from " << stats.nr_input_triangles << " to "
+			<< stats.nr_triangles << " triangles with error " << stats.max_error << ": " << 1000 * seconds << " ms, "
+			<< stats.nr_input_triangles / seconds << " triangles/s" << std::endl;
+		TEST_ASSERT(check_torus(M, 0.01f));
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration mesh_simplification_test_registration(
+	"cgv::media::mesh::mesh_simplification", test_mesh_simplification);
+
+extern CGV_API benchmark_registration mesh_simplification_benchmark_registration(
+	"cgv::media::mesh::mesh_simplification_benchmark", benchmark_mesh_simplification);
@@ -0,0 +1,141 @@
+#include <cgv/base/register.h>
+#include <cgv/media/mesh/vertex_cache_optimization.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+using namespace cgv::base;
+using namespace cgv::media::mesh;
+
+typedef cgv::type::uint32_type idx_type;
+typedef cgv::math::fvec<float, 3> vec3;
+
+/// append triangles of a regular grid with n x n quads in random order to elements and vertex positions on a sphere to positions
+static void construct_shuffled_grid(unsigned n, std::vector<idx_type>& elements, std::vector<vec3>& positions, unsigned seed = 1)
+{
+	idx_type base = idx_type(positions.size());
+	for (unsigned y = 0; y <= n; ++y)
+		for (unsigned x = 0; x <= n; ++x) {
+			float theta = 3.14159f * (y + 0.5f) / (n + 1), phi = 6.28318f * x / (n + 1);
+			positions.push_back(vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)));
+		}
+	std::vector<std::array<idx_type, 3> > triangles;
+	for (unsigned y = 0; y < n; ++y)
+		for (unsigned x = 0; x < n; ++x) {
+			idx_type i = base + y * (n + 1) + x;
+			triangles.push_back({ { i, i + 1, i + n + 2 } });
+			triangles.push_back({ { i, i + n + 2, i + n + 1 } });
+		}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+	for (const auto& t : triangles)
+		elements.insert(elements.end(), t.begin(), t.end());
+}
+
+/// return triangles of element range rotated such that their smallest index comes first and sorted
+static std::vector<std::array<idx_type, 3> > sorted_triangles(const std::vector<idx_type>& elements, size_t begin, size_t end)
+{
+	std::vector<std::array<idx_type, 3> > triangles;
+	for (size_t ei = begin; ei + 2 < end; ei += 3) {
+		std::array<idx_type, 3> t = { { elements[ei], elements[ei + 1], elements[ei + 2] } };
+		std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+		triangles.push_back(t);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+/// check statistics of the cache simulation and the improvement and correctness of all reorderings
+bool test_vertex_cache_optimization()
+{
+	// two triangles sharing an edge transform four vertices
+	std::vector<idx_type> quad = { 0, 1, 2, 2, 1, 3 };
+	vertex_cache_statistics s = simulate_vertex_cache(quad);
+	TEST_ASSERT_EQ(s.nr_triangles, 2u);
+	TEST_ASSERT_EQ(s.nr_vertices, 4u);
+	TEST_ASSERT_EQ(s.nr_cache_misses, 4u);
+	TEST_ASSERT_EQ(s.get_acmr(), 2.0);
+	TEST_ASSERT_EQ(s.get_atvr(), 1.0);
+	// with a cache of a single vertex only vertex 2 is reused
+	TEST_ASSERT_EQ(simulate_vertex_cache(quad, 1).nr_cache_misses, 5u);
+
+	// two shuffled grids in two ranges
+	std::vector<idx_type> elements;
+	std::vector<vec3> positions;
+	construct_shuffled_grid(40, elements, positions, 1);
+	size_t second_range_start = elements.size();
+	construct_shuffled_grid(30, elements, positions, 2);
+	std::vector<size_t> range_starts = { 0, second_range_start };
+	std::vector<idx_type> original = elements;
+	vertex_cache_statistics before = simulate_vertex_cache(elements);
+	std::vector<size_t> cluster_starts;
+	optimize_triangle_order(elements, positions.size(), 16, &range_starts, &cluster_starts);
+	vertex_cache_statistics after = simulate_vertex_cache(elements);
+	TEST_ASSERT(before.get_acmr() > 2.0);
+	TEST_ASSERT(after.get_acmr() < 0.8);
+	TEST_ASSERT(sorted_triangles(elements, 0, second_range_start) == sorted_triangles(original, 0, second_range_start));
+	TEST_ASSERT(sorted_triangles(elements, second_range_start, elements.size()) == sorted_triangles(original, second_range_start, original.size()));
+	TEST_ASSERT(!cluster_starts.empty() && cluster_starts[0] == 0);
+	TEST_ASSERT(std::find(cluster_starts.begin(), cluster_starts.end(), second_range_start) != cluster_starts.end());
+	TEST_ASSERT(std::is_sorted(cluster_starts.begin(), cluster_starts.end()));
+
+	// sorting clusters keeps triangles in their ranges and most of the cache locality
+	optimize_overdraw(elements, positions, cluster_starts, &range_starts);
+	TEST_ASSERT(sorted_triangles(elements, 0, second_range_start) == sorted_triangles(original, 0, second_range_start));
+	TEST_ASSERT(sorted_triangles(elements, second_range_start, elements.size()) == sorted_triangles(original, second_range_start, original.size()));
+	TEST_ASSERT(simulate_vertex_cache(elements).get_acmr() < 0.9);
+
+	// after fetch optimization vertices are referenced in ascending order of first use
+	std::vector<idx_type> ordered = elements, vertex_remap;
+	positions.push_back(vec3(0.0f));
+	TEST_ASSERT_EQ(optimize_vertex_fetch(ordered, positions.size(), vertex_remap), positions.size() - 1);
+	idx_type nr_used = 0;
+	bool first_use_order = true;
+	for (size_t ei = 0; ei < ordered.size(); ++ei) {
+		if (ordered[ei] > nr_used)
+			first_use_order = false;
+		if (ordered[ei] == nr_used)
+			++nr_used;
+		if (ordered[ei] != vertex_remap[elements[ei]])
+			first_use_order = false;
+	}
+	TEST_ASSERT(first_use_order);
+	TEST_ASSERT_EQ(vertex_remap.back(), idx_type(positions.size() - 1));
+	std::vector<idx_type> sorted_remap = vertex_remap;
+	std::sort(sorted_remap.begin(), sorted_remap.end());
+	for (idx_type vi = 0; vi < sorted_remap.size(); ++vi)
+		TEST_ASSERT_EQ(sorted_remap[vi], vi);
+	return true;
+}
+
+/// report reordering time and simulated cache statistics for a large shuffled grid
+bool benchmark_vertex_cache_optimization()
+{
+	std::vector<idx_type> elements;
+	std::vector<vec3> positions;
+	construct_shuffled_grid(700, elements, positions);
+	vertex_cache_statistics before = simulate_vertex_cache(elements);
+	std::vector<size_t> cluster_starts;
+	auto start = std::chrono::steady_clock::now();
+	optimize_triangle_order(elements, positions.size(), 16, 0, &cluster_starts);
+	double tipsify_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	vertex_cache_statistics after = simulate_vertex_cache(elements);
+	start = std::chrono::steady_clock::now();
+	optimize_overdraw(elements, positions, cluster_starts);
+	double overdraw_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	vertex_cache_statistics after_overdraw = simulate_vertex_cache(elements);
+	std::cout << "vertex cache optimization of " << before.nr_triangles << " triangles: ACMR " << before.get_acmr() << " -> "
+		<< after.get_acmr() << " in " << 1000 * tipsify_seconds << " ms, ATVR " << before.get_atvr() << " -> " << after.get_atvr()
+		<< ", after sorting " << cluster_starts.size() << " clusters in " << 1000 * overdraw_seconds << " ms ACMR "
+		<< after_overdraw.get_acmr() << std::endl;
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration vertex_cache_optimization_test_registration(
+	"cgv::media::mesh::vertex_cache_optimization", test_vertex_cache_optimization);
+
+extern CGV_API benchmark_registration vertex_cache_optimization_benchmark_registration(
+	"cgv::media::mesh::vertex_cache_optimization_benchmark", benchmark_vertex_cache_optimization);
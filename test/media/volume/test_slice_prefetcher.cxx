@@ -0,0 +1,176 @@
+#include <cgv/base/register.h>
+#include <cgv/media/volume/slice_prefetcher.h>
+#include <cgv/media/volume/sliced_volume_io.h>
+#include <test/temp_file_name.h>
+#include <cstdio>
+#include <fstream>
+
+using namespace cgv::base;
+using namespace cgv::media::volume;
+
+static const int width = 8, height = 6, nr_slices = 20;
+
+/// value of pixel p in slice i
+static cgv::type::uint16_type slice_value(int i, int p)
+{
+	return cgv::type::uint16_type(1000 * i + p);
+}
+
+/// write raw slice i preceded by a file header of nr_header_bytes that readers skip, or only the first nr_values pixels
+static bool write_raw_slice(const std::string& file_name, int i, int nr_header_bytes = 7, int nr_values = width * height)
+{
+	std::ofstream os(file_name.c_str(), std::ios::binary);
+	for (int b = 0; b < nr_header_bytes; ++b)
+		os.put(char(0xff));
+	for (int p = 0; p < nr_values; ++p) {
+		cgv::type::uint16_type v = slice_value(i, p);
+		os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+	}
+	return os.good();
+}
+
+/// return whether the view contains slice i
+static bool check_slice(const cgv::data::data_view* dv, int i)
+{
+	if (!dv)
+		return false;
+	const cgv::type::uint16_type* ptr = dv->get_ptr<cgv::type::uint16_type>();
+	for (int p = 0; p < width * height; ++p)
+		if (ptr[p] != slice_value(i, p))
+			return false;
+	return true;
+}
+
+/// read the slices [begin, end) through the sliding window and return whether all of them were correct
+static bool read_all_slices(slice_prefetcher& prefetcher, int begin, int end)
+{
+	bool correct = true;
+	for (int i = begin; i < end; ++i) {
+		correct = check_slice(prefetcher.get_slice(i), i) && correct;
+		prefetcher.release_slices_before(i + 1);
+	}
+	return correct;
+}
+
+bool test_slice_prefetcher()
+{
+	// volume of raw 16 bit slices without file extension, whose data is stored at the end of the slice files
+	ooc_sliced_volume svol;
+	svol.get_format().set_component_format(cgv::data::component_format(cgv::type::info::TI_UINT16, cgv::data::CF_L));
+	svol.resize(volume::dimension_type(width, height, nr_slices));
+	svol.ref_extent() = volume::extent_type(1, 1, 1);
+	svol.file_name_pattern = get_temp_file_name("test_slice_prefetcher_0$");
+	for (int i = 0; i < nr_slices; ++i)
+		TEST_ASSERT(write_raw_slice(svol.get_slice_file_name(i), i));
+
+	// read all slices with more threads than needed for a small ring
+	{
+		slice_prefetcher prefetcher;
+		TEST_ASSERT(prefetcher.start(svol, 3, 4));
+		TEST_ASSERT_EQ(prefetcher.get_capacity(), 4u);
+		TEST_ASSERT_EQ(prefetcher.get_slice_file_name(12), svol.get_slice_file_name(12));
+		TEST_ASSERT(read_all_slices(prefetcher, 0, nr_slices));
+		slice_prefetcher::statistics stats = prefetcher.get_statistics();
+		TEST_ASSERT_EQ(stats.nr_slices, size_t(nr_slices));
+		TEST_ASSERT_EQ(stats.nr_bytes, size_t(nr_slices * width * height * 2));
+		TEST_ASSERT(stats.elapsed_seconds > 0);
+		TEST_ASSERT(stats.get_slices_per_second() > 0);
+		TEST_ASSERT(stats.get_megabytes_per_second() > 0);
+	}
+
+	// only slices in the window of not released slices can be accessed
+	{
+		slice_prefetcher prefetcher;
+		TEST_ASSERT(prefetcher.start(svol, 2, 4, 5, 12));
+		TEST_ASSERT(prefetcher.get_slice(4) == 0);
+		TEST_ASSERT(prefetcher.get_slice(9) == 0);
+		TEST_ASSERT(check_slice(prefetcher.get_slice(8), 8));
+		TEST_ASSERT(check_slice(prefetcher.get_slice(5), 5));
+		prefetcher.release_slices_before(7);
+		TEST_ASSERT(prefetcher.get_slice(6) == 0);
+		TEST_ASSERT(check_slice(prefetcher.get_slice(10), 10));
+		TEST_ASSERT(prefetcher.get_slice(11) == 0);
+		prefetcher.release_slices_before(9);
+		TEST_ASSERT(check_slice(prefetcher.get_slice(11), 11));
+		TEST_ASSERT(prefetcher.get_slice(12) == 0);
+		TEST_ASSERT(!prefetcher.start(svol, 2, 4, 5, nr_slices + 1));
+		TEST_ASSERT(!prefetcher.start(svol, 2, 4, 6, 5));
+	}
+
+	// slices released before they were scheduled are skipped
+	{
+		slice_prefetcher prefetcher;
+		TEST_ASSERT(prefetcher.start(svol, 2, 4));
+		prefetcher.release_slices_before(12);
+		TEST_ASSERT(read_all_slices(prefetcher, 12, nr_slices));
+		// at most the slices of the first window can have been loaded before the release
+		TEST_ASSERT(prefetcher.get_statistics().nr_slices <= size_t(nr_slices - 12 + 4));
+		prefetcher.release_slices_before(nr_slices + 5);
+		TEST_ASSERT(prefetcher.get_slice(nr_slices - 1) == 0);
+	}
+
+	// missing and too small slice files fail without stopping the remaining slices
+	{
+		std::vector<std::string> file_names;
+		for (int i = 0; i < nr_slices; ++i)
+			file_names.push_back(svol.get_slice_file_name(i));
+		file_names[2] = get_temp_file_name("test_slice_prefetcher_missing");
+		file_names[3] = get_temp_file_name("test_slice_prefetcher_small");
+		std::remove(file_names[2].c_str());
+		TEST_ASSERT(write_raw_slice(file_names[3], 3, 0, width * height - 1));
+		slice_prefetcher prefetcher;
+		TEST_ASSERT(prefetcher.start(svol, 2, 4, 0, -1, &file_names));
+		TEST_ASSERT(check_slice(prefetcher.get_slice(1), 1));
+		TEST_ASSERT(prefetcher.get_slice(2) == 0);
+		TEST_ASSERT(prefetcher.get_slice(3) == 0);
+		prefetcher.release_slices_before(4);
+		TEST_ASSERT(read_all_slices(prefetcher, 4, nr_slices));
+		TEST_ASSERT_EQ(prefetcher.get_statistics().nr_slices, size_t(nr_slices - 2));
+		std::remove(file_names[3].c_str());
+		file_names.resize(5);
+		TEST_ASSERT(!prefetcher.start(svol, 2, 4, 0, -1, &file_names));
+	}
+
+	// stopping wakes loaders that wait for free slots, and a stopped prefetcher can be restarted
+	{
+		slice_prefetcher prefetcher;
+		TEST_ASSERT(prefetcher.start(svol, 4, 2));
+		TEST_ASSERT(check_slice(prefetcher.get_slice(1), 1));
+		prefetcher.stop();
+		TEST_ASSERT(prefetcher.get_statistics().nr_slices <= 2u);
+		TEST_ASSERT(prefetcher.start(svol, 1, 3));
+		TEST_ASSERT(read_all_slices(prefetcher, 0, nr_slices));
+		// the destructor stops loaders of a prefetcher that is still running
+		TEST_ASSERT(prefetcher.start(svol, 2, 2));
+	}
+
+	// read the volume from a header with configured prefetching and report the statistics
+	{
+		std::string header_file_name = get_temp_file_name("test_slice_prefetcher.svx");
+		ooc_sliced_volume header_vol = svol;
+		header_vol.file_name_pattern = "test_slice_prefetcher_0$";
+		TEST_ASSERT(write_sliced_header(header_file_name, header_vol));
+		volume V;
+		slice_prefetcher::statistics stats;
+		TEST_ASSERT(read_from_sliced_volume(header_file_name, V, 2, 3, &stats));
+		TEST_ASSERT(V.get_dimensions() == volume::dimension_type(width, height, nr_slices));
+		bool volume_correct = true;
+		const cgv::type::uint16_type* ptr = V.get_data_ptr<cgv::type::uint16_type>();
+		for (int i = 0; i < nr_slices; ++i)
+			for (int p = 0; p < width * height; ++p)
+				volume_correct = volume_correct && ptr[i * width * height + p] == slice_value(i, p);
+		TEST_ASSERT(volume_correct);
+		TEST_ASSERT_EQ(stats.nr_slices, size_t(nr_slices));
+		TEST_ASSERT_EQ(stats.nr_bytes, size_t(nr_slices * width * height * 2));
+		std::remove(header_file_name.c_str());
+	}
+
+	for (int i = 0; i < nr_slices; ++i)
+		std::remove(svol.get_slice_file_name(i).c_str());
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration slice_prefetcher_test_registration(
+	"cgv::media::volume::slice_prefetcher", test_slice_prefetcher);
@@ -0,0 +1,267 @@
+#include <cgv/base/register.h>
+#include <cgv/os/socket.h>
+#include <cgv/os/http_server.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::os;
+
+/// response received by a test client
+struct test_response
+{
+	std::string status;
+	std::map<std::string, std::string> headers;
+	std::string body;
+};
+
+/// receive one response including a chunked body from client and return false if the connection was closed
+static bool receive_response(socket_client_ptr client, test_response& r, bool head_only = false)
+{
+	r = test_response();
+	std::string line = client->receive_line();
+	if (line.empty())
+		return false;
+	r.status = line.substr(9, line.find_last_not_of("\r\n") - 8);
+	while ((line = client->receive_line()) != "\r\n" && !line.empty()) {
+		size_t colon = line.find(':');
+		r.headers[line.substr(0, colon)] = line.substr(colon + 2, line.find_last_not_of("\r\n") - colon - 1);
+	}
+	if (head_only)
+		return true;
+	if (r.headers["Transfer-Encoding"] == "chunked") {
+		while (true) {
+			size_t size = std::strtoul(client->receive_line().c_str(), 0, 16);
+			if (size > 0)
+				r.body += client->receive_data(unsigned(size));
+			client->receive_data(2);
+			if (size == 0)
+				return true;
+		}
+	}
+	size_t size = std::strtoul(r.headers["Content-Length"].c_str(), 0, 10);
+	if (size > 0)
+		r.body = client->receive_data(unsigned(size));
+	return r.body.size() == size;
+}
+
+/// send get request for path on client and receive its response
+static bool get(socket_client_ptr client, const std::string& path, test_response& r)
+{
+	return client->send_data("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n") && receive_response(client, r);
+}
+
+/// handler of test requests, which streams answers from threads that are joined by the test
+struct test_http_handler
+{
+	std::vector<char> block;
+	std::string file_name;
+	std::mutex mtx;
+	std::vector<std::thread> stream_threads;
+	test_http_handler() : block(1 << 20)
+	{
+		for (size_t i = 0; i < block.size(); ++i)
+			block[i] = char(i % 253);
+	}
+	void handle(http_request& q)
+	{
+		if (q.path == "/hello")
+			q.answer = "hello " + q.params["name"];
+		else if (q.path == "/slow") {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			q.answer = "slow";
+		}
+		else if (q.path == "/echo") {
+			q.answer = q.body;
+			q.content_type = "application/octet-stream";
+		}
+		else if (q.path == "/block") {
+			q.answer_data = block.data();
+			q.answer_size = block.size();
+		}
+		else if (q.path == "/file")
+			q.answer_file = file_name;
+		else if (q.path == "/missing_file")
+			q.answer_file = file_name + ".missing";
+		else if (q.path == "/stream") {
+			q.stream_answer = true;
+			http_response_stream_ptr s = q.answer_stream;
+			std::lock_guard<std::mutex> lock(mtx);
+			stream_threads.push_back(std::thread([s]() {
+				for (int i = 0; i < 3; ++i) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+					s->send_chunk("chunk " + std::to_string(i) + ";");
+				}
+				s->close();
+			}));
+		}
+		else if (q.path == "/throw")
+			throw std::runtime_error("handler failed");
+		else {
+			q.status = "404 Not Found";
+			q.answer = "not found";
+		}
+	}
+	void join()
+	{
+		for (auto& t : stream_threads)
+			t.join();
+		stream_threads.clear();
+	}
+};
+
+/// exercise keep alive, pipelining, zero copy and file answers, chunked streaming and error responses
+bool test_http_server()
+{
+	test_http_handler handler;
+	handler.file_name = "test_http_server.tmp";
+	std::string file_content(100000, 'f');
+	FILE* fp = fopen(handler.file_name.c_str(), "wb");
+	TEST_ASSERT(fp != 0);
+	fwrite(file_content.data(), 1, file_content.size(), fp);
+	fclose(fp);
+
+	http_server server([&](http_request& q) { handler.handle(q); }, 2);
+	TEST_ASSERT(server.listen(0));
+	std::thread server_thread(&http_server::run, &server);
+
+	// all requests of a kept alive connection
+	socket_client_ptr client = create_socket_client();
+	TEST_ASSERT(client->connect("localhost", server.get_port()));
+	test_response r;
+	TEST_ASSERT(get(client, "/hello?name=a%20b", r));
+	TEST_ASSERT_EQ(r.status, "200 OK");
+	TEST_ASSERT_EQ(r.body, "hello a b");
+	TEST_ASSERT_EQ(r.headers["Connection"], "keep-alive");
+	TEST_ASSERT(client->send_data("POST /echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nabcde"));
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.body, "abcde");
+	TEST_ASSERT_EQ(r.headers["Content-Type"], "application/octet-stream");
+	TEST_ASSERT(get(client, "/block", r));
+	TEST_ASSERT(r.body == std::string(handler.block.begin(), handler.block.end()));
+	TEST_ASSERT(get(client, "/file", r));
+	TEST_ASSERT(r.body == file_content);
+	TEST_ASSERT(get(client, "/missing_file", r));
+	TEST_ASSERT_EQ(r.status, "404 Not Found");
+	TEST_ASSERT(get(client, "/stream", r));
+	TEST_ASSERT_EQ(r.body, "chunk 0;chunk 1;chunk 2;");
+	TEST_ASSERT(get(client, "/throw", r));
+	TEST_ASSERT_EQ(r.status, "500 Internal Server Error");
+	TEST_ASSERT(client->send_data("HEAD /hello HTTP/1.1\r\n\r\n"));
+	TEST_ASSERT(receive_response(client, r, true));
+	TEST_ASSERT_EQ(r.headers["Content-Length"], "6");
+	TEST_ASSERT(get(client, "/hello?name=c", r));
+	TEST_ASSERT_EQ(r.body, "hello c");
+
+	// pipelined requests are answered in request order although the first one is handled last
+	TEST_ASSERT(client->send_data("GET /slow HTTP/1.1\r\n\r\nGET /stream HTTP/1.1\r\n\r\nGET /hello?name=d HTTP/1.1\r\n\r\n"));
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.body, "slow");
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.body, "chunk 0;chunk 1;chunk 2;");
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.body, "hello d");
+	client->close();
+
+	// HTTP/1.0 connections are closed after the response unless they are kept alive on request
+	client = create_socket_client();
+	TEST_ASSERT(client->connect("localhost", server.get_port()));
+	TEST_ASSERT(client->send_data("GET /hello HTTP/1.0\r\n\r\n"));
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.headers["Connection"], "close");
+	TEST_ASSERT(!receive_response(client, r));
+	client->close();
+
+	// malformed requests are rejected and close the connection
+	client = create_socket_client();
+	TEST_ASSERT(client->connect("localhost", server.get_port()));
+	TEST_ASSERT(client->send_data("garbage\r\n\r\n"));
+	TEST_ASSERT(receive_response(client, r));
+	TEST_ASSERT_EQ(r.status, "400 Bad Request");
+	TEST_ASSERT(!receive_response(client, r));
+	client->close();
+
+	for (int i = 0; i < 200 && server.get_statistics().nr_open_connections > 0; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	http_server::statistics s = server.get_statistics();
+	TEST_ASSERT_EQ(s.nr_connections, 3u);
+	TEST_ASSERT_EQ(s.nr_open_connections, 0u);
+	TEST_ASSERT_EQ(s.nr_requests, 13u);
+
+	server.stop();
+	server_thread.join();
+	handler.join();
+	std::remove(handler.file_name.c_str());
+	return true;
+}
+
+/// measure throughput and latency of small requests on many kept alive connections driven by a few client threads
+bool benchmark_http_server()
+{
+	const int nr_client_threads = 4, nr_requests = 100;
+	for (int nr_connections : { 16, 128, 512 }) {
+		http_server server([](http_request& q) { q.answer = "hello " + q.params["name"]; });
+		if (!server.listen(0)) {
+			std::cerr << server.get_last_error() << std::endl;
+			return false;
+		}
+		std::thread server_thread(&http_server::run, &server);
+		std::vector<socket_client_ptr> clients;
+		for (int i = 0; i < nr_connections; ++i) {
+			clients.push_back(create_socket_client());
+			TEST_ASSERT(clients.back()->connect("localhost", server.get_port()));
+		}
+		std::vector<std::vector<double> > latencies(nr_client_threads);
+		std::atomic<int> nr_errors(0);
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (int t = 0; t < nr_client_threads; ++t)
+			threads.push_back(std::thread([&, t]() {
+				const std::string request = "GET /hello?name=" + std::to_string(t) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+				test_response r;
+				// each thread sends one request on all its connections before collecting the responses
+				for (int n = 0; n < nr_requests; ++n) {
+					auto sent = std::chrono::steady_clock::now();
+					for (int i = t; i < nr_connections; i += nr_client_threads)
+						if (!clients[i]->send_data(request))
+							++nr_errors;
+					for (int i = t; i < nr_connections; i += nr_client_threads) {
+						if (!receive_response(clients[i], r) || r.body != "hello " + std::to_string(t))
+							++nr_errors;
+						latencies[t].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+					}
+				}
+			}));
+		for (auto& t : threads)
+			t.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		TEST_ASSERT_EQ(nr_errors, 0);
+		std::vector<double> all;
+		for (const auto& l : latencies)
+			all.insert(all.end(), l.begin(), l.end());
+		std::sort(all.begin(), all.end());
+		auto percentile = [&all](double p) { return all[std::min(all.size() - 1, size_t(p * all.size()))]; };
+		std::cout << "http server with " << nr_connections << " connections: " << all.size() / seconds << " requests/s, latency p50 "
+			<< percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms, p99.9 " << percentile(0.999) << " ms" << std::endl;
+		for (auto& c : clients)
+			c->close();
+		server.stop();
+		server_thread.join();
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration http_server_test_registration(
+	"cgv::os::http_server", test_http_server);
+
+extern CGV_API benchmark_registration http_server_benchmark_registration(
+	"cgv::os::http_server_benchmark", benchmark_http_server);
@@ -0,0 +1,200 @@
+#include <cgv/base/register.h>
+#include <cgv/os/socket.h>
+#include <cgv/os/socket_event_loop.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+using namespace cgv::base;
+using namespace cgv::os;
+
+/// handler that echoes lines with a prefix and answers "big" with a large block of data
+struct echo_handler : public socket_connection_handler
+{
+	std::atomic<int> nr_open, nr_accepted, nr_lines;
+	std::atomic<size_t> nr_bytes_received;
+	std::vector<char> big_block;
+	echo_handler() : nr_open(0), nr_accepted(0), nr_lines(0), nr_bytes_received(0), big_block(8 << 20)
+	{
+		for (size_t i = 0; i < big_block.size(); ++i)
+			big_block[i] = char(i % 251);
+	}
+	void on_connect(socket_connection&)
+	{
+		++nr_open;
+		++nr_accepted;
+	}
+	void on_receive(socket_connection& c)
+	{
+		static const char prefix[] = "echo: ";
+		size_t n;
+		while ((n = c.find_line()) > 0) {
+			// count line before answering, such that the client sees the count after receiving the answer
+			++nr_lines;
+			if (std::string(c.get_input(), n) == "big\n") {
+				c.send(big_block.data(), big_block.size());
+				c.send("\n", 1);
+			}
+			else {
+				// answer with a single gather send of the prefix and the line in the input buffer
+				socket_connection::buffer buffers[2] = { { prefix, sizeof(prefix) - 1 }, { c.get_input(), n } };
+				c.send(buffers, 2);
+			}
+			c.consume(n);
+		}
+	}
+	void on_close(socket_connection& c)
+	{
+		nr_bytes_received += c.get_statistics().nr_bytes_received;
+		--nr_open;
+	}
+};
+
+/// serve hundreds of simultaneously open connections, large sends, timers and posted functions from one thread
+bool test_socket_event_loop()
+{
+	echo_handler handler;
+	socket_event_loop loop;
+	TEST_ASSERT(loop.listen(0, &handler));
+	int port = loop.get_listening_port();
+	// only local connections are accepted unless another interface is given explicitly
+	TEST_ASSERT_EQ(loop.get_listening_address(), std::string("127.0.0.1"));
+	TEST_ASSERT(!loop.listen(0, &handler, 128, "localhost"));
+	TEST_ASSERT(!loop.get_last_error().empty());
+	TEST_ASSERT(loop.listen(0, &handler, 128, "0.0.0.0"));
+	TEST_ASSERT_EQ(loop.get_listening_address(1), std::string("0.0.0.0"));
+	int any_port = loop.get_listening_port(1);
+	std::thread loop_thread(&socket_event_loop::run, &loop);
+
+	// open all connections before using them, such that they are served at the same time
+	const int nr_clients = 300, nr_rounds = 3;
+	std::vector<socket_client_ptr> clients;
+	for (int i = 0; i < nr_clients; ++i) {
+		socket_client_ptr c = create_socket_client();
+		TEST_ASSERT(c->connect("localhost", port));
+		clients.push_back(c);
+	}
+	size_t nr_bytes_sent = 0;
+	for (int r = 0; r < nr_rounds; ++r)
+		for (int i = 0; i < nr_clients; ++i) {
+			std::string line = "client " + std::to_string(i) + " round " + std::to_string(r);
+			TEST_ASSERT(clients[i]->send_line(line));
+			nr_bytes_sent += line.size() + 1;
+			TEST_ASSERT_EQ(clients[i]->receive_line(), "echo: " + line + "\n");
+		}
+	TEST_ASSERT_EQ(handler.nr_accepted, nr_clients);
+	TEST_ASSERT_EQ(handler.nr_lines, nr_clients * nr_rounds);
+
+	// a block larger than the socket buffers is queued and sent when the socket becomes writable
+	TEST_ASSERT(clients[0]->send_line("big"));
+	nr_bytes_sent += 4;
+	std::string block = clients[0]->receive_data(unsigned(handler.big_block.size() + 1));
+	TEST_ASSERT_EQ(block.size(), handler.big_block.size() + 1);
+	TEST_ASSERT(std::equal(handler.big_block.begin(), handler.big_block.end(), block.begin()));
+
+	// periodic timer added from another thread via post cancels itself after five activations
+	std::atomic<int> nr_activations(0);
+	size_t timer_id = 0;
+	loop.post([&]() {
+		timer_id = loop.add_timer(0.001, [&]() {
+			if (++nr_activations == 5)
+				TEST_ASSERT(loop.cancel_timer(timer_id));
+		}, 0.002);
+	});
+	for (int i = 0; i < 200 && nr_activations < 5; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	TEST_ASSERT_EQ(nr_activations, 5);
+
+	// closing clients closes their connections in the loop
+	for (auto& c : clients)
+		c->close();
+	clients.clear();
+	for (int i = 0; i < 200 && handler.nr_open > 0; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	TEST_ASSERT_EQ(handler.nr_open, 0);
+	TEST_ASSERT_EQ(handler.nr_bytes_received, nr_bytes_sent);
+
+	// the listener on all interfaces accepts local connections as well
+	socket_client_ptr any_client = create_socket_client();
+	TEST_ASSERT(any_client->connect("localhost", any_port));
+	TEST_ASSERT(any_client->send_line("any interface"));
+	TEST_ASSERT_EQ(any_client->receive_line(), std::string("echo: any interface\n"));
+	any_client->close();
+
+	loop.stop();
+	loop_thread.join();
+	return true;
+}
+
+/// handler that answers each fixed size request with a response of the same size
+struct ping_handler : public socket_connection_handler
+{
+	size_t message_size;
+	ping_handler(size_t _message_size) : message_size(_message_size) {}
+	void on_receive(socket_connection& c)
+	{
+		while (c.get_input_size() >= message_size) {
+			c.send(c.get_input(), message_size);
+			c.consume(message_size);
+		}
+	}
+};
+
+/// measure request/response throughput of one loop thread serving many connections driven by a few client threads
+bool benchmark_socket_event_loop()
+{
+	const size_t message_size = 256;
+	const int nr_client_threads = 4, nr_requests = 200;
+	for (int nr_connections : { 16, 128, 512 }) {
+		ping_handler handler(message_size);
+		socket_event_loop loop;
+		TEST_ASSERT(loop.listen(0, &handler, 1024));
+		int port = loop.get_listening_port();
+		std::thread loop_thread(&socket_event_loop::run, &loop);
+		std::vector<socket_client_ptr> clients;
+		for (int i = 0; i < nr_connections; ++i) {
+			clients.push_back(create_socket_client());
+			TEST_ASSERT(clients.back()->connect("localhost", port));
+		}
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		std::atomic<int> nr_errors(0);
+		for (int t = 0; t < nr_client_threads; ++t)
+			threads.push_back(std::thread([&, t]() {
+				std::vector<char> message(message_size, char('a' + t));
+				// each thread sends one request on all its connections before collecting the responses
+				for (int r = 0; r < nr_requests; ++r) {
+					for (int i = t; i < nr_connections; i += nr_client_threads)
+						if (!clients[i]->send_data(message.data(), unsigned(message_size)))
+							++nr_errors;
+					for (int i = t; i < nr_connections; i += nr_client_threads)
+						if (clients[i]->receive_data(unsigned(message_size)).size() != message_size)
+							++nr_errors;
+				}
+			}));
+		for (auto& t : threads)
+			t.join();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		TEST_ASSERT_EQ(nr_errors, 0);
+		double nr_messages = double(nr_connections) * nr_requests;
+		std::cout << loop.get_backend_name() << " loop with " << nr_connections << " connections: "
+			<< nr_messages / seconds << " requests/s, "
+			<< 2 * nr_messages * message_size / (1048576.0 * seconds) << " MB/s" << std::endl;
+		for (auto& c : clients)
+			c->close();
+		loop.stop();
+		loop_thread.join();
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration socket_event_loop_test_registration(
+	"cgv::os::socket_event_loop", test_socket_event_loop);
+
+extern CGV_API benchmark_registration socket_event_loop_benchmark_registration(
+	"cgv::os::socket_event_loop_benchmark", benchmark_socket_event_loop);
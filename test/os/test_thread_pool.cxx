@@ -0,0 +1,125 @@
+#include <cgv/base/register.h>
+#include <cgv/os/thread_pool.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+using namespace cgv::base;
+using namespace cgv::os;
+
+/// return seconds since given time point
+static double seconds_since(const std::chrono::steady_clock::time_point& t)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+/// sum of square roots in [b,e) as compute bound work load
+static double sum_of_roots(size_t b, size_t e)
+{
+	double s = 0;
+	for (size_t i = b; i < e; ++i)
+		s += std::sqrt(double(i));
+	return s;
+}
+
+bool test_thread_pool()
+{
+	for (int nr_workers = 0; nr_workers < 5; nr_workers += 2) {
+		thread_pool pool(nr_workers);
+		TEST_ASSERT_EQ(pool.get_nr_workers(), unsigned(nr_workers));
+
+		// each index visited exactly once for different grain sizes
+		const size_t n = 100000;
+		std::vector<std::atomic<int> > visits(n);
+		for (size_t grain_size : { size_t(0), size_t(1), size_t(7), n }) {
+			for (auto& v : visits)
+				v = 0;
+			pool.parallel_for(0, n, [&](size_t i) { ++visits[i]; }, grain_size);
+			size_t nr_wrong = 0;
+			for (auto& v : visits)
+				nr_wrong += v != 1 ? 1 : 0;
+			TEST_ASSERT_EQ(nr_wrong, 0);
+		}
+
+		// reduction independent of scheduling
+		size_t sum = pool.parallel_reduce(size_t(0), n, size_t(0),
+			[](size_t b, size_t e) { size_t s = 0; for (size_t i = b; i < e; ++i) s += i; return s; },
+			[](size_t a, size_t b) { return a + b; });
+		TEST_ASSERT_EQ(sum, n * (n - 1) / 2);
+		double s0 = pool.parallel_reduce(0, n, 0.0, sum_of_roots, [](double a, double b) { return a + b; }, 1000);
+		double s1 = pool.parallel_reduce(0, n, 0.0, sum_of_roots, [](double a, double b) { return a + b; }, 1000);
+		TEST_ASSERT(s0 == s1);
+
+		// nested parallel loops
+		std::atomic<size_t> nr_inner(0);
+		pool.parallel_for(0, 64, [&](size_t) {
+			pool.parallel_for(0, 100, [&](size_t) { ++nr_inner; }, 10);
+		}, 1);
+		TEST_ASSERT_EQ(nr_inner.load(), size_t(6400));
+
+		// task group with recursively spawned tasks
+		std::atomic<int> nr_tasks(0);
+		{
+			task_group group(pool);
+			std::function<void(int)> spawn = [&](int depth) {
+				++nr_tasks;
+				if (depth > 0) {
+					group.run([&spawn, depth]() { spawn(depth - 1); });
+					group.run([&spawn, depth]() { spawn(depth - 1); });
+				}
+			};
+			group.run([&spawn]() { spawn(10); });
+			group.wait();
+		}
+		TEST_ASSERT_EQ(nr_tasks.load(), 2047);
+
+		// exceptions of tasks are rethrown by wait
+		bool caught = false;
+		try {
+			pool.parallel_for(0, 1000, [](size_t i) {
+				if (i == 500)
+					throw std::runtime_error("failure");
+			}, 10);
+		}
+		catch (const std::runtime_error&) {
+			caught = true;
+		}
+		TEST_ASSERT(caught);
+	}
+	return true;
+}
+
+/// measure per task overhead and speedup of compute bound loops for 1 to 64 threads
+bool benchmark_thread_pool()
+{
+	const size_t nr_empty_tasks = 200000, n = 1 << 26;
+	std::cout << "threads | ns per empty task | seconds for " << n << " square roots | speedup" << std::endl;
+	double sequential_seconds = 0;
+	for (unsigned nr_threads = 1; nr_threads <= 64; nr_threads *= 2) {
+		thread_pool pool(int(nr_threads) - 1);
+		auto start = std::chrono::steady_clock::now();
+		std::atomic<size_t> count(0);
+		pool.parallel_for(0, nr_empty_tasks, [&count](size_t) { count.fetch_add(1, std::memory_order_relaxed); }, 1);
+		double task_ns = 1e9 * seconds_since(start) / nr_empty_tasks;
+		TEST_ASSERT_EQ(count.load(), nr_empty_tasks);
+
+		start = std::chrono::steady_clock::now();
+		double s = pool.parallel_reduce(0, n, 0.0, sum_of_roots, [](double a, double b) { return a + b; }, 1 << 16);
+		double seconds = seconds_since(start);
+		if (nr_threads == 1)
+			sequential_seconds = seconds;
+		std::cout << nr_threads << " | " << task_ns << " | " << seconds << " | " << sequential_seconds / seconds
+				  << (s > 0 ? "" : " ") << std::endl;
+	}
+	return true;
+}
+
+#include <test/lib_begin.h>
+
+extern CGV_API test_registration thread_pool_test_registration(
+	"cgv::os::thread_pool", test_thread_pool);
+
+extern CGV_API benchmark_registration thread_pool_benchmark_registration(
+	"cgv::os::thread_pool_benchmark", benchmark_thread_pool);
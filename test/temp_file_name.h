@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+/// return path of a file with the given name in the directory for temporary files of the system
+inline std::string get_temp_file_name(const std::string& name)
+{
+	for (const char* var : { "TMPDIR", "TEMP", "TMP" }) {
+		const char* dir = std::getenv(var);
+		if (dir && *dir)
+			return std::string(dir) + "/" + name;
+	}
+#ifdef _WIN32
+	return name;
+#else
+	return "/tmp/" + name;
+#endif
+}